@@ -0,0 +1,116 @@
+/**
+ * @file io_uring_ring.h
+ * @brief io_uring 提交/完成队列的最小封装 (内部头文件)
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 直接使用 io_uring_setup/io_uring_enter/io_uring_register 系统调用
+ * 和 mmap 的共享队列，不依赖 liburing。完成队列在用户态直接读取，
+ * 只有提交和等待需要进入内核。
+ */
+
+#ifndef LIBCO_OOP_INTERNAL_IO_URING_RING_H
+#define LIBCO_OOP_INTERNAL_IO_URING_RING_H
+
+#include <linux/io_uring.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace libco_oop {
+
+/**
+ * @brief io_uring 实例
+ *
+ * 非线程安全，由单个 IOManager 独占使用。
+ */
+class IoUringRing {
+public:
+    IoUringRing() noexcept = default;
+    ~IoUringRing() noexcept;
+
+    IoUringRing(const IoUringRing&) = delete;
+    IoUringRing& operator=(const IoUringRing&) = delete;
+
+    /**
+     * @brief 创建 io_uring 实例并映射队列
+     * @param entries 提交队列深度 (内核向上取整到2的幂)
+     * @return bool 内核不支持或资源不足时返回 false (errno 为失败原因)
+     */
+    bool init(unsigned entries) noexcept;
+
+    bool is_valid() const noexcept { return ring_fd_ >= 0; }
+
+    /**
+     * @brief 取得一个清零的提交队列项
+     * @return io_uring_sqe* 提交队列已满时返回 nullptr
+     */
+    io_uring_sqe* get_sqe() noexcept;
+
+    /**
+     * @brief 已准备但尚未被内核消费的提交队列项数
+     */
+    unsigned pending() const noexcept
+    {
+        return sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    }
+
+    /**
+     * @brief 提交所有待提交的项，并可选地等待完成
+     * @param min_complete 至少等待的完成数，0 表示不等待
+     * @return int 提交的项数，失败返回 -errno
+     */
+    int submit(unsigned min_complete = 0) noexcept;
+
+    /**
+     * @brief 在用户态收集完成队列项 (不进入内核)
+     * @param fn 对每个 io_uring_cqe 调用
+     * @return unsigned 收集到的项数
+     */
+    template <typename F>
+    unsigned reap(F&& fn)
+    {
+        unsigned head = *cq_head_;
+        const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        while (head != tail) {
+            fn(cqes_[head & cq_mask_]);
+            ++head;
+            ++count;
+        }
+        if (count > 0) {
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+        return count;
+    }
+
+    /**
+     * @brief io_uring_register 封装
+     * @return int 成功返回非负值，失败返回 -errno
+     */
+    int register_resource(unsigned opcode, const void* arg, unsigned count) noexcept;
+
+private:
+    int ring_fd_ = -1;
+
+    void* sq_ring_ = nullptr;           ///< 提交队列映射
+    size_t sq_ring_size_ = 0;
+    void* cq_ring_ = nullptr;           ///< 完成队列映射 (SINGLE_MMAP 时与提交队列相同)
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;      ///< 提交队列项数组
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_head_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    unsigned sqe_tail_ = 0;             ///< 已准备的位置 (提交时才发布给内核)
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_INTERNAL_IO_URING_RING_H
@@ -0,0 +1,280 @@
+/**
+ * @file buffer.h
+ * @brief 引用计数的缓冲区链
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 代理这类服务中数据从一个套接字读出、解析后原样写往另一个套接字，
+ * 在每个协程自己的 std::vector 之间拷贝负载是系统调用之外最大的开销：
+ * - BufferPool 按 slab 批量映射固定大小的块，块用完后回到空闲链表 (最近释放的最先复用)
+ * - BufferBlock 带引用计数，多个链可以同时引用同一块中的不同区间
+ * - BufferChain 是 (块, 偏移, 长度) 片段的序列：读取时直接把块的空闲
+ *   空间交给 readv，切分、拼接和转发只调整引用，不拷贝数据；写出时把
+ *   片段直接交给 writev/sendmsg
+ *
+ * IOManager::read()/write() 的 BufferChain 重载和 ZeroCopySender (zero_copy.h)
+ * 在此之上提供协程化的分散/聚集IO。
+ */
+
+#ifndef LIBCO_OOP_BUFFER_H
+#define LIBCO_OOP_BUFFER_H
+
+#include <sys/uio.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace libco_oop {
+
+class BufferPool;
+
+/**
+ * @brief 缓冲区块
+ *
+ * 块的内存属于 BufferPool 的 slab，引用计数降为 0 时回到池中。
+ * 引用计数不是原子的，引用同一块的链只能在池所在的线程上使用。
+ */
+class BufferBlock {
+public:
+    char* data() const noexcept { return data_; }
+    size_t capacity() const noexcept { return capacity_; }
+
+    /**
+     * @brief 当前引用数
+     */
+    uint32_t use_count() const noexcept { return refs_; }
+
+    void retain() noexcept { ++refs_; }
+
+    /**
+     * @brief 释放一个引用，最后一个引用释放时把块还给池
+     */
+    void release() noexcept;
+
+private:
+    friend class BufferPool;
+
+    char* data_;                ///< 块内存 (slab 中)
+    BufferPool* pool_;          ///< 所属的池
+    BufferBlock* next_free_;    ///< 空闲链表的链接
+    uint32_t capacity_;         ///< 块大小
+    uint32_t refs_;             ///< 引用数
+};
+
+/**
+ * @brief 缓冲区池选项
+ */
+struct BufferPoolOptions {
+    size_t block_size = 16 * 1024;  ///< 每块字节数 (向上取整到 64)
+    size_t blocks_per_slab = 64;    ///< 空闲链表为空时一次映射的块数
+    size_t max_blocks = 0;          ///< 最多分配的块数，0 表示不限制
+};
+
+/**
+ * @brief 缓冲区池统计信息
+ */
+struct BufferPoolStatistics {
+    uint64_t allocations = 0;   ///< allocate() 成功次数
+    uint64_t failures = 0;      ///< 达到上限或映射失败的次数
+    size_t slabs = 0;           ///< 已映射的 slab 数
+    size_t blocks = 0;          ///< 已映射的块数
+    size_t in_use = 0;          ///< 当前被引用的块数
+};
+
+/**
+ * @brief 固定大小缓冲区块的池
+ *
+ * slab 用 mmap 映射，块在 slab 内连续排列；块大小是页大小的倍数时每块都按页对齐，
+ * 适合 MSG_ZEROCOPY 和直接IO。slab 只在池析构时解除映射。
+ *
+ * 池不是线程安全的，只能在创建它的线程上使用 (local() 提供每线程实例)。
+ * 池必须比它分配的块存活更久。
+ */
+class BufferPool {
+public:
+    explicit BufferPool(const BufferPoolOptions& opts = BufferPoolOptions{}) noexcept;
+    ~BufferPool() noexcept;
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief 当前线程的默认池 (默认选项)
+     */
+    static BufferPool& local() noexcept;
+
+    /**
+     * @brief 分配一个块，引用数为 1
+     * @return BufferBlock* 达到 max_blocks 或映射失败时返回 nullptr 并设置 errno 为 ENOMEM
+     */
+    BufferBlock* allocate() noexcept;
+
+    size_t get_block_size() const noexcept { return block_size_; }
+    const BufferPoolStatistics& get_statistics() const noexcept { return stats_; }
+
+private:
+    friend class BufferBlock;
+
+    struct Slab;
+
+    size_t block_size_;
+    size_t blocks_per_slab_;
+    size_t max_blocks_;
+    BufferBlock* free_ = nullptr;       ///< 空闲链表 (头部最近释放)
+    Slab* slabs_ = nullptr;             ///< 已映射的 slab
+    BufferPoolStatistics stats_;
+
+    bool grow() noexcept;
+    void recycle(BufferBlock* block) noexcept;
+};
+
+inline void BufferBlock::release() noexcept
+{
+    if (--refs_ == 0) {
+        pool_->recycle(this);
+    }
+}
+
+/**
+ * @brief 由引用计数块组成的字节序列
+ *
+ * 链持有其中每个片段所在块的一个引用。写入端通过 prepare()/commit() 直接
+ * 在块中接收数据；读取端通过 fill_iovec() 把片段交给聚集写，consume() 丢弃
+ * 已处理的前缀。split_to() 和 append() 在链之间转移或共享片段，不拷贝数据。
+ *
+ * 只有不被其他链共享的末尾块的剩余空间可以继续写入，共享块保持不变。
+ * 片段数组按需增长，clear() 和 consume() 之后保留容量。
+ *
+ * @code
+ * BufferChain in;
+ * io.read(client, in, 64 * 1024);             // 数据直接读入池中的块
+ * BufferChain request;
+ * in.split_to(request, header_length + body_length);
+ * io.write(upstream, request);                // 同样的块直接交给 writev
+ * @endcode
+ */
+class BufferChain {
+public:
+    /**
+     * @param pool 写入时分配新块的池
+     */
+    explicit BufferChain(BufferPool& pool = BufferPool::local()) noexcept;
+    ~BufferChain() noexcept;
+
+    BufferChain(BufferChain&& other) noexcept;
+    BufferChain& operator=(BufferChain&& other) noexcept;
+    BufferChain(const BufferChain&) = delete;
+    BufferChain& operator=(const BufferChain&) = delete;
+
+    /**
+     * @brief 数据字节数
+     */
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    /**
+     * @brief 片段数 (fill_iovec() 需要的 iovec 数)
+     */
+    size_t segment_count() const noexcept { return count_ - head_; }
+
+    BufferPool& get_pool() const noexcept { return *pool_; }
+
+    //========================================================================
+    // 写入端
+    //========================================================================
+
+    /**
+     * @brief 准备至少 min_length 字节的可写空间
+     * @param iov 输出：可写区间 (首项可能是末尾块的剩余空间)
+     * @param max_iov iov 的容量
+     * @param min_length 需要的字节数，0 表示一块
+     * @return size_t 填写的 iovec 数；分配块失败时返回 0 并设置 errno 为 ENOMEM。
+     *         max_iov 不足以容纳 min_length 时空间可能少于 min_length
+     *
+     * 随后必须调用 commit()，两者之间不能修改链。
+     */
+    size_t prepare(iovec* iov, size_t max_iov, size_t min_length = 0) noexcept;
+
+    /**
+     * @brief 把最近一次 prepare() 的空间中前 length 字节计入数据，释放未用到的新块
+     */
+    void commit(size_t length) noexcept;
+
+    /**
+     * @brief 在末尾拷贝写入 (用于协议头这类小数据)
+     * @return bool 分配失败时返回 false，已写入的部分保留
+     */
+    bool append(const void* data, size_t length) noexcept;
+
+    /**
+     * @brief 把 other 的全部片段移到末尾，other 变为空
+     * @return bool 片段数组扩容失败时返回 false，两个链都保持不变
+     */
+    bool append(BufferChain&& other) noexcept;
+
+    /**
+     * @brief 在末尾引用 other 中 [offset, offset + length) 的数据，不拷贝
+     * @return bool 区间越界时返回 false 并设置 errno 为 EINVAL；扩容失败时设置 ENOMEM
+     */
+    bool append(const BufferChain& other, size_t offset, size_t length) noexcept;
+
+    //========================================================================
+    // 读取端
+    //========================================================================
+
+    /**
+     * @brief 用 offset 之后的数据填写 iovec (用于 writev/sendmsg)
+     * @return size_t 填写的 iovec 数，数据多于 max_iov 个片段时只填写前 max_iov 个
+     */
+    size_t fill_iovec(iovec* iov, size_t max_iov, size_t offset = 0) const noexcept;
+
+    /**
+     * @brief 把 offset 之后最多 length 字节拷贝到 out (例如解析跨片段的协议头)
+     * @return size_t 拷贝的字节数
+     */
+    size_t copy_to(void* out, size_t length, size_t offset = 0) const noexcept;
+
+    /**
+     * @brief 丢弃前 length 字节 (超过 size() 时清空)
+     */
+    void consume(size_t length) noexcept;
+
+    /**
+     * @brief 把前 length 字节移到 out 的末尾
+     * @return bool length 超过 size() 时返回 false 并设置 errno 为 EINVAL；扩容失败时设置 ENOMEM，
+     *         两个链都保持不变
+     *
+     * 边界落在片段中间时两边共享该块。
+     */
+    bool split_to(BufferChain& out, size_t length) noexcept;
+
+    /**
+     * @brief 释放所有片段
+     */
+    void clear() noexcept;
+
+private:
+    /**
+     * @brief 一段数据：块中的 [offset, offset + length)
+     */
+    struct Segment {
+        BufferBlock* block;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    BufferPool* pool_;
+    Segment* segments_ = nullptr;       ///< [head_, count_) 为有效片段
+    size_t head_ = 0;
+    size_t count_ = 0;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    size_t prepared_ = 0;               ///< prepare() 时第一个可写片段的下标
+
+    bool reserve(size_t extra) noexcept;
+    void push(BufferBlock* block, uint32_t offset, uint32_t length) noexcept;
+    bool writable_tail(const Segment& segment) const noexcept;
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_BUFFER_H
@@ -0,0 +1,503 @@
+/**
+ * @file channel.h
+ * @brief 协程之间、协程与线程之间的有界通道
+ * @author libco-oop
+ * @version 1.0
+ *
+ * Channel<T>: 同一调度器内协程之间的通道，没有锁也没有原子操作
+ * - 发送方遇到等待的接收方时直接把值交给它，不经过缓冲区
+ * - 等待者是协程栈上的侵入式节点，挂起和唤醒不分配内存
+ * - 容量为 0 时是同步通道 (发送方等到接收方取走为止)
+ *
+ * MpscChannel<T>: 多生产者单消费者的无锁有界通道，生产者可以在任意线程
+ * - 环形缓冲区的每个槽位带序号 (Vyukov 有界队列)，发送和接收各一次 CAS/存储
+ * - 消费者只在缓冲区为空时发布自己并挂起，生产者只在看到等待的消费者时
+ *   唤醒它，连续的发送只唤醒一次
+ * - 等待者按所在上下文挂起 (见 waiter.h)：IOManager 的协程被其他线程唤醒时
+ *   经过该 IOManager 的 eventfd (同样合并)，普通线程在 futex 上阻塞
+ */
+
+#ifndef LIBCO_OOP_CHANNEL_H
+#define LIBCO_OOP_CHANNEL_H
+
+#include "libco_oop/intrusive_list.h"
+#include "libco_oop/io_manager.h"
+#include "libco_oop/scheduler.h"
+#include "libco_oop/waiter.h"
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace libco_oop {
+
+namespace detail {
+
+/**
+ * @brief 元素的未初始化存储
+ */
+template <typename T>
+struct alignas(T) ChannelStorage {
+    unsigned char bytes[sizeof(T)];
+
+    T* get() noexcept { return std::launder(reinterpret_cast<T*>(bytes)); }
+};
+
+} // namespace detail
+
+//============================================================================
+// Channel: 单调度器通道
+//============================================================================
+
+/**
+ * @brief 同一调度器内协程之间的有界通道
+ * @tparam T 元素类型，需可移动构造和移动赋值
+ *
+ * 所有操作必须在同一线程上进行。send()/recv() 需要等待时挂起当前协程，
+ * 不在调度器的协程中时返回 false (EPERM)；try_send()/try_recv() 不等待。
+ * 关闭后缓冲区中剩余的元素仍可接收。
+ */
+template <typename T>
+class Channel {
+public:
+    /**
+     * @brief 创建通道
+     * @param capacity 缓冲区容量，0 表示同步通道
+     */
+    explicit Channel(size_t capacity = 0)
+        : buffer_(capacity > 0 ? new detail::ChannelStorage<T>[capacity] : nullptr)
+        , capacity_(capacity)
+    {
+    }
+
+    /**
+     * @brief 销毁缓冲区中剩余的元素；析构时不能有等待者
+     */
+    ~Channel() noexcept
+    {
+        while (size_ > 0) {
+            buffer_[head_].get()->~T();
+            head_ = next(head_);
+            --size_;
+        }
+    }
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    /**
+     * @brief 发送，缓冲区已满且没有接收方时挂起
+     * @return bool 成功返回 true；失败返回 false 并设置 errno
+     *         (EPIPE: 通道已关闭，EPERM: 需要等待但不在调度器的协程中)
+     */
+    bool send(T value)
+    {
+        if (try_send(std::move(value))) {
+            return true;
+        }
+        if (closed_) {
+            return false;
+        }
+
+        Waiter self(&value);
+        senders_.push_back(&self);
+        return wait(self, senders_);
+    }
+
+    /**
+     * @brief 接收，通道为空时挂起
+     * @param out 接收到的元素
+     * @return bool 成功返回 true；失败返回 false 并设置 errno
+     *         (EPIPE: 通道已关闭且为空，EPERM: 需要等待但不在调度器的协程中)
+     */
+    bool recv(T& out)
+    {
+        if (try_recv(out)) {
+            return true;
+        }
+        if (closed_) {
+            return false;
+        }
+
+        Waiter self(&out);
+        receivers_.push_back(&self);
+        return wait(self, receivers_);
+    }
+
+    /**
+     * @brief 不等待的发送
+     * @return bool 通道已满 (EAGAIN) 或已关闭 (EPIPE) 时返回 false，value 不被移动
+     */
+    template <typename U>
+    bool try_send(U&& value)
+    {
+        if (closed_) {
+            errno = EPIPE;
+            return false;
+        }
+        if (Waiter* receiver = receivers_.pop_front()) {
+            *receiver->item = std::forward<U>(value);
+            complete(receiver);
+            return true;
+        }
+        if (size_ == capacity_) {
+            errno = EAGAIN;
+            return false;
+        }
+        push(std::forward<U>(value));
+        return true;
+    }
+
+    /**
+     * @brief 不等待的接收
+     * @return bool 通道为空 (EAGAIN) 或已关闭且为空 (EPIPE) 时返回 false
+     */
+    bool try_recv(T& out)
+    {
+        if (size_ > 0) {
+            T* item = buffer_[head_].get();
+            out = std::move(*item);
+            item->~T();
+            head_ = next(head_);
+            --size_;
+            // 空出的位置交给等待最久的发送方
+            if (Waiter* sender = senders_.pop_front()) {
+                push(std::move(*sender->item));
+                complete(sender);
+            }
+            return true;
+        }
+        if (Waiter* sender = senders_.pop_front()) {
+            out = std::move(*sender->item);
+            complete(sender);
+            return true;
+        }
+        errno = closed_ ? EPIPE : EAGAIN;
+        return false;
+    }
+
+    /**
+     * @brief 关闭通道，唤醒所有等待者 (返回 EPIPE)
+     */
+    void close() noexcept
+    {
+        closed_ = true;
+        while (Waiter* waiter = senders_.pop_front()) {
+            waiter->scheduler->schedule(waiter->coroutine);
+        }
+        while (Waiter* waiter = receivers_.pop_front()) {
+            waiter->scheduler->schedule(waiter->coroutine);
+        }
+    }
+
+    bool is_closed() const noexcept { return closed_; }
+    size_t size() const noexcept { return size_; }
+    size_t get_capacity() const noexcept { return capacity_; }
+
+private:
+    /**
+     * @brief 挂起的发送方或接收方
+     */
+    struct Waiter : IntrusiveListNode {
+        Scheduler* scheduler = Scheduler::current();
+        Coroutine* coroutine = Coroutine::current();
+        T* item;                    ///< 发送方的值或接收方的输出
+        bool done = false;          ///< 已被对方完成
+
+        explicit Waiter(T* item) noexcept : item(item) {}
+    };
+
+    std::unique_ptr<detail::ChannelStorage<T>[]> buffer_;
+    size_t capacity_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+    bool closed_ = false;
+    IntrusiveList<Waiter> senders_;
+    IntrusiveList<Waiter> receivers_;
+
+    size_t next(size_t index) const noexcept { return index + 1 == capacity_ ? 0 : index + 1; }
+
+    template <typename U>
+    void push(U&& value)
+    {
+        size_t tail = head_ + size_;
+        if (tail >= capacity_) {
+            tail -= capacity_;
+        }
+        new (buffer_[tail].bytes) T(std::forward<U>(value));
+        ++size_;
+    }
+
+    static void complete(Waiter* waiter) noexcept
+    {
+        waiter->done = true;
+        waiter->scheduler->schedule(waiter->coroutine);
+    }
+
+    bool wait(Waiter& self, IntrusiveList<Waiter>& queue) noexcept
+    {
+        while (!self.done && !closed_) {
+            if (!Scheduler::suspend()) {
+                queue.remove(&self);
+                errno = EPERM;
+                return false;
+            }
+        }
+        if (self.done) {
+            return true;
+        }
+        errno = EPIPE;
+        return false;
+    }
+};
+
+//============================================================================
+// MpscChannel: 跨线程多生产者单消费者通道
+//============================================================================
+
+/**
+ * @brief 多生产者单消费者的无锁有界通道
+ * @tparam T 元素类型，需可移动构造和移动赋值
+ *
+ * send()/try_send()/close() 可在任意线程调用；recv()/try_recv()
+ * 同一时刻只能有一个调用者。缓冲区已满时 send() 等待消费者取走元素，
+ * 这条慢路径上等待的发送方由互斥锁保护的链表管理。
+ * 与 close() 并发的 send() 可能成功但元素不再被接收。
+ */
+template <typename T>
+class MpscChannel {
+public:
+    /**
+     * @brief 创建通道
+     * @param capacity 缓冲区容量，向上取整到2的幂
+     */
+    explicit MpscChannel(size_t capacity = 1024)
+    {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        cells_.reset(new Cell[rounded]);
+        mask_ = rounded - 1;
+        for (size_t i = 0; i < rounded; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 销毁缓冲区中剩余的元素；析构时不能有等待者
+     */
+    ~MpscChannel() noexcept
+    {
+        for (;;) {
+            Cell& cell = cells_[dequeue_pos_ & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+                break;
+            }
+            cell.storage.get()->~T();
+            ++dequeue_pos_;
+        }
+    }
+
+    MpscChannel(const MpscChannel&) = delete;
+    MpscChannel& operator=(const MpscChannel&) = delete;
+
+    /**
+     * @brief 发送 (任意线程)，缓冲区已满时等待
+     * @return bool 通道已关闭时返回 false (EPIPE)
+     */
+    bool send(T value)
+    {
+        for (;;) {
+            if (try_send(std::move(value))) {
+                return true;
+            }
+            if (errno == EPIPE) {
+                return false;
+            }
+
+            detail::Waiter waiter;
+            {
+                std::lock_guard<std::mutex> lock(senders_mutex_);
+                senders_.push_back(&waiter);
+            }
+            blocked_senders_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // 重新检查：消费者可能在登记之前就已取走元素
+            if (!is_full() || closed_.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(senders_mutex_);
+                if (waiter.is_linked()) {
+                    senders_.remove(&waiter);
+                    blocked_senders_.fetch_sub(1, std::memory_order_relaxed);
+                    continue;
+                }
+                // 已被消费者取走，必须等待它的唤醒
+            }
+            waiter.wait();
+        }
+    }
+
+    /**
+     * @brief 不等待的发送 (任意线程)
+     * @return bool 通道已满 (EAGAIN) 或已关闭 (EPIPE) 时返回 false，value 不被移动
+     */
+    template <typename U>
+    bool try_send(U&& value)
+    {
+        if (closed_.load(std::memory_order_acquire)) {
+            errno = EPIPE;
+            return false;
+        }
+
+        Cell* cell;
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                errno = EAGAIN;
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->storage.bytes) T(std::forward<U>(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        // 与消费者登记后的重新检查配对，二者至少有一方看到对方
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumer_.load(std::memory_order_relaxed) != nullptr) {
+            if (detail::Waiter* waiter = consumer_.exchange(nullptr)) {
+                waiter->notify();
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief 接收 (消费者)，通道为空时等待
+     * @return bool 通道已关闭且为空时返回 false (EPIPE)
+     */
+    bool recv(T& out)
+    {
+        for (;;) {
+            if (try_recv(out)) {
+                return true;
+            }
+            if (errno == EPIPE) {
+                return false;
+            }
+
+            detail::Waiter waiter;
+            consumer_.store(&waiter, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // 重新检查：生产者可能在发布之前就已写入
+            if (is_ready() || closed_.load(std::memory_order_relaxed)) {
+                if (consumer_.exchange(nullptr) == &waiter) {
+                    continue;
+                }
+                // 已被生产者取走，必须等待它的唤醒
+            }
+            waiter.wait();
+        }
+    }
+
+    /**
+     * @brief 不等待的接收 (消费者)
+     * @return bool 通道为空 (EAGAIN) 或已关闭且为空 (EPIPE) 时返回 false
+     */
+    bool try_recv(T& out)
+    {
+        Cell& cell = cells_[dequeue_pos_ & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+            errno = closed_.load(std::memory_order_acquire) && !is_ready() ? EPIPE : EAGAIN;
+            return false;
+        }
+        T* item = cell.storage.get();
+        out = std::move(*item);
+        item->~T();
+        cell.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+
+        // 与发送方登记后的重新检查配对
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (blocked_senders_.load(std::memory_order_relaxed) > 0) {
+            wake_sender();
+        }
+        return true;
+    }
+
+    /**
+     * @brief 关闭通道 (任意线程)，唤醒所有等待者
+     */
+    void close() noexcept
+    {
+        closed_.store(true);
+        if (detail::Waiter* waiter = consumer_.exchange(nullptr)) {
+            waiter->notify();
+        }
+        while (wake_sender()) {
+        }
+    }
+
+    bool is_closed() const noexcept { return closed_.load(std::memory_order_acquire); }
+    size_t get_capacity() const noexcept { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        detail::ChannelStorage<T> storage;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};                ///< 生产者端
+    alignas(64) size_t dequeue_pos_ = 0;                            ///< 消费者端
+    alignas(64) std::atomic<detail::Waiter*> consumer_{nullptr}; ///< 挂起的消费者
+    std::atomic<bool> closed_{false};
+    std::atomic<size_t> blocked_senders_{0};                        ///< 缓冲区满时等待的发送方数
+    std::mutex senders_mutex_;
+    IntrusiveList<detail::Waiter> senders_;
+
+    bool is_ready() const noexcept
+    {
+        return cells_[dequeue_pos_ & mask_].sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1;
+    }
+
+    bool is_full() const noexcept
+    {
+        const size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        const size_t sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos) < 0;
+    }
+
+    bool wake_sender() noexcept
+    {
+        detail::Waiter* waiter;
+        {
+            std::lock_guard<std::mutex> lock(senders_mutex_);
+            waiter = senders_.pop_front();
+            if (waiter == nullptr) {
+                return false;
+            }
+            blocked_senders_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        waiter->notify();
+        return true;
+    }
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_CHANNEL_H
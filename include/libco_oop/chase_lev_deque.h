@@ -0,0 +1,216 @@
+/**
+ * @file chase_lev_deque.h
+ * @brief Chase-Lev 无锁工作窃取双端队列
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 所有者线程在底部 push/pop (LIFO)，其他线程从顶部 steal (FIFO)。
+ * 内存序按照 Lê 等人 "Correct and Efficient Work-Stealing for Weak
+ * Memory Models" (PPoPP 2013) 的 C11 版本。
+ */
+
+#ifndef LIBCO_OOP_CHASE_LEV_DEQUE_H
+#define LIBCO_OOP_CHASE_LEV_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace libco_oop {
+
+/**
+ * @brief Chase-Lev 工作窃取双端队列
+ * @tparam T 元素类型，必须是指针，nullptr 表示队列为空
+ *
+ * 容量不足时所有者把数组扩大一倍。旧数组可能仍在被窃取者读取，
+ * 因此保留到队列析构时才释放。
+ */
+template <typename T>
+class ChaseLevDeque {
+    static_assert(std::is_pointer<T>::value, "ChaseLevDeque element must be a pointer");
+
+public:
+    /**
+     * @brief 构造队列
+     * @param capacity 初始容量，向上取整到2的幂
+     */
+    explicit ChaseLevDeque(size_t capacity = 1024)
+    {
+        size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        array_.store(new Array(rounded, nullptr), std::memory_order_relaxed);
+    }
+
+    ~ChaseLevDeque() noexcept
+    {
+        Array* array = array_.load(std::memory_order_relaxed);
+        while (array != nullptr) {
+            Array* previous = array->previous;
+            delete array;
+            array = previous;
+        }
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    /**
+     * @brief 在底部压入元素 (仅所有者线程)
+     */
+    void push(T element)
+    {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Array* array = array_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(array->capacity) - 1) {
+            array = grow(array, top, bottom);
+        }
+        array->put(bottom, element);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 在底部一次压入多个元素 (仅所有者线程)
+     * @param count 元素个数
+     * @param next 每次调用返回下一个元素
+     *
+     * 所有元素写入后只发布一次 bottom_，窃取者要么看不到这一批，
+     * 要么看到全部。
+     */
+    template <typename Next>
+    void push_batch(size_t count, Next&& next)
+    {
+        if (count == 0) {
+            return;
+        }
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Array* array = array_.load(std::memory_order_relaxed);
+        while (bottom - top + static_cast<int64_t>(count) > static_cast<int64_t>(array->capacity)) {
+            array = grow(array, top, bottom);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            array->put(bottom + static_cast<int64_t>(i), next());
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + static_cast<int64_t>(count), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 从底部弹出元素 (仅所有者线程)
+     * @return T 队列为空时返回 nullptr
+     */
+    T pop() noexcept
+    {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T element = array->get(bottom);
+        if (top == bottom) {
+            // 最后一个元素，与窃取者竞争
+            if (!top_.compare_exchange_strong(top, top + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                element = nullptr;
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return element;
+    }
+
+    /**
+     * @brief 从顶部窃取元素 (任意线程)
+     * @return T 队列为空或与其他线程竞争失败时返回 nullptr
+     */
+    T steal() noexcept
+    {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        Array* array = array_.load(std::memory_order_acquire);
+        T element = array->get(top);
+        if (!top_.compare_exchange_strong(top, top + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return element;
+    }
+
+    /**
+     * @brief 元素数量的近似值
+     */
+    size_t size() const noexcept
+    {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    /**
+     * @brief 当前数组容量
+     */
+    size_t capacity() const noexcept
+    {
+        return array_.load(std::memory_order_relaxed)->capacity;
+    }
+
+private:
+    struct Array {
+        size_t capacity;
+        size_t mask;
+        Array* previous;                ///< 扩容前的数组 (延迟释放)
+        std::atomic<T>* slots;
+
+        Array(size_t cap, Array* prev)
+            : capacity(cap), mask(cap - 1), previous(prev), slots(new std::atomic<T>[cap])
+        {
+        }
+
+        ~Array() { delete[] slots; }
+
+        T get(int64_t index) const noexcept
+        {
+            return slots[static_cast<size_t>(index) & mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, T element) noexcept
+        {
+            slots[static_cast<size_t>(index) & mask].store(element, std::memory_order_relaxed);
+        }
+    };
+
+    alignas(64) std::atomic<int64_t> top_{0};       ///< 窃取端
+    alignas(64) std::atomic<int64_t> bottom_{0};    ///< 所有者端
+    alignas(64) std::atomic<Array*> array_{nullptr};
+
+    Array* grow(Array* array, int64_t top, int64_t bottom)
+    {
+        Array* bigger = new Array(array->capacity * 2, array);
+        for (int64_t i = top; i < bottom; ++i) {
+            bigger->put(i, array->get(i));
+        }
+        array_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_CHASE_LEV_DEQUE_H
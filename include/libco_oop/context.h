@@ -3,9 +3,15 @@
  * @brief 协程上下文管理系统
  * @author libco-oop
  * @version 1.0
- * 
+ *
  * 实现协程的核心上下文切换机制，这是协程库的基础。
  * 结合libco的稳定性和libaco的高性能，设计现代C++风格的上下文管理接口。
+ *
+ * 上下文类是由三个编译期策略组合而成的模板 BasicContext：
+ * - SavePolicy  决定使用哪个汇编切换入口 (运行时配置/精简/完整FPU)
+ * - StatsPolicy 决定是否存在切换计数
+ * - CheckPolicy 决定是否存在有效性标记和状态校验
+ * Context 是与早期版本行为一致的默认组合。
  */
 
 #ifndef LIBCO_OOP_CONTEXT_H
@@ -13,6 +19,25 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <cassert>
+#include <cstring>
+#include <exception>
+#include <type_traits>
+
+/**
+ * @brief 上下文校验开关
+ *
+ * 为1时 swap_unchecked() 也会做状态校验和切换计数。
+ * 默认只在调试构建 (DEBUG) 或插桩构建 (LIBCO_OOP_INSTRUMENT) 中开启，
+ * 发布构建下 swap_unchecked() 只剩一次汇编调用。
+ */
+#ifndef LIBCO_OOP_CONTEXT_CHECKS
+    #if defined(DEBUG) || defined(LIBCO_OOP_INSTRUMENT)
+        #define LIBCO_OOP_CONTEXT_CHECKS 1
+    #else
+        #define LIBCO_OOP_CONTEXT_CHECKS 0
+    #endif
+#endif
 
 namespace libco_oop {
 
@@ -20,8 +45,8 @@ namespace libco_oop {
  * @brief 上下文保存模式
  */
 enum class ContextMode {
-    MINIMAL,    ///< 精简模式 - 只保存必要寄存器 (类似libaco)
-    COMPLETE    ///< 完整模式 - 保存所有寄存器 (类似libco)
+    MINIMAL,    ///< 精简模式 - 只保存必要寄存器，不处理FPU/SSE状态 (类似libaco)
+    COMPLETE    ///< 完整模式 - 保存所有寄存器，按 save_fpu 保存FPU/SSE状态 (类似libco)
 };
 
 /**
@@ -31,240 +56,707 @@ struct ContextConfig {
     ContextMode mode = ContextMode::COMPLETE;   ///< 保存模式
     bool save_fpu = true;                       ///< 是否保存FPU/SSE状态
     bool enable_debugging = false;              ///< 是否启用调试信息
-    
-    ContextConfig() = default;
-    
-    explicit ContextConfig(ContextMode m, bool fpu = true, bool debug = false)
+
+    constexpr ContextConfig() = default;
+
+    constexpr explicit ContextConfig(ContextMode m, bool fpu = true, bool debug = false)
         : mode(m), save_fpu(fpu), enable_debugging(debug) {}
 };
 
 /**
- * @brief CPU寄存器状态结构 (x86_64)
- * 
- * 根据System V ABI和libaco的优化经验设计：
+ * @brief 协程入口函数的属性
+ *
+ * x86_64 上新上下文以 jmp 进入入口，栈上没有返回地址，入口需要自行
+ * 对齐栈 (force_align_arg_pointer)；AArch64 的 sp 始终16字节对齐，
+ * 且没有这个属性。
+ */
+#if defined(__x86_64__)
+#define LIBCO_OOP_CONTEXT_ENTRY __attribute__((force_align_arg_pointer, noinline))
+#else
+#define LIBCO_OOP_CONTEXT_ENTRY __attribute__((noinline))
+#endif
+
+/**
+ * @brief CPU寄存器状态结构
+ *
+ * 根据各平台的调用约定和libaco的优化经验设计：
  * - 保存被调用者保存的寄存器 (callee-saved registers)
  * - 栈指针和基址指针
  * - 返回地址
- * - 可选的FPU/SSE状态
+ * - 可选的浮点控制状态
+ *
+ * 栈指针和恢复地址在所有平台上都叫 rsp/rip，供平台无关的代码使用。
+ *
+ * x86_64 上通用寄存器部分 (0x00 - 0x3F) 恰好占满一个64字节缓存行，
+ * 结构放在缓存行边界上时精简切换每一侧只访问一个缓存行，
+ * FPU/SSE 控制字在下一个缓存行，只有保存FPU状态的切换才会访问。
  */
 struct alignas(16) RegisterState {
-#ifdef __x86_64__
+#if defined(__x86_64__)
     // 被调用者保存的通用寄存器 (按libaco优化顺序)
     void* r12;      ///< r12 通用寄存器
-    void* r13;      ///< r13 通用寄存器  
+    void* r13;      ///< r13 通用寄存器
     void* r14;      ///< r14 通用寄存器
     void* r15;      ///< r15 通用寄存器
     void* rip;      ///< 指令指针 (返回地址)
     void* rsp;      ///< 栈指针
     void* rbx;      ///< rbx 通用寄存器
     void* rbp;      ///< 基址指针
-    
+
     // FPU/SSE状态 (可选，通过配置控制)
     uint16_t fpucw;     ///< FPU控制字
     uint32_t mxcsr;     ///< SSE控制和状态寄存器
     uint16_t _padding;  ///< 内存对齐填充
+#elif defined(__aarch64__)
+    // AAPCS64 被调用者保存的通用寄存器
+    void* x19_x28[10];  ///< x19 - x28
+    void* fp;           ///< x29 帧指针
+    void* rip;          ///< 恢复地址 (保存时的 x30/lr)
+    void* rsp;          ///< 栈指针 (sp)
+
+    // 浮点控制寄存器 (可选，通过配置控制)
+    uint64_t fpcr;      ///< FPCR (舍入模式、异常陷阱、flush-to-zero)
+
+    // d8 - d15 是 AAPCS64 规定的被调用者保存寄存器 (v8 - v15 的低 64 位)，
+    // 与 x19 - x29 一样在所有模式下都保存
+    uint64_t d8_d15[8]; ///< d8 - d15
 #else
-    #error "Currently only x86_64 is supported. Other platforms will be added in future versions."
+    #error "Currently only x86_64 and aarch64 are supported."
 #endif
 };
 
-// 静态断言确保寄存器状态结构大小正确
+static_assert(alignof(RegisterState) == 16, "RegisterState must be 16-byte aligned");
+
+// 汇编代码 (context_switch*.S) 按固定偏移访问各字段，布局变化时必须同步修改
+#if defined(__x86_64__)
 // x86_64: 8个指针(8*8=64字节) + uint16_t(2字节) + uint32_t(4字节) + uint16_t(2字节) = 72字节
 static_assert(sizeof(RegisterState) >= 72, "RegisterState size must be at least 72 bytes for x86_64");
-static_assert(alignof(RegisterState) == 16, "RegisterState must be 16-byte aligned");
+static_assert(offsetof(RegisterState, rip) == 0x20, "context_switch.S expects rip at 0x20");
+static_assert(offsetof(RegisterState, rsp) == 0x28, "context_switch.S expects rsp at 0x28");
+static_assert(offsetof(RegisterState, rbp) == 0x38, "context_switch.S expects rbp at 0x38");
+static_assert(offsetof(RegisterState, fpucw) == 0x40, "context_switch.S expects fpucw at 0x40");
+static_assert(offsetof(RegisterState, mxcsr) == 0x44, "context_switch.S expects mxcsr at 0x44");
+static_assert(offsetof(RegisterState, fpucw) == 64, "general purpose registers must fill exactly one cache line");
+#elif defined(__aarch64__)
+static_assert(sizeof(RegisterState) == 0xB0, "context_switch_aarch64.S expects a 176-byte RegisterState");
+static_assert(offsetof(RegisterState, fp) == 0x50, "context_switch_aarch64.S expects x29 at 0x50");
+static_assert(offsetof(RegisterState, rip) == 0x58, "context_switch_aarch64.S expects lr at 0x58");
+static_assert(offsetof(RegisterState, rsp) == 0x60, "context_switch_aarch64.S expects sp at 0x60");
+static_assert(offsetof(RegisterState, fpcr) == 0x68, "context_switch_aarch64.S expects fpcr at 0x68");
+static_assert(offsetof(RegisterState, d8_d15) == 0x70, "context_switch_aarch64.S expects d8 at 0x70");
+#endif
+
+/**
+ * @brief 上下文切换的汇编函数声明
+ *
+ * 这些函数在 context_switch.S 中实现，提供底层的寄存器保存和恢复。
+ */
+extern "C" {
+    /**
+     * @brief 执行上下文切换的底层汇编函数
+     * @param from_regs 源上下文的寄存器状态指针
+     * @param to_regs 目标上下文的寄存器状态指针
+     * @param save_fpu 是否保存FPU/SSE状态
+     */
+    void libco_oop_context_swap(RegisterState* from_regs, RegisterState* to_regs, bool save_fpu) noexcept;
+
+    /**
+     * @brief 精简模式 (MINIMAL) 专用的上下文切换汇编函数
+     * @param from_regs 源上下文的寄存器状态指针
+     * @param to_regs 目标上下文的寄存器状态指针
+     *
+     * 只保存/恢复被调用者保存的通用寄存器、rsp 和 rip，
+     * 没有运行时分支，也不处理FPU/SSE状态。
+     */
+    void libco_oop_context_swap_minimal(RegisterState* from_regs, RegisterState* to_regs) noexcept;
+
+    /**
+     * @brief 完整模式专用的上下文切换汇编函数
+     * @param from_regs 源上下文的寄存器状态指针
+     * @param to_regs 目标上下文的寄存器状态指针
+     *
+     * 无条件保存/恢复FPU控制字和MXCSR，没有 save_fpu 参数和运行时分支。
+     */
+    void libco_oop_context_swap_full(RegisterState* from_regs, RegisterState* to_regs) noexcept;
+
+    /**
+     * @brief 保存当前上下文的底层汇编函数
+     * @param regs 要保存到的寄存器状态指针
+     * @param save_fpu 是否保存FPU/SSE状态
+     * @return int 保存操作的返回值 (0=第一次调用, 1=从restore返回)
+     */
+    int libco_oop_context_save(RegisterState* regs, bool save_fpu) noexcept;
+
+    /**
+     * @brief 恢复上下文的底层汇编函数
+     * @param regs 要恢复的寄存器状态指针
+     * @param save_fpu 是否恢复FPU/SSE状态
+     */
+    [[noreturn]] void libco_oop_context_restore(RegisterState* regs, bool save_fpu) noexcept;
+}
+
+/**
+ * @brief 全局上下文工具函数
+ */
+namespace context_utils {
+    /**
+     * @brief 获取当前栈指针
+     * @return void* 当前栈指针值
+     */
+    void* get_current_stack_pointer() noexcept;
+
+    /**
+     * @brief 检查栈指针是否对齐
+     * @param sp 要检查的栈指针
+     * @return bool 是否按16字节对齐
+     *
+     * 在头文件中内联实现，校验路径上不产生函数调用。
+     */
+    inline bool is_stack_aligned(void* sp) noexcept
+    {
+        return sp != nullptr && (reinterpret_cast<uintptr_t>(sp) & 15) == 0;
+    }
+
+    /**
+     * @brief 对齐栈指针
+     * @param sp 要对齐的栈指针
+     * @return void* 对齐后的栈指针 (向下对齐到16字节边界)
+     */
+    inline void* align_stack_pointer(void* sp) noexcept
+    {
+        return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(sp) & ~static_cast<uintptr_t>(15));
+    }
+
+    /**
+     * @brief 把寄存器状态中的浮点控制状态设为平台默认值
+     *
+     * x86_64 为标准FPU控制字和MXCSR，AArch64 为 FPCR = 0 (就近舍入、不触发陷阱)。
+     */
+    inline void init_fpu_state(RegisterState& regs) noexcept
+    {
+#if defined(__x86_64__)
+        regs.fpucw = 0x037F;    // 标准FPU控制字
+        regs.mxcsr = 0x1F80;    // 标准SSE控制字
+#elif defined(__aarch64__)
+        regs.fpcr = 0;
+#endif
+    }
+
+    /**
+     * @brief 把当前线程的浮点控制状态保存到寄存器状态中
+     *
+     * 用于先走精简切换、之后补存FPU状态的路径。
+     */
+    inline void save_fpu_state(RegisterState& regs) noexcept
+    {
+#if defined(__x86_64__)
+        __asm__ __volatile__("fnstcw %0" : "=m"(regs.fpucw));
+        __asm__ __volatile__("stmxcsr %0" : "=m"(regs.mxcsr));
+#elif defined(__aarch64__)
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(regs.fpcr));
+#endif
+    }
+}
+
+//============================================================================
+// 上下文策略
+//============================================================================
+
+/**
+ * @brief BasicContext 的编译期策略
+ *
+ * 每个策略都是可空的基类，未启用的功能不占用任何存储 (空基类优化)。
+ */
+namespace context_policy {
+
+/**
+ * @brief 运行时配置的保存策略 (默认 Context 使用)
+ *
+ * 每个上下文保存一份 ContextConfig，切换时按双方模式选择汇编入口。
+ */
+class DynamicSave {
+public:
+    static constexpr bool configurable = true;
+
+    constexpr DynamicSave() = default;
+    constexpr explicit DynamicSave(const ContextConfig& config) : config_(config) {}
+
+    const ContextConfig& config() const noexcept { return config_; }
+
+    void switch_to(RegisterState* from, RegisterState* to, const DynamicSave& other) const noexcept
+    {
+        if (config_.mode == ContextMode::MINIMAL || other.config_.mode == ContextMode::MINIMAL) {
+            // 精简模式：独立的汇编入口，不处理FPU/SSE状态
+            libco_oop_context_swap_minimal(from, to);
+        } else {
+            // 确保两个上下文使用相同的配置（FPU保存策略）
+            libco_oop_context_swap(from, to, config_.save_fpu && other.config_.save_fpu);
+        }
+    }
+
+    bool saves_fpu() const noexcept { return config_.save_fpu; }
+
+protected:
+    ContextConfig config_;              ///< 上下文配置
+};
+
+/**
+ * @brief 精简保存策略：固定使用 libco_oop_context_swap_minimal
+ */
+class MinimalSave {
+public:
+    static constexpr bool configurable = false;
+    static constexpr ContextConfig kConfig{ContextMode::MINIMAL, false, false};
+
+    static const ContextConfig& config() noexcept { return kConfig; }
+
+    static void switch_to(RegisterState* from, RegisterState* to, const MinimalSave&) noexcept
+    {
+        libco_oop_context_swap_minimal(from, to);
+    }
+
+    static constexpr bool saves_fpu() noexcept { return false; }
+};
+
+/**
+ * @brief 完整保存策略：固定使用 libco_oop_context_swap_full
+ */
+class FpuSave {
+public:
+    static constexpr bool configurable = false;
+    static constexpr ContextConfig kConfig{ContextMode::COMPLETE, true, false};
+
+    static const ContextConfig& config() noexcept { return kConfig; }
+
+    static void switch_to(RegisterState* from, RegisterState* to, const FpuSave&) noexcept
+    {
+        libco_oop_context_swap_full(from, to);
+    }
+
+    static constexpr bool saves_fpu() noexcept { return true; }
+};
+
+/**
+ * @brief 切换计数统计策略
+ */
+class SwitchCounter {
+public:
+    static constexpr bool enabled = true;
+
+    void on_switch() noexcept { ++switch_count_; }
+    size_t switch_count() const noexcept { return switch_count_; }
+    void reset_stats() noexcept { switch_count_ = 0; }
+    void take_stats(SwitchCounter& other) noexcept
+    {
+        switch_count_ = other.switch_count_;
+        other.switch_count_ = 0;
+    }
+
+private:
+    size_t switch_count_ = 0;           ///< 上下文切换统计
+};
+
+/**
+ * @brief 无统计策略，不占用存储
+ */
+class NoStats {
+public:
+    static constexpr bool enabled = false;
+
+    void on_switch() noexcept {}
+    static constexpr size_t switch_count() noexcept { return 0; }
+    void reset_stats() noexcept {}
+    void take_stats(NoStats&) noexcept {}
+};
 
 /**
- * @brief 协程上下文类
- * 
+ * @brief 状态校验策略：维护有效性标记，swap() 前校验双方状态
+ */
+class StateCheck {
+public:
+    static constexpr bool enabled = true;
+
+    bool valid_flag(const RegisterState&) const noexcept { return is_valid_; }
+    void set_valid(bool valid) noexcept { is_valid_ = valid; }
+
+private:
+    bool is_valid_ = false;             ///< 上下文有效性标记
+};
+
+/**
+ * @brief 无校验策略：有效性由寄存器内容推导，swap() 不做校验
+ */
+class NoCheck {
+public:
+    static constexpr bool enabled = false;
+
+    static bool valid_flag(const RegisterState& regs) noexcept
+    {
+        return regs.rsp != nullptr && regs.rip != nullptr;
+    }
+    void set_valid(bool) noexcept {}
+};
+
+/**
+ * @brief 寄存器状态存储
+ *
+ * 作为 BasicContext 的第一个基类，保证寄存器状态位于对象开头：
+ * 切换访问的寄存器与对象的缓存行对齐一致，配置、统计和校验标记
+ * 等冷数据排在寄存器之后。
+ */
+struct RegisterStorage {
+    RegisterState registers_;           ///< CPU寄存器状态
+};
+
+} // namespace context_policy
+
+//============================================================================
+// BasicContext
+//============================================================================
+
+/**
+ * @brief 协程上下文类模板
+ *
  * 封装协程的CPU状态，提供现代C++风格的上下文切换接口。
  * 设计原则：
  * - RAII资源管理
  * - 异常安全
  * - 高性能
  * - 类型安全
+ *
+ * @tparam SavePolicy  保存策略，决定汇编切换入口 (DynamicSave/MinimalSave/FpuSave)
+ * @tparam StatsPolicy 统计策略 (SwitchCounter/NoStats)
+ * @tparam CheckPolicy 校验策略 (StateCheck/NoCheck)
  */
-class Context {
+template <typename SavePolicy, typename StatsPolicy, typename CheckPolicy>
+class BasicContext : private context_policy::RegisterStorage,
+                     private SavePolicy, private StatsPolicy, private CheckPolicy {
 public:
     /**
      * @brief 默认构造函数，初始化空上下文
+     */
+    BasicContext() noexcept
+    {
+        initialize_registers();
+    }
+
+    /**
+     * @brief 按配置构造上下文 (仅运行时配置的保存策略可用)
      * @param config 上下文配置选项
      */
-    explicit Context(const ContextConfig& config = ContextConfig{});
-    
+    template <typename P = SavePolicy, typename = std::enable_if_t<P::configurable>>
+    explicit BasicContext(const ContextConfig& config) noexcept
+        : SavePolicy(config)
+    {
+        initialize_registers();
+    }
+
     /**
      * @brief 析构函数，清理资源
+     *
+     * RegisterState 是 POD 类型，不需要特殊清理。
      */
-    ~Context() noexcept;
-    
+    ~BasicContext() noexcept = default;
+
     /**
      * @brief 移动构造函数
      * @param other 要移动的上下文对象
      */
-    Context(Context&& other) noexcept;
-    
+    BasicContext(BasicContext&& other) noexcept
+        : RegisterStorage{other.registers_}
+        , SavePolicy(static_cast<const SavePolicy&>(other))
+    {
+        take_state(other);
+    }
+
     /**
      * @brief 移动赋值运算符
      * @param other 要移动的上下文对象
-     * @return Context& 当前对象引用
+     * @return BasicContext& 当前对象引用
      */
-    Context& operator=(Context&& other) noexcept;
-    
+    BasicContext& operator=(BasicContext&& other) noexcept
+    {
+        if (this != &other) {
+            static_cast<SavePolicy&>(*this) = static_cast<const SavePolicy&>(other);
+            registers_ = other.registers_;
+            take_state(other);
+        }
+        return *this;
+    }
+
     // 禁用拷贝构造和拷贝赋值 (上下文应该是唯一的)
-    Context(const Context&) = delete;
-    Context& operator=(const Context&) = delete;
-    
+    BasicContext(const BasicContext&) = delete;
+    BasicContext& operator=(const BasicContext&) = delete;
+
     /**
      * @brief 保存当前执行上下文
      * @return bool 保存是否成功
-     * 
+     *
      * 将当前CPU状态保存到此上下文对象中。
      * 通常在协程切换时调用。
      */
-    bool save() noexcept;
-    
+    bool save() noexcept
+    {
+        // 调用底层汇编函数保存当前上下文
+        int result = libco_oop_context_save(&registers_, SavePolicy::saves_fpu());
+
+        if (result == 0) {
+            // 第一次调用，保存成功
+            CheckPolicy::set_valid(true);
+        } else {
+            // 从 restore 返回，上下文已经切换
+            StatsPolicy::on_switch();
+        }
+        return true;
+    }
+
     /**
      * @brief 恢复到指定上下文
-     * @return bool 恢复是否成功
-     * 
+     *
      * 将CPU状态恢复到此上下文保存的状态。
      * 注意：此函数不会返回，会直接跳转到保存时的执行点。
      */
-    [[noreturn]] void restore() noexcept;
-    
+    [[noreturn]] void restore() noexcept
+    {
+        // 如果上下文无效，终止程序（因为函数标记为 noreturn）
+        if (!validate_state()) {
+            std::terminate();
+        }
+
+        // 调用底层汇编函数恢复上下文
+        libco_oop_context_restore(&registers_, SavePolicy::saves_fpu());
+    }
+
     /**
      * @brief 原子性的上下文切换
      * @param other 要切换到的上下文
      * @return bool 切换是否成功
-     * 
+     *
      * 保存当前上下文，然后切换到目标上下文。
      * 这是协程切换的核心操作。
+     * 使用运行时配置时，任一上下文为 MINIMAL 模式即走
+     * libco_oop_context_swap_minimal 精简路径，否则走完整路径
+     * (与 save_fpu 取交集的规则一致)；静态保存策略固定使用各自的入口。
+     * 校验策略为 NoCheck 时不做校验，始终返回 true。
+     */
+    bool swap(BasicContext& other) noexcept
+    {
+        // 验证两个上下文都有效
+        // 切换路径上只有汇编调用，不会抛出异常，因此不需要 try/catch
+        if (CheckPolicy::enabled && (!validate_state() || !other.validate_state())) {
+            return false;
+        }
+
+        SavePolicy::switch_to(&registers_, &other.registers_, other);
+
+        // 执行到这里说明切换成功返回
+        StatsPolicy::on_switch();
+        CheckPolicy::set_valid(true);
+        return true;
+    }
+
+    /**
+     * @brief 无校验的快速上下文切换 (头文件内联)
+     * @param other 要切换到的上下文
+     *
+     * 调用者负责保证两个上下文都有效。发布构建下不做状态校验、
+     * 不更新切换计数，只剩保存策略对应的一次汇编调用；
+     * LIBCO_OOP_CONTEXT_CHECKS 为1时以断言校验并计数。
      */
-    bool swap(Context& other) noexcept;
-    
+    void swap_unchecked(BasicContext& other) noexcept
+    {
+#if LIBCO_OOP_CONTEXT_CHECKS
+        assert(validate_state() && other.validate_state());
+        StatsPolicy::on_switch();
+#endif
+        SavePolicy::switch_to(&registers_, &other.registers_, other);
+    }
+
     /**
      * @brief 检查上下文是否有效
      * @return bool 上下文是否已初始化且有效
      */
-    bool is_valid() const noexcept;
-    
+    bool is_valid() const noexcept
+    {
+        return validate_state();
+    }
+
     /**
      * @brief 重置上下文状态
-     * 
+     *
      * 将上下文重置为初始状态，清除所有保存的寄存器状态。
      */
-    void reset() noexcept;
-    
+    void reset() noexcept
+    {
+        CheckPolicy::set_valid(false);
+        StatsPolicy::reset_stats();
+        initialize_registers();
+    }
+
     /**
      * @brief 获取栈指针
      * @return void* 当前保存的栈指针，如果上下文无效则返回nullptr
      */
-    void* get_stack_pointer() const noexcept;
-    
+    void* get_stack_pointer() const noexcept
+    {
+        return registers_.rsp;
+    }
+
     /**
      * @brief 设置栈指针
      * @param sp 新的栈指针值
      * @return bool 设置是否成功
      */
-    bool set_stack_pointer(void* sp) noexcept;
-    
+    bool set_stack_pointer(void* sp) noexcept
+    {
+        if (sp == nullptr) {
+            return false;
+        }
+
+        // 检查栈指针对齐
+        registers_.rsp = context_utils::align_stack_pointer(sp);
+
+        // 如果之前无效，设置栈指针后可能变为有效
+        if (!CheckPolicy::valid_flag(registers_)) {
+            CheckPolicy::set_valid(registers_.rip != nullptr);
+        }
+        return true;
+    }
+
     /**
      * @brief 获取指令指针
      * @return void* 当前保存的指令指针，如果上下文无效则返回nullptr
      */
-    void* get_instruction_pointer() const noexcept;
-    
+    void* get_instruction_pointer() const noexcept
+    {
+        return registers_.rip;
+    }
+
     /**
      * @brief 设置指令指针
      * @param ip 新的指令指针值
      * @return bool 设置是否成功
      */
-    bool set_instruction_pointer(void* ip) noexcept;
-    
+    bool set_instruction_pointer(void* ip) noexcept
+    {
+        if (ip == nullptr) {
+            return false;
+        }
+
+        registers_.rip = ip;
+
+        // 如果之前无效，设置指令指针后可能变为有效
+        if (!CheckPolicy::valid_flag(registers_)) {
+            CheckPolicy::set_valid(registers_.rsp != nullptr);
+        }
+        return true;
+    }
+
     /**
      * @brief 获取上下文配置
-     * @return const ContextConfig& 当前配置的引用
+     * @return const ContextConfig& 当前配置的引用 (静态保存策略返回固定配置)
      */
-    const ContextConfig& get_config() const noexcept;
-    
+    const ContextConfig& get_config() const noexcept
+    {
+        return SavePolicy::config();
+    }
+
     /**
      * @brief 获取上下文统计信息
-     * @return size_t 上下文切换次数
+     * @return size_t 上下文切换次数 (NoStats 策略下恒为0)
+     */
+    size_t get_switch_count() const noexcept
+    {
+        return StatsPolicy::switch_count();
+    }
+
+    /**
+     * @brief 访问底层寄存器状态
+     * @return RegisterState& 寄存器状态引用
+     *
+     * 供栈管理、调度器等底层组件直接调用汇编切换函数使用。
      */
-    size_t get_switch_count() const noexcept;
+    RegisterState& registers() noexcept { return registers_; }
+    const RegisterState& registers() const noexcept { return registers_; }
 
 private:
-    RegisterState registers_;           ///< CPU寄存器状态
-    ContextConfig config_;              ///< 上下文配置
-    bool is_valid_;                     ///< 上下文有效性标记
-    size_t switch_count_;               ///< 上下文切换统计
-    
     /**
      * @brief 验证上下文状态的完整性
      * @return bool 上下文状态是否完整
      */
-    bool validate_state() const noexcept;
-    
+    bool validate_state() const noexcept
+    {
+        // 基本有效性检查
+        if (!CheckPolicy::valid_flag(registers_)) {
+            return false;
+        }
+
+        // 栈指针不能为空且应该对齐
+        if (!context_utils::is_stack_aligned(registers_.rsp)) {
+            return false;
+        }
+
+        // 指令指针不能为空 (除非是刚初始化的上下文)
+        if (registers_.rip == nullptr && StatsPolicy::switch_count() > 0) {
+            return false;
+        }
+        return true;
+    }
+
     /**
      * @brief 初始化寄存器状态
      */
-    void initialize_registers() noexcept;
+    void initialize_registers() noexcept
+    {
+        // 清零所有寄存器
+        std::memset(&registers_, 0, sizeof(registers_));
+
+        // 根据配置初始化FPU/SSE状态
+        if (SavePolicy::saves_fpu()) {
+            context_utils::init_fpu_state(registers_);
+        }
+    }
+
+    /**
+     * @brief 从被移动对象接管有效性和统计，并使其失效
+     */
+    void take_state(BasicContext& other) noexcept
+    {
+        CheckPolicy::set_valid(other.CheckPolicy::valid_flag(other.registers_));
+        StatsPolicy::take_stats(other);
+        other.CheckPolicy::set_valid(false);
+    }
 };
 
 /**
- * @brief 上下文切换的汇编函数声明
- * 
- * 这些函数在 context_switch.S 中实现，提供底层的寄存器保存和恢复。
+ * @brief 默认上下文类型：运行时配置 + 切换计数 + 状态校验
  */
-extern "C" {
-    /**
-     * @brief 执行上下文切换的底层汇编函数
-     * @param from_regs 源上下文的寄存器状态指针
-     * @param to_regs 目标上下文的寄存器状态指针
-     * @param save_fpu 是否保存FPU/SSE状态
-     */
-    void libco_oop_context_swap(RegisterState* from_regs, RegisterState* to_regs, bool save_fpu) noexcept;
-    
-    /**
-     * @brief 保存当前上下文的底层汇编函数
-     * @param regs 要保存到的寄存器状态指针
-     * @param save_fpu 是否保存FPU/SSE状态
-     * @return int 保存操作的返回值 (0=第一次调用, 1=从restore返回)
-     */
-    int libco_oop_context_save(RegisterState* regs, bool save_fpu) noexcept;
-    
-    /**
-     * @brief 恢复上下文的底层汇编函数
-     * @param regs 要恢复的寄存器状态指针
-     * @param save_fpu 是否恢复FPU/SSE状态
-     */
-    [[noreturn]] void libco_oop_context_restore(RegisterState* regs, bool save_fpu) noexcept;
-}
+using Context = BasicContext<context_policy::DynamicSave,
+                             context_policy::SwitchCounter,
+                             context_policy::StateCheck>;
 
 /**
- * @brief 全局上下文工具函数
+ * @brief 最精简的上下文类型：只有寄存器状态，切换即一次汇编调用
  */
-namespace context_utils {
-    /**
-     * @brief 获取当前栈指针
-     * @return void* 当前栈指针值
-     */
-    void* get_current_stack_pointer() noexcept;
-    
-    /**
-     * @brief 检查栈指针是否对齐
-     * @param sp 要检查的栈指针
-     * @return bool 是否按16字节对齐
-     */
-    bool is_stack_aligned(void* sp) noexcept;
-    
-    /**
-     * @brief 对齐栈指针
-     * @param sp 要对齐的栈指针
-     * @return void* 对齐后的栈指针
-     */
-    void* align_stack_pointer(void* sp) noexcept;
-}
+using FastContext = BasicContext<context_policy::MinimalSave,
+                                 context_policy::NoStats,
+                                 context_policy::NoCheck>;
+
+/**
+ * @brief 保存FPU/SSE状态且无额外开销的上下文类型
+ */
+using FpuContext = BasicContext<context_policy::FpuSave,
+                                context_policy::NoStats,
+                                context_policy::NoCheck>;
+
+static_assert(sizeof(FastContext) == sizeof(RegisterState), "FastContext must hold nothing but registers");
+static_assert(sizeof(FpuContext) == sizeof(RegisterState), "FpuContext must hold nothing but registers");
+
+// 默认组合在 context.cpp 中显式实例化
+extern template class BasicContext<context_policy::DynamicSave,
+                                   context_policy::SwitchCounter,
+                                   context_policy::StateCheck>;
 
 } // namespace libco_oop
 
-#endif // LIBCO_OOP_CONTEXT_H 
\ No newline at end of file
+#endif // LIBCO_OOP_CONTEXT_H
@@ -0,0 +1,546 @@
+/**
+ * @file coroutine.h
+ * @brief 基础协程类
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 在 Context 和 Stack 之上提供面向用户的协程接口：
+ * - CoroutineState: 协程状态机
+ * - CoroutineFunction: 带小对象优化的协程入口函数包装器
+ * - Coroutine: 协程控制块，创建、恢复、让出和复用
+ *
+ * 控制块和栈都来自每线程的池，稳态下创建和销毁协程不分配内存。
+ */
+
+#ifndef LIBCO_OOP_COROUTINE_H
+#define LIBCO_OOP_COROUTINE_H
+
+#include "libco_oop/context.h"
+#include "libco_oop/coroutine_local.h"
+#include "libco_oop/intrusive_list.h"
+#include "libco_oop/metrics.h"
+#include "libco_oop/stack.h"
+#include "libco_oop/timer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace libco_oop {
+
+/**
+ * @brief 协程状态
+ */
+enum class CoroutineState {
+    READY,      ///< 已创建，尚未开始执行
+    RUNNING,    ///< 正在执行
+    SUSPENDED,  ///< 已让出，等待恢复
+    FINISHED,   ///< 入口函数正常返回
+    ERROR       ///< 入口函数抛出异常
+};
+
+/**
+ * @brief 调度类
+ *
+ * Scheduler 为每个类维护独立的就绪队列，按 SchedulingPolicy 在类之间选择。
+ */
+enum class SchedulingClass : uint8_t {
+    LATENCY,    ///< 延迟敏感 (例如 RPC 处理)
+    NORMAL,     ///< 默认
+    BATCH       ///< 后台批处理
+};
+
+/// 调度类的数量
+constexpr size_t kSchedulingClasses = 3;
+
+/**
+ * @brief 协程入口函数包装器
+ *
+ * 与 std::function<void()> 类似，但可以保存只能移动的可调用对象，
+ * 且捕获不超过 kInlineSize 字节的可调用对象直接存放在对象内部，
+ * 不进行堆分配。更大的可调用对象退回到堆上。
+ */
+class CoroutineFunction {
+public:
+    static constexpr size_t kInlineSize = 64;   ///< 内联存储大小 (字节)
+
+    CoroutineFunction() noexcept = default;
+
+    /**
+     * @brief 从任意 void() 可调用对象构造
+     */
+    template <typename F, typename = std::enable_if_t<
+        !std::is_same<std::decay_t<F>, CoroutineFunction>::value>>
+    CoroutineFunction(F&& f)
+    {
+        using Fn = std::decay_t<F>;
+        if constexpr (fits_inline<Fn>()) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            ops_ = &InlineOps<Fn>::ops;
+        } else {
+            Fn* heap = new Fn(std::forward<F>(f));
+            ::new (static_cast<void*>(storage_)) Fn*(heap);
+            ops_ = &HeapOps<Fn>::ops;
+        }
+    }
+
+    CoroutineFunction(CoroutineFunction&& other) noexcept
+    {
+        take(other);
+    }
+
+    CoroutineFunction& operator=(CoroutineFunction&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    CoroutineFunction(const CoroutineFunction&) = delete;
+    CoroutineFunction& operator=(const CoroutineFunction&) = delete;
+
+    ~CoroutineFunction() noexcept
+    {
+        reset();
+    }
+
+    /**
+     * @brief 调用保存的可调用对象
+     */
+    void operator()()
+    {
+        ops_->invoke(storage_);
+    }
+
+    /**
+     * @brief 销毁保存的可调用对象 (及其捕获)
+     */
+    void reset() noexcept
+    {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    /**
+     * @brief 可调用对象是否存放在内联存储中
+     */
+    bool is_inline() const noexcept { return ops_ != nullptr && ops_->is_inline; }
+
+    /**
+     * @brief 保存的可调用对象的类型 (为空时为 typeid(void))
+     */
+    const std::type_info& target_type() const noexcept { return ops_ != nullptr ? *ops_->type : typeid(void); }
+
+    /**
+     * @brief 调用实现的地址，用于在诊断信息中定位入口函数 (为空时为 nullptr)
+     */
+    const void* get_invoker() const noexcept
+    {
+        return ops_ != nullptr ? reinterpret_cast<const void*>(ops_->invoke) : nullptr;
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*relocate)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+        const std::type_info* type;
+        bool is_inline;
+    };
+
+    template <typename Fn>
+    static constexpr bool fits_inline()
+    {
+        return sizeof(Fn) <= kInlineSize
+            && alignof(Fn) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+    template <typename Fn>
+    struct InlineOps {
+        static void invoke(void* storage) { (*static_cast<Fn*>(storage))(); }
+        static void relocate(void* dst, void* src) noexcept
+        {
+            Fn* from = static_cast<Fn*>(src);
+            ::new (dst) Fn(std::move(*from));
+            from->~Fn();
+        }
+        static void destroy(void* storage) noexcept { static_cast<Fn*>(storage)->~Fn(); }
+        static constexpr Ops ops{&invoke, &relocate, &destroy, &typeid(Fn), true};
+    };
+
+    template <typename Fn>
+    struct HeapOps {
+        static void invoke(void* storage) { (**static_cast<Fn**>(storage))(); }
+        static void relocate(void* dst, void* src) noexcept
+        {
+            ::new (dst) Fn*(*static_cast<Fn**>(src));
+        }
+        static void destroy(void* storage) noexcept { delete *static_cast<Fn**>(storage); }
+        static constexpr Ops ops{&invoke, &relocate, &destroy, &typeid(Fn), false};
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];   ///< 可调用对象存储
+    const Ops* ops_ = nullptr;                                      ///< 类型擦除的操作表
+
+    void take(CoroutineFunction& other) noexcept
+    {
+        if (other.ops_ != nullptr) {
+            other.ops_->relocate(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+};
+
+/**
+ * @brief 协程创建选项
+ */
+struct CoroutineOptions {
+    size_t stack_size = 0;                      ///< 所需最小栈大小，0 表示使用分配器默认大小
+    bool save_fpu = false;                      ///< 切换时是否保存/恢复FPU控制字和MXCSR
+    StackAllocator* stack_allocator = nullptr;  ///< 栈来源，nullptr 表示 FixedStackAllocator::local()
+    HybridStackAllocator* hybrid = nullptr;     ///< 使用混合栈策略 (优先于 stack_allocator)
+    StackProfile* profile = nullptr;            ///< 混合栈策略使用的协程画像
+    StackUsage* stack_usage = nullptr;          ///< 栈用量画像：stack_size 为0时按推荐大小分配栈，采样栈的高水位记入其中
+    SchedulingClass scheduling_class = SchedulingClass::NORMAL; ///< 调度类
+    uint64_t deadline = 0;                      ///< 截止时刻 (毫秒，TimerManager::now_ms() 时间基)，0 表示没有截止时刻
+};
+
+class Coroutine;
+class CoroutinePool;
+
+namespace stack_guard {
+namespace detail {
+struct Access;
+} // namespace detail
+} // namespace stack_guard
+
+class Scheduler;
+class WorkStealingScheduler;
+
+/**
+ * @brief 协程删除器，把控制块归还到当前线程的池中
+ *
+ * 从 CoroutinePool 借出的协程先交回协程池，由池决定保留还是销毁。
+ */
+struct CoroutineDeleter {
+    void operator()(Coroutine* coroutine) const noexcept;
+};
+
+/**
+ * @brief 协程智能指针
+ */
+using CoroutinePtr = std::unique_ptr<Coroutine, CoroutineDeleter>;
+
+/**
+ * @brief 协程类
+ *
+ * 非对称协程：resume() 从调用者切换到协程，yield() 从协程切换回
+ * 最近一次恢复它的调用者。调用者可以是线程本身，也可以是另一个协程
+ * (嵌套恢复)。
+ *
+ * 协程内抛出且未捕获的异常会结束协程 (state 为 ERROR)，
+ * 并在对应的 resume() 中重新抛给调用者。
+ * 销毁一个处于 SUSPENDED 状态的协程不会展开其栈，栈上对象的析构函数不会执行。
+ *
+ * 控制块内嵌侵入式链表节点，供调度器的就绪队列和等待队列使用。
+ *
+ * 控制块按缓存行对齐，字段按冷热分区：一次调度和切换只访问开头的
+ * 三个缓存行 (链表节点和调度状态、通用寄存器、栈绑定的快速路径字段)，
+ * 入口函数、异常、分配器、统计、协程局部存储和定时器节点排在之后。
+ */
+class alignas(64) Coroutine : private IntrusiveListNode {
+public:
+    /**
+     * @brief 创建协程
+     * @param fn 协程入口函数，任意 void() 可调用对象
+     * @param opts 创建选项
+     * @return CoroutinePtr 新协程，处于 READY 状态；栈分配失败返回空指针
+     */
+    template <typename F>
+    static CoroutinePtr create(F&& fn, const CoroutineOptions& opts = CoroutineOptions{})
+    {
+        return create_function(CoroutineFunction(std::forward<F>(fn)), opts);
+    }
+
+    /**
+     * @brief 以已包装的入口函数创建协程
+     */
+    static CoroutinePtr create_function(CoroutineFunction fn, const CoroutineOptions& opts = CoroutineOptions{});
+
+    Coroutine(const Coroutine&) = delete;
+    Coroutine& operator=(const Coroutine&) = delete;
+
+    /**
+     * @brief 恢复协程执行，直到它让出或结束
+     * @return bool 协程不处于 READY/SUSPENDED 状态时返回 false
+     *
+     * 协程因未捕获的异常结束时，异常在这里重新抛出。
+     */
+    bool resume();
+
+    /**
+     * @brief 让出当前协程，切换回恢复它的调用者
+     * @return bool 不在协程中调用时返回 false
+     */
+    static bool yield() noexcept;
+
+    /**
+     * @brief 从当前协程直接切换到另一个协程 (对称切换)
+     * @param target 目标协程，必须处于 READY/SUSPENDED 状态
+     * @return bool 不在协程中调用或目标不可恢复时返回 false
+     *
+     * 目标继承当前协程的调用者：目标之后 yield() 会回到恢复当前协程的
+     * 调用者，而不是回到当前协程。当前协程变为 SUSPENDED。
+     */
+    static bool yield_to(Coroutine& target) noexcept;
+
+    /**
+     * @brief 获取当前线程正在运行的协程
+     * @return Coroutine* 不在协程中时返回 nullptr
+     *
+     * 不内联：协程可能在不同线程上恢复，每次调用都重新读取线程局部变量，
+     * 避免编译器跨切换缓存旧线程的地址。
+     */
+    static Coroutine* current() noexcept;
+
+    /**
+     * @brief 以新的入口函数复用协程 (栈和控制块保持不变)
+     * @param fn 新的入口函数
+     * @return bool 协程处于 RUNNING/SUSPENDED 状态时返回 false
+     *
+     * 调度类保持不变，截止时刻清零。
+     */
+    template <typename F>
+    bool reset(F&& fn)
+    {
+        return reset_function(CoroutineFunction(std::forward<F>(fn)));
+    }
+
+    /**
+     * @brief 以已包装的入口函数复用协程
+     */
+    bool reset_function(CoroutineFunction fn) noexcept;
+
+    CoroutineState get_state() const noexcept { return state_; }
+    bool is_finished() const noexcept
+    {
+        return state_ == CoroutineState::FINISHED || state_ == CoroutineState::ERROR;
+    }
+
+    /**
+     * @brief 获取协程唯一ID
+     */
+    uint64_t get_id() const noexcept { return id_; }
+
+    /**
+     * @brief 获取协程运行的栈
+     */
+    Stack* get_stack() const noexcept { return binding_.get_stack(); }
+
+    /**
+     * @brief 获取协程的栈绑定 (统计换入换出)
+     */
+    const StackBinding& get_stack_binding() const noexcept { return binding_; }
+
+    /**
+     * @brief 获取协程被恢复的次数
+     */
+    size_t get_resume_count() const noexcept { return resume_count_; }
+
+    /**
+     * @brief 获取调度类 (由 Scheduler::set_scheduling_class() 修改)
+     */
+    SchedulingClass get_scheduling_class() const noexcept { return scheduling_class_; }
+
+    /**
+     * @brief 获取截止时刻 (毫秒)，0 表示没有截止时刻 (由 Scheduler::set_deadline() 修改)
+     */
+    uint64_t get_deadline() const noexcept { return deadline_; }
+
+    /**
+     * @brief 获取拥有协程的单线程调度器
+     * @return Scheduler* 未交给 Scheduler (或其子类) 时返回 nullptr
+     */
+    Scheduler* get_scheduler() const noexcept { return scheduler_; }
+
+    /**
+     * @brief 获取协程的运行指标
+     * @return metrics::CoroutineMetrics 运行指标关闭时只有切换次数
+     *
+     * 运行周期在切出时累计，正在运行的协程不包含本次切入以来的部分。
+     */
+    metrics::CoroutineMetrics get_metrics() const noexcept
+    {
+        metrics::CoroutineMetrics result;
+        result.switches = resume_count_;
+        result.run_cycles = run_cycles_;
+        result.max_stack_depth = max_stack_depth_;
+        return result;
+    }
+
+private:
+    friend struct CoroutineDeleter;
+    friend class CoroutinePool;
+    friend class Scheduler;
+    friend class WorkStealingScheduler;
+    friend struct stack_guard::detail::Access;
+    template <typename> friend class IntrusiveList;
+    friend void* coroutine_local::get(int key) noexcept;
+    friend bool coroutine_local::set(int key, void* value) noexcept;
+
+    // 热数据第一行：链表节点 (基类) 之后是调度和切换读写的状态
+    StackBinding* caller_ = nullptr;        ///< 最近一次恢复本协程的调用者
+    Coroutine* resumer_ = nullptr;          ///< 恢复本协程的协程 (线程本身为空)
+    Scheduler* scheduler_ = nullptr;        ///< 拥有本协程的调度器
+    size_t resume_count_ = 0;               ///< 恢复次数
+    CoroutineState state_ = CoroutineState::READY;  ///< 协程状态
+    bool save_fpu_;                         ///< 切换时是否保存FPU状态
+    std::atomic<uint8_t> wake_state_{0};    ///< 多线程调度器的挂起/唤醒状态
+    bool local_hooks_ = false;              ///< locals_ 中是否有带切换钩子的值 (locals_.has_hooks() 的热副本)
+    SchedulingClass scheduling_class_;      ///< 调度类 (决定进入哪个就绪队列)
+    uint64_t deadline_;                     ///< 截止时刻 (毫秒，0 表示没有；入队排序时读取)
+
+    // 热数据第二、三行：通用寄存器独占一行，随后是栈绑定
+    alignas(64) FastContext context_;       ///< 协程上下文
+    StackBinding binding_;                  ///< 上下文与栈的绑定
+
+    // 冷数据：创建、结束、复用和睡眠时才访问
+    CoroutineFunction function_;            ///< 入口函数
+    std::exception_ptr exception_;          ///< 未捕获的异常
+    StackAllocator* stack_allocator_;       ///< 栈的来源 (默认为创建线程的 local() 实例，混合栈策略时为空)
+    HybridStackAllocator* hybrid_;          ///< 混合栈分配器
+    StackUsage* stack_usage_;               ///< 栈用量画像
+    CoroutinePool* pool_ = nullptr;         ///< 借出本协程的协程池 (销毁时归还)
+    uint64_t id_;                           ///< 协程ID
+    alignas(64) LocalStorage locals_;       ///< 协程局部存储 (独占一行)
+    TimerNode timer_;                       ///< 睡眠和等待超时使用的定时器节点
+    // 运行指标字段不随 LIBCO_OOP_METRICS 增减，只有开启时才更新
+    uint64_t run_cycles_ = 0;               ///< 累计运行周期数
+    uint64_t switched_in_at_ = 0;           ///< 最近一次切入时的周期计数
+    size_t max_stack_depth_ = 0;            ///< 切出时采样的最大栈深度
+
+    Coroutine(CoroutineFunction&& fn, const CoroutineOptions& opts) noexcept;
+    ~Coroutine() noexcept;
+
+    /**
+     * @brief 恢复协程，返回最终切换回调用者的协程
+     *
+     * 经过 yield_to() 的对称切换后，切换回来的可能是另一个协程。
+     * 不重新抛出异常。调用者负责保证协程可恢复。
+     */
+    Coroutine* switch_in() noexcept;
+
+    bool is_resumable() const noexcept
+    {
+        return state_ == CoroutineState::READY || state_ == CoroutineState::SUSPENDED;
+    }
+
+    bool attach_stack(const CoroutineOptions& opts) noexcept;
+    void prepare_entry() noexcept;
+    void release_stack() noexcept;
+    void record_stack_usage() noexcept;
+    void record_switch_in() noexcept;
+    void record_switch_out() noexcept;
+    void clear_locals() noexcept;
+
+    /**
+     * @brief 执行权从 from 转移到 to 之前调用协程局部存储的切换钩子 (空指针代表线程本身)
+     */
+    static void switch_locals(Coroutine* from, Coroutine* to) noexcept;
+
+    static void entry_point();
+};
+
+/**
+ * @brief 一批尚未交给调度器的协程
+ *
+ * 批量派生先在一次遍历中创建所有协程 (控制块和栈都来自每线程的池)，
+ * 再由调度器的 submit_batch() 一次接入就绪队列，而不是逐个入队。
+ * 析构时销毁仍留在批次中的协程。
+ */
+class CoroutineBatch {
+public:
+    CoroutineBatch() noexcept = default;
+    ~CoroutineBatch() noexcept { clear(); }
+
+    CoroutineBatch(const CoroutineBatch&) = delete;
+    CoroutineBatch& operator=(const CoroutineBatch&) = delete;
+
+    /**
+     * @brief 创建协程并加入批次
+     * @return bool 创建失败时返回 false
+     */
+    template <typename F>
+    bool add(F&& fn, const CoroutineOptions& opts = CoroutineOptions{})
+    {
+        return push(Coroutine::create(std::forward<F>(fn), opts));
+    }
+
+    /**
+     * @brief 为 [begin, end) 中的每个元素创建一个运行 fn(element) 的协程
+     * @return bool 任一协程创建失败时返回 false (已创建的留在批次中)
+     *
+     * 每个协程持有 fn 和元素的副本。
+     */
+    template <typename Iterator, typename F>
+    bool add_each(Iterator begin, Iterator end, const F& fn, const CoroutineOptions& opts = CoroutineOptions{})
+    {
+        using Value = typename std::iterator_traits<Iterator>::value_type;
+        for (; begin != end; ++begin) {
+            if (!add([fn, value = Value(*begin)]() mutable { fn(value); }, opts)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief 把已创建的协程加入批次
+     * @return bool coroutine 为空时返回 false
+     */
+    bool push(CoroutinePtr coroutine) noexcept
+    {
+        if (!coroutine) {
+            return false;
+        }
+        coroutines_.push_back(coroutine.release());
+        return true;
+    }
+
+    /**
+     * @brief 销毁批次中的所有协程
+     */
+    void clear() noexcept
+    {
+        while (Coroutine* coroutine = coroutines_.pop_front()) {
+            CoroutineDeleter()(coroutine);
+        }
+    }
+
+    size_t size() const noexcept { return coroutines_.size(); }
+    bool empty() const noexcept { return coroutines_.empty(); }
+
+private:
+    friend class Scheduler;
+    friend class WorkStealingScheduler;
+
+    IntrusiveList<Coroutine> coroutines_;   ///< 批次中的协程
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_COROUTINE_H
@@ -0,0 +1,221 @@
+/**
+ * @file coroutine_local.h
+ * @brief 协程局部存储
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 多个协程复用同一线程时 thread_local 变量会在协程之间共享，
+ * 请求上下文、分配器缓存和跟踪 span 需要跟随协程而不是线程：
+ * - 键在进程内注册一次 (create_key())，对应一个固定的槽位序号
+ * - 值存放在协程控制块内的小数组中，前 kInlineSlots 个键的访问只是
+ *   一次当前协程读取加一次槽位读取；序号更大的键在首次写入时分配溢出数组
+ * - 不在协程中 (线程本身) 时访问线程自己的一份存储
+ * - 协程结束、复用或销毁时对非空的值调用键的析构函数，线程退出时同样处理线程自己的值
+ *
+ * 每个键可以带一个切换钩子，执行权在两个上下文 (协程或线程本身) 之间
+ * 转移时以双方的值调用，用于让 jemalloc tcache 这类每线程缓存跟随协程。
+ * 只有设置过带钩子的键的上下文参与切换时才调用钩子，其余切换只多一次标志判断。
+ *
+ * CoroutineLocal<T> 是对应 libco CO_ROUTINE_SPECIFIC 的类型化封装。
+ */
+
+#ifndef LIBCO_OOP_COROUTINE_LOCAL_H
+#define LIBCO_OOP_COROUTINE_LOCAL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace libco_oop {
+
+namespace coroutine_local {
+
+/// 键的最大数量 (与 PTHREAD_KEYS_MAX 相同)
+constexpr size_t kMaxKeys = 1024;
+
+/// 控制块内联存储的槽位数
+constexpr size_t kInlineSlots = 6;
+
+/// 值的析构函数，只对非空的值调用
+using Destructor = void (*)(void* value);
+
+/**
+ * @brief 切换钩子
+ * @param from 让出执行权的上下文中该键的值
+ * @param to 得到执行权的上下文中该键的值
+ *
+ * 双方的值都为空时不调用。钩子在切换之前运行，运行时当前协程仍是让出的一方。
+ */
+using SwitchHook = void (*)(void* from, void* to);
+
+/**
+ * @brief 注册一个键
+ * @param destructor 值的析构函数，可以为空
+ * @param on_switch 切换钩子，可以为空
+ * @return int 键的槽位序号；键已用尽时返回 -1 并设置 errno 为 EAGAIN
+ *
+ * 键不能注销。
+ */
+int create_key(Destructor destructor = nullptr, SwitchHook on_switch = nullptr) noexcept;
+
+/**
+ * @brief 获取当前协程 (不在协程中时为线程本身) 中键的值
+ * @return void* 未设置或键无效时返回 nullptr
+ */
+void* get(int key) noexcept;
+
+/**
+ * @brief 设置当前协程 (不在协程中时为线程本身) 中键的值
+ * @return bool 键无效时返回 false 并设置 errno 为 EINVAL；分配溢出数组失败时设置 ENOMEM
+ *
+ * 不调用旧值的析构函数。
+ */
+bool set(int key, void* value) noexcept;
+
+} // namespace coroutine_local
+
+/**
+ * @brief 一个上下文 (协程或线程本身) 的局部存储
+ *
+ * 内嵌在协程控制块中，大小为一个缓存行。
+ */
+class LocalStorage {
+public:
+    LocalStorage() noexcept = default;
+    ~LocalStorage() noexcept;
+
+    LocalStorage(const LocalStorage&) = delete;
+    LocalStorage& operator=(const LocalStorage&) = delete;
+
+    /**
+     * @brief 获取槽位中的值
+     */
+    void* get(size_t key) const noexcept
+    {
+        if (key < coroutine_local::kInlineSlots) {
+            return inline_[key];
+        }
+        const size_t index = key - coroutine_local::kInlineSlots;
+        return index < overflow_capacity_ ? overflow_[index] : nullptr;
+    }
+
+    /**
+     * @brief 设置槽位中的值
+     * @return bool 分配溢出数组失败时返回 false
+     */
+    bool set(size_t key, void* value) noexcept;
+
+    /**
+     * @brief 对所有非空的值调用键的析构函数并清空
+     *
+     * 析构函数中设置的新值会在下一轮中继续清理，最多 4 轮 (与 pthread 相同)。
+     * 保留溢出数组供复用的协程使用。从未设置过值时只有一次标志判断。
+     */
+    void clear() noexcept
+    {
+        if (has_values_) {
+            clear_values();
+        }
+    }
+
+    /**
+     * @brief 是否设置过带切换钩子的键 (clear() 之后重新计算)
+     */
+    bool has_hooks() const noexcept { return has_hooks_; }
+
+private:
+    void clear_values() noexcept;
+
+    void* inline_[coroutine_local::kInlineSlots] = {};  ///< 内联槽位
+    void** overflow_ = nullptr;                         ///< 溢出槽位 (首次写入时分配)
+    uint32_t overflow_capacity_ = 0;                    ///< 溢出槽位数
+    bool has_values_ = false;                           ///< 是否设置过非空的值
+    bool has_hooks_ = false;                            ///< 是否设置过带切换钩子的键
+};
+
+static_assert(sizeof(LocalStorage) <= 64, "local storage should fit in one cache line");
+
+namespace coroutine_local {
+namespace detail {
+
+/**
+ * @brief 键是否已注册
+ */
+bool is_valid_key(int key) noexcept;
+
+/**
+ * @brief 以双方的值调用所有带钩子的键的切换钩子
+ */
+void run_switch_hooks(const LocalStorage& from, const LocalStorage& to) noexcept;
+
+} // namespace detail
+} // namespace coroutine_local
+
+/**
+ * @brief 类型化的协程局部变量
+ *
+ * 每个上下文在首次 get() 时默认构造一份 T，随上下文结束析构。
+ * 键不能注销，应定义为静态对象 (与 thread_local 变量的用法相同)。
+ *
+ * @code
+ * static CoroutineLocal<RequestContext> request_context;
+ * request_context.get()->trace_id = id;
+ * @endcode
+ */
+template <typename T>
+class CoroutineLocal {
+public:
+    /**
+     * @param on_switch 切换钩子，以双方的 T* 调用 (可能为空指针)
+     */
+    explicit CoroutineLocal(coroutine_local::SwitchHook on_switch = nullptr) noexcept
+        : key_(coroutine_local::create_key(&destroy, on_switch))
+    {
+    }
+
+    CoroutineLocal(const CoroutineLocal&) = delete;
+    CoroutineLocal& operator=(const CoroutineLocal&) = delete;
+
+    /**
+     * @brief 获取当前上下文的值，首次访问时默认构造
+     * @return T* 键注册失败或存储分配失败时返回 nullptr
+     */
+    T* get()
+    {
+        if (T* value = peek()) {
+            return value;
+        }
+        if (key_ < 0) {
+            return nullptr;
+        }
+        T* value = new T();
+        if (!coroutine_local::set(key_, value)) {
+            delete value;
+            return nullptr;
+        }
+        return value;
+    }
+
+    /**
+     * @brief 获取当前上下文的值，不构造
+     * @return T* 尚未构造时返回 nullptr
+     */
+    T* peek() const noexcept { return static_cast<T*>(coroutine_local::get(key_)); }
+
+    T* operator->() { return get(); }
+
+    /**
+     * @brief 键是否注册成功
+     */
+    bool valid() const noexcept { return key_ >= 0; }
+
+    int key() const noexcept { return key_; }
+
+private:
+    static void destroy(void* value) noexcept { delete static_cast<T*>(value); }
+
+    int key_;   ///< 槽位序号
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_COROUTINE_LOCAL_H
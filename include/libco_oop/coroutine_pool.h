@@ -0,0 +1,180 @@
+/**
+ * @file coroutine_pool.h
+ * @brief 协程池
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 结束的协程不销毁，连同控制块、上下文和已绑定的栈一起留在池中，
+ * 下一个任务通过 Coroutine::reset() 直接复用：
+ * - 栈不经过分配器归还和重新分配，已驻留的页不会再次缺页，
+ *   最近用过的协程最先被复用，它的栈顶还在缓存中
+ * - 池只属于创建它的线程 (local() 提供每线程实例)，栈页始终由同一线程
+ *   首次触及，自然落在该线程所在的 NUMA 节点上
+ * - max_active 限制同时借出的协程数，超出时拒绝而不是无限制地创建
+ * - 空闲协程按低水位收缩：一个收缩周期内始终没有被借出的空闲协程被释放
+ */
+
+#ifndef LIBCO_OOP_COROUTINE_POOL_H
+#define LIBCO_OOP_COROUTINE_POOL_H
+
+#include "libco_oop/coroutine.h"
+#include "libco_oop/intrusive_list.h"
+#include "libco_oop/scheduler.h"
+#include "libco_oop/timer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace libco_oop {
+
+class IOManager;
+
+/**
+ * @brief 协程池选项
+ */
+struct CoroutinePoolOptions {
+    size_t max_idle = 256;              ///< 最多保留的空闲协程数，超出时归还的协程直接销毁
+    size_t min_idle = 0;                ///< 收缩时至少保留的空闲协程数
+    size_t max_active = 0;              ///< 同时借出的协程数上限，0 表示不限制
+    uint64_t shrink_interval_ms = 1000; ///< 收缩定时器的周期 (毫秒)
+    CoroutineOptions coroutine;         ///< 池中没有空闲协程时新建协程的选项
+};
+
+/**
+ * @brief 协程池统计信息
+ */
+struct CoroutinePoolStatistics {
+    uint64_t acquired = 0;      ///< acquire() 成功次数
+    uint64_t hits = 0;          ///< 复用空闲协程的次数
+    uint64_t created = 0;       ///< 池中没有空闲协程而新建的次数
+    uint64_t rejected = 0;      ///< 超过 max_active 被拒绝的次数
+    uint64_t recycled = 0;      ///< 结束后回到池中的协程数
+    uint64_t discarded = 0;     ///< 归还时被销毁的协程数 (池已满或协程不可复用)
+    uint64_t trimmed = 0;       ///< 收缩释放的空闲协程数
+    size_t idle = 0;            ///< 当前空闲协程数
+    size_t active = 0;          ///< 当前借出的协程数
+};
+
+/**
+ * @brief 协程池
+ *
+ * acquire() 借出的协程与 Coroutine::create() 创建的协程用法相同，
+ * 可以直接 resume()，也可以交给调度器；销毁 CoroutinePtr (或调度器
+ * 销毁结束的协程) 时协程回到池中。
+ *
+ * 池不是线程安全的，只能在创建它的线程上调用。借出的协程可以在其他
+ * 线程上销毁 (例如被工作窃取调度器迁移)，这时协程直接销毁，只释放
+ * 并发名额。挂起中被销毁的协程栈上还有未展开的帧，同样不回到池中。
+ *
+ * 池必须比它借出的协程存活更久；使用收缩定时器时，IOManager 析构前
+ * 要先调用 stop_shrink_timer()。
+ */
+class CoroutinePool {
+public:
+    explicit CoroutinePool(const CoroutinePoolOptions& opts = CoroutinePoolOptions{}) noexcept;
+    ~CoroutinePool() noexcept;
+
+    CoroutinePool(const CoroutinePool&) = delete;
+    CoroutinePool& operator=(const CoroutinePool&) = delete;
+
+    /**
+     * @brief 获取当前线程的默认协程池 (默认选项)
+     */
+    static CoroutinePool& local() noexcept;
+
+    /**
+     * @brief 借出一个协程
+     * @param fn 协程入口函数
+     * @return CoroutinePtr 处于 READY 状态的协程；失败返回空指针并设置 errno
+     *         (EAGAIN: 已达到 max_active，ENOMEM: 新建协程失败)
+     */
+    template <typename F>
+    CoroutinePtr acquire(F&& fn)
+    {
+        return acquire_function(CoroutineFunction(std::forward<F>(fn)));
+    }
+
+    /**
+     * @brief 以已包装的入口函数借出协程
+     */
+    CoroutinePtr acquire_function(CoroutineFunction fn) noexcept;
+
+    /**
+     * @brief 借出协程并交给调度器
+     * @return Coroutine* 协程指针 (由调度器拥有)，失败返回 nullptr 并设置 errno
+     */
+    template <typename F>
+    Coroutine* spawn(Scheduler& scheduler, F&& fn)
+    {
+        CoroutinePtr coroutine = acquire(std::forward<F>(fn));
+        if (!coroutine) {
+            return nullptr;
+        }
+        return scheduler.submit(std::move(coroutine));
+    }
+
+    /**
+     * @brief 预先创建空闲协程，直到空闲数达到 count (不超过 max_idle)
+     * @return size_t 实际的空闲协程数
+     */
+    size_t reserve(size_t count) noexcept;
+
+    /**
+     * @brief 收缩一个周期：释放自上次收缩以来始终空闲的协程，至少保留 min_idle 个
+     * @return size_t 释放的协程数
+     */
+    size_t shrink() noexcept;
+
+    /**
+     * @brief 释放所有空闲协程
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief 在 IOManager 上按 shrink_interval_ms 周期调用 shrink()
+     * @param io 与本池在同一线程上的 IOManager
+     * @return bool shrink_interval_ms 为 0 时返回 false
+     *
+     * 定时器只在空闲数超过 min_idle 时等待，池收缩到位后不再阻止
+     * IOManager::run() 返回；之后有协程回到池中时重新启动。
+     */
+    bool start_shrink_timer(IOManager& io) noexcept;
+
+    /**
+     * @brief 停止收缩定时器
+     */
+    void stop_shrink_timer() noexcept;
+
+    size_t get_idle_count() const noexcept { return idle_.size(); }
+    size_t get_active_count() const noexcept { return active_.load(std::memory_order_relaxed); }
+    const CoroutinePoolOptions& get_options() const noexcept { return options_; }
+    CoroutinePoolStatistics get_statistics() const noexcept;
+
+private:
+    friend struct CoroutineDeleter;
+
+    CoroutinePoolOptions options_;          ///< 池选项
+    IntrusiveList<Coroutine> idle_;         ///< 空闲协程，头部最近归还 (最热)
+    size_t idle_low_ = 0;                   ///< 自上次收缩以来空闲数的最小值
+    std::atomic<size_t> active_{0};         ///< 借出的协程数 (其他线程销毁时也会递减)
+    const void* owner_;                     ///< 所属线程的标识
+    IOManager* io_ = nullptr;               ///< 收缩定时器所在的调度器
+    TimerNode shrink_timer_;                ///< 收缩定时器
+    CoroutinePoolStatistics stats_;         ///< 统计信息 (idle/active 在读取时填充)
+
+    /**
+     * @brief 协程销毁时调用，决定协程回到池中还是销毁
+     * @return bool 协程已回到池中时返回 true
+     */
+    bool recycle(Coroutine* coroutine) noexcept;
+
+    void arm_shrink_timer() noexcept;
+    void destroy(Coroutine* coroutine) noexcept;
+
+    static void on_shrink_timer(TimerNode* node);
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_COROUTINE_POOL_H
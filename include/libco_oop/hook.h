@@ -0,0 +1,52 @@
+/**
+ * @file hook.h
+ * @brief 阻塞系统调用接管 (符号插桩)
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 链接 libco_oop_hook 后，以下 libc 函数被同名符号覆盖，真实实现通过
+ * dlsym(RTLD_NEXT) 获取：
+ *   read, write, recv, send, connect, accept, poll, nanosleep, usleep
+ * 以及维护 fd 状态所需的 close, fcntl。
+ *
+ * 在 IOManager 的协程中调用时，会阻塞的调用变为非阻塞调用加挂起：
+ * - 用户未设置 O_NONBLOCK 的套接字/管道在首次使用时被内部设为非阻塞，
+ *   fcntl(F_GETFL) 对用户隐藏该标志，协程外对它的调用仍保持阻塞语义
+ * - 用户自己设置了 O_NONBLOCK 的 fd 和普通文件直接透传
+ * - 睡眠和 poll 超时由 IOManager 的时间轮实现
+ *
+ * 其他上下文 (普通线程、非 IOManager 调度器、本线程已禁用) 直接透传，
+ * 透传判断只读取线程局部变量，开销为几纳秒。
+ */
+
+#ifndef LIBCO_OOP_HOOK_H
+#define LIBCO_OOP_HOOK_H
+
+namespace libco_oop {
+
+class IOManager;
+
+/**
+ * @brief 系统调用接管控制
+ */
+namespace syscall_hook {
+    /**
+     * @brief 启用或禁用当前线程的接管 (默认启用)
+     */
+    void set_enabled(bool enabled) noexcept;
+
+    /**
+     * @brief 当前线程是否启用接管
+     */
+    bool is_enabled() noexcept;
+
+    /**
+     * @brief 此刻的系统调用会被接管到哪个 IOManager
+     * @return IOManager* 不在 IOManager 的协程中或已禁用时返回 nullptr
+     */
+    IOManager* active_manager() noexcept;
+}
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_HOOK_H
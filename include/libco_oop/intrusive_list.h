@@ -0,0 +1,218 @@
+/**
+ * @file intrusive_list.h
+ * @brief 侵入式双向链表
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 链表节点嵌入在元素自身中 (例如协程控制块)，入队和出队都不分配内存，
+ * 任意位置的删除是 O(1)。一个节点同一时刻只能位于一个链表中。
+ */
+
+#ifndef LIBCO_OOP_INTRUSIVE_LIST_H
+#define LIBCO_OOP_INTRUSIVE_LIST_H
+
+#include <cstddef>
+
+namespace libco_oop {
+
+/**
+ * @brief 侵入式链表节点
+ *
+ * 元素类继承此节点即可放入 IntrusiveList。未链接时 prev/next 为空。
+ */
+struct IntrusiveListNode {
+    IntrusiveListNode* prev = nullptr;  ///< 前一个节点
+    IntrusiveListNode* next = nullptr;  ///< 后一个节点
+
+    /**
+     * @brief 节点是否在某个链表中
+     */
+    bool is_linked() const noexcept { return next != nullptr; }
+};
+
+/**
+ * @brief 侵入式双向循环链表
+ * @tparam T 元素类型，必须 (可以私有地) 继承 IntrusiveListNode
+ *
+ * 链表不拥有元素，析构时只断开链接。
+ */
+template <typename T>
+class IntrusiveList {
+public:
+    IntrusiveList() noexcept
+    {
+        head_.prev = &head_;
+        head_.next = &head_;
+    }
+
+    ~IntrusiveList() noexcept
+    {
+        clear();
+    }
+
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    bool empty() const noexcept { return head_.next == &head_; }
+    size_t size() const noexcept { return size_; }
+
+    /**
+     * @brief 获取首元素
+     * @return T* 链表为空时返回 nullptr
+     */
+    T* front() const noexcept
+    {
+        return empty() ? nullptr : to_element(head_.next);
+    }
+
+    /**
+     * @brief 获取尾元素
+     * @return T* 链表为空时返回 nullptr
+     */
+    T* back() const noexcept
+    {
+        return empty() ? nullptr : to_element(head_.prev);
+    }
+
+    void push_back(T* element) noexcept
+    {
+        link_before(&head_, to_node(element));
+    }
+
+    void push_front(T* element) noexcept
+    {
+        link_before(head_.next, to_node(element));
+    }
+
+    /**
+     * @brief 有序插入：从尾部向前越过所有比 element 大的元素
+     * @param less 严格弱序比较 less(a, b)
+     *
+     * 相等的元素保持插入顺序。新元素通常排在末尾时 (例如按固定超时计算的
+     * 截止时刻) 为 O(1)，最坏为 O(n)。
+     */
+    template <typename Less>
+    void insert_sorted(T* element, Less&& less) noexcept
+    {
+        IntrusiveListNode* position = &head_;
+        while (position->prev != &head_ && less(element, to_element(position->prev))) {
+            position = position->prev;
+        }
+        link_before(position, to_node(element));
+    }
+
+    /**
+     * @brief 取出首元素
+     * @return T* 链表为空时返回 nullptr
+     */
+    T* pop_front() noexcept
+    {
+        if (empty()) {
+            return nullptr;
+        }
+        IntrusiveListNode* node = head_.next;
+        unlink(node);
+        return to_element(node);
+    }
+
+    /**
+     * @brief 取出尾元素
+     * @return T* 链表为空时返回 nullptr
+     */
+    T* pop_back() noexcept
+    {
+        if (empty()) {
+            return nullptr;
+        }
+        IntrusiveListNode* node = head_.prev;
+        unlink(node);
+        return to_element(node);
+    }
+
+    /**
+     * @brief 从链表中删除元素 (元素必须在本链表中)
+     */
+    void remove(T* element) noexcept
+    {
+        unlink(to_node(element));
+    }
+
+    /**
+     * @brief 把 other 的全部元素整体接到本链表末尾，O(1)
+     */
+    void splice_back(IntrusiveList& other) noexcept
+    {
+        if (other.empty()) {
+            return;
+        }
+        IntrusiveListNode* first = other.head_.next;
+        IntrusiveListNode* last = other.head_.prev;
+
+        first->prev = head_.prev;
+        head_.prev->next = first;
+        last->next = &head_;
+        head_.prev = last;
+        size_ += other.size_;
+
+        other.head_.prev = &other.head_;
+        other.head_.next = &other.head_;
+        other.size_ = 0;
+    }
+
+    /**
+     * @brief 断开所有元素
+     */
+    void clear() noexcept
+    {
+        while (!empty()) {
+            unlink(head_.next);
+        }
+    }
+
+    /**
+     * @brief 依次访问每个元素 (访问期间不能修改链表)
+     */
+    template <typename F>
+    void for_each(F&& fn) const
+    {
+        for (IntrusiveListNode* node = head_.next; node != &head_; node = node->next) {
+            fn(to_element(node));
+        }
+    }
+
+private:
+    IntrusiveListNode head_;            ///< 哨兵节点
+    size_t size_ = 0;                   ///< 元素数量
+
+    static IntrusiveListNode* to_node(T* element) noexcept
+    {
+        return static_cast<IntrusiveListNode*>(element);
+    }
+
+    static T* to_element(IntrusiveListNode* node) noexcept
+    {
+        return static_cast<T*>(node);
+    }
+
+    void link_before(IntrusiveListNode* position, IntrusiveListNode* node) noexcept
+    {
+        node->prev = position->prev;
+        node->next = position;
+        position->prev->next = node;
+        position->prev = node;
+        ++size_;
+    }
+
+    void unlink(IntrusiveListNode* node) noexcept
+    {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        node->prev = nullptr;
+        node->next = nullptr;
+        --size_;
+    }
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_INTRUSIVE_LIST_H
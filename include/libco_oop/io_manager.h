@@ -0,0 +1,392 @@
+/**
+ * @file io_manager.h
+ * @brief IO事件驱动调度器 (epoll / io_uring 后端)
+ * @author libco-oop
+ * @version 1.1
+ *
+ * IOManager 继承 Scheduler，把IO多路复用集成进调度循环。后端在构造时选择：
+ *
+ * epoll (就绪通知):
+ * - 每个 fd 只注册一次，边缘触发，同时关注读写
+ * - 等待者保存在按 fd 下标索引的平坦表中 (每个 fd 一个读者槽、一个写者槽)
+ * - 每次 epoll_wait 批量收集事件，唤醒等待的协程，不分配内存
+ *
+ * 边缘触发下事件只通知一次：没有等待者时事件记录为就绪标志，
+ * 下一次 wait_for() 直接返回，调用者重试系统调用。
+ *
+ * io_uring (完成通知):
+ * - IO辅助函数直接准备提交队列项后挂起，请求记录在协程栈上，不分配内存
+ * - 提交队列项在调度 tick 或空闲时一次性批量提交
+ * - 完成队列在用户态直接收集，只有空闲等待时才进入内核
+ * - 支持注册缓冲区 (read_fixed/write_fixed) 和固定文件 (FixedFile)
+ *
+ * readv/writev/recvmsg/sendmsg 和 BufferChain 重载直接在缓冲区链的块上
+ * 分散读、聚集写，数据从一个套接字转发到另一个套接字时不经过拷贝。
+ *
+ * 两种后端共用一个分层时间轮：等待时的超时取自下一个非空槽位，
+ * 协程睡眠 (co_sleep) 和等待超时使用协程控制块内嵌的定时器节点。
+ *
+ * 其他线程通过 unpark() 唤醒 park() 挂起的协程：唤醒请求压入无锁栈，
+ * 用一个 eventfd 通知调度循环；调度循环处理之前的多次唤醒只写一次 eventfd。
+ */
+
+#ifndef LIBCO_OOP_IO_MANAGER_H
+#define LIBCO_OOP_IO_MANAGER_H
+
+#include "libco_oop/scheduler.h"
+#include "libco_oop/buffer.h"
+#include "libco_oop/intrusive_list.h"
+#include "libco_oop/timer.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace libco_oop {
+
+class IoUringRing;
+
+/**
+ * @brief IO事件类型
+ */
+enum class IOEventType {
+    READ,   ///< 可读 (包括对端关闭和错误)
+    WRITE,  ///< 可写 (包括错误)
+    ERROR   ///< 错误队列非空 (例如 MSG_ZEROCOPY 的完成通知)；epoll 后端与 WRITE 共用等待槽，
+            ///< 可能因可写而提前返回
+};
+
+/**
+ * @brief IO后端类型
+ */
+enum class IOBackend {
+    EPOLL,      ///< epoll 边缘触发
+    IO_URING,   ///< io_uring，内核不支持时 is_valid() 为 false
+    AUTO        ///< 优先 io_uring，不支持时回退到 epoll
+};
+
+/**
+ * @brief IOManager 选项
+ */
+struct IOManagerOptions {
+    size_t max_events = 256;        ///< 每次 epoll_wait 收集的最大事件数
+    size_t initial_fds = 1024;      ///< fd 表的初始容量
+    IOBackend backend = IOBackend::EPOLL;
+    unsigned uring_entries = 256;   ///< io_uring 提交队列深度
+};
+
+/**
+ * @brief io_uring 固定文件表中的下标 (见 IOManager::register_files())
+ */
+struct FixedFile {
+    unsigned index;
+};
+
+/**
+ * @brief IOManager 统计信息
+ */
+struct IOStatistics {
+    uint64_t registrations = 0;     ///< epoll_ctl(ADD) 次数
+    uint64_t polls = 0;             ///< epoll_wait / io_uring_enter 调用次数
+    uint64_t events = 0;            ///< 收集到的事件数 (epoll 事件或完成队列项)
+    uint64_t submissions = 0;       ///< 准备的 io_uring 提交队列项数
+    uint64_t wakeups = 0;           ///< 因IO事件唤醒的协程数
+    uint64_t timeouts = 0;          ///< 到期的定时器数
+    uint64_t remote_wakeups = 0;    ///< 处理的跨线程唤醒数
+    uint64_t wakeup_signals = 0;    ///< 写 eventfd 的次数 (合并后的跨线程通知)
+    size_t waiting = 0;             ///< 当前等待IO的协程数
+    size_t sleeping = 0;            ///< 当前睡眠的协程数
+    size_t parked = 0;              ///< 当前 park() 挂起的协程数
+};
+
+class IOManager;
+
+/**
+ * @brief 跨线程唤醒节点，位于 park() 挂起的协程栈上
+ *
+ * 等待者先构造节点并发布给唤醒者，再调用 park()；唤醒者 (任意线程) 调用
+ * IOManager::unpark()。节点在 IOManager 线程上投递后等待者才会返回。
+ */
+struct RemoteWakeup : IntrusiveListNode {
+    IOManager* manager = nullptr;       ///< 等待者所在的 IOManager，不能 park() 时为空
+    Coroutine* coroutine = nullptr;     ///< 等待的协程
+    RemoteWakeup* link = nullptr;       ///< 跨线程投递栈的链接
+    bool delivered = false;             ///< 已在 IOManager 线程上投递
+
+    /**
+     * @brief 绑定当前上下文：在 IOManager 拥有的协程中时 manager 为该 IOManager
+     */
+    RemoteWakeup() noexcept;
+};
+
+/**
+ * @brief IO事件驱动调度器
+ *
+ * epoll 后端中协程的IO调用先尝试非阻塞系统调用，遇到 EAGAIN 时用
+ * wait_for() 挂起，事件就绪后由调度循环唤醒并重试。fd 必须是非阻塞的。
+ *
+ * io_uring 后端中协程的IO调用直接成为提交队列项，完成后唤醒协程并
+ * 返回结果；不在协程中时与 epoll 后端一样直接执行非阻塞系统调用。
+ *
+ * 关闭 fd 前必须调用 remove_fd() (或使用 close())，否则 fd 号被复用后
+ * 表项仍处于已注册状态。
+ */
+class IOManager : public Scheduler {
+public:
+    explicit IOManager(const IOManagerOptions& opts = IOManagerOptions{});
+    ~IOManager() noexcept override;
+
+    /**
+     * @brief 获取当前线程正在运行的 IOManager
+     * @return IOManager* 当前调度器不是 IOManager 时返回 nullptr
+     */
+    static IOManager* current() noexcept;
+
+    /**
+     * @brief 后端实例是否创建成功
+     */
+    bool is_valid() const noexcept { return (epoll_fd_ >= 0 || ring_ != nullptr) && wakeup_fd_ >= 0; }
+
+    /**
+     * @brief 实际使用的后端 (AUTO 解析后的结果)
+     */
+    IOBackend get_backend() const noexcept { return ring_ ? IOBackend::IO_URING : IOBackend::EPOLL; }
+
+    /**
+     * @brief 挂起当前协程，直到 fd 上的事件就绪
+     * @param fd 非阻塞文件描述符
+     * @param type 等待的事件类型
+     * @param timeout_ms 超时 (毫秒)，负数表示不超时
+     * @return int 成功返回 0；失败返回 -1 并设置 errno
+     *         (EPERM: 不在本调度器的协程中，EBUSY: 已有协程在等待同一事件，
+     *          ECANCELED: 等待期间 fd 被 remove_fd()，ETIMEDOUT: 超时)
+     *
+     * io_uring 后端使用 IORING_OP_POLL_ADD，不检查 EBUSY。
+     */
+    int wait_for(int fd, IOEventType type, int64_t timeout_ms = -1) noexcept;
+
+    /**
+     * @brief 当前协程睡眠 ms 毫秒，期间调度其他协程
+     * @return int 成功返回 0；不在本调度器的协程中返回 -1 (EPERM)
+     *
+     * ms 为 0 时等价于 Scheduler::yield()。
+     */
+    int sleep_for(uint64_t ms) noexcept;
+
+    /**
+     * @brief 在 delay_ms 毫秒后调用 node->callback (在调度循环中)
+     * @return bool 节点已在等待或没有回调时返回 false
+     *
+     * 有定时器等待时 run() 不会返回。
+     */
+    bool add_timer(TimerNode* node, uint64_t delay_ms) noexcept;
+
+    /**
+     * @brief 取消定时器，O(1)
+     * @return bool 定时器已到期或未添加时返回 false
+     */
+    bool cancel_timer(TimerNode* node) noexcept;
+
+    /**
+     * @brief 挂起当前协程，直到 unpark(&node) 在本线程上投递
+     * @param node 在当前协程中构造、manager 为本调度器的节点
+     * @return int 成功返回 0；node 不属于当前协程时返回 -1 (EPERM)
+     *
+     * 有协程 park() 时 run() 不会返回。
+     */
+    int park(RemoteWakeup& node) noexcept;
+
+    /**
+     * @brief 唤醒 park() 挂起 (或即将挂起) 的协程，任意线程可调用
+     *
+     * 在 node->manager 的调度循环中调用时直接唤醒；否则压入跨线程栈，
+     * 调度循环取走之前的后续唤醒不再写 eventfd。调用返回后不再访问 node，
+     * 但 node->manager 必须仍然存活。
+     */
+    static void unpark(RemoteWakeup* node) noexcept;
+
+    /**
+     * @brief 获取时间轮 (例如按绝对时刻添加定时器)
+     */
+    TimerManager& get_timer_manager() noexcept { return timers_; }
+
+    /**
+     * @brief 取消 fd 的注册，唤醒其上的等待者 (返回 ECANCELED)
+     * @return bool fd 未注册时返回 false；io_uring 后端在 fd 上没有未完成请求时返回 false
+     */
+    bool remove_fd(int fd) noexcept;
+
+    /**
+     * @brief 非阻塞IO辅助函数
+     *
+     * 语义与同名系统调用相同；在本调度器的协程中遇到 EAGAIN 时挂起
+     * 等待就绪后重试，在其他上下文中直接返回系统调用的结果。
+     */
+    ssize_t read(int fd, void* buffer, size_t length) noexcept;
+    ssize_t write(int fd, const void* buffer, size_t length) noexcept;
+    ssize_t recv(int fd, void* buffer, size_t length, int flags) noexcept;
+    ssize_t send(int fd, const void* buffer, size_t length, int flags) noexcept;
+    int accept(int fd, sockaddr* address, socklen_t* length) noexcept;
+    int connect(int fd, const sockaddr* address, socklen_t length) noexcept;
+    ssize_t readv(int fd, const iovec* iov, int count) noexcept;
+    ssize_t writev(int fd, const iovec* iov, int count) noexcept;
+    ssize_t recvmsg(int fd, msghdr* message, int flags) noexcept;
+    ssize_t sendmsg(int fd, const msghdr* message, int flags) noexcept;
+
+    /**
+     * @brief 把最多 length 字节直接读入 chain 末尾的块 (一次 readv)
+     * @param length 最多读取的字节数，0 表示一块
+     * @return ssize_t 读取的字节数，对端关闭时为 0；失败返回 -1 并设置 errno
+     *         (分配块失败时为 ENOMEM)
+     */
+    ssize_t read(int fd, BufferChain& chain, size_t length = 0) noexcept;
+
+    /**
+     * @brief 把 chain 的全部数据聚集写出，写出的部分从 chain 中消费
+     * @return ssize_t 写出的字节数；失败返回 -1 并设置 errno，chain 中保留未写出的数据
+     *
+     * 部分写入时在协程中等待可写后继续，直到 chain 为空。
+     */
+    ssize_t write(int fd, BufferChain& chain) noexcept;
+
+    /**
+     * @brief 固定文件上的读写 (仅 io_uring 后端，需在本调度器的协程中)
+     * @return ssize_t 失败返回 -1 并设置 errno (EOPNOTSUPP: epoll 后端，
+     *         EPERM: 不在协程中)
+     */
+    ssize_t read(FixedFile file, void* buffer, size_t length) noexcept;
+    ssize_t write(FixedFile file, const void* buffer, size_t length) noexcept;
+
+    /**
+     * @brief 在注册缓冲区上读写，内核直接使用已固定的页面
+     * @param fd 文件描述符
+     * @param buffer 必须位于第 buffer_index 个注册缓冲区内
+     * @param buffer_index register_buffers() 中的下标
+     * @param offset 文件偏移，-1 表示当前位置 (流式 fd 必须为 -1)
+     * @return ssize_t 与 read_fixed/write_fixed 相同的约束和错误码
+     */
+    ssize_t read_fixed(int fd, void* buffer, size_t length, unsigned buffer_index,
+                       int64_t offset = -1) noexcept;
+    ssize_t write_fixed(int fd, const void* buffer, size_t length, unsigned buffer_index,
+                        int64_t offset = -1) noexcept;
+    ssize_t read_fixed(FixedFile file, void* buffer, size_t length, unsigned buffer_index,
+                       int64_t offset = -1) noexcept;
+    ssize_t write_fixed(FixedFile file, const void* buffer, size_t length, unsigned buffer_index,
+                        int64_t offset = -1) noexcept;
+
+    /**
+     * @brief 注册/注销固定缓冲区 (同一时间只能有一组)
+     * @return bool epoll 后端或内核拒绝时返回 false 并设置 errno
+     */
+    bool register_buffers(const iovec* buffers, unsigned count) noexcept;
+    bool unregister_buffers() noexcept;
+
+    /**
+     * @brief 注册/更新/注销固定文件表
+     *
+     * update_files() 中 fd 为 -1 的项表示清空该位置。
+     * @return bool epoll 后端或内核拒绝时返回 false 并设置 errno
+     */
+    bool register_files(const int* fds, unsigned count) noexcept;
+    bool update_files(unsigned offset, const int* fds, unsigned count) noexcept;
+    bool unregister_files() noexcept;
+
+    /**
+     * @brief remove_fd() 后关闭 fd
+     */
+    int close(int fd) noexcept;
+
+    /**
+     * @brief 把 fd 设为非阻塞
+     * @return bool 失败时返回 false
+     */
+    static bool set_nonblocking(int fd) noexcept;
+
+    IOStatistics get_statistics() const noexcept;
+
+protected:
+    bool idle() override;
+    void tick() override;
+
+private:
+    /**
+     * @brief fd 表项
+     */
+    struct FdSlot {
+        Coroutine* reader = nullptr;    ///< 等待可读的协程
+        Coroutine* writer = nullptr;    ///< 等待可写的协程
+        uint32_t generation = 0;        ///< remove_fd() 时递增，过滤过期事件
+        bool registered = false;        ///< 是否已加入 epoll
+        bool read_ready = false;        ///< 无等待者时到达的可读事件
+        bool write_ready = false;       ///< 无等待者时到达的可写事件
+    };
+
+    struct UringOp;
+    struct UringRequest;
+
+    int epoll_fd_ = -1;
+    std::vector<FdSlot> fds_;                   ///< 按 fd 索引
+    std::vector<epoll_event> events_;           ///< epoll_wait 的输出缓冲
+    size_t waiting_ = 0;                        ///< 等待IO的协程数
+    IOStatistics stats_;
+
+    std::unique_ptr<IoUringRing> ring_;         ///< io_uring 后端，epoll 后端时为空
+    IntrusiveList<UringRequest> in_flight_;     ///< 已准备但尚未完成的请求
+    struct UringTimespec {                      ///< 与 __kernel_timespec 布局相同
+        int64_t tv_sec;
+        long long tv_nsec;
+    };
+    UringTimespec uring_timespec_{};
+    uint64_t uring_timeout_deadline_ = 0;       ///< 已提交的 IORING_OP_TIMEOUT 的到期时刻
+    bool uring_timeout_armed_ = false;          ///< 是否有未完成的 IORING_OP_TIMEOUT
+    bool uring_wakeup_armed_ = false;           ///< eventfd 上是否有未完成的 IORING_OP_POLL_ADD
+    bool uring_wakeup_fired_ = false;           ///< 本次收集中 eventfd 已就绪
+
+    TimerManager timers_;                       ///< 时间轮
+    size_t sleeping_ = 0;                       ///< 睡眠的协程数
+
+    int wakeup_fd_ = -1;                        ///< 跨线程唤醒的 eventfd
+    IntrusiveList<RemoteWakeup> parked_;        ///< park() 挂起的协程
+    alignas(64) std::atomic<RemoteWakeup*> remote_head_{nullptr};   ///< 其他线程投递的唤醒
+    std::atomic<bool> remote_signaled_{false};  ///< eventfd 已写入且尚未处理
+    std::atomic<uint64_t> wakeup_signals_{0};
+
+    friend struct RemoteWakeup;
+
+    bool owns_current() const noexcept;
+    FdSlot* acquire_slot(int fd) noexcept;
+    size_t poll(int timeout_ms) noexcept;
+    void wake(Coroutine*& waiter) noexcept;
+    int64_t poll_timeout() noexcept;
+    void expire_timers() noexcept;
+    void deliver(RemoteWakeup* node) noexcept;
+    void post_remote(RemoteWakeup* node) noexcept;
+    size_t drain_remote() noexcept;
+    void uring_arm_wakeup() noexcept;
+
+    static void wake_sleeper(TimerNode* node);
+    static void wake_waiter(TimerNode* node);
+    static void cancel_request(TimerNode* node);
+
+    ssize_t uring_execute(const UringOp& op, int64_t timeout_ms = -1) noexcept;
+    void uring_arm_timeout(uint64_t deadline) noexcept;
+    bool uring_cancel(const UringRequest* target) noexcept;
+    size_t uring_reap() noexcept;
+    size_t uring_poll(bool wait) noexcept;
+    bool uring_register(unsigned opcode, const void* arg, unsigned count) noexcept;
+};
+
+/**
+ * @brief 当前协程睡眠 ms 毫秒 (IOManager::current()->sleep_for(ms))
+ * @return int 不在 IOManager 的协程中时返回 -1 (EPERM)
+ */
+int co_sleep(uint64_t ms) noexcept;
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_IO_MANAGER_H
@@ -0,0 +1,210 @@
+/**
+ * @file metrics.h
+ * @brief 协程与调度器运行指标
+ * @author libco-oop
+ * @version 1.0
+ *
+ * - 每线程计数器：协程切换次数、运行周期数、创建和结束的协程数
+ * - 每调度器计数器：切换次数、就绪队列长度、窃取次数、IO等待次数、定时器到期数
+ * - 每协程指标：切换次数、累计运行周期 (rdtsc)、切出时采样的最大栈深度
+ *
+ * 计数器只由所属线程用 relaxed 读改写更新 (不是原子的 fetch_add)，
+ * 其他线程读取时得到近似值；snapshot() 在读取时才按线程和调度器汇总，
+ * 切换路径上没有共享写。
+ *
+ * LIBCO_OOP_METRICS 为0时更新代码不参与编译，snapshot() 返回 enabled 为 false 的空快照。
+ * Coroutine、Scheduler 中的计数器字段始终存在，对象布局与宏无关，
+ * 用不同取值编译的库和使用者可以混合链接 (以库的取值为准)。
+ */
+
+#ifndef LIBCO_OOP_METRICS_H
+#define LIBCO_OOP_METRICS_H
+
+#include "libco_oop/intrusive_list.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief 是否编译运行指标
+ *
+ * 默认只在调试构建 (DEBUG) 或插桩构建 (LIBCO_OOP_INSTRUMENT) 中开启，
+ * 也可以由 xmake 选项 metrics 单独开启。
+ */
+#ifndef LIBCO_OOP_METRICS
+    #if defined(DEBUG) || defined(LIBCO_OOP_INSTRUMENT)
+        #define LIBCO_OOP_METRICS 1
+    #else
+        #define LIBCO_OOP_METRICS 0
+    #endif
+#endif
+
+namespace libco_oop {
+namespace metrics {
+
+constexpr bool kEnabled = LIBCO_OOP_METRICS != 0;
+
+/**
+ * @brief 读取周期计数器 (x86 为 TSC，aarch64 为虚拟计数器)
+ */
+inline uint64_t read_cycles() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * @brief 单写者计数器：所属线程更新，任意线程读取
+ */
+class Counter {
+public:
+    void add(uint64_t n = 1) noexcept
+    {
+        value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void set(uint64_t value) noexcept { value_.store(value, std::memory_order_relaxed); }
+    uint64_t load() const noexcept { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * @brief 单线程调度器的计数器
+ */
+struct SchedulerCounters {
+    Counter switches;           ///< 切入协程的次数
+    Counter run_queue;          ///< 最近一次调度时的就绪队列长度
+    Counter io_waits;           ///< 协程开始等待IO的次数
+    Counter timer_fires;        ///< 到期的定时器数
+};
+
+/**
+ * @brief 每线程的协程计数器
+ */
+struct ThreadCounters : IntrusiveListNode {
+    Counter switches;           ///< 本线程上协程被切入的次数
+    Counter run_cycles;         ///< 协程在本线程上运行的周期数
+    Counter created;            ///< 本线程创建的协程数
+    Counter finished;           ///< 在本线程上结束的协程数
+};
+
+/**
+ * @brief 一个调度器的指标
+ */
+struct SchedulerMetrics {
+    const char* kind = "";      ///< 调度器类型 ("scheduler" / "io_manager" / "work_stealing")
+    uint64_t id = 0;            ///< 进程内唯一的调度器编号
+    uint64_t switches = 0;      ///< 切入协程的次数
+    size_t run_queue = 0;       ///< 就绪队列长度 (近似值)
+    uint64_t steals = 0;        ///< 窃取成功的次数
+    uint64_t io_waits = 0;      ///< 协程开始等待IO的次数
+    uint64_t timer_fires = 0;   ///< 到期的定时器数
+};
+
+/**
+ * @brief 一个协程的指标
+ */
+struct CoroutineMetrics {
+    uint64_t switches = 0;          ///< 被切入的次数
+    uint64_t run_cycles = 0;        ///< 累计运行周期数
+    size_t max_stack_depth = 0;     ///< 切出时采样的最大栈深度 (字节)
+};
+
+/**
+ * @brief 进程级指标快照
+ */
+struct MetricsSnapshot {
+    bool enabled = kEnabled;            ///< 是否编译了运行指标
+    size_t threads = 0;                 ///< 当前登记的线程数
+    uint64_t switches = 0;              ///< 协程切换总数 (含已退出的线程)
+    uint64_t run_cycles = 0;            ///< 协程运行周期总数
+    uint64_t coroutines_created = 0;    ///< 创建的协程总数
+    uint64_t coroutines_finished = 0;   ///< 结束的协程总数
+    std::vector<SchedulerMetrics> schedulers;   ///< 存活的调度器
+};
+
+/**
+ * @brief 登记到快照中的指标来源 (一个调度器)
+ *
+ * 所有者在构造完成后 attach()，析构开始时 detach()；
+ * detach() 会等待正在进行的 snapshot()，之后不再调用 collect。
+ */
+class Source : public IntrusiveListNode {
+public:
+    using CollectFn = void (*)(const void* owner, SchedulerMetrics& out) noexcept;
+
+    Source() noexcept = default;
+    ~Source() noexcept { detach(); }
+
+    Source(const Source&) = delete;
+    Source& operator=(const Source&) = delete;
+
+    /**
+     * @brief 登记来源
+     * @param kind 调度器类型 (静态字符串)
+     * @param owner 传给 collect 的所有者
+     * @param collect 读取所有者计数器的函数，可能在任意线程上调用
+     */
+    void attach(const char* kind, const void* owner, CollectFn collect) noexcept;
+
+    /**
+     * @brief 注销来源 (未登记时无效果)
+     */
+    void detach() noexcept;
+
+    /**
+     * @brief 读取一次指标 (不经过登记表)
+     */
+    SchedulerMetrics collect() const noexcept;
+
+    uint64_t get_id() const noexcept { return id_; }
+
+private:
+    const char* kind_ = "";
+    const void* owner_ = nullptr;
+    CollectFn collect_ = nullptr;
+    uint64_t id_ = 0;
+};
+
+/**
+ * @brief 汇总所有线程和调度器的指标
+ */
+MetricsSnapshot snapshot();
+
+/**
+ * @brief 以 Prometheus 文本格式输出快照
+ * @param snapshot 指标快照
+ * @param prefix 指标名前缀
+ */
+std::string format_prometheus(const MetricsSnapshot& snapshot, const std::string& prefix = "libco_oop");
+
+namespace detail {
+
+/**
+ * @brief 登记/注销线程计数器，线程退出时其计数并入进程总数
+ */
+void register_thread(ThreadCounters& counters) noexcept;
+void unregister_thread(ThreadCounters& counters) noexcept;
+
+} // namespace detail
+
+} // namespace metrics
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_METRICS_H
@@ -0,0 +1,326 @@
+/**
+ * @file scheduler.h
+ * @brief 单线程协程调度器
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 每个线程一个调度器，就绪队列是嵌入在协程控制块中的侵入式双向链表，
+ * 入队、出队和任意位置删除都不分配内存。
+ *
+ * 每个调度类 (SchedulingClass) 有独立的就绪队列，SchedulingPolicy 决定
+ * 按严格优先级还是按权重在类之间选择，并可以在类内按截止时刻 (EDF) 排序。
+ * 选择类只检查固定数量的队列，每次出队 O(1)。默认所有协程都属于 NORMAL 类，
+ * 行为与单个先进先出队列相同。
+ *
+ * 协程让出时直接切换回调度循环的上下文；yield_to() 在两个协程之间
+ * 直接交接，完全绕过就绪队列，适合生产者/消费者这类成对协程。
+ */
+
+#ifndef LIBCO_OOP_SCHEDULER_H
+#define LIBCO_OOP_SCHEDULER_H
+
+#include "libco_oop/coroutine.h"
+#include "libco_oop/intrusive_list.h"
+#include "libco_oop/metrics.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace libco_oop {
+
+/**
+ * @brief 调度器统计信息
+ */
+struct SchedulerStatistics {
+    uint64_t spawned = 0;       ///< 交给调度器的协程数
+    uint64_t finished = 0;      ///< 已结束并销毁的协程数
+    uint64_t dispatches = 0;    ///< 调度循环切入协程的次数
+    uint64_t handoffs = 0;      ///< yield_to() 直接交接的次数
+    uint64_t class_dispatches[kSchedulingClasses] = {};    ///< 各调度类被切入的次数
+    uint64_t starvation_boosts = 0; ///< 饥饿保护越过更高的类调度的次数
+};
+
+/**
+ * @brief 在调度类之间选择的方式
+ */
+enum class ClassSelection {
+    STRICT,     ///< 严格优先级：总是先调度最高的非空类
+    WEIGHTED    ///< 加权轮转：每轮各类最多调度 weights[类] 个协程，按优先级顺序用完额度
+};
+
+/**
+ * @brief 调度策略
+ */
+struct SchedulingPolicy {
+    ClassSelection selection = ClassSelection::STRICT;
+    /// WEIGHTED: 每轮各类的调度额度 (按 SchedulingClass 顺序)，0 表示只在其他类都为空时调度
+    uint32_t weights[kSchedulingClasses] = {16, 4, 1};
+    /// 非空的类连续被越过这么多次调度后，下一次调度它 (饥饿保护)，0 表示关闭
+    uint32_t starvation_limit = 64;
+    /// 是否在类内先按截止时刻从早到晚调度有截止时刻的协程 (EDF)，之后才是没有截止时刻的协程
+    bool deadline_ordering = false;
+};
+
+/**
+ * @brief 单线程轮转调度器
+ *
+ * 调度器拥有交给它的协程：协程结束后由调度器销毁。
+ * 协程只能在创建它的调度器所在线程上运行。
+ *
+ * 用 suspend() 挂起的协程不在任何队列中，由唤醒者负责用 schedule()
+ * 放回就绪队列；调度器析构时只销毁就绪队列中的协程。
+ */
+class Scheduler {
+public:
+    Scheduler() noexcept;
+    virtual ~Scheduler() noexcept;
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /**
+     * @brief 获取当前线程正在运行调度循环的调度器
+     * @return Scheduler* 不在 run() 中时返回 nullptr
+     */
+    static Scheduler* current() noexcept;
+
+    /**
+     * @brief 创建协程并放入就绪队列
+     * @param fn 协程入口函数
+     * @param opts 创建选项
+     * @return Coroutine* 新协程 (由调度器拥有)，创建失败返回 nullptr
+     */
+    template <typename F>
+    Coroutine* spawn(F&& fn, const CoroutineOptions& opts = CoroutineOptions{})
+    {
+        return submit(Coroutine::create(std::forward<F>(fn), opts));
+    }
+
+    /**
+     * @brief 把已创建的协程交给调度器并放入就绪队列
+     * @param coroutine 处于 READY/SUSPENDED 状态的协程
+     * @return Coroutine* 协程指针，coroutine 为空或不可恢复时返回 nullptr
+     */
+    Coroutine* submit(CoroutinePtr coroutine) noexcept;
+
+    /**
+     * @brief 为 [begin, end) 中的每个元素创建一个运行 fn(element) 的协程，整体放入就绪队列
+     * @param begin 元素序列起点
+     * @param end 元素序列终点
+     * @param fn 可拷贝的 void(element&) 可调用对象，每个协程持有一份副本
+     * @param opts 创建选项
+     * @return size_t 放入就绪队列的协程数；任一协程创建失败时全部丢弃并返回 0
+     *
+     * 协程按元素顺序排在各自调度类的就绪队列末尾。
+     */
+    template <typename Iterator, typename F>
+    size_t spawn_batch(Iterator begin, Iterator end, const F& fn, const CoroutineOptions& opts = CoroutineOptions{})
+    {
+        CoroutineBatch batch;
+        if (!batch.add_each(begin, end, fn, opts)) {
+            return 0;
+        }
+        return submit_batch(batch);
+    }
+
+    /**
+     * @brief 把一批协程一次接到就绪队列末尾，O(批次大小)；全部进入同一个先进先出队列时只拼接一次链表
+     * @param batch 全部处于 READY/SUSPENDED 状态且未交给调度器的协程
+     * @return size_t 交给调度器的协程数；批次中有不可提交的协程时返回 0，批次保持不变
+     */
+    size_t submit_batch(CoroutineBatch& batch) noexcept;
+
+    /**
+     * @brief 把调度器拥有的协程放回就绪队列 (唤醒)
+     * @param coroutine 待唤醒的协程
+     * @return bool 协程不属于本调度器或不可恢复时返回 false；已在队列中时返回 true
+     */
+    virtual bool schedule(Coroutine* coroutine) noexcept;
+
+    /**
+     * @brief 设置调度策略
+     * @return bool 就绪队列非空时返回 false (不改变已排队协程的位置)
+     */
+    bool set_policy(const SchedulingPolicy& policy) noexcept;
+
+    const SchedulingPolicy& get_policy() const noexcept { return policy_; }
+
+    /**
+     * @brief 修改调度器拥有的协程的调度类
+     * @return bool 协程不属于本调度器时返回 false
+     *
+     * 协程已在就绪队列中时移到新类的队尾 (或按截止时刻的位置)。
+     */
+    bool set_scheduling_class(Coroutine* coroutine, SchedulingClass scheduling_class) noexcept;
+
+    /**
+     * @brief 修改调度器拥有的协程的截止时刻
+     * @param deadline 毫秒 (TimerManager::now_ms() 时间基)，0 表示没有截止时刻
+     * @return bool 协程不属于本调度器时返回 false
+     */
+    bool set_deadline(Coroutine* coroutine, uint64_t deadline) noexcept;
+
+    /**
+     * @brief 运行调度循环，直到就绪队列为空且 idle() 返回 false，或 stop() 被调用
+     *
+     * 协程因未捕获的异常结束时，协程被销毁，异常从 run() 抛出；
+     * 之后可以再次调用 run() 继续调度剩余的协程。
+     */
+    void run();
+
+    /**
+     * @brief 请求调度循环在当前协程让出后退出
+     */
+    void stop() noexcept { stopping_ = true; }
+
+    /**
+     * @brief 让出当前协程并重新排到就绪队列末尾
+     * @return bool 不在协程中调用时返回 false
+     *
+     * 不属于任何调度器的协程退化为 Coroutine::yield()。
+     */
+    static bool yield() noexcept;
+
+    /**
+     * @brief 挂起当前协程，不放回就绪队列
+     * @return bool 不在调度器拥有的协程中调用时返回 false
+     *
+     * 之后需要用 schedule() 唤醒。
+     */
+    static bool suspend() noexcept;
+
+    /**
+     * @brief 把执行权直接交给另一个协程，不经过调度循环
+     * @param target 同一调度器拥有的协程
+     * @return bool 不在调度器拥有的协程中调用或目标不可交接时返回 false
+     *
+     * 目标若在就绪队列中则先移出；当前协程排到就绪队列末尾。
+     */
+    static bool yield_to(Coroutine* target) noexcept;
+
+    size_t get_ready_count() const noexcept
+    {
+        size_t count = 0;
+        for (const ReadyQueue& queue : ready_) {
+            count += queue.fifo.size() + queue.deadline.size();
+        }
+        return count;
+    }
+
+    /**
+     * @brief 获取某个调度类的就绪协程数
+     */
+    size_t get_ready_count(SchedulingClass scheduling_class) const noexcept
+    {
+        const ReadyQueue& queue = ready_[static_cast<size_t>(scheduling_class)];
+        return queue.fifo.size() + queue.deadline.size();
+    }
+
+    size_t get_live_count() const noexcept { return live_; }
+    const SchedulerStatistics& get_statistics() const noexcept { return stats_; }
+
+    /**
+     * @brief 读取运行指标 (可以在任意线程调用)
+     * @return metrics::SchedulerMetrics 运行指标关闭时只有 kind
+     */
+    metrics::SchedulerMetrics get_metrics() const noexcept;
+
+protected:
+    static constexpr uint64_t kTickInterval = 64;   ///< 每调度多少个协程触发一次 tick()
+
+    /**
+     * @brief 供子类指定运行指标中的调度器类型
+     * @param metrics_kind 静态字符串，例如 "io_manager"
+     */
+    explicit Scheduler(const char* metrics_kind) noexcept;
+
+    /**
+     * @brief 就绪队列为空时调用 (例如等待IO事件或定时器)
+     * @return bool 返回 true 继续调度循环，false 退出 run()
+     */
+    virtual bool idle() { return false; }
+
+    /**
+     * @brief 调度节拍，就绪队列非空时每调度 kTickInterval 个协程调用一次
+     *
+     * 用于在 CPU 密集的负载下非阻塞地收集IO事件，避免它们饥饿。
+     */
+    virtual void tick() {}
+
+    /**
+     * @brief 销毁调度器拥有的协程，返回其未捕获的异常
+     *
+     * 子类用它在析构时释放不在就绪队列中的等待协程。
+     */
+    std::exception_ptr retire(Coroutine* coroutine) noexcept;
+
+    /**
+     * @brief 协程是否由本调度器拥有
+     */
+    bool owns(const Coroutine* coroutine) const noexcept
+    {
+        return coroutine != nullptr && coroutine->scheduler_ == this;
+    }
+
+    /**
+     * @brief 协程控制块内嵌的定时器节点
+     */
+    static TimerNode& get_timer(Coroutine* coroutine) noexcept { return coroutine->timer_; }
+
+    /**
+     * @brief 拥有协程的调度器
+     */
+    static Scheduler* get_owner(const Coroutine* coroutine) noexcept { return coroutine->scheduler_; }
+
+    /**
+     * @brief 子类更新的计数器 (IO等待、定时器到期)
+     */
+    metrics::SchedulerCounters& get_metrics_counters() noexcept { return counters_; }
+
+private:
+    /**
+     * @brief 一个调度类的就绪队列
+     */
+    struct ReadyQueue {
+        IntrusiveList<Coroutine> deadline;  ///< 有截止时刻的协程，按截止时刻排序 (只在 EDF 时使用)
+        IntrusiveList<Coroutine> fifo;      ///< 其余协程，先进先出
+        uint32_t credits = 0;               ///< WEIGHTED: 本轮剩余的调度额度
+        uint32_t skipped = 0;               ///< 非空时连续被越过的次数
+
+        bool empty() const noexcept { return deadline.empty() && fifo.empty(); }
+    };
+
+    uint32_t ready_mask_ = 0;           ///< 非空调度类的位图 (第 c 位对应类 c)
+    uint32_t credit_mask_ = 0;          ///< WEIGHTED: 仍有额度的调度类的位图
+    bool stopping_ = false;             ///< stop() 已被调用
+    size_t live_ = 0;                   ///< 调度器拥有且尚未结束的协程数
+    ReadyQueue ready_[kSchedulingClasses];  ///< 各调度类的就绪队列
+    SchedulingPolicy policy_;           ///< 调度策略
+    SchedulerStatistics stats_;         ///< 统计信息
+    const char* metrics_kind_;          ///< 运行指标中的调度器类型
+    // 与 LIBCO_OOP_METRICS 无关地保留，布局不随宏变化；只有开启时才更新和登记
+    metrics::SchedulerCounters counters_;   ///< 运行指标计数器
+    metrics::Source metrics_source_;        ///< 快照登记 (先于计数器析构)
+
+    static void collect_metrics(const void* owner, metrics::SchedulerMetrics& out) noexcept;
+
+    /**
+     * @brief 协程所在 (或将要进入) 的就绪队列
+     */
+    IntrusiveList<Coroutine>& queue_of(const Coroutine* coroutine) noexcept
+    {
+        ReadyQueue& queue = ready_[static_cast<size_t>(coroutine->scheduling_class_)];
+        return policy_.deadline_ordering && coroutine->deadline_ != 0 ? queue.deadline : queue.fifo;
+    }
+
+    void enqueue(Coroutine* coroutine) noexcept;
+    void dequeue(Coroutine* coroutine) noexcept;
+    Coroutine* pop_ready() noexcept;
+    size_t select_class(uint32_t mask) noexcept;
+    size_t select_weighted() noexcept;
+    size_t guard_starvation(size_t chosen) noexcept;
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_SCHEDULER_H
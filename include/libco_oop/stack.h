@@ -0,0 +1,935 @@
+/**
+ * @file stack.h
+ * @brief 协程栈管理系统
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 提供协程栈内存的分配、保护和复用：
+ * - Stack: 基于 mmap 的 RAII 栈内存，栈底带 PROT_NONE 保护页
+ * - StackAllocator: 栈分配器抽象接口
+ * - FixedStackAllocator: 固定大小栈分配器，带每线程空闲链表 (栈池)
+ * - SizeClassStackAllocator: 按 2 的幂分级的栈池，配合 StackUsage 按实测用量选择栈大小
+ * - SharedStackAllocator: 共享栈分配器，多个协程轮流运行在同一块大栈上 (类似libco)
+ * - SaveBufferPool: 共享栈保存缓冲区的分级 slab 分配器
+ * - StackBinding: 上下文与栈的绑定，负责共享栈的换入换出
+ * - HybridStackAllocator: 按切换频率和栈深度在共享栈与独立栈之间自动选择
+ *
+ * 栈内存按需提交：mmap 只保留虚拟地址空间，物理页在首次访问时才分配，
+ * 因此进程 RSS 只随协程实际使用的栈深度增长。
+ *
+ * 栈用量采样：StackOptions::canary_sample 非0时，分配器每 N 次分配把一个栈
+ * 整体涂抹为金丝雀图样，协程释放栈时扫描出历史最大深度 (高水位)，
+ * 记入按入口函数类型保存的 StackUsage，之后同类协程按推荐大小分配栈。
+ */
+
+#ifndef LIBCO_OOP_STACK_H
+#define LIBCO_OOP_STACK_H
+
+#include "libco_oop/context.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace libco_oop {
+
+class StackBinding;
+class SharedStackAllocator;
+class HybridStackAllocator;
+
+/**
+ * @brief 栈分配选项
+ */
+struct StackOptions {
+    size_t stack_size = 128 * 1024;     ///< 可用栈大小 (字节，不含保护页，向上取整到页)
+    bool guard_page = true;             ///< 是否在栈底设置保护页
+    size_t max_cached = 256;            ///< 栈池最多缓存的空闲栈数量
+    size_t canary_sample = 0;           ///< 每 N 次分配涂抹一个栈用于测量高水位，0 表示关闭 (共享栈忽略)
+
+    StackOptions() = default;
+
+    explicit StackOptions(size_t size, bool guard = true, size_t cached = 256)
+        : stack_size(size), guard_page(guard), max_cached(cached) {}
+};
+
+/**
+ * @brief 栈分配统计信息
+ */
+struct StackStatistics {
+    size_t in_use = 0;                  ///< 当前已分配 (使用中) 的栈数量
+    size_t cached = 0;                  ///< 栈池中空闲可复用的栈数量
+    size_t total_allocations = 0;       ///< allocate() 成功次数
+    size_t pool_hits = 0;               ///< 从栈池直接复用的次数
+    size_t mmap_calls = 0;              ///< 实际发生的 mmap 次数
+    size_t munmap_calls = 0;            ///< 实际发生的 munmap 次数
+    size_t reserved_bytes = 0;          ///< 当前保留的虚拟地址空间 (含保护页)
+    size_t sampled = 0;                 ///< 涂抹了金丝雀图样的分配次数
+};
+
+/**
+ * @brief 单个协程栈
+ *
+ * 内存布局 (地址从低到高)：
+ *
+ *     [guard page (PROT_NONE)][ usable stack ............ ] <- top
+ *     ^ mapping begin          ^ base                        ^ base + size
+ *
+ * 栈向低地址增长，越过 base 会触及保护页并触发 SIGSEGV，而不是破坏相邻内存。
+ * 注意：带保护页的栈占用两个 VMA，大量栈时需要关注 vm.max_map_count。
+ */
+class Stack {
+public:
+    /**
+     * @brief 构造空栈 (无效)
+     */
+    Stack() noexcept = default;
+
+    /**
+     * @brief 分配指定大小的栈
+     * @param size 可用栈大小 (字节)，向上取整到页大小
+     * @param guard_page 是否设置栈底保护页
+     *
+     * 分配失败时栈处于无效状态，可通过 is_valid() 检查。
+     */
+    explicit Stack(size_t size, bool guard_page = true) noexcept;
+
+    /**
+     * @brief 析构函数，释放栈内存
+     */
+    ~Stack() noexcept;
+
+    Stack(Stack&& other) noexcept;
+    Stack& operator=(Stack&& other) noexcept;
+
+    // 栈内存是独占资源，禁止拷贝
+    Stack(const Stack&) = delete;
+    Stack& operator=(const Stack&) = delete;
+
+    /**
+     * @brief 获取栈底地址 (可用区域的最低地址)
+     */
+    void* get_base() const noexcept { return base_; }
+
+    /**
+     * @brief 获取栈顶地址 (可用区域的最高地址，16字节对齐)
+     *
+     * 新协程的初始栈指针应从这里开始向下使用。
+     */
+    void* get_top() const noexcept { return static_cast<char*>(base_) + size_; }
+
+    /**
+     * @brief 获取可用栈大小
+     */
+    size_t get_size() const noexcept { return size_; }
+
+    /**
+     * @brief 获取包含保护页在内的映射大小
+     */
+    size_t get_mapped_size() const noexcept { return size_ + guard_size_; }
+
+    /**
+     * @brief 获取保护页区域
+     */
+    void* get_guard_begin() const noexcept { return memory_; }
+    size_t get_guard_size() const noexcept { return guard_size_; }
+
+    /**
+     * @brief 检查栈是否有效
+     */
+    bool is_valid() const noexcept { return memory_ != nullptr; }
+
+    /**
+     * @brief 检查地址是否位于可用栈区域内
+     * @param sp 要检查的地址
+     */
+    bool contains(const void* sp) const noexcept
+    {
+        auto p = reinterpret_cast<uintptr_t>(sp);
+        auto lo = reinterpret_cast<uintptr_t>(base_);
+        return p >= lo && p <= lo + size_;
+    }
+
+    /**
+     * @brief 检查栈指针是否已溢出 (低于栈底)
+     * @param sp 要检查的栈指针
+     * @return bool 栈指针越过栈底返回 true
+     */
+    bool check_overflow(const void* sp) const noexcept
+    {
+        return reinterpret_cast<uintptr_t>(sp) < reinterpret_cast<uintptr_t>(base_);
+    }
+
+    /**
+     * @brief 计算给定栈指针对应的已用栈深度
+     * @param sp 栈指针
+     * @return size_t 从栈顶到 sp 的字节数
+     */
+    size_t used_bytes(const void* sp) const noexcept
+    {
+        return static_cast<size_t>(reinterpret_cast<uintptr_t>(get_top()) - reinterpret_cast<uintptr_t>(sp));
+    }
+
+    /**
+     * @brief 获取栈上当前栈帧所属的绑定
+     *
+     * 为空表示栈上没有需要保留的栈帧 (未使用、已换出或已停放)。
+     */
+    StackBinding* get_occupant() const noexcept { return occupant_; }
+
+    /**
+     * @brief 把整个可用区域涂抹为金丝雀图样，供 high_water_mark() 扫描
+     *
+     * 会提交整个栈的物理页，只应对采样的栈使用；栈上不能有正在使用的栈帧。
+     */
+    void paint() noexcept;
+
+    /**
+     * @brief 清除涂抹标记，并归还高水位以下只被涂抹过的物理页
+     */
+    void unpaint() noexcept;
+
+    bool is_painted() const noexcept { return painted_; }
+
+    /**
+     * @brief 扫描涂抹过的栈，计算涂抹以来的最大栈深度
+     * @return size_t 从栈顶到最低一个被改写的字的字节数，未涂抹返回 0
+     */
+    size_t high_water_mark() const noexcept;
+
+    /**
+     * @brief 获取系统页大小
+     */
+    static size_t page_size() noexcept;
+
+private:
+    friend class FixedStackAllocator;
+    friend class StackBinding;
+
+    void* memory_ = nullptr;            ///< 映射起始地址 (含保护页)
+    void* base_ = nullptr;              ///< 可用区域起始地址
+    size_t size_ = 0;                   ///< 可用区域大小
+    size_t guard_size_ = 0;             ///< 保护页大小
+    Stack* next_free_ = nullptr;        ///< 栈池空闲链表指针
+    StackBinding* occupant_ = nullptr;  ///< 栈上当前栈帧所属的绑定
+    bool painted_ = false;              ///< 是否涂抹了金丝雀图样
+
+    void release() noexcept;
+};
+
+/**
+ * @brief 栈分配器抽象接口
+ */
+class StackAllocator {
+public:
+    virtual ~StackAllocator() = default;
+
+    /**
+     * @brief 分配一个栈
+     * @param size 需要的最小可用栈大小，0 表示使用分配器默认大小
+     * @return Stack* 分配的栈，失败返回 nullptr
+     */
+    virtual Stack* allocate(size_t size = 0) = 0;
+
+    /**
+     * @brief 归还一个栈
+     * @param stack 由本分配器分配的栈
+     */
+    virtual void deallocate(Stack* stack) noexcept = 0;
+
+    /**
+     * @brief 获取分配统计信息
+     */
+    virtual StackStatistics get_statistics() const noexcept = 0;
+
+    /**
+     * @brief 设置分配选项
+     * @param opts 新的分配选项
+     */
+    virtual void set_options(const StackOptions& opts) = 0;
+};
+
+/**
+ * @brief 固定大小栈分配器
+ *
+ * 每个栈独立 mmap (类似 libaco 的独立栈)，归还的栈挂到侵入式空闲链表中，
+ * 下次分配直接复用，常态下分配和释放都不进入内核。
+ * 分配只能在创建实例的线程上进行，通过 local() 获取每线程独立的默认实例。
+ * 迁移到其他线程的协程可以在任意线程归还栈：其他线程归还的栈先挂到
+ * 加锁的远程链表，由所属线程下次分配时收回，统计始终记在所属分配器上。
+ */
+class FixedStackAllocator : public StackAllocator {
+public:
+    explicit FixedStackAllocator(const StackOptions& opts = StackOptions{}) noexcept;
+    ~FixedStackAllocator() override;
+
+    FixedStackAllocator(const FixedStackAllocator&) = delete;
+    FixedStackAllocator& operator=(const FixedStackAllocator&) = delete;
+
+    /**
+     * @brief 分配固定大小的栈
+     * @param size 需要的最小大小，超过固定栈大小时返回 nullptr
+     */
+    Stack* allocate(size_t size = 0) override;
+
+    /**
+     * @brief 归还栈到空闲链表，缓存已满时直接释放
+     *
+     * 可以在任意线程调用，非所属线程归还的栈延迟到所属线程下次分配时处理。
+     */
+    void deallocate(Stack* stack) noexcept override;
+
+    /**
+     * @brief 获取分配统计信息
+     *
+     * 远程链表中等待收回的栈不计入 in_use。
+     */
+    StackStatistics get_statistics() const noexcept override;
+
+    /**
+     * @brief 设置分配选项
+     *
+     * 修改栈大小或保护页设置会释放所有已缓存的栈。
+     */
+    void set_options(const StackOptions& opts) override;
+
+    /**
+     * @brief 获取当前分配选项
+     */
+    const StackOptions& get_options() const noexcept { return options_; }
+
+    /**
+     * @brief 预先分配栈放入栈池 (预热)
+     * @param count 希望缓存的空闲栈数量
+     * @return size_t 实际缓存的空闲栈数量
+     */
+    size_t reserve(size_t count);
+
+    /**
+     * @brief 释放栈池中多余的空闲栈
+     * @param keep 保留的空闲栈数量
+     */
+    void trim(size_t keep = 0) noexcept;
+
+    /**
+     * @brief 获取当前线程的默认分配器实例
+     *
+     * 线程退出时仍有栈在其他线程上使用的实例不会立即销毁，
+     * 由最后一个归还的栈释放。
+     */
+    static FixedStackAllocator& local() noexcept;
+
+private:
+    StackOptions options_;              ///< 分配选项
+    Stack* free_list_ = nullptr;        ///< 空闲栈链表
+    StackStatistics stats_;             ///< 分配统计
+    size_t sample_countdown_ = 0;       ///< 距下一次涂抹的分配次数
+
+    // 跨线程归还
+    std::thread::id owner_;                     ///< 所属线程 (创建实例的线程)
+    std::mutex remote_mutex_;                   ///< 保护远程链表与线程退出后的统计
+    Stack* remote_free_ = nullptr;              ///< 其他线程归还、尚未收回的栈
+    std::atomic<size_t> remote_pending_{0};     ///< 远程链表长度
+    std::atomic<bool> orphaned_{false};         ///< 所属线程已经退出 (只用于 local() 实例)
+
+    /**
+     * @brief 按采样频率涂抹分配出去的栈
+     */
+    void sample(Stack* stack) noexcept;
+
+    /**
+     * @brief 在所属线程上归还一个栈
+     */
+    void release(Stack* stack) noexcept;
+
+    /**
+     * @brief 收回远程链表中的栈
+     */
+    void drain_remote() noexcept;
+
+    /**
+     * @brief 所属线程退出时调用：释放缓存，没有使用中的栈时销毁实例
+     */
+    void retire() noexcept;
+};
+
+//============================================================================
+// 栈用量采样与分级栈池
+//============================================================================
+
+/**
+ * @brief 一类协程的栈用量画像
+ *
+ * 由调用者按协程类型保存 (stack_usage_for<F>() 提供按入口函数类型的实例)，
+ * 跨协程实例累积涂抹栈上测得的高水位。计数器是 relaxed 原子变量，
+ * 协程可以在任意线程上释放栈。
+ */
+class StackUsage {
+public:
+    static constexpr size_t kMinSamples = 8;    ///< 给出推荐大小所需的最少样本数
+    static constexpr size_t kHeadroom = 2;      ///< 推荐大小相对最大高水位的倍数
+
+    StackUsage() noexcept = default;
+    StackUsage(const StackUsage&) = delete;
+    StackUsage& operator=(const StackUsage&) = delete;
+
+    /**
+     * @brief 记录一次采样
+     * @param used 涂抹栈上测得的高水位 (字节)
+     */
+    void record(size_t used) noexcept;
+
+    size_t get_samples() const noexcept { return samples_.load(std::memory_order_relaxed); }
+    size_t get_max_used() const noexcept { return max_used_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 获取平均高水位
+     */
+    size_t get_average_used() const noexcept;
+
+    /**
+     * @brief 推荐的栈大小
+     * @param min_samples 样本数少于此值时返回 0 (使用分配器默认大小)
+     * @return size_t 最大高水位的 kHeadroom 倍，向上取整到页，至少两页
+     *
+     * 采样只能覆盖已经出现过的执行路径，推荐值的余量用于吸收未采样到的更深的调用；
+     * 保护页保证越界时以 SIGSEGV 结束而不是破坏相邻内存。
+     */
+    size_t recommended_size(size_t min_samples = kMinSamples) const noexcept;
+
+    /**
+     * @brief 清空所有样本
+     */
+    void reset() noexcept;
+
+private:
+    std::atomic<size_t> samples_{0};    ///< 样本数
+    std::atomic<size_t> total_used_{0}; ///< 高水位之和
+    std::atomic<size_t> max_used_{0};   ///< 最大高水位
+};
+
+/**
+ * @brief 按入口函数类型区分的默认栈用量画像
+ *
+ * 每个 lambda 都有独立的类型，因此同一处创建的协程共享一个画像。
+ */
+template <typename F>
+StackUsage& stack_usage_for() noexcept
+{
+    static StackUsage usage;
+    return usage;
+}
+
+/**
+ * @brief 分级栈分配器
+ *
+ * 从 min_size 开始按 2 的幂分级直到 StackOptions::stack_size，每级一个
+ * FixedStackAllocator 栈池；allocate(size) 取能容纳 size 的最小一级，
+ * allocate(0) 取最大一级。与 StackUsage 配合，协程按实测用量使用小栈，
+ * 同样数量的协程保留的虚拟地址空间和驻留的物理页随之减少。
+ * 实例本身不是线程安全的。
+ */
+class SizeClassStackAllocator : public StackAllocator {
+public:
+    static constexpr size_t kDefaultMinSize = 16 * 1024;
+
+    /**
+     * @brief 构造分级栈分配器
+     * @param opts 最大一级的选项，保护页、缓存数量和采样频率作用于每一级
+     * @param min_size 最小一级的大小
+     */
+    explicit SizeClassStackAllocator(const StackOptions& opts = StackOptions{},
+                                     size_t min_size = kDefaultMinSize);
+
+    SizeClassStackAllocator(const SizeClassStackAllocator&) = delete;
+    SizeClassStackAllocator& operator=(const SizeClassStackAllocator&) = delete;
+
+    /**
+     * @brief 从能容纳 size 的最小一级分配
+     * @param size 需要的最小大小，0 表示最大一级，超过最大一级时返回 nullptr
+     */
+    Stack* allocate(size_t size = 0) override;
+
+    /**
+     * @brief 按栈大小归还到对应的一级，不属于任何一级的栈直接释放
+     */
+    void deallocate(Stack* stack) noexcept override;
+
+    /**
+     * @brief 获取所有级别的统计信息之和
+     */
+    StackStatistics get_statistics() const noexcept override;
+
+    /**
+     * @brief 设置分配选项
+     *
+     * 重建所有级别并释放已缓存的栈；之后归还的旧栈直接释放。
+     */
+    void set_options(const StackOptions& opts) override;
+
+    size_t get_class_count() const noexcept { return classes_.size(); }
+    FixedStackAllocator& get_class(size_t index) noexcept { return *classes_[index]; }
+
+private:
+    size_t min_size_;                                           ///< 最小一级的大小
+    std::vector<std::unique_ptr<FixedStackAllocator>> classes_; ///< 从小到大的各级栈池
+
+    void build_classes(const StackOptions& opts);
+};
+
+//============================================================================
+// 共享栈
+//============================================================================
+
+/**
+ * @brief 保存缓冲区统计信息
+ */
+struct SaveBufferStatistics {
+    size_t blocks_in_use = 0;           ///< 当前使用中的缓冲区数量
+    size_t bytes_in_use = 0;            ///< 当前使用中的缓冲区容量之和 (按规格计)
+    size_t slab_bytes = 0;              ///< 向系统申请的 slab 内存总量
+    size_t slab_count = 0;              ///< slab 数量
+};
+
+/**
+ * @brief 共享栈保存缓冲区的分级 slab 分配器
+ *
+ * 按 2 的幂分级 (64B ~ 1MB)，每级从 mmap 得到的 slab 中切块，
+ * 释放的块挂回该级的空闲链表，不经过 malloc。超过最大规格的请求
+ * 单独 mmap。slab 只在分配器析构时整体释放。
+ * 实例本身不是线程安全的。
+ */
+class SaveBufferPool {
+public:
+    static constexpr size_t kMinBlockSize = 64;                 ///< 最小规格
+    static constexpr size_t kNumClasses = 15;                   ///< 规格数量 (64B << 14 = 1MB)
+    static constexpr size_t kMaxBlockSize = kMinBlockSize << (kNumClasses - 1);
+    static constexpr size_t kSlabSize = 256 * 1024;             ///< 单个 slab 的目标大小
+
+    SaveBufferPool() noexcept = default;
+    ~SaveBufferPool() noexcept;
+
+    SaveBufferPool(const SaveBufferPool&) = delete;
+    SaveBufferPool& operator=(const SaveBufferPool&) = delete;
+
+    /**
+     * @brief 分配至少 size 字节的缓冲区
+     * @param size 需要的字节数
+     * @param capacity 输出实际容量 (所属规格的大小)
+     * @return void* 缓冲区地址 (64字节对齐)，失败返回 nullptr
+     */
+    void* allocate(size_t size, size_t& capacity) noexcept;
+
+    /**
+     * @brief 归还缓冲区
+     * @param block allocate() 返回的地址
+     * @param capacity allocate() 输出的容量
+     */
+    void deallocate(void* block, size_t capacity) noexcept;
+
+    /**
+     * @brief 计算 size 对应的规格大小
+     */
+    static size_t block_size_for(size_t size) noexcept;
+
+    SaveBufferStatistics get_statistics() const noexcept { return stats_; }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Slab {
+        Slab* next;
+        size_t size;
+    };
+
+    FreeBlock* free_lists_[kNumClasses] = {};   ///< 每级空闲链表
+    Slab* slabs_ = nullptr;                     ///< 已申请的 slab 链表
+    SaveBufferStatistics stats_;                ///< 统计信息
+
+    bool refill(size_t index) noexcept;
+};
+
+/**
+ * @brief 共享栈
+ *
+ * 栈上同一时刻只保存一个协程 (占用者) 的栈帧，
+ * 其他绑定到此栈的协程的栈内容保存在各自的缓冲区中。
+ */
+class SharedStack : public Stack {
+public:
+    SharedStack(size_t size, bool guard_page, SharedStackAllocator* owner) noexcept
+        : Stack(size, guard_page), owner_(owner) {}
+
+    /**
+     * @brief 获取当前绑定到此栈的协程数量
+     */
+    size_t get_user_count() const noexcept { return users_; }
+
+    /**
+     * @brief 获取所属的分配器
+     */
+    SharedStackAllocator* get_owner() const noexcept { return owner_; }
+
+private:
+    friend class StackBinding;
+    friend class SharedStackAllocator;
+
+    SharedStackAllocator* owner_;       ///< 所属分配器 (提供保存缓冲区)
+    size_t users_ = 0;                  ///< 绑定到此栈的数量
+};
+
+/**
+ * @brief 共享栈分配器
+ *
+ * 预先分配 count 个大栈，allocate() 以轮转方式把协程分摊到这些栈上。
+ * 切换时只把被换出协程实际使用的部分 [rsp, top) 拷贝到按需分配的
+ * 保存缓冲区中，空闲协程的内存占用只有栈帧大小，而不是整个栈。
+ * 实例本身不是线程安全的，绑定到同一分配器的协程必须在同一线程上运行。
+ */
+class SharedStackAllocator : public StackAllocator {
+public:
+    /**
+     * @brief 构造共享栈分配器
+     * @param count 共享栈数量 (至少为1)
+     * @param opts 每个共享栈的选项 (max_cached 不使用)
+     */
+    explicit SharedStackAllocator(size_t count = 1, const StackOptions& opts = StackOptions{});
+    ~SharedStackAllocator() override;
+
+    SharedStackAllocator(const SharedStackAllocator&) = delete;
+    SharedStackAllocator& operator=(const SharedStackAllocator&) = delete;
+
+    /**
+     * @brief 分配一个共享栈 (实际类型为 SharedStack)
+     * @param size 需要的最小大小，超过共享栈大小时返回 nullptr
+     */
+    Stack* allocate(size_t size = 0) override;
+
+    /**
+     * @brief 解除一个协程对共享栈的使用，栈本身由分配器持有
+     */
+    void deallocate(Stack* stack) noexcept override;
+
+    StackStatistics get_statistics() const noexcept override;
+
+    /**
+     * @brief 设置分配选项
+     *
+     * 只在没有协程使用共享栈时生效，否则忽略。
+     */
+    void set_options(const StackOptions& opts) override;
+
+    /**
+     * @brief 以 SharedStack 类型分配共享栈
+     */
+    SharedStack* acquire(size_t size = 0);
+
+    /**
+     * @brief 获取共享栈数量
+     */
+    size_t get_stack_count() const noexcept { return stacks_.size(); }
+
+    /**
+     * @brief 获取保存缓冲区分配器
+     */
+    SaveBufferPool& get_buffer_pool() noexcept { return buffers_; }
+    const SaveBufferPool& get_buffer_pool() const noexcept { return buffers_; }
+
+private:
+    StackOptions options_;                          ///< 共享栈选项
+    std::vector<std::unique_ptr<SharedStack>> stacks_;  ///< 共享栈
+    size_t next_ = 0;                               ///< 轮转分配位置
+    StackStatistics stats_;                         ///< 统计信息
+    SaveBufferPool buffers_;                        ///< 保存缓冲区
+
+    void create_stacks(size_t count);
+};
+
+/**
+ * @brief 绑定的换入换出统计
+ */
+struct StackBindingStatistics {
+    size_t resume_count = 0;            ///< 被切换进入的次数
+    size_t save_count = 0;              ///< 栈内容被换出的次数
+    size_t restore_count = 0;           ///< 栈内容被换入的次数
+    size_t copied_bytes = 0;            ///< 换入换出累计拷贝的字节数
+};
+
+/**
+ * @brief 上下文与栈的绑定
+ *
+ * 记录上下文的寄存器状态运行在哪个栈上。目标的栈帧在栈上时
+ * switch_to() 就是一次汇编切换；目标运行在共享栈且栈上当前是
+ * 其他协程的栈帧，或目标的独立栈已被停放 (park) 时，
+ * 先换出占用者、换入目标，再切换。
+ *
+ * 当前协程与目标共享同一个栈时，当前协程正运行在要被覆盖的栈上，
+ * 拷贝交给每线程一个运行在独立小栈上的中转上下文完成。
+ */
+class StackBinding {
+public:
+    StackBinding() noexcept = default;
+
+    /**
+     * @brief 析构时解除绑定，释放保存缓冲区
+     */
+    ~StackBinding() noexcept { unbind(); }
+
+    StackBinding(const StackBinding&) = delete;
+    StackBinding& operator=(const StackBinding&) = delete;
+
+    /**
+     * @brief 绑定到独立栈 (或线程栈)
+     * @param regs 上下文的寄存器状态，例如 Context::registers()
+     * @param stack 运行的栈，nullptr 表示线程自身的栈
+     * @param buffers 停放时使用的保存缓冲区分配器，nullptr 表示不支持 park()
+     */
+    void bind(RegisterState& regs, Stack* stack = nullptr, SaveBufferPool* buffers = nullptr) noexcept;
+
+    /**
+     * @brief 绑定到共享栈
+     * @param regs 上下文的寄存器状态
+     * @param stack 由 SharedStackAllocator 分配的共享栈
+     */
+    void bind(RegisterState& regs, SharedStack* stack) noexcept;
+
+    /**
+     * @brief 解除绑定，释放保存缓冲区，放弃共享栈的占用
+     *
+     * 协程结束后调用，栈上残留的栈帧不会再被保存。
+     * 由 HybridStackAllocator 绑定的会同时把栈归还给它。
+     */
+    void unbind() noexcept;
+
+    /**
+     * @brief 丢弃栈帧 (上下文将从头开始运行)，保留绑定和保存缓冲区
+     *
+     * 用于复用协程：共享栈上不再保留本绑定的栈帧，独立栈直接归本绑定使用。
+     */
+    void discard() noexcept;
+
+    /**
+     * @brief 停放：把栈帧保存到缓冲区并归还栈上的物理页
+     * @return bool 是否停放成功
+     *
+     * 只能对未在运行的绑定调用。停放后栈的地址范围保持不变，
+     * 下次切换进入时自动把栈帧拷回原处。
+     */
+    bool park() noexcept;
+
+    /**
+     * @brief 切换到目标绑定的上下文
+     * @param to 目标
+     * @param save_fpu 是否保存/恢复FPU控制字和MXCSR
+     *
+     * 调用者负责保证双方寄存器状态有效。
+     */
+    void switch_to(StackBinding& to, bool save_fpu = false) noexcept
+    {
+        Stack* stack = to.stack_;
+        ++to.stats_.resume_count;
+        if (stack == nullptr || stack->occupant_ == &to) {
+            // 快速路径：目标的栈帧已在栈上
+            raw_switch(regs_, to.regs_, save_fpu);
+            return;
+        }
+        switch_slow(to, save_fpu);
+    }
+
+    /**
+     * @brief 放弃当前栈帧并切换到另一个绑定 (不会返回)
+     * @param to 目标
+     * @param save_fpu 是否恢复FPU控制字和MXCSR
+     *
+     * 当前栈帧不保存，之后不能再切换回本绑定的旧执行点。不经过中转上下文，
+     * 调用者不能运行在本绑定的栈上 (用于在备用信号栈上结束栈溢出的协程)。
+     */
+    [[noreturn]] void abandon_to(StackBinding& to, bool save_fpu = false) noexcept;
+
+    bool is_bound() const noexcept { return regs_ != nullptr; }
+    bool is_shared() const noexcept { return shared_ != nullptr; }
+    Stack* get_stack() const noexcept { return stack_; }
+    SharedStack* get_shared_stack() const noexcept { return shared_; }
+    RegisterState* get_registers() const noexcept { return regs_; }
+
+    /**
+     * @brief 栈帧当前是否在栈上 (而不是在保存缓冲区中)
+     */
+    bool is_resident() const noexcept { return stack_ == nullptr || stack_->occupant_ == this; }
+
+    /**
+     * @brief 获取保存缓冲区中栈内容的大小
+     */
+    size_t get_saved_size() const noexcept { return save_size_; }
+
+    /**
+     * @brief 获取保存缓冲区容量
+     */
+    size_t get_save_capacity() const noexcept { return save_capacity_; }
+
+    const StackBindingStatistics& get_statistics() const noexcept { return stats_; }
+
+private:
+    friend struct StackCopier;
+    friend class HybridStackAllocator;
+
+    // switch_to() 的快速路径只访问开头的三个字段
+    RegisterState* regs_ = nullptr;     ///< 上下文寄存器状态
+    Stack* stack_ = nullptr;            ///< 运行的栈
+    StackBindingStatistics stats_;      ///< 换入换出统计
+    SharedStack* shared_ = nullptr;     ///< 共享栈 (独立栈时为空)
+    SaveBufferPool* buffers_ = nullptr; ///< 保存缓冲区分配器
+    void* save_buffer_ = nullptr;       ///< 保存缓冲区
+    size_t save_size_ = 0;              ///< 已保存的字节数
+    size_t save_capacity_ = 0;          ///< 保存缓冲区容量
+    HybridStackAllocator* tracker_ = nullptr;   ///< 跟踪此绑定的混合栈分配器
+    size_t tracking_slot_ = 0;                  ///< 在跟踪表中的位置
+
+    static void raw_switch(RegisterState* from, RegisterState* to, bool save_fpu) noexcept
+    {
+        if (save_fpu) {
+            libco_oop_context_swap_full(from, to);
+        } else {
+            libco_oop_context_swap_minimal(from, to);
+        }
+    }
+
+    void switch_slow(StackBinding& to, bool save_fpu) noexcept;
+
+    /**
+     * @brief 把栈上的栈帧 [rsp, top) 保存到缓冲区并放弃占用
+     */
+    bool save_stack() noexcept;
+
+    /**
+     * @brief 换出当前占用者，把缓冲区内容拷回栈上并成为占用者
+     */
+    void restore_stack() noexcept;
+};
+
+//============================================================================
+// 混合栈策略
+//============================================================================
+
+/**
+ * @brief 栈类型
+ */
+enum class StackKind {
+    SHARED,     ///< 共享栈 - 内存占用低，换入换出需要拷贝 (类似libco)
+    PRIVATE     ///< 独立栈 - 切换只有一次汇编调用 (类似libaco)
+};
+
+/**
+ * @brief 混合栈策略选项
+ */
+struct HybridStackOptions {
+    StackOptions private_stack;         ///< 独立栈选项
+    StackOptions shared_stack;          ///< 共享栈选项
+    size_t shared_stack_count = 4;      ///< 共享栈数量
+    size_t hot_switches = 64;           ///< 一个统计周期内换入次数达到此值判为高频协程
+    size_t deep_copy_bytes = 16 * 1024; ///< 平均每次换入拷贝字节数达到此值判为深栈协程
+    size_t idle_periods = 4;            ///< 独立栈协程连续空闲的周期数达到此值即降级
+};
+
+/**
+ * @brief 一类协程的栈使用画像
+ *
+ * 由调用者按协程类型 (例如入口函数或连接类型) 保存，跨协程实例累积。
+ * HybridStackAllocator 在统计周期中更新它，并在下次绑定时据此选择栈类型。
+ */
+struct StackProfile {
+    StackKind preferred = StackKind::SHARED;    ///< 下次绑定时使用的栈类型
+    size_t resumes = 0;                         ///< 累计换入次数
+    size_t copied_bytes = 0;                    ///< 累计换入换出拷贝字节数
+    size_t promotions = 0;                      ///< 被升级为独立栈的次数
+    size_t demotions = 0;                       ///< 被降级回共享栈的次数
+};
+
+/**
+ * @brief 混合栈策略统计信息
+ */
+struct HybridStackStatistics {
+    size_t shared_bindings = 0;         ///< 当前使用共享栈的绑定数量
+    size_t private_bindings = 0;        ///< 当前使用独立栈的绑定数量
+    size_t parked = 0;                  ///< 当前已停放的独立栈数量
+    size_t promotions = 0;              ///< 累计升级次数
+    size_t demotions = 0;               ///< 累计降级次数
+    size_t periods = 0;                 ///< 已执行的统计周期数
+};
+
+/**
+ * @brief 混合栈分配器
+ *
+ * 在 SharedStackAllocator 和 FixedStackAllocator 之上按协程的实际行为选择栈：
+ * - 统计周期内换入次数多、或每次换入拷贝量大的共享栈协程被升级，
+ *   同一画像的协程此后绑定到独立栈，切换不再拷贝；
+ * - 连续多个周期没有被换入的独立栈协程被降级：立即停放 (栈帧存入
+ *   保存缓冲区并归还物理页)，同一画像此后回到共享栈。
+ *
+ * 栈帧中保存着指向栈内的指针，正在运行的协程无法迁移到其他地址的栈上，
+ * 因此升级在下次绑定时生效；降级的内存收益通过停放立即生效。
+ * rebalance() 应由调度器周期性调用，且调用者不能是绑定到本分配器的协程。
+ * 实例本身不是线程安全的。
+ */
+class HybridStackAllocator {
+public:
+    explicit HybridStackAllocator(const HybridStackOptions& opts = HybridStackOptions{});
+    ~HybridStackAllocator();
+
+    HybridStackAllocator(const HybridStackAllocator&) = delete;
+    HybridStackAllocator& operator=(const HybridStackAllocator&) = delete;
+
+    /**
+     * @brief 为上下文选择栈并绑定
+     * @param binding 要绑定的 StackBinding
+     * @param regs 上下文的寄存器状态
+     * @param profile 协程画像，nullptr 表示总是使用共享栈
+     * @return bool 绑定是否成功
+     *
+     * 绑定后由调用者把上下文的栈指针设置为 binding.get_stack()->get_top()。
+     */
+    bool bind(StackBinding& binding, RegisterState& regs, StackProfile* profile = nullptr);
+
+    /**
+     * @brief 解除绑定并归还栈，把本次运行的统计累积到画像中
+     */
+    void unbind(StackBinding& binding) noexcept;
+
+    /**
+     * @brief 执行一个统计周期：标记需要升级的画像，停放空闲的独立栈
+     */
+    void rebalance() noexcept;
+
+    /**
+     * @brief 获取统计信息
+     */
+    HybridStackStatistics get_statistics() const noexcept;
+
+    const HybridStackOptions& get_options() const noexcept { return options_; }
+    FixedStackAllocator& get_private_allocator() noexcept { return private_; }
+    SharedStackAllocator& get_shared_allocator() noexcept { return shared_; }
+
+private:
+    struct Entry {
+        StackBinding* binding;          ///< 被跟踪的绑定
+        StackProfile* profile;          ///< 所属画像
+        size_t last_resumes;            ///< 上个周期结束时的换入次数
+        size_t last_copied;             ///< 上个周期结束时的拷贝字节数
+        size_t last_restores;           ///< 上个周期结束时的换入拷贝次数
+        size_t idle_periods;            ///< 连续空闲周期数
+    };
+
+    HybridStackOptions options_;        ///< 策略选项
+    FixedStackAllocator private_;       ///< 独立栈来源
+    SharedStackAllocator shared_;       ///< 共享栈来源，同时提供保存缓冲区
+    std::vector<Entry> entries_;        ///< 被跟踪的绑定
+    HybridStackStatistics stats_;       ///< 累计统计
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_STACK_H
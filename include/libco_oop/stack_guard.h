@@ -0,0 +1,120 @@
+/**
+ * @file stack_guard.h
+ * @brief 协程栈溢出检测
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 保护页只能阻止栈溢出破坏相邻内存，溢出本身表现为一次 SIGSEGV。
+ * install() 安装在备用信号栈 (sigaltstack) 上运行的 SIGSEGV 处理函数：
+ * - 故障地址落在当前协程栈的保护页内时判定为栈溢出，报告协程ID、
+ *   入口函数和栈大小
+ * - 可选只结束溢出的协程：协程以 StackOverflowError 结束 (state 为 ERROR)，
+ *   异常照常在 resume() / Scheduler::run() 中抛出，线程和其他协程继续运行
+ * - 其他故障交给之前安装的处理函数 (没有时恢复默认动作)
+ *
+ * 检测只在故障发生时工作，协程切换路径上没有任何额外开销。
+ * 备用信号栈是每线程的：install() 为调用线程准备，之后首次运行协程的
+ * 线程自动准备；install() 之前已经运行过协程的其他线程需要调用 prepare_thread()。
+ * 单个栈帧大于一页时可能越过保护页，这种溢出无法识别。
+ */
+
+#ifndef LIBCO_OOP_STACK_GUARD_H
+#define LIBCO_OOP_STACK_GUARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace libco_oop {
+
+class Coroutine;
+
+/**
+ * @brief 协程栈溢出异常 (由 OverflowAction::TERMINATE_COROUTINE 产生)
+ */
+class StackOverflowError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief 识别到栈溢出之后的动作
+ */
+enum class OverflowAction {
+    ABORT,                  ///< 报告后交给之前的处理函数 (默认动作为终止进程并产生 core)
+    TERMINATE_COROUTINE     ///< 报告后只结束溢出的协程，切换回它的调用者
+};
+
+/**
+ * @brief 栈溢出信息
+ */
+struct StackOverflowInfo {
+    uint64_t coroutine_id = 0;          ///< 溢出协程的ID
+    const char* entry_type = nullptr;   ///< 入口函数类型的修饰名 (typeid().name()，可用 c++filt 解析)
+    const void* entry_address = nullptr; ///< 入口函数调用实现的地址 (可用 addr2line 解析)
+    size_t stack_size = 0;              ///< 栈的可用大小 (字节)
+    const void* fault_address = nullptr; ///< 故障地址
+};
+
+/**
+ * @brief 栈溢出检测选项
+ */
+struct StackGuardOptions {
+    OverflowAction action = OverflowAction::ABORT;  ///< 识别到溢出之后的动作
+    bool report = true;                             ///< 是否向标准错误输出一行报告
+    /// 识别到溢出时在信号处理函数中调用，只能使用异步信号安全的操作
+    void (*on_overflow)(const StackOverflowInfo& info) = nullptr;
+    size_t alt_stack_size = 64 * 1024;              ///< 每线程备用信号栈大小 (字节)
+};
+
+namespace stack_guard {
+
+/**
+ * @brief 安装 SIGSEGV 处理函数并为调用线程准备备用信号栈
+ * @param opts 检测选项
+ * @return bool 成功返回 true；失败返回 false 并设置 errno
+ *
+ * 已经安装时只更新选项。应在启动工作线程之前调用。
+ */
+bool install(const StackGuardOptions& opts = StackGuardOptions{}) noexcept;
+
+/**
+ * @brief 恢复安装之前的 SIGSEGV 处理函数
+ *
+ * 已准备的备用信号栈保留到线程退出。
+ */
+void uninstall() noexcept;
+
+/**
+ * @brief 是否已安装
+ */
+bool is_installed() noexcept;
+
+/**
+ * @brief 为调用线程准备备用信号栈
+ * @return bool 未安装或分配失败时返回 false (已有备用信号栈时直接返回 true)
+ */
+bool prepare_thread() noexcept;
+
+/**
+ * @brief 获取识别到的栈溢出次数 (进程级)
+ */
+size_t get_overflow_count() noexcept;
+
+namespace detail {
+
+struct Access;
+
+/**
+ * @brief 登记线程的当前协程变量 (线程首次运行协程时调用)
+ * @param current 线程状态中的当前协程指针，线程退出前传入 nullptr
+ *
+ * 信号处理函数通过它找到溢出的协程，不需要在信号处理函数中构造线程状态。
+ */
+void attach_thread(Coroutine* const* current) noexcept;
+
+} // namespace detail
+} // namespace stack_guard
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_STACK_GUARD_H
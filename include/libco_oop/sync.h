@@ -0,0 +1,234 @@
+/**
+ * @file sync.h
+ * @brief 协程同步原语：CoMutex、CoCondVar、CoSemaphore
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 需要等待时挂起当前协程 (切换回调度循环)，而不是阻塞工作线程；
+ * 在普通线程中使用时在 futex 上阻塞 (见 waiter.h)，二者可以混用。
+ *
+ * - 无竞争时加锁、解锁、获取、释放都是一次原子操作，不切换
+ * - 等待者是等待方栈上的侵入式节点，按 FIFO 顺序唤醒
+ * - 互斥锁和信号量直接交接给等待最久的等待者，不会被后来者插队
+ *
+ * 等待队列由一个内部互斥锁保护，只在有竞争的慢路径上使用，
+ * 持有期间从不挂起。持有 std::mutex 跨过让出点会让单线程调度器死锁，
+ * 持有 CoMutex 则不会。
+ */
+
+#ifndef LIBCO_OOP_SYNC_H
+#define LIBCO_OOP_SYNC_H
+
+#include "libco_oop/intrusive_list.h"
+#include "libco_oop/waiter.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace libco_oop {
+
+//============================================================================
+// CoMutex
+//============================================================================
+
+/**
+ * @brief 协程互斥锁
+ *
+ * 满足 Lockable 要求，可以用于 std::lock_guard / std::unique_lock。
+ * 不可重入；解锁者不必是加锁的协程。
+ */
+class CoMutex {
+public:
+    CoMutex() noexcept = default;
+    ~CoMutex() noexcept = default;
+
+    CoMutex(const CoMutex&) = delete;
+    CoMutex& operator=(const CoMutex&) = delete;
+
+    /**
+     * @brief 加锁，已被持有时挂起当前协程
+     */
+    void lock() noexcept
+    {
+        uint32_t expected = UNLOCKED;
+        if (state_.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+                                           std::memory_order_relaxed)) {
+            return;
+        }
+        lock_slow();
+    }
+
+    /**
+     * @brief 尝试加锁，不等待
+     */
+    bool try_lock() noexcept
+    {
+        uint32_t expected = UNLOCKED;
+        return state_.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 解锁，有等待者时把锁交给等待最久的一个
+     */
+    void unlock() noexcept
+    {
+        uint32_t expected = LOCKED;
+        if (state_.compare_exchange_strong(expected, UNLOCKED, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+            return;
+        }
+        unlock_slow();
+    }
+
+    /**
+     * @brief 锁是否被持有 (仅供诊断)
+     */
+    bool is_locked() const noexcept { return state_.load(std::memory_order_relaxed) != UNLOCKED; }
+
+private:
+    enum : uint32_t {
+        UNLOCKED = 0,
+        LOCKED = 1,         ///< 被持有，没有等待者
+        CONTENDED = 2       ///< 被持有，有等待者
+    };
+
+    std::atomic<uint32_t> state_{UNLOCKED};
+    std::mutex queue_mutex_;                    ///< 保护等待队列
+    IntrusiveList<detail::Waiter> waiters_;
+
+    void lock_slow() noexcept;
+    void unlock_slow() noexcept;
+};
+
+//============================================================================
+// CoCondVar
+//============================================================================
+
+/**
+ * @brief 协程条件变量，与 CoMutex 配合使用
+ *
+ * 没有虚假唤醒：wait() 只在 notify_one()/notify_all() 选中它之后返回。
+ */
+class CoCondVar {
+public:
+    CoCondVar() noexcept = default;
+    ~CoCondVar() noexcept = default;
+
+    CoCondVar(const CoCondVar&) = delete;
+    CoCondVar& operator=(const CoCondVar&) = delete;
+
+    /**
+     * @brief 释放 mutex 并等待通知，返回前重新加锁
+     * @param mutex 调用者持有的锁
+     */
+    void wait(CoMutex& mutex) noexcept;
+
+    /**
+     * @brief 等待直到 predicate() 为 true
+     */
+    template <typename Predicate>
+    void wait(CoMutex& mutex, Predicate predicate)
+    {
+        while (!predicate()) {
+            wait(mutex);
+        }
+    }
+
+    /**
+     * @brief 唤醒等待最久的一个等待者
+     */
+    void notify_one() noexcept;
+
+    /**
+     * @brief 唤醒所有等待者
+     */
+    void notify_all() noexcept;
+
+    /**
+     * @brief 没有等待者时的快速检查 (一次原子读)
+     */
+    bool has_waiters() const noexcept { return waiting_.load(std::memory_order_relaxed) != 0; }
+
+private:
+    std::atomic<size_t> waiting_{0};            ///< 等待者数，无等待者时 notify 不加锁
+    std::mutex queue_mutex_;                    ///< 保护等待队列
+    IntrusiveList<detail::Waiter> waiters_;
+};
+
+//============================================================================
+// CoSemaphore
+//============================================================================
+
+/**
+ * @brief 协程计数信号量
+ */
+class CoSemaphore {
+public:
+    /**
+     * @brief 创建信号量
+     * @param count 初始许可数
+     */
+    explicit CoSemaphore(int64_t count = 0) noexcept : count_(count) {}
+    ~CoSemaphore() noexcept = default;
+
+    CoSemaphore(const CoSemaphore&) = delete;
+    CoSemaphore& operator=(const CoSemaphore&) = delete;
+
+    /**
+     * @brief 获取一个许可，没有许可时挂起当前协程
+     */
+    void acquire() noexcept
+    {
+        // 计数为负时其绝对值是等待者数
+        if (count_.fetch_sub(1, std::memory_order_acquire) > 0) {
+            return;
+        }
+        acquire_slow();
+    }
+
+    /**
+     * @brief 尝试获取一个许可，不等待
+     */
+    bool try_acquire() noexcept
+    {
+        int64_t count = count_.load(std::memory_order_relaxed);
+        while (count > 0) {
+            if (count_.compare_exchange_weak(count, count - 1, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 释放一个许可，有等待者时直接交给等待最久的一个
+     */
+    void release() noexcept
+    {
+        if (count_.fetch_add(1, std::memory_order_release) >= 0) {
+            return;
+        }
+        release_slow();
+    }
+
+    /**
+     * @brief 当前可用的许可数 (负数表示等待者数，仅供诊断)
+     */
+    int64_t get_count() const noexcept { return count_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> count_;
+    std::mutex queue_mutex_;                    ///< 保护等待队列
+    IntrusiveList<detail::Waiter> waiters_;
+    size_t pending_ = 0;                        ///< 等待者入队之前到达的释放
+
+    void acquire_slow() noexcept;
+    void release_slow() noexcept;
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_SYNC_H
@@ -0,0 +1,537 @@
+/**
+ * @file task.h
+ * @brief C++20 无栈协程 (co_await) 与有栈协程运行时的互操作
+ * @author libco-oop
+ * @version 1.0
+ *
+ * Task<T> 是惰性启动的无栈协程，与有栈协程共用同一个调度器和事件循环，
+ * 不需要第二个线程池，也没有跨池的线程交接：
+ * - 有栈协程 (或普通线程) 通过 await_task() 等待 Task 完成，等待期间
+ *   只挂起当前有栈协程，同一线程上的其他协程继续运行
+ * - Task 通过 co_await stackful(fn) 等待一段有栈代码完成；Channel/IO
+ *   等会挂起的操作可以这样直接使用，async_recv()/async_send()/
+ *   async_wait_for() 是常用的包装
+ * - co_await async_sleep(ms) 直接把定时器登记到 IOManager，不占用栈
+ * - spawn_task() 把 Task 分离到调度器上运行；Task 在无栈等待处挂起期间
+ *   不占用有栈协程
+ *
+ * 需要 C++20 (xmake f --cxx20=y)；C++17 构建中本头文件为空，
+ * LIBCO_OOP_HAS_TASK 为 0。
+ */
+
+#ifndef LIBCO_OOP_TASK_H
+#define LIBCO_OOP_TASK_H
+
+#if defined(__cpp_impl_coroutine) && __cplusplus >= 202002L
+#define LIBCO_OOP_HAS_TASK 1
+#else
+#define LIBCO_OOP_HAS_TASK 0
+#endif
+
+#if LIBCO_OOP_HAS_TASK
+
+#include "libco_oop/coroutine_pool.h"
+#include "libco_oop/io_manager.h"
+#include "libco_oop/waiter.h"
+#include "libco_oop/work_stealing.h"
+#include <atomic>
+#include <cerrno>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#endif
+
+namespace libco_oop {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+/**
+ * @brief 分离的 Task 抛出的异常，由恢复它的宿主协程重新抛出
+ */
+inline thread_local std::exception_ptr t_detached_exception;
+
+/**
+ * @brief 清除无栈协程在有栈协程的栈上留下的 AddressSanitizer 标记
+ *
+ * 无栈协程以尾调用转移控制，返回时不清除自己栈帧的 redzone；
+ * AddressSanitizer 又不认识协程栈，之后在同一深度抛出异常会被误报为越界。
+ * 在 resume() 返回后调用，当前栈帧以下的部分都已失效。
+ */
+inline void unpoison_dead_frames() noexcept
+{
+#if defined(__SANITIZE_ADDRESS__)
+    Coroutine* coroutine = Coroutine::current();
+    Stack* stack = coroutine != nullptr ? coroutine->get_stack() : nullptr;
+    char* frame = static_cast<char*>(__builtin_frame_address(0));
+    if (stack != nullptr && stack->contains(frame)) {
+        char* base = static_cast<char*>(stack->get_base());
+        __asan_unpoison_memory_region(base, static_cast<size_t>(frame - base));
+    }
+#endif
+}
+
+/**
+ * @brief 在有栈宿主中恢复无栈协程
+ *
+ * 恢复期间结束的分离 Task 如果抛出了异常，在这里重新抛出，
+ * 宿主协程以异常结束，调度器的 run() 把它传给调用者。
+ */
+inline void resume_task(std::coroutine_handle<> handle)
+{
+    handle.resume();
+    unpoison_dead_frames();
+    if (t_detached_exception) {
+        std::exception_ptr exception = std::move(t_detached_exception);
+        t_detached_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+/**
+ * @brief 在当前调度器上启动一个有栈宿主协程运行 fn
+ * @return bool 当前线程没有调度器或创建失败时返回 false
+ */
+template <typename F>
+bool spawn_host(F&& fn)
+{
+    if (Scheduler* scheduler = Scheduler::current()) {
+        return CoroutinePool::local().spawn(*scheduler, std::forward<F>(fn)) != nullptr;
+    }
+    if (WorkStealingScheduler* scheduler = WorkStealingScheduler::current()) {
+        return scheduler->spawn(std::forward<F>(fn));
+    }
+    return false;
+}
+
+/**
+ * @brief Task 承诺对象的公共部分
+ */
+class TaskPromiseBase {
+public:
+    static constexpr uintptr_t kRunning = 0;    ///< 还没有结束，也没有有栈等待者
+    static constexpr uintptr_t kDone = 1;       ///< 已结束
+
+    /**
+     * @brief 结束时把控制转给等待者
+     */
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            TaskPromiseBase& promise = handle.promise();
+            if (promise.continuation_) {
+                return promise.continuation_;       // 对称转移，不增加栈深度
+            }
+            if (promise.detached_) {
+                if (promise.exception_) {
+                    t_detached_exception = std::move(promise.exception_);
+                }
+                handle.destroy();
+                return std::noop_coroutine();
+            }
+            // notify() 之后等待者可能立即销毁 Task，不能再访问帧
+            const uintptr_t previous = promise.state_.exchange(kDone, std::memory_order_acq_rel);
+            if (previous != kRunning) {
+                reinterpret_cast<Waiter*>(previous)->notify();
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+    /**
+     * @brief 登记有栈等待者
+     * @return bool Task 已经结束时返回 false，不需要等待
+     */
+    bool publish_waiter(Waiter* waiter) noexcept
+    {
+        uintptr_t expected = kRunning;
+        return state_.compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(waiter),
+                                              std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+
+    void set_continuation(std::coroutine_handle<> continuation) noexcept { continuation_ = continuation; }
+    void detach() noexcept { detached_ = true; }
+
+protected:
+    void rethrow_if_failed()
+    {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+private:
+    std::coroutine_handle<> continuation_;      ///< 等待本 Task 的无栈协程
+    std::exception_ptr exception_;              ///< 未捕获的异常
+    std::atomic<uintptr_t> state_{kRunning};    ///< kRunning / kDone / 有栈等待者 (Waiter*)
+    bool detached_ = false;                     ///< 由 spawn_task() 分离，结束时自行销毁
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value) { value_.emplace(std::forward<U>(value)); }
+
+    T take_result()
+    {
+        rethrow_if_failed();
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+    void take_result() { rethrow_if_failed(); }
+};
+
+} // namespace detail
+
+//============================================================================
+// Task
+//============================================================================
+
+/**
+ * @brief 惰性启动的无栈协程
+ * @tparam T 结果类型
+ *
+ * 创建后不运行，直到被 co_await、await_task() 或 spawn_task() 启动。
+ * Task 只能移动；销毁 Task 时一并销毁协程帧，因此不能在 Task 挂起
+ * 等待其他操作时销毁它。
+ */
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    Task() noexcept = default;
+    explicit Task(handle_type handle) noexcept : handle_(handle) {}
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() noexcept { reset(); }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    bool is_valid() const noexcept { return static_cast<bool>(handle_); }
+    bool is_done() const noexcept { return handle_ && handle_.done(); }
+
+    /**
+     * @brief 在无栈协程中等待：启动 Task，结束后对称转移回等待者
+     */
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter {
+            handle_type handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+            {
+                handle.promise().set_continuation(continuation);
+                return handle;
+            }
+
+            T await_resume() { return handle.promise().take_result(); }
+        };
+        return Awaiter{handle_};
+    }
+
+    /**
+     * @brief 放弃协程帧的所有权
+     */
+    handle_type release() noexcept { return std::exchange(handle_, nullptr); }
+
+private:
+    handle_type handle_;
+
+    void reset() noexcept
+    {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = nullptr;
+        }
+    }
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+//============================================================================
+// 有栈一侧：等待与分离 Task
+//============================================================================
+
+/**
+ * @brief 在有栈协程 (或普通线程) 中运行 Task 并等待它结束
+ * @return T Task 的结果；Task 抛出的异常在这里重新抛出
+ *
+ * Task 在调用者的栈上启动，运行到第一次挂起；之后挂起当前有栈协程
+ * (普通线程则阻塞)，Task 结束时由恢复它的一方唤醒。
+ *
+ * 不经过 AddressSanitizer 插桩：异常从这里抛出时，展开的栈帧上不能
+ * 留下 redzone 标记 (协程栈上的标记不会被 AddressSanitizer 清除)。
+ */
+template <typename T>
+__attribute__((no_sanitize_address))
+T await_task(Task<T> task)
+{
+    auto handle = task.release();
+    struct Guard {
+        std::coroutine_handle<detail::TaskPromise<T>> handle;
+        ~Guard() { handle.destroy(); }
+    } guard{handle};
+
+    detail::Waiter waiter;
+    handle.resume();
+    detail::unpoison_dead_frames();
+    if (handle.promise().publish_waiter(&waiter)) {
+        waiter.wait();
+    }
+    return handle.promise().take_result();
+}
+
+/**
+ * @brief 把 Task 分离到调度器上运行
+ * @param scheduler 运行 Task 的调度器，必须属于当前线程
+ * @return bool 创建宿主协程失败时返回 false 并设置 errno，Task 被销毁
+ *
+ * Task 在协程池借出的宿主协程中启动。co_await stackful() 等有栈操作
+ * 直接在宿主的栈上运行；Task 在 async_sleep() 等无栈等待处挂起时宿主
+ * 结束并回到池中，之后由唤醒它的一方继续运行。Task 抛出的异常从恢复它的宿主协程中
+ * 重新抛出，最终由 scheduler.run() 抛给调用者。
+ */
+inline bool spawn_task(Scheduler& scheduler, Task<void> task)
+{
+    auto handle = task.release();
+    if (!handle) {
+        errno = EINVAL;
+        return false;
+    }
+    handle.promise().detach();
+    if (CoroutinePool::local().spawn(scheduler, [handle] { detail::resume_task(handle); }) == nullptr) {
+        handle.destroy();
+        return false;
+    }
+    return true;
+}
+
+//============================================================================
+// 无栈一侧：等待有栈操作
+//============================================================================
+
+/**
+ * @brief 在无栈协程中等待一段有栈代码
+ * @tparam F 可调用对象，可以调用 Channel、IOManager 等会挂起当前协程的操作
+ *
+ * - 已经在有栈协程中恢复时直接在当前栈上运行，没有额外开销
+ * - 否则在当前调度器上借出一个有栈协程运行 fn，结束后在该协程中恢复 Task
+ * - 当前线程没有调度器 (或借出失败) 时在调用线程上直接运行
+ */
+template <typename F>
+class StackfulAwaiter {
+public:
+    using result_type = std::invoke_result_t<F&>;
+
+    explicit StackfulAwaiter(F fn) : fn_(std::move(fn)) {}
+
+    bool await_ready() const noexcept { return Coroutine::current() != nullptr; }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        // 宿主恢复 Task 之后本对象可能已随协程帧销毁，宿主不能再访问它
+        return detail::spawn_host([this, handle] {
+            run();
+            detail::resume_task(handle);
+        });
+    }
+
+    result_type await_resume()
+    {
+        if (!finished_) {
+            run();
+        }
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+        if constexpr (!std::is_void_v<result_type>) {
+            return std::move(*result_);
+        }
+    }
+
+private:
+    using storage_type = std::conditional_t<std::is_void_v<result_type>, bool, result_type>;
+
+    F fn_;
+    std::optional<storage_type> result_;
+    std::exception_ptr exception_;
+    bool finished_ = false;
+
+    void run() noexcept
+    {
+        try {
+            if constexpr (std::is_void_v<result_type>) {
+                fn_();
+            } else {
+                result_.emplace(fn_());
+            }
+        } catch (...) {
+            exception_ = std::current_exception();
+        }
+        finished_ = true;
+    }
+};
+
+/**
+ * @brief co_await stackful(fn)：在有栈上下文中运行 fn 并取得结果
+ */
+template <typename F>
+StackfulAwaiter<std::decay_t<F>> stackful(F&& fn)
+{
+    return StackfulAwaiter<std::decay_t<F>>(std::forward<F>(fn));
+}
+
+/**
+ * @brief 从通道接收
+ * @return 通道关闭或出错时为空 (errno 同 recv())
+ */
+template <template <typename> class Channel, typename T>
+auto async_recv(Channel<T>& channel)
+{
+    return stackful([&channel]() -> std::optional<T> {
+        T value;
+        if (!channel.recv(value)) {
+            return std::nullopt;
+        }
+        return std::optional<T>(std::move(value));
+    });
+}
+
+/**
+ * @brief 向通道发送
+ * @return bool 同 send()
+ */
+template <template <typename> class Channel, typename T, typename U>
+auto async_send(Channel<T>& channel, U&& value)
+{
+    return stackful([&channel, item = T(std::forward<U>(value))]() mutable {
+        return channel.send(std::move(item));
+    });
+}
+
+/**
+ * @brief 等待 fd 上的事件就绪
+ * @return int 同 IOManager::wait_for()
+ */
+inline auto async_wait_for(IOManager& io, int fd, IOEventType type, int64_t timeout_ms = -1)
+{
+    return stackful([&io, fd, type, timeout_ms] { return io.wait_for(fd, type, timeout_ms); });
+}
+
+//============================================================================
+// 无栈一侧：定时器
+//============================================================================
+
+/**
+ * @brief co_await async_sleep(ms)：睡眠期间不占用任何栈
+ *
+ * 定时器节点嵌在等待者中，到期时在调度循环中借出宿主协程恢复 Task。
+ * 结果同 co_sleep()：不在 IOManager 的线程上时立即返回 -1 (EPERM)。
+ */
+class SleepAwaiter {
+public:
+    explicit SleepAwaiter(uint64_t ms) noexcept : ms_(ms), io_(IOManager::current()) {}
+
+    bool await_ready() const noexcept { return io_ == nullptr; }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        handle_ = handle;
+        timer_.callback = &SleepAwaiter::on_timer;
+        timer_.context = this;
+        return io_->add_timer(&timer_, ms_);
+    }
+
+    int await_resume() const noexcept
+    {
+        if (io_ == nullptr) {
+            errno = EPERM;
+            return -1;
+        }
+        return 0;
+    }
+
+private:
+    uint64_t ms_;
+    IOManager* io_;
+    TimerNode timer_;
+    std::coroutine_handle<> handle_;
+
+    static void on_timer(TimerNode* node)
+    {
+        SleepAwaiter* self = static_cast<SleepAwaiter*>(node->context);
+        const std::coroutine_handle<> handle = self->handle_;
+        if (CoroutinePool::local().spawn(*self->io_, [handle] { detail::resume_task(handle); }) == nullptr) {
+            handle.resume();
+        }
+    }
+};
+
+inline SleepAwaiter async_sleep(uint64_t ms) noexcept
+{
+    return SleepAwaiter(ms);
+}
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_HAS_TASK
+
+#endif // LIBCO_OOP_TASK_H
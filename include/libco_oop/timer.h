@@ -0,0 +1,160 @@
+/**
+ * @file timer.h
+ * @brief 分层时间轮定时器
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 面向“大量插入、几乎总被取消”的超时场景 (例如每连接的空闲超时)：
+ * - 插入和取消都是 O(1)，不分配内存：定时器节点侵入式地嵌入在
+ *   宿主对象中 (每个协程控制块内嵌一个)
+ * - 5 层时间轮，精度 1ms：第 0 层 256 个槽，其余各层 64 个槽，
+ *   覆盖约 49 天；更远的到期时刻被截断到最远层，级联时重新放置
+ * - 每层一个占用位图，推进时钟时跳过空槽，计算下一次到期也只查位图
+ */
+
+#ifndef LIBCO_OOP_TIMER_H
+#define LIBCO_OOP_TIMER_H
+
+#include "libco_oop/intrusive_list.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace libco_oop {
+
+/**
+ * @brief 定时器节点
+ *
+ * 嵌入在宿主对象中，由宿主管理生命周期；节点在时间轮中时宿主不能销毁。
+ */
+struct TimerNode : IntrusiveListNode {
+    using Callback = void (*)(TimerNode* node);
+
+    Callback callback = nullptr;                ///< 到期时调用，调用前节点已离开时间轮
+    void* context = nullptr;                    ///< 回调使用的用户数据
+    uint64_t deadline = 0;                      ///< 到期时刻 (毫秒)
+    IntrusiveList<TimerNode>* slot = nullptr;   ///< 所在的槽位
+
+    /**
+     * @brief 节点是否在时间轮中等待到期
+     */
+    bool is_pending() const noexcept { return is_linked(); }
+};
+
+/**
+ * @brief 分层时间轮
+ *
+ * 时间以调用者提供的毫秒数表示 (通常为 now_ms())，非线程安全。
+ */
+class TimerManager {
+public:
+    static constexpr unsigned kLevels = 5;                  ///< 层数
+    static constexpr unsigned kLevel0Bits = 8;              ///< 第 0 层 256 个槽
+    static constexpr unsigned kLevelBits = 6;               ///< 其余各层 64 个槽
+    static constexpr uint64_t kMaxDelay = (uint64_t(1) << (kLevel0Bits + kLevelBits * (kLevels - 1))) - 1;
+
+    /**
+     * @brief 创建时间轮
+     * @param now_ms 起始时刻
+     */
+    explicit TimerManager(uint64_t now_ms = 0) noexcept;
+    ~TimerManager() noexcept;
+
+    TimerManager(const TimerManager&) = delete;
+    TimerManager& operator=(const TimerManager&) = delete;
+
+    /**
+     * @brief 当前单调时钟 (毫秒)
+     */
+    static uint64_t now_ms() noexcept;
+
+    /**
+     * @brief 插入定时器，O(1)
+     * @param node 定时器节点，callback 不能为空
+     * @param deadline 到期时刻；已过去的时刻在下一次 advance() 时到期
+     * @return bool 节点已在时间轮中或没有回调时返回 false
+     */
+    bool add(TimerNode* node, uint64_t deadline) noexcept;
+
+    /**
+     * @brief 取消定时器，O(1)
+     * @return bool 节点不在时间轮中 (已到期或未插入) 时返回 false
+     */
+    bool cancel(TimerNode* node) noexcept;
+
+    /**
+     * @brief 推进时钟到 now，依次调用到期定时器的回调
+     * @return size_t 到期的定时器数
+     *
+     * 回调中可以插入和取消定时器；回调中插入的已到期定时器推迟到下一毫秒，
+     * 避免零延迟的周期定时器在一次推进中无限循环。
+     */
+    size_t advance(uint64_t now);
+
+    /**
+     * @brief 距离下一个非空槽位的毫秒数，用作 epoll_wait 的超时
+     * @return int64_t 没有定时器时返回 -1；已有到期定时器时返回 0
+     *
+     * 只有更高层有定时器时返回下一次级联的时刻，可能早于真正的到期时刻。
+     */
+    int64_t next_timeout(uint64_t now) const noexcept;
+
+    /**
+     * @brief 移出所有定时器而不调用回调
+     * @param fn 对每个移出的节点调用
+     */
+    template <typename F>
+    void drain(F&& fn)
+    {
+        for_each_slot([&](IntrusiveList<TimerNode>& slot) {
+            while (TimerNode* node = slot.pop_front()) {
+                node->slot = nullptr;
+                fn(node);
+            }
+        });
+        clear_bits();
+    }
+
+    size_t size() const noexcept { return count_; }
+    bool empty() const noexcept { return count_ == 0; }
+
+    /**
+     * @brief 下一个待处理的时刻 (之前的时刻都已处理)
+     */
+    uint64_t get_current() const noexcept { return current_; }
+
+private:
+    static constexpr unsigned kLevel0Size = 1u << kLevel0Bits;
+    static constexpr unsigned kLevelSize = 1u << kLevelBits;
+
+    IntrusiveList<TimerNode> level0_[kLevel0Size];
+    IntrusiveList<TimerNode> levels_[kLevels - 1][kLevelSize];
+    uint64_t level0_bits_[kLevel0Size / 64] = {};   ///< 第 0 层非空槽位图
+    uint64_t level_bits_[kLevels - 1] = {};         ///< 其余各层非空槽位图
+    uint64_t current_;                              ///< 下一个待处理的时刻
+    size_t count_ = 0;                              ///< 定时器总数
+    size_t higher_count_ = 0;                       ///< 第 1 层及以上的定时器数
+    bool firing_ = false;                           ///< 是否正在调用回调
+
+    void place(TimerNode* node) noexcept;
+    void unlink(TimerNode* node) noexcept;
+    void cascade() noexcept;
+    int find_level0(unsigned from) const noexcept;
+    void clear_bits() noexcept;
+
+    template <typename F>
+    void for_each_slot(F&& fn)
+    {
+        for (auto& slot : level0_) {
+            fn(slot);
+        }
+        for (auto& level : levels_) {
+            for (auto& slot : level) {
+                fn(slot);
+            }
+        }
+    }
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_TIMER_H
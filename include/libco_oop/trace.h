@@ -0,0 +1,241 @@
+/**
+ * @file trace.h
+ * @brief 调度事件跟踪
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 记录协程切入、切出、IO等待、定时器唤醒和窃取事件，用于定位长尾延迟
+ * (哪个协程长时间占用了线程)：
+ * - 每线程一个环形缓冲区，只由所属线程写入，满了覆盖最旧的事件
+ * - 时间戳为周期计数器 (metrics::read_cycles())，导出时换算为微秒
+ * - collect() 可在任意线程上调用，不阻塞写入者；format_chrome_trace()
+ *   输出 Chrome/Perfetto 可直接打开的 JSON (chrome://tracing、ui.perfetto.dev)
+ *
+ * LIBCO_OOP_TRACING 为0时 record() 为空函数，start() 返回 false；
+ * 编译进来之后在 start() 之前每个事件只多一次 relaxed 读和一次分支。
+ */
+
+#ifndef LIBCO_OOP_TRACE_H
+#define LIBCO_OOP_TRACE_H
+
+#include "libco_oop/intrusive_list.h"
+#include "libco_oop/metrics.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 是否编译调度事件跟踪
+ *
+ * 默认只在调试构建 (DEBUG) 或插桩构建 (LIBCO_OOP_INSTRUMENT) 中开启，
+ * 也可以由 xmake 选项 trace 单独开启。宏不影响任何类型的布局，
+ * 只决定 record() 是否为空函数；是否能开始记录由库编译时的取值决定。
+ */
+#ifndef LIBCO_OOP_TRACING
+    #if defined(DEBUG) || defined(LIBCO_OOP_INSTRUMENT)
+        #define LIBCO_OOP_TRACING 1
+    #else
+        #define LIBCO_OOP_TRACING 0
+    #endif
+#endif
+
+namespace libco_oop {
+namespace trace {
+
+constexpr bool kEnabled = LIBCO_OOP_TRACING != 0;
+
+/// 每线程环形缓冲区的默认容量 (事件数)
+constexpr size_t kDefaultCapacity = 16 * 1024;
+
+/**
+ * @brief 事件类型
+ */
+enum class EventType : uint8_t {
+    SWITCH_IN,      ///< 协程被切入
+    SWITCH_OUT,     ///< 协程让出、挂起或结束
+    IO_PARK,        ///< 协程开始等待IO (arg 为 fd，io_uring 请求为操作码)
+    TIMER_WAKE,     ///< 定时器到期唤醒协程
+    STEAL           ///< 工作线程窃取到协程 (arg 为被窃取的工作线程序号)
+};
+
+/**
+ * @brief 一个事件
+ */
+struct Event {
+    uint64_t cycles = 0;            ///< 周期计数器时间戳
+    uint64_t coroutine_id = 0;      ///< 协程ID
+    uint32_t arg = 0;               ///< 事件参数
+    EventType type = EventType::SWITCH_IN;
+};
+
+/**
+ * @brief 一个线程的事件
+ */
+struct ThreadTrace {
+    uint32_t tid = 0;               ///< 内核线程ID
+    uint64_t dropped = 0;           ///< 被覆盖的事件数
+    std::vector<Event> events;      ///< 按时间顺序的事件
+};
+
+/**
+ * @brief 跟踪快照
+ */
+struct TraceSnapshot {
+    uint64_t start_cycles = 0;      ///< 第一次 start() 时的周期计数
+    double cycles_per_us = 0;       ///< 周期计数器频率
+    std::vector<ThreadTrace> threads;
+};
+
+/**
+ * @brief 单写者环形缓冲区
+ *
+ * 写入者先递增 head_ 再写槽位，写完后发布 committed_；读取者拷贝
+ * committed_ 之前的槽位，再读 head_ 丢弃拷贝期间可能被覆盖的部分。
+ * 槽位由 relaxed 原子字组成，读写并发时没有数据竞争。
+ */
+class ThreadRing : public IntrusiveListNode {
+public:
+    /**
+     * @brief 构造环形缓冲区
+     * @param capacity 容量，向上取整到 2 的幂
+     */
+    explicit ThreadRing(size_t capacity);
+
+    ThreadRing(const ThreadRing&) = delete;
+    ThreadRing& operator=(const ThreadRing&) = delete;
+
+    void push(EventType type, uint64_t coroutine_id, uint32_t arg) noexcept
+    {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        head_.store(head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Slot& slot = slots_[head & mask_];
+        slot.cycles.store(metrics::read_cycles(), std::memory_order_relaxed);
+        slot.coroutine_id.store(coroutine_id, std::memory_order_relaxed);
+        slot.word.store(static_cast<uint64_t>(arg) << 8 | static_cast<uint8_t>(type),
+                        std::memory_order_relaxed);
+        committed_.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 读取缓冲区中仍然有效的事件
+     */
+    ThreadTrace read() const;
+
+    /**
+     * @brief 丢弃所有事件，只能在写入者不再写入时调用
+     */
+    void clear() noexcept;
+
+    size_t get_capacity() const noexcept { return mask_ + 1; }
+    uint32_t get_tid() const noexcept { return tid_; }
+
+    bool is_retired() const noexcept { return retired_.load(std::memory_order_acquire); }
+    void retire() noexcept { retired_.store(true, std::memory_order_release); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> cycles{0};
+        std::atomic<uint64_t> coroutine_id{0};
+        std::atomic<uint64_t> word{0};      ///< arg << 8 | type
+    };
+
+    std::unique_ptr<Slot[]> slots_;         ///< 槽位
+    size_t mask_;                           ///< 容量 - 1
+    uint32_t tid_;                          ///< 所属线程
+    std::atomic<uint64_t> head_{0};         ///< 已占用的槽位数 (先于写入递增)
+    std::atomic<uint64_t> committed_{0};    ///< 已写完的槽位数
+    std::atomic<bool> retired_{false};      ///< 所属线程已退出
+};
+
+namespace detail {
+
+extern std::atomic<bool> g_running;
+
+/**
+ * @brief 获取当前线程的环形缓冲区，第一次调用时创建并登记
+ * @return ThreadRing* 内存不足时返回 nullptr
+ */
+ThreadRing* local_ring() noexcept;
+
+} // namespace detail
+
+/**
+ * @brief 开始记录
+ * @param capacity 之后新建的每线程缓冲区容量 (事件数)
+ * @return bool 未编译跟踪时返回 false
+ */
+bool start(size_t capacity = kDefaultCapacity) noexcept;
+
+/**
+ * @brief 停止记录，已记录的事件保留到 clear()
+ */
+void stop() noexcept;
+
+/**
+ * @brief 是否正在记录
+ */
+inline bool is_running() noexcept
+{
+#if LIBCO_OOP_TRACING
+    return detail::g_running.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 记录一个事件
+ * @param type 事件类型
+ * @param coroutine_id 协程ID
+ * @param arg 事件参数
+ */
+inline void record(EventType type, uint64_t coroutine_id, uint32_t arg = 0) noexcept
+{
+#if LIBCO_OOP_TRACING
+    if (!detail::g_running.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (ThreadRing* ring = detail::local_ring()) {
+        ring->push(type, coroutine_id, arg);
+    }
+#else
+    (void)type;
+    (void)coroutine_id;
+    (void)arg;
+#endif
+}
+
+/**
+ * @brief 读取所有线程 (含已退出的线程) 的事件
+ */
+TraceSnapshot collect();
+
+/**
+ * @brief 丢弃所有事件并释放已退出线程的缓冲区，应在 stop() 之后调用
+ */
+void clear() noexcept;
+
+/**
+ * @brief 把快照格式化为 Chrome trace event JSON
+ *
+ * 切入/切出对应一个名为 "co <id>" 的时间片 (B/E)，其余事件为瞬时事件；
+ * 缓冲区覆盖导致没有切入的切出被丢弃。
+ */
+std::string format_chrome_trace(const TraceSnapshot& snapshot);
+
+/**
+ * @brief 读取当前所有事件并写入 Chrome trace JSON 文件
+ * @param path 输出文件路径
+ * @return bool 写入失败时返回 false 并设置 errno
+ */
+bool dump_chrome_trace(const char* path);
+
+} // namespace trace
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_TRACE_H
@@ -0,0 +1,77 @@
+/**
+ * @file waiter.h
+ * @brief 协程同步原语共用的等待者
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 等待者在构造时按当前上下文选择挂起方式，唤醒者不必知道对方在哪里运行：
+ * - IOManager 拥有的协程：park()/unpark()，可以被任意线程唤醒
+ * - 工作窃取调度器的协程：WorkStealingScheduler::suspend()/schedule()
+ * - 其他调度器拥有的协程：Scheduler::suspend()/schedule()，唤醒者必须在同一线程
+ * - 其他上下文 (普通线程)：在 futex 上阻塞线程
+ *
+ * 协程等待者让出的是协程而不是线程，同一线程上的其他协程继续运行。
+ */
+
+#ifndef LIBCO_OOP_WAITER_H
+#define LIBCO_OOP_WAITER_H
+
+#include "libco_oop/intrusive_list.h"
+#include "libco_oop/io_manager.h"
+#include <atomic>
+#include <cstdint>
+
+namespace libco_oop {
+
+class WorkStealingScheduler;
+
+namespace detail {
+
+/**
+ * @brief 等待者，位于等待者自己的栈上，可放入侵入式等待队列
+ */
+class Waiter : public IntrusiveListNode {
+public:
+    /**
+     * @brief 绑定当前上下文
+     */
+    Waiter() noexcept;
+
+    Waiter(const Waiter&) = delete;
+    Waiter& operator=(const Waiter&) = delete;
+
+    /**
+     * @brief 挂起或阻塞，直到 notify()
+     */
+    void wait() noexcept;
+
+    /**
+     * @brief 唤醒等待者，每个等待者只能调用一次
+     *
+     * 返回后不再访问等待者，等待者可以立即销毁。
+     */
+    void notify() noexcept;
+
+private:
+    enum class Kind : uint8_t {
+        THREAD,         ///< futex
+        SCHEDULER,      ///< 单线程调度器
+        WORK_STEALING,  ///< 工作窃取调度器
+        IO_MANAGER      ///< IOManager::park()
+    };
+
+    /// 工作窃取等待者的完成阶段 (其他种类只使用 0 和 1)
+    static constexpr uint32_t kNotifying = 1;   ///< 唤醒者正在 schedule()
+    static constexpr uint32_t kNotified = 2;    ///< schedule() 已返回，等待者可以结束
+
+    RemoteWakeup wakeup_;                       ///< 当前协程及其 IOManager
+    Scheduler* scheduler_ = nullptr;
+    WorkStealingScheduler* work_stealing_ = nullptr;
+    std::atomic<uint32_t> signaled_{0};         ///< futex 字 / 协程等待者的完成标志
+    Kind kind_ = Kind::THREAD;
+};
+
+} // namespace detail
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_WAITER_H
@@ -0,0 +1,237 @@
+/**
+ * @file work_stealing.h
+ * @brief 多线程工作窃取调度器 (M:N)
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 每个工作线程持有一个 Chase-Lev 双端队列：本线程产生的就绪协程压入
+ * 底部并从底部取出，空闲的工作线程从随机选择的其他线程顶部窃取。
+ * 其他线程提交的协程进入全局注入队列。
+ *
+ * 挂起的协程只持有私有栈上的帧和 RegisterState 中的被调用者保存寄存器，
+ * 因此可以在任意工作线程上恢复。共享栈和混合栈不能跨线程使用。
+ */
+
+#ifndef LIBCO_OOP_WORK_STEALING_H
+#define LIBCO_OOP_WORK_STEALING_H
+
+#include "libco_oop/coroutine.h"
+#include "libco_oop/intrusive_list.h"
+#include "libco_oop/metrics.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace libco_oop {
+
+/**
+ * @brief 工作窃取调度器选项
+ */
+struct WorkStealingOptions {
+    size_t worker_count = 0;        ///< 工作线程数，0 表示 CPU 核数
+    size_t deque_capacity = 1024;   ///< 每个工作线程队列的初始容量
+    int spin_rounds = 64;           ///< 找不到任务时休眠前的尝试轮数
+    bool pin_workers = false;       ///< 是否把工作线程绑定到 CPU 核
+};
+
+/**
+ * @brief 工作窃取调度器统计信息
+ */
+struct WorkStealingStatistics {
+    uint64_t spawned = 0;       ///< 交给调度器的协程数
+    uint64_t finished = 0;      ///< 已结束并销毁的协程数
+    uint64_t dispatches = 0;    ///< 切入协程的次数
+    uint64_t steals = 0;        ///< 从其他线程窃取成功的次数
+    uint64_t parks = 0;         ///< 工作线程休眠次数
+    uint64_t wakeups = 0;       ///< 唤醒休眠工作线程的次数
+};
+
+/**
+ * @brief 多线程工作窃取调度器
+ *
+ * 调度器拥有交给它的协程，协程结束后由执行它的工作线程销毁。
+ * 协程只能通过本类的 yield()/suspend() 让出；在协程中直接调用
+ * Coroutine::yield() 等同于 suspend()。不支持 yield_to() 和嵌套恢复。
+ *
+ * 用 suspend() 挂起的协程由唤醒者 (可以在任意线程) 调用 schedule() 放回；
+ * 在协程真正切换出去之前到达的唤醒不会丢失。
+ */
+class WorkStealingScheduler {
+public:
+    /**
+     * @brief 构造调度器并启动工作线程
+     */
+    explicit WorkStealingScheduler(const WorkStealingOptions& opts = WorkStealingOptions{});
+
+    /**
+     * @brief 停止并等待工作线程退出，销毁仍在队列中的协程
+     */
+    ~WorkStealingScheduler() noexcept;
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    /**
+     * @brief 创建协程并放入调度器 (任意线程)
+     * @return bool 创建失败或选项使用了共享栈时返回 false
+     *
+     * 不返回协程指针：协程可能在返回前就已在其他线程上结束并被销毁。
+     */
+    template <typename F>
+    bool spawn(F&& fn, const CoroutineOptions& opts = CoroutineOptions{})
+    {
+        return submit(Coroutine::create(std::forward<F>(fn), opts));
+    }
+
+    /**
+     * @brief 把已创建的协程交给调度器 (任意线程)
+     * @param coroutine 处于 READY/SUSPENDED 状态、使用私有栈的协程
+     * @return bool 协程为空、不可恢复或使用共享栈时返回 false
+     */
+    bool submit(CoroutinePtr coroutine) noexcept;
+
+    /**
+     * @brief 为 [begin, end) 中的每个元素创建一个运行 fn(element) 的协程并放入调度器 (任意线程)
+     * @param fn 可拷贝的 void(element&) 可调用对象，每个协程持有一份副本
+     * @return size_t 交给调度器的协程数；任一协程创建失败时全部丢弃并返回 0
+     */
+    template <typename Iterator, typename F>
+    size_t spawn_batch(Iterator begin, Iterator end, const F& fn, const CoroutineOptions& opts = CoroutineOptions{})
+    {
+        CoroutineBatch batch;
+        if (!batch.add_each(begin, end, fn, opts)) {
+            return 0;
+        }
+        return submit_batch(batch);
+    }
+
+    /**
+     * @brief 把一批协程一次交给调度器 (任意线程)
+     * @param batch 全部处于 READY/SUSPENDED 状态、使用私有栈的协程
+     * @return size_t 交给调度器的协程数；批次中有不可提交的协程时返回 0，批次保持不变
+     *
+     * 在本调度器的工作线程中调用时，本线程按工作线程数分得的一份一次压入
+     * 本地队列，其余进入注入队列；注入队列只加锁一次，并唤醒足够多的休眠者，
+     * 各工作线程每次从注入队列取走一份，一次发布到自己的本地队列。
+     */
+    size_t submit_batch(CoroutineBatch& batch) noexcept;
+
+    /**
+     * @brief 唤醒用 suspend() 挂起的协程 (任意线程)
+     * @param coroutine 本调度器拥有且尚未结束的协程
+     * @return bool coroutine 为空时返回 false；已在队列中时返回 true
+     */
+    bool schedule(Coroutine* coroutine) noexcept;
+
+    /**
+     * @brief 等待所有协程结束
+     *
+     * 协程因未捕获的异常结束时，重新抛出第一个异常。
+     * 不能在工作线程中调用。
+     */
+    void wait();
+
+    /**
+     * @brief 停止工作线程 (析构时自动调用)
+     *
+     * 正在运行的协程让出后工作线程退出，队列中剩余的协程被销毁。
+     */
+    void shutdown() noexcept;
+
+    /**
+     * @brief 获取当前工作线程所属的调度器
+     * @return WorkStealingScheduler* 不在工作线程中时返回 nullptr
+     */
+    static WorkStealingScheduler* current() noexcept;
+
+    /**
+     * @brief 获取当前工作线程的编号
+     * @return size_t 不在工作线程中时返回 SIZE_MAX
+     *
+     * 协程可能在两次调用之间迁移到其他工作线程。
+     */
+    static size_t current_worker_index() noexcept;
+
+    /**
+     * @brief 让出当前协程，稍后在某个工作线程上继续执行
+     * @return bool 不在调度器运行的协程中调用时返回 false
+     */
+    static bool yield() noexcept;
+
+    /**
+     * @brief 挂起当前协程，直到 schedule() 唤醒
+     * @return bool 不在调度器运行的协程中调用时返回 false
+     */
+    static bool suspend() noexcept;
+
+    size_t get_worker_count() const noexcept { return workers_.size(); }
+    size_t get_live_count() const noexcept { return live_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 汇总各工作线程的统计信息 (近似值)
+     */
+    WorkStealingStatistics get_statistics() const noexcept;
+
+    /**
+     * @brief 读取运行指标 (可以在任意线程调用)
+     *
+     * 切换和窃取次数取自各工作线程一直维护的计数器，
+     * 运行指标关闭时同样可用，只是不登记到 metrics::snapshot()。
+     */
+    metrics::SchedulerMetrics get_metrics() const noexcept;
+
+private:
+    struct Worker;
+
+    WorkStealingOptions options_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex inject_mutex_;                       ///< 保护注入队列
+    IntrusiveList<Coroutine> injected_;             ///< 非工作线程提交的协程
+    std::atomic<size_t> injected_size_{0};          ///< 注入队列长度 (无锁检查)
+
+    std::mutex park_mutex_;                         ///< 休眠/唤醒
+    std::condition_variable park_cv_;
+    std::atomic<uint64_t> park_epoch_{0};           ///< 每次唤醒递增
+    std::atomic<int> sleepers_{0};                  ///< 正在休眠或准备休眠的工作线程数
+    std::atomic<bool> stopping_{false};
+
+    std::atomic<size_t> live_{0};                   ///< 尚未结束的协程数
+    std::atomic<uint64_t> spawned_{0};
+    std::atomic<uint64_t> finished_{0};
+    std::atomic<uint64_t> wakeups_{0};
+    std::mutex done_mutex_;                         ///< 等待全部结束
+    std::condition_variable done_cv_;
+    std::exception_ptr exception_;                  ///< 第一个未捕获的异常 (受 done_mutex_ 保护)
+    metrics::Source metrics_source_;                ///< 快照登记 (只在 LIBCO_OOP_METRICS 开启时登记)
+
+    /**
+     * @brief 获取当前线程的工作线程对象
+     *
+     * 不内联：协程迁移后必须重新读取线程局部变量。
+     */
+    static Worker* current_worker() noexcept;
+
+    void worker_main(Worker& worker) noexcept;
+    Coroutine* find_work(Worker& worker) noexcept;
+    Coroutine* next_local(Worker& worker) noexcept;
+    Coroutine* take_injected(Worker& worker) noexcept;
+    Coroutine* steal(Worker& worker) noexcept;
+    bool has_visible_work() const noexcept;
+    void park(Worker& worker) noexcept;
+    void dispatch(Worker& worker, Coroutine* coroutine) noexcept;
+    void enqueue(Coroutine* coroutine) noexcept;
+    void notify(size_t count = 1) noexcept;
+    void retire(Coroutine* coroutine) noexcept;
+    static void collect_metrics(const void* owner, metrics::SchedulerMetrics& out) noexcept;
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_WORK_STEALING_H
@@ -0,0 +1,127 @@
+/**
+ * @file zero_copy.h
+ * @brief MSG_ZEROCOPY 发送
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 大块写入使用 MSG_ZEROCOPY 时内核直接引用用户页，不把数据拷贝进套接字缓冲区，
+ * 但在完成通知 (错误队列上的 SO_EE_ORIGIN_ZEROCOPY) 到达之前页面不能被修改。
+ * ZeroCopySender 把每次零拷贝 sendmsg 发出的 BufferChain 片段移入待完成环，
+ * 持有块的引用直到通知到达，通知到达后块才回到 BufferPool 被复用：
+ * - 小于阈值的写入直接拷贝发送 (固定页面和处理通知的开销大于拷贝)
+ * - 待完成的发送达到上限、或超过套接字的 optmem 限制 (ENOBUFS) 时
+ *   分别先等待通知、或这一次改为拷贝发送
+ * - 不支持 SO_ZEROCOPY 的套接字 (例如 UNIX 域套接字) 全部拷贝发送
+ */
+
+#ifndef LIBCO_OOP_ZERO_COPY_H
+#define LIBCO_OOP_ZERO_COPY_H
+
+#include "libco_oop/buffer.h"
+#include "libco_oop/io_manager.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace libco_oop {
+
+/**
+ * @brief 零拷贝发送选项
+ */
+struct ZeroCopyOptions {
+    size_t threshold = 16 * 1024;   ///< 一次 sendmsg 不少于这么多字节时使用 MSG_ZEROCOPY
+    size_t max_pending = 256;       ///< 最多同时等待通知的零拷贝发送数
+};
+
+/**
+ * @brief 零拷贝发送统计信息
+ */
+struct ZeroCopyStatistics {
+    uint64_t zerocopy_sends = 0;    ///< 带 MSG_ZEROCOPY 的 sendmsg 次数
+    uint64_t copied_sends = 0;      ///< 拷贝发送的 sendmsg 次数
+    uint64_t fallbacks = 0;         ///< 因 ENOBUFS 改为拷贝发送的次数
+    uint64_t completions = 0;       ///< 收到通知的零拷贝发送数
+    uint64_t kernel_copied = 0;     ///< 其中内核仍然拷贝了数据的发送数 (例如回环、不支持的网卡)
+};
+
+/**
+ * @brief 一个套接字上的零拷贝发送端
+ *
+ * 套接字上的零拷贝发送必须全部经过同一个 ZeroCopySender (通知按发送次数编号)。
+ * 需要在 IOManager 的协程中使用；等待通知时占用该 fd 的写等待槽。
+ *
+ * 销毁前应调用 flush()：销毁时仍未完成的发送直接释放引用，块被复用后
+ * 内核可能发出被覆盖的数据。
+ */
+class ZeroCopySender {
+public:
+    /**
+     * @param fd 非阻塞的 TCP 套接字；构造时设置 SO_ZEROCOPY
+     */
+    ZeroCopySender(IOManager& io, int fd, const ZeroCopyOptions& opts = ZeroCopyOptions{});
+    ~ZeroCopySender() noexcept;
+
+    ZeroCopySender(const ZeroCopySender&) = delete;
+    ZeroCopySender& operator=(const ZeroCopySender&) = delete;
+
+    /**
+     * @brief 套接字是否启用了 SO_ZEROCOPY
+     */
+    bool is_zerocopy() const noexcept { return enabled_; }
+
+    /**
+     * @brief 发送 chain 的全部数据，发出的部分从 chain 中移走
+     * @param flags sendmsg 的标志 (不需要包含 MSG_ZEROCOPY)
+     * @return ssize_t 发送的字节数；失败返回 -1 并设置 errno，chain 中保留未发送的数据
+     *
+     * 返回时数据已交给内核，零拷贝发送的块由本对象持有到通知到达。
+     */
+    ssize_t send(BufferChain& chain, int flags = 0) noexcept;
+
+    /**
+     * @brief 不阻塞地处理已到达的通知，释放完成的发送
+     * @return size_t 本次完成的发送数
+     */
+    size_t reap() noexcept;
+
+    /**
+     * @brief 等待所有零拷贝发送完成
+     * @param timeout_ms 超时 (毫秒)，负数表示不超时
+     * @return int 成功返回 0；失败返回 -1 并设置 errno (ETIMEDOUT: 超时，EPERM: 不在协程中)
+     *
+     * 对端不读取数据时 TCP 发送不会完成，应设置超时。
+     */
+    int flush(int64_t timeout_ms = -1) noexcept;
+
+    /**
+     * @brief 等待通知的零拷贝发送数
+     */
+    size_t get_pending() const noexcept { return pending_count_; }
+
+    const ZeroCopyStatistics& get_statistics() const noexcept { return stats_; }
+
+private:
+    /**
+     * @brief 一次零拷贝发送持有的数据
+     */
+    struct Pending {
+        BufferChain data;
+        bool done = false;
+    };
+
+    IOManager& io_;
+    int fd_;
+    size_t threshold_;
+    bool enabled_ = false;
+    std::vector<Pending> pending_;      ///< 按通知序号排列的环
+    size_t first_slot_ = 0;             ///< 最早未完成发送在环中的位置
+    uint32_t first_id_ = 0;             ///< 最早未完成发送的通知序号
+    size_t pending_count_ = 0;
+    ZeroCopyStatistics stats_;
+
+    void complete(uint32_t first, uint32_t last, bool copied) noexcept;
+};
+
+} // namespace libco_oop
+
+#endif // LIBCO_OOP_ZERO_COPY_H
@@ -0,0 +1,589 @@
+/**
+ * @file coroutine.cpp
+ * @brief 基础协程类实现
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 实现协程的创建、恢复、让出和复用，以及每线程的控制块池。
+ */
+
+#include "libco_oop/coroutine.h"
+#include "libco_oop/coroutine_pool.h"
+#include "libco_oop/stack_guard.h"
+#include "libco_oop/trace.h"
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <mutex>
+#include <vector>
+
+namespace libco_oop {
+
+namespace {
+
+//============================================================================
+// 线程状态
+//============================================================================
+
+// ThreadState::main_locals.has_hooks() 的副本：平凡类型的线程局部变量没有初始化检查，
+// 协程与线程本身之间的每次切换都要读取
+thread_local bool t_main_local_hooks = false;
+
+/**
+ * @brief 每线程的协程运行状态
+ *
+ * 线程本身也需要一个上下文，作为最外层 resume() 的调用者。
+ */
+struct ThreadState {
+    FastContext main_context;           ///< 线程自身的上下文
+    StackBinding main_binding;          ///< 线程栈的绑定
+    Coroutine* current = nullptr;       ///< 当前运行的协程
+    LocalStorage main_locals;           ///< 线程本身的协程局部存储
+#if LIBCO_OOP_METRICS
+    metrics::ThreadCounters counters;   ///< 本线程的协程计数器
+#endif
+
+    ThreadState() noexcept
+    {
+        main_binding.bind(main_context.registers());
+        stack_guard::detail::attach_thread(&current);
+#if LIBCO_OOP_METRICS
+        metrics::detail::register_thread(counters);
+#endif
+    }
+
+    ~ThreadState()
+    {
+        // 析构函数可能访问协程局部存储，在线程状态仍然完整时清理
+        main_locals.clear();
+        t_main_local_hooks = false;
+        stack_guard::detail::attach_thread(nullptr);
+#if LIBCO_OOP_METRICS
+        metrics::detail::unregister_thread(counters);
+#endif
+    }
+};
+
+ThreadState& thread_state() noexcept
+{
+    static thread_local ThreadState state;
+    return state;
+}
+
+//============================================================================
+// 协程ID
+//============================================================================
+
+/**
+ * @brief 分配协程ID
+ *
+ * 每个线程一次从全局计数器取一段ID，避免每次创建都竞争同一个缓存行。
+ */
+uint64_t next_coroutine_id() noexcept
+{
+    static std::atomic<uint64_t> global_next{1};
+    static constexpr uint64_t kBatch = 1024;
+    static thread_local uint64_t next = 0;
+    static thread_local uint64_t limit = 0;
+
+    if (next == limit) {
+        next = global_next.fetch_add(kBatch, std::memory_order_relaxed);
+        limit = next + kBatch;
+    }
+    return next++;
+}
+
+//============================================================================
+// 控制块池
+//============================================================================
+
+/**
+ * @brief 控制块内存块
+ *
+ * Coroutine 按缓存行对齐，slab 以同样的对齐分配，每个控制块都从
+ * 缓存行边界开始，相邻控制块不共享缓存行。
+ */
+union ControlBlock {
+    ControlBlock* next;
+    alignas(Coroutine) unsigned char storage[sizeof(Coroutine)];
+};
+
+static_assert(alignof(ControlBlock) >= 64, "control blocks must start on a cache line");
+
+/**
+ * @brief 进程级的控制块 slab 登记表
+ *
+ * slab 只在进程退出时释放：协程可以在其他线程上销毁，控制块会进入
+ * 销毁线程的空闲链表，因此 slab 不能随创建线程一起释放。
+ * 退出线程的空闲链表交回这里，由之后需要补充的线程接管。
+ */
+class ControlBlockRegistry {
+public:
+    static constexpr size_t kBlocksPerSlab = 64;
+
+    ~ControlBlockRegistry()
+    {
+        for (ControlBlock* slab : slabs_) {
+            ::operator delete(slab, std::align_val_t(alignof(ControlBlock)));
+        }
+    }
+
+    static ControlBlockRegistry& instance()
+    {
+        static ControlBlockRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief 取得一批空闲控制块 (优先接管退出线程留下的)
+     * @return ControlBlock* 空闲链表头，失败返回 nullptr
+     */
+    ControlBlock* acquire_batch() noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (orphans_ != nullptr) {
+            ControlBlock* list = orphans_;
+            orphans_ = nullptr;
+            return list;
+        }
+
+        ControlBlock* slab = static_cast<ControlBlock*>(::operator new(
+            sizeof(ControlBlock) * kBlocksPerSlab, std::align_val_t(alignof(ControlBlock)), std::nothrow));
+        if (slab == nullptr) {
+            return nullptr;
+        }
+        try {
+            slabs_.push_back(slab);
+        } catch (...) {
+            ::operator delete(slab, std::align_val_t(alignof(ControlBlock)));
+            return nullptr;
+        }
+
+        for (size_t i = 0; i + 1 < kBlocksPerSlab; ++i) {
+            slab[i].next = &slab[i + 1];
+        }
+        slab[kBlocksPerSlab - 1].next = nullptr;
+        return slab;
+    }
+
+    /**
+     * @brief 接收退出线程的空闲链表
+     */
+    void give_back(ControlBlock* head, ControlBlock* tail) noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tail->next = orphans_;
+        orphans_ = head;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<ControlBlock*> slabs_;      ///< 所有 slab
+    ControlBlock* orphans_ = nullptr;       ///< 退出线程留下的空闲控制块
+};
+
+/**
+ * @brief 每线程的控制块空闲链表
+ */
+class ControlBlockCache {
+public:
+    ControlBlockCache() noexcept
+    {
+        // 确保登记表先于任何线程缓存构造，从而晚于它们析构
+        ControlBlockRegistry::instance();
+    }
+
+    ~ControlBlockCache()
+    {
+        if (free_list_ == nullptr) {
+            return;
+        }
+        ControlBlock* tail = free_list_;
+        while (tail->next != nullptr) {
+            tail = tail->next;
+        }
+        ControlBlockRegistry::instance().give_back(free_list_, tail);
+    }
+
+    void* allocate() noexcept
+    {
+        if (free_list_ == nullptr) {
+            free_list_ = ControlBlockRegistry::instance().acquire_batch();
+            if (free_list_ == nullptr) {
+                return nullptr;
+            }
+        }
+        ControlBlock* block = free_list_;
+        free_list_ = block->next;
+        return block;
+    }
+
+    void deallocate(void* memory) noexcept
+    {
+        ControlBlock* block = static_cast<ControlBlock*>(memory);
+        block->next = free_list_;
+        free_list_ = block;
+    }
+
+private:
+    ControlBlock* free_list_ = nullptr;
+};
+
+ControlBlockCache& control_blocks() noexcept
+{
+    static thread_local ControlBlockCache cache;
+    return cache;
+}
+
+} // namespace
+
+//============================================================================
+// Coroutine 类实现
+//============================================================================
+
+// 运行指标和事件跟踪都关闭时两个记录函数为空，内联后不留下任何代码
+inline void Coroutine::record_switch_in() noexcept
+{
+    trace::record(trace::EventType::SWITCH_IN, id_);
+#if LIBCO_OOP_METRICS
+    thread_state().counters.switches.add();
+    switched_in_at_ = metrics::read_cycles();
+#endif
+}
+
+// 只在协程栈上调用：当前帧地址到栈顶的距离即此刻的栈深度
+inline void Coroutine::record_switch_out() noexcept
+{
+    trace::record(trace::EventType::SWITCH_OUT, id_);
+#if LIBCO_OOP_METRICS
+    const uint64_t elapsed = metrics::read_cycles() - switched_in_at_;
+    run_cycles_ += elapsed;
+    thread_state().counters.run_cycles.add(elapsed);
+    const size_t depth = binding_.get_stack()->used_bytes(__builtin_frame_address(0));
+    if (depth > max_stack_depth_) {
+        max_stack_depth_ = depth;
+    }
+#endif
+}
+
+// 只有参与切换的一方设置过带钩子的值时才调用钩子，其余切换只多两次标志判断
+inline void Coroutine::switch_locals(Coroutine* from, Coroutine* to) noexcept
+{
+    const bool from_hooks = from != nullptr ? from->local_hooks_ : t_main_local_hooks;
+    const bool to_hooks = to != nullptr ? to->local_hooks_ : t_main_local_hooks;
+    if (__builtin_expect(from_hooks || to_hooks, 0)) {
+        LocalStorage& main = thread_state().main_locals;
+        coroutine_local::detail::run_switch_hooks(from != nullptr ? from->locals_ : main,
+                                                  to != nullptr ? to->locals_ : main);
+    }
+}
+
+void Coroutine::clear_locals() noexcept
+{
+    locals_.clear();
+    local_hooks_ = locals_.has_hooks();
+}
+
+Coroutine::Coroutine(CoroutineFunction&& fn, const CoroutineOptions& opts) noexcept
+    : save_fpu_(opts.save_fpu)
+    , scheduling_class_(opts.scheduling_class)
+    , deadline_(opts.deadline)
+    , function_(std::move(fn))
+    , stack_allocator_(opts.stack_allocator)
+    , hybrid_(opts.hybrid)
+    , stack_usage_(opts.stack_usage)
+    , id_(next_coroutine_id())
+{
+}
+
+Coroutine::~Coroutine() noexcept
+{
+    release_stack();
+}
+
+CoroutinePtr Coroutine::create_function(CoroutineFunction fn, const CoroutineOptions& opts)
+{
+    void* memory = control_blocks().allocate();
+    if (memory == nullptr) {
+        return nullptr;
+    }
+
+    Coroutine* coroutine = ::new (memory) Coroutine(std::move(fn), opts);
+    if (!coroutine->attach_stack(opts)) {
+        coroutine->~Coroutine();
+        control_blocks().deallocate(memory);
+        return nullptr;
+    }
+    coroutine->prepare_entry();
+#if LIBCO_OOP_METRICS
+    thread_state().counters.created.add();
+#endif
+    return CoroutinePtr(coroutine);
+}
+
+bool Coroutine::attach_stack(const CoroutineOptions& opts) noexcept
+{
+    RegisterState& regs = context_.registers();
+
+    if (hybrid_ != nullptr) {
+        const HybridStackOptions& hybrid_opts = hybrid_->get_options();
+        if (opts.stack_size > hybrid_opts.private_stack.stack_size
+            || opts.stack_size > hybrid_opts.shared_stack.stack_size) {
+            return false;
+        }
+        return hybrid_->bind(binding_, regs, opts.profile);
+    }
+
+    // 记下栈的来源，协程迁移到其他线程后仍归还给同一个分配器
+    if (stack_allocator_ == nullptr) {
+        stack_allocator_ = &FixedStackAllocator::local();
+    }
+    StackAllocator* allocator = stack_allocator_;
+    Stack* stack = nullptr;
+    const size_t recommended = opts.stack_size == 0 && stack_usage_ != nullptr
+        ? stack_usage_->recommended_size() : 0;
+    if (recommended != 0) {
+        stack = allocator->allocate(recommended);
+    }
+    // 推荐大小超过分配器的上限时退回默认大小
+    if (stack == nullptr) {
+        stack = allocator->allocate(opts.stack_size);
+    }
+    if (stack == nullptr) {
+        return false;
+    }
+
+    if (dynamic_cast<SharedStackAllocator*>(allocator) != nullptr) {
+        binding_.bind(regs, static_cast<SharedStack*>(stack));
+    } else {
+        binding_.bind(regs, stack);
+    }
+    return true;
+}
+
+void Coroutine::prepare_entry() noexcept
+{
+    context_.reset();
+    context_.set_stack_pointer(binding_.get_stack()->get_top());
+    context_.set_instruction_pointer(reinterpret_cast<void*>(&Coroutine::entry_point));
+}
+
+void Coroutine::release_stack() noexcept
+{
+    Stack* stack = binding_.get_stack();
+    if (stack == nullptr) {
+        return;
+    }
+    record_stack_usage();
+
+    if (hybrid_ != nullptr) {
+        // 混合栈分配器跟踪的绑定解除时会自动归还栈
+        binding_.unbind();
+        return;
+    }
+
+    binding_.unbind();
+    // 归还给分配栈的分配器，销毁所在的线程可能不是创建线程
+    stack_allocator_->deallocate(stack);
+}
+
+bool Coroutine::resume()
+{
+    if (!is_resumable()) {
+        return false;
+    }
+
+    Coroutine* returned = switch_in();
+    if (returned->state_ == CoroutineState::ERROR && returned->exception_) {
+        std::exception_ptr exception = std::move(returned->exception_);
+        returned->exception_ = nullptr;
+        std::rethrow_exception(exception);
+    }
+    return true;
+}
+
+Coroutine* Coroutine::switch_in() noexcept
+{
+    ThreadState& state = thread_state();
+    Coroutine* resumer = state.current;
+    resumer_ = resumer;
+    caller_ = resumer != nullptr ? &resumer->binding_ : &state.main_binding;
+    switch_locals(resumer, this);
+    state_ = CoroutineState::RUNNING;
+    ++resume_count_;
+    state.current = this;
+    record_switch_in();
+
+    caller_->switch_to(binding_, save_fpu_);
+
+    // 协程让出或结束，回到调用者。切换回来的仍是线程的当前协程
+    // (经过 yield_to() 时不一定是本协程)
+    ThreadState& back = thread_state();
+    Coroutine* returned = back.current;
+    back.current = resumer;
+    return returned;
+}
+
+bool Coroutine::yield() noexcept
+{
+    Coroutine* self = current();
+    if (self == nullptr) {
+        return false;
+    }
+
+    switch_locals(self, self->resumer_);
+    self->state_ = CoroutineState::SUSPENDED;
+    self->record_switch_out();
+    self->binding_.switch_to(*self->caller_, self->save_fpu_);
+    return true;
+}
+
+bool Coroutine::yield_to(Coroutine& target) noexcept
+{
+    Coroutine* self = current();
+    if (self == nullptr || &target == self || !target.is_resumable()) {
+        return false;
+    }
+
+    switch_locals(self, &target);
+
+    // 目标接替当前协程的位置，之后让出时直接回到原来的调用者
+    target.caller_ = self->caller_;
+    target.resumer_ = self->resumer_;
+    target.state_ = CoroutineState::RUNNING;
+    ++target.resume_count_;
+    self->state_ = CoroutineState::SUSPENDED;
+    thread_state().current = &target;
+    self->record_switch_out();
+    target.record_switch_in();
+
+    self->binding_.switch_to(target.binding_, self->save_fpu_ || target.save_fpu_);
+    return true;
+}
+
+__attribute__((noinline))
+Coroutine* Coroutine::current() noexcept
+{
+    return thread_state().current;
+}
+
+bool Coroutine::reset_function(CoroutineFunction fn) noexcept
+{
+    if (state_ == CoroutineState::RUNNING || state_ == CoroutineState::SUSPENDED) {
+        return false;
+    }
+
+    function_ = std::move(fn);
+    exception_ = nullptr;
+    clear_locals();
+    caller_ = nullptr;
+    resumer_ = nullptr;
+    resume_count_ = 0;
+#if LIBCO_OOP_METRICS
+    run_cycles_ = 0;
+    max_stack_depth_ = 0;
+#endif
+    id_ = next_coroutine_id();
+    deadline_ = 0;
+    state_ = CoroutineState::READY;
+
+    binding_.discard();
+    // 复用的协程重新涂抹，下一次运行单独测量
+    record_stack_usage();
+    if (binding_.get_stack()->is_painted()) {
+        binding_.get_stack()->paint();
+    }
+    prepare_entry();
+    return true;
+}
+
+void Coroutine::record_stack_usage() noexcept
+{
+    Stack* stack = binding_.get_stack();
+    if (stack_usage_ != nullptr && stack->is_painted()) {
+        stack_usage_->record(stack->high_water_mark());
+    }
+}
+
+LIBCO_OOP_CONTEXT_ENTRY
+void Coroutine::entry_point()
+{
+    Coroutine* self = current();
+
+    try {
+        self->function_();
+        self->state_ = CoroutineState::FINISHED;
+    } catch (...) {
+        self->exception_ = std::current_exception();
+        self->state_ = CoroutineState::ERROR;
+    }
+
+    // 及早释放入口函数的捕获和协程局部存储的值 (先让钩子交还线程级状态)
+    self->function_.reset();
+    switch_locals(self, self->resumer_);
+    self->clear_locals();
+    self->record_switch_out();
+#if LIBCO_OOP_METRICS
+    thread_state().counters.finished.add();
+#endif
+    self->binding_.switch_to(*self->caller_, self->save_fpu_);
+
+    // 已结束的协程不会再被恢复
+    std::terminate();
+}
+
+//============================================================================
+// 协程局部存储
+//============================================================================
+
+namespace coroutine_local {
+
+void* get(int key) noexcept
+{
+    ThreadState& state = thread_state();
+    const Coroutine* self = state.current;
+    return (self != nullptr ? self->locals_ : state.main_locals).get(static_cast<size_t>(key));
+}
+
+bool set(int key, void* value) noexcept
+{
+    if (!detail::is_valid_key(key)) {
+        errno = EINVAL;
+        return false;
+    }
+    ThreadState& state = thread_state();
+    Coroutine* self = state.current;
+    if (self == nullptr) {
+        if (!state.main_locals.set(static_cast<size_t>(key), value)) {
+            return false;
+        }
+        t_main_local_hooks = state.main_locals.has_hooks();
+        return true;
+    }
+    if (!self->locals_.set(static_cast<size_t>(key), value)) {
+        return false;
+    }
+    self->local_hooks_ = self->locals_.has_hooks();
+    return true;
+}
+
+} // namespace coroutine_local
+
+//============================================================================
+// CoroutineDeleter 实现
+//============================================================================
+
+void CoroutineDeleter::operator()(Coroutine* coroutine) const noexcept
+{
+    if (coroutine == nullptr) {
+        return;
+    }
+    assert(coroutine->state_ != CoroutineState::RUNNING);
+    if (coroutine->pool_ != nullptr && coroutine->pool_->recycle(coroutine)) {
+        return;
+    }
+    coroutine->~Coroutine();
+    control_blocks().deallocate(coroutine);
+}
+
+} // namespace libco_oop
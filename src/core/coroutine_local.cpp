@@ -0,0 +1,168 @@
+/**
+ * @file coroutine_local.cpp
+ * @brief 协程局部存储实现
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 实现进程级的键登记表和 LocalStorage 的溢出槽位与清理。
+ * 按当前上下文读写值的 get()/set() 需要线程状态，在 coroutine.cpp 中实现。
+ */
+
+#include "libco_oop/coroutine_local.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <mutex>
+
+namespace libco_oop {
+namespace coroutine_local {
+
+namespace {
+
+//============================================================================
+// 键登记表
+//============================================================================
+
+/// 析构函数中设置新值时重复清理的最大轮数 (PTHREAD_DESTRUCTOR_ITERATIONS)
+constexpr int kDestructorRounds = 4;
+
+/// 溢出槽位的最大数量
+constexpr size_t kMaxOverflow = kMaxKeys - kInlineSlots;
+
+struct KeyEntry {
+    std::atomic<Destructor> destructor{nullptr};
+    std::atomic<SwitchHook> on_switch{nullptr};
+};
+
+// 只增不减：已发布的条目不再修改，读取方不需要加锁
+KeyEntry g_keys[kMaxKeys];
+std::atomic<size_t> g_key_count{0};
+size_t g_hooked_keys[kMaxKeys];             ///< 带切换钩子的键
+std::atomic<size_t> g_hooked_count{0};
+std::mutex g_mutex;                         ///< 串行化注册
+
+} // namespace
+
+int create_key(Destructor destructor, SwitchHook on_switch) noexcept
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    const size_t key = g_key_count.load(std::memory_order_relaxed);
+    if (key == kMaxKeys) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    g_keys[key].destructor.store(destructor, std::memory_order_relaxed);
+    g_keys[key].on_switch.store(on_switch, std::memory_order_relaxed);
+    if (on_switch != nullptr) {
+        const size_t hooked = g_hooked_count.load(std::memory_order_relaxed);
+        g_hooked_keys[hooked] = key;
+        g_hooked_count.store(hooked + 1, std::memory_order_release);
+    }
+    g_key_count.store(key + 1, std::memory_order_release);
+    return static_cast<int>(key);
+}
+
+namespace detail {
+
+bool is_valid_key(int key) noexcept
+{
+    return key >= 0 && static_cast<size_t>(key) < g_key_count.load(std::memory_order_acquire);
+}
+
+void run_switch_hooks(const LocalStorage& from, const LocalStorage& to) noexcept
+{
+    const size_t count = g_hooked_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        const size_t key = g_hooked_keys[i];
+        void* from_value = from.get(key);
+        void* to_value = to.get(key);
+        if (from_value != nullptr || to_value != nullptr) {
+            g_keys[key].on_switch.load(std::memory_order_relaxed)(from_value, to_value);
+        }
+    }
+}
+
+} // namespace detail
+} // namespace coroutine_local
+
+//============================================================================
+// LocalStorage 类实现
+//============================================================================
+
+LocalStorage::~LocalStorage() noexcept
+{
+    clear();
+    std::free(overflow_);
+}
+
+bool LocalStorage::set(size_t key, void* value) noexcept
+{
+    using namespace coroutine_local;
+
+    if (key < kInlineSlots) {
+        inline_[key] = value;
+    } else {
+        const size_t index = key - kInlineSlots;
+        if (index >= overflow_capacity_) {
+            if (value == nullptr) {
+                return true;
+            }
+            size_t capacity = std::max<size_t>(overflow_capacity_ * 2, 8);
+            while (capacity <= index) {
+                capacity *= 2;
+            }
+            capacity = std::min(capacity, kMaxOverflow);
+
+            void** grown = static_cast<void**>(std::calloc(capacity, sizeof(void*)));
+            if (grown == nullptr) {
+                errno = ENOMEM;
+                return false;
+            }
+            std::copy(overflow_, overflow_ + overflow_capacity_, grown);
+            std::free(overflow_);
+            overflow_ = grown;
+            overflow_capacity_ = static_cast<uint32_t>(capacity);
+        }
+        overflow_[index] = value;
+    }
+
+    if (value != nullptr) {
+        has_values_ = true;
+        if (g_keys[key].on_switch.load(std::memory_order_relaxed) != nullptr) {
+            has_hooks_ = true;
+        }
+    }
+    return true;
+}
+
+void LocalStorage::clear_values() noexcept
+{
+    using namespace coroutine_local;
+
+    // 析构函数中重新设置的值会再次设置标志
+    has_values_ = false;
+    has_hooks_ = false;
+    for (int round = 0; round < kDestructorRounds; ++round) {
+        bool found = false;
+        // 析构函数可能写入新的溢出槽位，每次重新读取容量
+        for (size_t key = 0; key < kInlineSlots + overflow_capacity_; ++key) {
+            void*& slot = key < kInlineSlots ? inline_[key] : overflow_[key - kInlineSlots];
+            void* value = slot;
+            if (value == nullptr) {
+                continue;
+            }
+            slot = nullptr;
+            found = true;
+            if (Destructor destructor = g_keys[key].destructor.load(std::memory_order_acquire)) {
+                destructor(value);
+            }
+        }
+        if (!found) {
+            break;
+        }
+    }
+}
+
+} // namespace libco_oop
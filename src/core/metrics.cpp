@@ -0,0 +1,206 @@
+/**
+ * @file metrics.cpp
+ * @brief 运行指标登记表与快照
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 登记表只在线程/调度器登记、注销和取快照时加锁，计数器更新不经过这里。
+ */
+
+#include "libco_oop/metrics.h"
+#include <mutex>
+#include <sstream>
+
+namespace libco_oop {
+namespace metrics {
+
+namespace {
+
+/**
+ * @brief 进程级指标登记表
+ */
+class Registry {
+public:
+    static Registry& instance() noexcept
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    std::mutex mutex;
+    IntrusiveList<Source> sources;              ///< 存活的调度器
+    IntrusiveList<ThreadCounters> threads;      ///< 存活的线程
+    uint64_t retired_switches = 0;              ///< 已退出线程的计数 (受 mutex 保护)
+    uint64_t retired_run_cycles = 0;
+    uint64_t retired_created = 0;
+    uint64_t retired_finished = 0;
+    std::atomic<uint64_t> next_id{1};
+};
+
+/**
+ * @brief 输出一个指标的一行样本
+ */
+void write_sample(std::ostringstream& out, const std::string& name, const SchedulerMetrics* scheduler,
+                  uint64_t value)
+{
+    out << name;
+    if (scheduler != nullptr) {
+        out << "{kind=\"" << scheduler->kind << "\",id=\"" << scheduler->id << "\"}";
+    }
+    out << ' ' << value << '\n';
+}
+
+void write_header(std::ostringstream& out, const std::string& name, const char* type, const char* help)
+{
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << ' ' << type << '\n';
+}
+
+} // namespace
+
+//============================================================================
+// Source 类实现
+//============================================================================
+
+void Source::attach(const char* kind, const void* owner, CollectFn collect) noexcept
+{
+    Registry& registry = Registry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (is_linked()) {
+        return;
+    }
+    kind_ = kind;
+    owner_ = owner;
+    collect_ = collect;
+    id_ = registry.next_id.fetch_add(1, std::memory_order_relaxed);
+    registry.sources.push_back(this);
+}
+
+void Source::detach() noexcept
+{
+    if (!is_linked()) {
+        return;
+    }
+    Registry& registry = Registry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.sources.remove(this);
+}
+
+SchedulerMetrics Source::collect() const noexcept
+{
+    SchedulerMetrics metrics;
+    if (collect_ != nullptr) {
+        collect_(owner_, metrics);
+    }
+    metrics.kind = kind_;
+    metrics.id = id_;
+    return metrics;
+}
+
+//============================================================================
+// 线程计数器
+//============================================================================
+
+namespace detail {
+
+void register_thread(ThreadCounters& counters) noexcept
+{
+    Registry& registry = Registry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(&counters);
+}
+
+void unregister_thread(ThreadCounters& counters) noexcept
+{
+    Registry& registry = Registry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.remove(&counters);
+    registry.retired_switches += counters.switches.load();
+    registry.retired_run_cycles += counters.run_cycles.load();
+    registry.retired_created += counters.created.load();
+    registry.retired_finished += counters.finished.load();
+}
+
+} // namespace detail
+
+//============================================================================
+// 快照与导出
+//============================================================================
+
+MetricsSnapshot snapshot()
+{
+    MetricsSnapshot result;
+    Registry& registry = Registry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    result.threads = registry.threads.size();
+    result.switches = registry.retired_switches;
+    result.run_cycles = registry.retired_run_cycles;
+    result.coroutines_created = registry.retired_created;
+    result.coroutines_finished = registry.retired_finished;
+    registry.threads.for_each([&result](ThreadCounters* counters) {
+        result.switches += counters->switches.load();
+        result.run_cycles += counters->run_cycles.load();
+        result.coroutines_created += counters->created.load();
+        result.coroutines_finished += counters->finished.load();
+    });
+
+    result.schedulers.reserve(registry.sources.size());
+    registry.sources.for_each([&result](Source* source) {
+        result.schedulers.push_back(source->collect());
+    });
+    return result;
+}
+
+std::string format_prometheus(const MetricsSnapshot& snapshot, const std::string& prefix)
+{
+    std::ostringstream out;
+    if (!snapshot.enabled) {
+        return out.str();
+    }
+
+    struct Total {
+        const char* name;
+        const char* help;
+        uint64_t value;
+    };
+    const Total totals[] = {
+        {"_coroutine_switches_total", "Coroutine switch-ins on all threads", snapshot.switches},
+        {"_coroutine_run_cycles_total", "Cycle counter ticks spent running coroutines", snapshot.run_cycles},
+        {"_coroutines_created_total", "Coroutines created", snapshot.coroutines_created},
+        {"_coroutines_finished_total", "Coroutines that ran to completion", snapshot.coroutines_finished},
+    };
+    for (const Total& total : totals) {
+        write_header(out, prefix + total.name, "counter", total.help);
+        write_sample(out, prefix + total.name, nullptr, total.value);
+    }
+
+    struct Field {
+        const char* name;
+        const char* type;
+        const char* help;
+        uint64_t (*get)(const SchedulerMetrics&);
+    };
+    const Field fields[] = {
+        {"_scheduler_switches_total", "counter", "Coroutines dispatched by the scheduler",
+         [](const SchedulerMetrics& m) { return m.switches; }},
+        {"_scheduler_run_queue", "gauge", "Ready queue length",
+         [](const SchedulerMetrics& m) { return static_cast<uint64_t>(m.run_queue); }},
+        {"_scheduler_steals_total", "counter", "Coroutines stolen from other workers",
+         [](const SchedulerMetrics& m) { return m.steals; }},
+        {"_scheduler_io_waits_total", "counter", "Coroutines that started waiting for IO",
+         [](const SchedulerMetrics& m) { return m.io_waits; }},
+        {"_scheduler_timer_fires_total", "counter", "Expired timers",
+         [](const SchedulerMetrics& m) { return m.timer_fires; }},
+    };
+    for (const Field& field : fields) {
+        write_header(out, prefix + field.name, field.type, field.help);
+        for (const SchedulerMetrics& scheduler : snapshot.schedulers) {
+            write_sample(out, prefix + field.name, &scheduler, field.get(scheduler));
+        }
+    }
+    return out.str();
+}
+
+} // namespace metrics
+} // namespace libco_oop
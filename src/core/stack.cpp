@@ -0,0 +1,1135 @@
+/**
+ * @file stack.cpp
+ * @brief 协程栈管理实现
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 实现基于 mmap/mprotect 的协程栈、带空闲链表的固定大小栈分配器，
+ * 以及共享栈的换入换出。
+ */
+
+#include "libco_oop/stack.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <exception>
+#include <new>
+#include <utility>
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#endif
+
+namespace libco_oop {
+
+namespace {
+
+/**
+ * @brief 将大小向上取整到页大小的整数倍
+ */
+size_t round_to_pages(size_t size) noexcept
+{
+    const size_t page = Stack::page_size();
+    return (size + page - 1) & ~(page - 1);
+}
+
+/**
+ * @brief 拷贝栈内容
+ *
+ * 被换出协程的栈帧上有 AddressSanitizer 标记的 redzone，经过 memcpy
+ * 拦截器会被误报为越界，因此直接用内联汇编拷贝 (x86_64 为 rep movsb，
+ * AArch64 为 ldp/stp 每次16字节，剩余部分逐字节)。
+ */
+inline void copy_stack_bytes(void* dst, const void* src, size_t n) noexcept
+{
+#if defined(__x86_64__)
+    __asm__ __volatile__("rep movsb" : "+D"(dst), "+S"(src), "+c"(n) : : "memory");
+#elif defined(__aarch64__)
+    size_t pairs = n >> 4;
+    size_t tail = n & 15;
+    __asm__ __volatile__(
+        "1: cbz     %[pairs], 2f\n"
+        "   ldp     x9, x10, [%[src]], #16\n"
+        "   stp     x9, x10, [%[dst]], #16\n"
+        "   sub     %[pairs], %[pairs], #1\n"
+        "   b       1b\n"
+        "2: cbz     %[tail], 3f\n"
+        "   ldrb    w9, [%[src]], #1\n"
+        "   strb    w9, [%[dst]], #1\n"
+        "   sub     %[tail], %[tail], #1\n"
+        "   b       2b\n"
+        "3:\n"
+        : [dst] "+r"(dst), [src] "+r"(src), [pairs] "+r"(pairs), [tail] "+r"(tail)
+        :
+        : "x9", "x10", "memory");
+#endif
+}
+
+/**
+ * @brief 清除栈上残留的 AddressSanitizer 标记
+ *
+ * 共享栈换入后，以及新映射复用了旧栈的地址时，影子内存仍是
+ * 之前栈帧的 redzone 布局，会被误报为越界。释放栈时也要清除：
+ * 地址可能被不经过 Stack 的映射 (例如 io_uring 的队列) 复用。
+ */
+inline void unpoison_stack(void* begin, size_t size) noexcept
+{
+#if defined(__SANITIZE_ADDRESS__)
+    __asan_unpoison_memory_region(begin, size);
+#else
+    (void)begin;
+    (void)size;
+#endif
+}
+
+/// 金丝雀图样：栈帧中几乎不会出现的一个字
+constexpr uint64_t kStackCanary = 0xCA11AB1ECA11AB1EULL;
+
+/**
+ * @brief 涂抹 [begin, end)
+ *
+ * 不经过 AddressSanitizer 插桩：栈上可能残留着之前栈帧的 redzone 标记。
+ */
+__attribute__((no_sanitize_address))
+void paint_words(uint64_t* begin, uint64_t* end) noexcept
+{
+    for (uint64_t* p = begin; p != end; ++p) {
+        *p = kStackCanary;
+    }
+}
+
+/**
+ * @brief 从低地址向上找到第一个被改写的字
+ */
+__attribute__((no_sanitize_address))
+const uint64_t* find_dirty_word(const uint64_t* begin, const uint64_t* end) noexcept
+{
+    const uint64_t* p = begin;
+    while (p != end && *p == kStackCanary) {
+        ++p;
+    }
+    return p;
+}
+
+} // namespace
+
+//============================================================================
+// Stack 类实现
+//============================================================================
+
+size_t Stack::page_size() noexcept
+{
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return page;
+}
+
+Stack::Stack(size_t size, bool guard_page) noexcept
+{
+    if (size == 0) {
+        return;
+    }
+
+    const size_t usable = round_to_pages(size);
+    const size_t guard = guard_page ? page_size() : 0;
+
+    // MAP_NORESERVE: 只保留地址空间，物理页在首次访问时按需分配
+    void* memory = ::mmap(nullptr, usable + guard, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (memory == MAP_FAILED) {
+        return;
+    }
+
+    // 栈向低地址增长，保护页放在映射的最低处
+    if (guard != 0 && ::mprotect(memory, guard, PROT_NONE) != 0) {
+        ::munmap(memory, usable + guard);
+        return;
+    }
+
+    memory_ = memory;
+    base_ = static_cast<char*>(memory) + guard;
+    size_ = usable;
+    guard_size_ = guard;
+    unpoison_stack(base_, size_);
+}
+
+Stack::~Stack() noexcept
+{
+    release();
+}
+
+Stack::Stack(Stack&& other) noexcept
+    : memory_(other.memory_)
+    , base_(other.base_)
+    , size_(other.size_)
+    , guard_size_(other.guard_size_)
+    , painted_(other.painted_)
+{
+    other.memory_ = nullptr;
+    other.base_ = nullptr;
+    other.size_ = 0;
+    other.guard_size_ = 0;
+    other.painted_ = false;
+}
+
+Stack& Stack::operator=(Stack&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        memory_ = other.memory_;
+        base_ = other.base_;
+        size_ = other.size_;
+        guard_size_ = other.guard_size_;
+        painted_ = other.painted_;
+
+        other.memory_ = nullptr;
+        other.base_ = nullptr;
+        other.size_ = 0;
+        other.guard_size_ = 0;
+        other.painted_ = false;
+    }
+    return *this;
+}
+
+void Stack::release() noexcept
+{
+    if (memory_ != nullptr) {
+        unpoison_stack(base_, size_);
+        ::munmap(memory_, size_ + guard_size_);
+        memory_ = nullptr;
+        base_ = nullptr;
+        size_ = 0;
+        guard_size_ = 0;
+        painted_ = false;
+    }
+}
+
+void Stack::paint() noexcept
+{
+    if (base_ == nullptr) {
+        return;
+    }
+    unpoison_stack(base_, size_);
+    paint_words(static_cast<uint64_t*>(base_), static_cast<uint64_t*>(get_top()));
+    painted_ = true;
+}
+
+void Stack::unpaint() noexcept
+{
+    if (!painted_) {
+        return;
+    }
+
+    // 高水位以下的整页只被涂抹过，归还后下次访问重新清零分配
+    const uintptr_t page = page_size();
+    const uintptr_t base = reinterpret_cast<uintptr_t>(base_);
+    const uintptr_t dirty = reinterpret_cast<uintptr_t>(get_top()) - high_water_mark();
+    const uintptr_t end = dirty & ~(page - 1);
+    if (end > base) {
+        ::madvise(base_, end - base, MADV_DONTNEED);
+    }
+    painted_ = false;
+}
+
+size_t Stack::high_water_mark() const noexcept
+{
+    if (!painted_) {
+        return 0;
+    }
+    const uint64_t* begin = static_cast<const uint64_t*>(base_);
+    const uint64_t* end = static_cast<const uint64_t*>(get_top());
+    return used_bytes(find_dirty_word(begin, end));
+}
+
+//============================================================================
+// FixedStackAllocator 类实现
+//============================================================================
+
+FixedStackAllocator::FixedStackAllocator(const StackOptions& opts) noexcept
+    : options_(opts)
+    , owner_(std::this_thread::get_id())
+{
+    options_.stack_size = round_to_pages(options_.stack_size);
+}
+
+FixedStackAllocator::~FixedStackAllocator()
+{
+    // 只能释放池中的栈，仍在使用中的栈由持有者负责归还
+    drain_remote();
+    trim(0);
+}
+
+Stack* FixedStackAllocator::allocate(size_t size)
+{
+    if (size > options_.stack_size) {
+        return nullptr;
+    }
+    if (remote_pending_.load(std::memory_order_relaxed) != 0) {
+        drain_remote();
+    }
+
+    // 快速路径：从空闲链表复用，不进入内核
+    if (free_list_ != nullptr) {
+        Stack* stack = free_list_;
+        free_list_ = stack->next_free_;
+        stack->next_free_ = nullptr;
+        --stats_.cached;
+        ++stats_.in_use;
+        ++stats_.pool_hits;
+        ++stats_.total_allocations;
+        sample(stack);
+        return stack;
+    }
+
+    // 慢速路径：新建栈
+    Stack* stack = new (std::nothrow) Stack(options_.stack_size, options_.guard_page);
+    if (stack == nullptr) {
+        return nullptr;
+    }
+    if (!stack->is_valid()) {
+        delete stack;
+        return nullptr;
+    }
+
+    ++stats_.mmap_calls;
+    ++stats_.in_use;
+    ++stats_.total_allocations;
+    stats_.reserved_bytes += stack->get_mapped_size();
+    sample(stack);
+    return stack;
+}
+
+void FixedStackAllocator::sample(Stack* stack) noexcept
+{
+    if (options_.canary_sample == 0) {
+        return;
+    }
+    if (sample_countdown_ == 0) {
+        sample_countdown_ = options_.canary_sample;
+        stack->paint();
+        ++stats_.sampled;
+    }
+    --sample_countdown_;
+}
+
+void FixedStackAllocator::deallocate(Stack* stack) noexcept
+{
+    if (stack == nullptr) {
+        return;
+    }
+    if (!orphaned_.load(std::memory_order_acquire) && owner_ == std::this_thread::get_id()) {
+        release(stack);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(remote_mutex_);
+    if (!orphaned_.load(std::memory_order_relaxed)) {
+        // 统计只由所属线程修改，这里只挂到远程链表
+        stack->next_free_ = remote_free_;
+        remote_free_ = stack;
+        remote_pending_.fetch_add(1, std::memory_order_release);
+        return;
+    }
+
+    // 所属线程已经退出：直接释放，最后一个栈归还时销毁实例
+    --stats_.in_use;
+    stats_.reserved_bytes -= stack->get_mapped_size();
+    ++stats_.munmap_calls;
+    delete stack;
+    const bool last = stats_.in_use == 0;
+    lock.unlock();
+    if (last) {
+        delete this;
+    }
+}
+
+void FixedStackAllocator::release(Stack* stack) noexcept
+{
+    --stats_.in_use;
+
+    // 选项变化后归还的旧栈，或缓存已满时直接释放
+    if (stats_.cached >= options_.max_cached
+        || stack->get_size() != options_.stack_size
+        || (stack->get_guard_size() != 0) != options_.guard_page) {
+        stats_.reserved_bytes -= stack->get_mapped_size();
+        ++stats_.munmap_calls;
+        delete stack;
+        return;
+    }
+
+    // 不清零、不 madvise：保留已驻留的页，复用时无需再次缺页。
+    // 涂抹过的栈例外，只被涂抹过的页没有复用价值
+    stack->unpaint();
+    stack->next_free_ = free_list_;
+    free_list_ = stack;
+    ++stats_.cached;
+}
+
+void FixedStackAllocator::drain_remote() noexcept
+{
+    Stack* stack = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(remote_mutex_);
+        stack = std::exchange(remote_free_, nullptr);
+        remote_pending_.store(0, std::memory_order_relaxed);
+    }
+    while (stack != nullptr) {
+        Stack* next = stack->next_free_;
+        stack->next_free_ = nullptr;
+        release(stack);
+        stack = next;
+    }
+}
+
+void FixedStackAllocator::retire() noexcept
+{
+    std::unique_lock<std::mutex> lock(remote_mutex_);
+    orphaned_.store(true, std::memory_order_release);
+    Stack* stack = std::exchange(remote_free_, nullptr);
+    remote_pending_.store(0, std::memory_order_relaxed);
+    while (stack != nullptr) {
+        Stack* next = stack->next_free_;
+        stack->next_free_ = nullptr;
+        release(stack);
+        stack = next;
+    }
+    trim(0);
+    const bool idle = stats_.in_use == 0;
+    lock.unlock();
+    if (idle) {
+        delete this;
+    }
+}
+
+StackStatistics FixedStackAllocator::get_statistics() const noexcept
+{
+    StackStatistics stats = stats_;
+    stats.in_use -= remote_pending_.load(std::memory_order_acquire);
+    return stats;
+}
+
+void FixedStackAllocator::set_options(const StackOptions& opts)
+{
+    StackOptions normalized = opts;
+    normalized.stack_size = round_to_pages(normalized.stack_size);
+
+    const bool layout_changed = normalized.stack_size != options_.stack_size
+                             || normalized.guard_page != options_.guard_page;
+    options_ = normalized;
+
+    if (layout_changed) {
+        trim(0);
+    } else {
+        trim(options_.max_cached);
+    }
+}
+
+size_t FixedStackAllocator::reserve(size_t count)
+{
+    if (count > options_.max_cached) {
+        count = options_.max_cached;
+    }
+
+    while (stats_.cached < count) {
+        Stack* stack = new (std::nothrow) Stack(options_.stack_size, options_.guard_page);
+        if (stack == nullptr) {
+            break;
+        }
+        if (!stack->is_valid()) {
+            delete stack;
+            break;
+        }
+        ++stats_.mmap_calls;
+        stats_.reserved_bytes += stack->get_mapped_size();
+
+        stack->next_free_ = free_list_;
+        free_list_ = stack;
+        ++stats_.cached;
+    }
+    return stats_.cached;
+}
+
+void FixedStackAllocator::trim(size_t keep) noexcept
+{
+    while (stats_.cached > keep && free_list_ != nullptr) {
+        Stack* stack = free_list_;
+        free_list_ = stack->next_free_;
+        --stats_.cached;
+        stats_.reserved_bytes -= stack->get_mapped_size();
+        ++stats_.munmap_calls;
+        delete stack;
+    }
+}
+
+FixedStackAllocator& FixedStackAllocator::local() noexcept
+{
+    // 实例在堆上：线程退出后其他线程仍可能归还这个线程分配的栈
+    struct Holder {
+        FixedStackAllocator* allocator = new FixedStackAllocator();
+        ~Holder() { allocator->retire(); }
+    };
+    static thread_local Holder holder;
+    return *holder.allocator;
+}
+
+//============================================================================
+// StackUsage 类实现
+//============================================================================
+
+void StackUsage::record(size_t used) noexcept
+{
+    samples_.fetch_add(1, std::memory_order_relaxed);
+    total_used_.fetch_add(used, std::memory_order_relaxed);
+    size_t max = max_used_.load(std::memory_order_relaxed);
+    while (used > max && !max_used_.compare_exchange_weak(max, used, std::memory_order_relaxed)) {
+    }
+}
+
+size_t StackUsage::get_average_used() const noexcept
+{
+    const size_t samples = get_samples();
+    return samples == 0 ? 0 : total_used_.load(std::memory_order_relaxed) / samples;
+}
+
+size_t StackUsage::recommended_size(size_t min_samples) const noexcept
+{
+    if (get_samples() < min_samples || get_samples() == 0) {
+        return 0;
+    }
+    return std::max(round_to_pages(get_max_used() * kHeadroom), 2 * Stack::page_size());
+}
+
+void StackUsage::reset() noexcept
+{
+    samples_.store(0, std::memory_order_relaxed);
+    total_used_.store(0, std::memory_order_relaxed);
+    max_used_.store(0, std::memory_order_relaxed);
+}
+
+//============================================================================
+// SizeClassStackAllocator 类实现
+//============================================================================
+
+SizeClassStackAllocator::SizeClassStackAllocator(const StackOptions& opts, size_t min_size)
+    : min_size_(round_to_pages(min_size == 0 ? Stack::page_size() : min_size))
+{
+    build_classes(opts);
+}
+
+void SizeClassStackAllocator::build_classes(const StackOptions& opts)
+{
+    classes_.clear();
+    const size_t max_size = round_to_pages(opts.stack_size);
+    for (size_t size = min_size_; ; size *= 2) {
+        StackOptions level = opts;
+        level.stack_size = std::min(size, max_size);
+        classes_.push_back(std::make_unique<FixedStackAllocator>(level));
+        if (level.stack_size == max_size) {
+            break;
+        }
+    }
+}
+
+Stack* SizeClassStackAllocator::allocate(size_t size)
+{
+    if (size == 0) {
+        return classes_.back()->allocate();
+    }
+    for (const std::unique_ptr<FixedStackAllocator>& level : classes_) {
+        if (size <= level->get_options().stack_size) {
+            return level->allocate();
+        }
+    }
+    return nullptr;
+}
+
+void SizeClassStackAllocator::deallocate(Stack* stack) noexcept
+{
+    if (stack == nullptr) {
+        return;
+    }
+    for (const std::unique_ptr<FixedStackAllocator>& level : classes_) {
+        if (stack->get_size() == level->get_options().stack_size) {
+            level->deallocate(stack);
+            return;
+        }
+    }
+    // set_options() 之前分配的栈
+    delete stack;
+}
+
+StackStatistics SizeClassStackAllocator::get_statistics() const noexcept
+{
+    StackStatistics total;
+    for (const std::unique_ptr<FixedStackAllocator>& level : classes_) {
+        const StackStatistics stats = level->get_statistics();
+        total.in_use += stats.in_use;
+        total.cached += stats.cached;
+        total.total_allocations += stats.total_allocations;
+        total.pool_hits += stats.pool_hits;
+        total.mmap_calls += stats.mmap_calls;
+        total.munmap_calls += stats.munmap_calls;
+        total.reserved_bytes += stats.reserved_bytes;
+        total.sampled += stats.sampled;
+    }
+    return total;
+}
+
+void SizeClassStackAllocator::set_options(const StackOptions& opts)
+{
+    build_classes(opts);
+}
+
+//============================================================================
+// SaveBufferPool 类实现
+//============================================================================
+
+namespace {
+
+/**
+ * @brief 计算 size 所属的规格序号
+ */
+size_t class_index(size_t size) noexcept
+{
+    size_t index = 0;
+    size_t block = SaveBufferPool::kMinBlockSize;
+    while (block < size) {
+        block <<= 1;
+        ++index;
+    }
+    return index;
+}
+
+// slab 头部占用一个最小规格，保证块按64字节对齐
+constexpr size_t kSlabHeader = SaveBufferPool::kMinBlockSize;
+
+} // namespace
+
+SaveBufferPool::~SaveBufferPool() noexcept
+{
+    while (slabs_ != nullptr) {
+        Slab* slab = slabs_;
+        slabs_ = slab->next;
+        ::munmap(slab, slab->size);
+    }
+}
+
+size_t SaveBufferPool::block_size_for(size_t size) noexcept
+{
+    if (size > kMaxBlockSize) {
+        return round_to_pages(size);
+    }
+    return kMinBlockSize << class_index(size);
+}
+
+void* SaveBufferPool::allocate(size_t size, size_t& capacity) noexcept
+{
+    if (size > kMaxBlockSize) {
+        // 超大请求单独映射
+        const size_t bytes = round_to_pages(size);
+        void* block = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED) {
+            return nullptr;
+        }
+        capacity = bytes;
+        ++stats_.blocks_in_use;
+        stats_.bytes_in_use += bytes;
+        return block;
+    }
+
+    const size_t index = class_index(size);
+    if (free_lists_[index] == nullptr && !refill(index)) {
+        return nullptr;
+    }
+
+    FreeBlock* block = free_lists_[index];
+    free_lists_[index] = block->next;
+    capacity = kMinBlockSize << index;
+    ++stats_.blocks_in_use;
+    stats_.bytes_in_use += capacity;
+    return block;
+}
+
+void SaveBufferPool::deallocate(void* block, size_t capacity) noexcept
+{
+    if (block == nullptr) {
+        return;
+    }
+    --stats_.blocks_in_use;
+    stats_.bytes_in_use -= capacity;
+
+    if (capacity > kMaxBlockSize) {
+        ::munmap(block, capacity);
+        return;
+    }
+
+    const size_t index = class_index(capacity);
+    FreeBlock* free_block = static_cast<FreeBlock*>(block);
+    free_block->next = free_lists_[index];
+    free_lists_[index] = free_block;
+}
+
+bool SaveBufferPool::refill(size_t index) noexcept
+{
+    const size_t block = kMinBlockSize << index;
+    size_t count = (kSlabSize - kSlabHeader) / block;
+    if (count < 2) {
+        count = 2;
+    }
+    const size_t bytes = round_to_pages(kSlabHeader + count * block);
+
+    void* memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+
+    Slab* slab = static_cast<Slab*>(memory);
+    slab->next = slabs_;
+    slab->size = bytes;
+    slabs_ = slab;
+    ++stats_.slab_count;
+    stats_.slab_bytes += bytes;
+
+    // 按地址从高到低压入，分配时从低地址开始使用
+    count = (bytes - kSlabHeader) / block;
+    char* first = static_cast<char*>(memory) + kSlabHeader;
+    for (size_t i = count; i > 0; --i) {
+        FreeBlock* free_block = reinterpret_cast<FreeBlock*>(first + (i - 1) * block);
+        free_block->next = free_lists_[index];
+        free_lists_[index] = free_block;
+    }
+    return true;
+}
+
+//============================================================================
+// SharedStackAllocator 类实现
+//============================================================================
+
+SharedStackAllocator::SharedStackAllocator(size_t count, const StackOptions& opts)
+    : options_(opts)
+{
+    options_.stack_size = round_to_pages(options_.stack_size);
+    create_stacks(count == 0 ? 1 : count);
+}
+
+SharedStackAllocator::~SharedStackAllocator() = default;
+
+void SharedStackAllocator::create_stacks(size_t count)
+{
+    stacks_.clear();
+    stats_.reserved_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        std::unique_ptr<SharedStack> stack(
+            new (std::nothrow) SharedStack(options_.stack_size, options_.guard_page, this));
+        if (!stack || !stack->is_valid()) {
+            break;
+        }
+        ++stats_.mmap_calls;
+        stats_.reserved_bytes += stack->get_mapped_size();
+        stacks_.push_back(std::move(stack));
+    }
+    next_ = 0;
+}
+
+Stack* SharedStackAllocator::allocate(size_t size)
+{
+    return acquire(size);
+}
+
+SharedStack* SharedStackAllocator::acquire(size_t size)
+{
+    if (size > options_.stack_size || stacks_.empty()) {
+        return nullptr;
+    }
+
+    SharedStack* stack = stacks_[next_].get();
+    next_ = (next_ + 1) % stacks_.size();
+    ++stack->users_;
+    ++stats_.in_use;
+    ++stats_.total_allocations;
+    return stack;
+}
+
+void SharedStackAllocator::deallocate(Stack* stack) noexcept
+{
+    if (stack == nullptr) {
+        return;
+    }
+    SharedStack* shared = static_cast<SharedStack*>(stack);
+    if (shared->users_ > 0) {
+        --shared->users_;
+        --stats_.in_use;
+    }
+}
+
+StackStatistics SharedStackAllocator::get_statistics() const noexcept
+{
+    return stats_;
+}
+
+void SharedStackAllocator::set_options(const StackOptions& opts)
+{
+    if (stats_.in_use != 0) {
+        return;
+    }
+    const size_t count = stacks_.size();
+    stats_.munmap_calls += count;
+    options_ = opts;
+    options_.stack_size = round_to_pages(options_.stack_size);
+    create_stacks(count == 0 ? 1 : count);
+}
+
+//============================================================================
+// StackBinding 类实现
+//============================================================================
+
+/**
+ * @brief 每线程的中转上下文
+ *
+ * 当前协程要切换到同一共享栈上的另一个协程时，当前协程还运行在
+ * 要被覆盖的栈上。先切到运行在独立小栈上的中转上下文，由它完成
+ * 换出和换入后再切到目标。
+ */
+struct StackCopier {
+    static constexpr size_t kStackSize = 32 * 1024;
+
+    Stack stack{kStackSize};            ///< 中转上下文自身的栈
+    RegisterState regs{};               ///< 中转上下文寄存器状态
+    StackBinding* from = nullptr;       ///< 待换出的协程
+    StackBinding* to = nullptr;         ///< 待换入的协程
+    bool save_fpu = false;              ///< 第二段切换是否恢复FPU状态
+
+    StackCopier() noexcept
+    {
+        if (!stack.is_valid()) {
+            std::terminate();
+        }
+        regs.rsp = context_utils::align_stack_pointer(stack.get_top());
+        regs.rip = reinterpret_cast<void*>(&StackCopier::run);
+    }
+
+    static StackCopier& local() noexcept
+    {
+        static thread_local StackCopier copier;
+        return copier;
+    }
+
+    LIBCO_OOP_CONTEXT_ENTRY
+    static void run()
+    {
+        for (;;) {
+            StackCopier& copier = local();
+            StackBinding* from = copier.from;
+            StackBinding* to = copier.to;
+
+            if (copier.save_fpu) {
+                // 第一段切换走精简路径，这里补存源协程的FPU状态
+                context_utils::save_fpu_state(*from->regs_);
+            }
+
+            if (!from->save_stack()) {
+                std::terminate();
+            }
+            to->restore_stack();
+            StackBinding::raw_switch(&copier.regs, to->regs_, copier.save_fpu);
+        }
+    }
+};
+
+void StackBinding::bind(RegisterState& regs, Stack* stack, SaveBufferPool* buffers) noexcept
+{
+    unbind();
+    regs_ = &regs;
+    stack_ = stack;
+    buffers_ = buffers;
+    if (stack != nullptr) {
+        // 独立栈从一开始就由自己占用
+        stack->occupant_ = this;
+    }
+}
+
+void StackBinding::bind(RegisterState& regs, SharedStack* stack) noexcept
+{
+    unbind();
+    regs_ = &regs;
+    stack_ = stack;
+    shared_ = stack;
+    buffers_ = stack != nullptr ? &stack->get_owner()->get_buffer_pool() : nullptr;
+}
+
+void StackBinding::unbind() noexcept
+{
+    if (tracker_ != nullptr) {
+        // 由混合栈分配器负责归还栈，它会再次调用 unbind()
+        tracker_->unbind(*this);
+        return;
+    }
+    if (stack_ != nullptr && stack_->occupant_ == this) {
+        // 挂起中解除绑定的栈帧没有正常返回，清除它们留下的 redzone 标记，
+        // 否则复用这个栈的下一个协程会被误报
+        char* sp = static_cast<char*>(regs_->rsp);
+        if (stack_->contains(sp)) {
+            unpoison_stack(sp, stack_->used_bytes(sp));
+        }
+        stack_->occupant_ = nullptr;
+    }
+    if (save_buffer_ != nullptr) {
+        buffers_->deallocate(save_buffer_, save_capacity_);
+    }
+    regs_ = nullptr;
+    stack_ = nullptr;
+    shared_ = nullptr;
+    buffers_ = nullptr;
+    save_buffer_ = nullptr;
+    save_size_ = 0;
+    save_capacity_ = 0;
+    stats_ = StackBindingStatistics{};
+}
+
+void StackBinding::discard() noexcept
+{
+    save_size_ = 0;
+    if (stack_ == nullptr) {
+        return;
+    }
+    if (shared_ != nullptr) {
+        if (stack_->occupant_ == this) {
+            stack_->occupant_ = nullptr;
+        }
+    } else {
+        stack_->occupant_ = this;
+    }
+}
+
+bool StackBinding::park() noexcept
+{
+    if (stack_ == nullptr || buffers_ == nullptr || stack_->occupant_ != this) {
+        return false;
+    }
+
+    char* sp = static_cast<char*>(regs_->rsp);
+    if (!save_stack()) {
+        return false;
+    }
+
+    // 栈帧已在缓冲区中，归还栈上已驻留的物理页，下次访问时重新清零分配
+    const uintptr_t page = Stack::page_size();
+    char* begin = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(sp) & ~(page - 1));
+    char* top = static_cast<char*>(stack_->get_top());
+    if (begin < static_cast<char*>(stack_->get_base())) {
+        begin = static_cast<char*>(stack_->get_base());
+    }
+    ::madvise(begin, static_cast<size_t>(top - begin), MADV_DONTNEED);
+    return true;
+}
+
+void StackBinding::switch_slow(StackBinding& to, bool save_fpu) noexcept
+{
+    if (stack_ == to.stack_) {
+        // 当前协程就是栈的占用者，经中转上下文完成拷贝
+        StackCopier& copier = StackCopier::local();
+        copier.from = this;
+        copier.to = &to;
+        copier.save_fpu = save_fpu;
+        libco_oop_context_swap_minimal(regs_, &copier.regs);
+        return;
+    }
+
+    // 当前协程运行在别的栈上，可以直接覆盖目标栈
+    to.restore_stack();
+    raw_switch(regs_, to.regs_, save_fpu);
+}
+
+void StackBinding::abandon_to(StackBinding& to, bool save_fpu) noexcept
+{
+    discard();
+    ++to.stats_.resume_count;
+    if (!to.is_resident()) {
+        // 本绑定已放弃共享栈，目标的栈帧可以直接拷回
+        to.restore_stack();
+    }
+    raw_switch(regs_, to.regs_, save_fpu);
+    std::terminate();
+}
+
+bool StackBinding::save_stack() noexcept
+{
+    char* top = static_cast<char*>(stack_->get_top());
+    char* sp = static_cast<char*>(regs_->rsp);
+    const size_t used = static_cast<size_t>(top - sp);
+
+    if (used > save_capacity_) {
+        buffers_->deallocate(save_buffer_, save_capacity_);
+        save_capacity_ = 0;
+        save_buffer_ = buffers_->allocate(used, save_capacity_);
+        if (save_buffer_ == nullptr) {
+            return false;
+        }
+    }
+
+    copy_stack_bytes(save_buffer_, sp, used);
+    save_size_ = used;
+    stack_->occupant_ = nullptr;
+    ++stats_.save_count;
+    stats_.copied_bytes += used;
+    return true;
+}
+
+void StackBinding::restore_stack() noexcept
+{
+    StackBinding* occupant = stack_->occupant_;
+    if (occupant != nullptr && !occupant->save_stack()) {
+        // 占用者的栈帧无处保存，继续运行只会破坏其他协程
+        std::terminate();
+    }
+
+    if (save_size_ != 0) {
+        char* top = static_cast<char*>(stack_->get_top());
+        copy_stack_bytes(top - save_size_, save_buffer_, save_size_);
+        ++stats_.restore_count;
+        stats_.copied_bytes += save_size_;
+    }
+    unpoison_stack(stack_->get_base(), stack_->get_size());
+    stack_->occupant_ = this;
+}
+
+//============================================================================
+// HybridStackAllocator 类实现
+//============================================================================
+
+HybridStackAllocator::HybridStackAllocator(const HybridStackOptions& opts)
+    : options_(opts)
+    , private_(opts.private_stack)
+    , shared_(opts.shared_stack_count, opts.shared_stack)
+{
+}
+
+HybridStackAllocator::~HybridStackAllocator()
+{
+    while (!entries_.empty()) {
+        unbind(*entries_.back().binding);
+    }
+}
+
+bool HybridStackAllocator::bind(StackBinding& binding, RegisterState& regs, StackProfile* profile)
+{
+    binding.unbind();
+
+    const bool use_private = profile != nullptr && profile->preferred == StackKind::PRIVATE;
+    if (use_private) {
+        Stack* stack = private_.allocate();
+        if (stack == nullptr) {
+            return false;
+        }
+        binding.bind(regs, stack, &shared_.get_buffer_pool());
+        ++stats_.private_bindings;
+    } else {
+        SharedStack* stack = shared_.acquire();
+        if (stack == nullptr) {
+            return false;
+        }
+        binding.bind(regs, stack);
+        ++stats_.shared_bindings;
+    }
+
+    binding.tracker_ = this;
+    binding.tracking_slot_ = entries_.size();
+    entries_.push_back(Entry{&binding, profile, 0, 0, 0, 0});
+    return true;
+}
+
+void HybridStackAllocator::unbind(StackBinding& binding) noexcept
+{
+    if (binding.tracker_ != this) {
+        return;
+    }
+
+    // 从跟踪表中移除 (与末尾交换)
+    const size_t slot = binding.tracking_slot_;
+    Entry entry = entries_[slot];
+    entries_[slot] = entries_.back();
+    entries_[slot].binding->tracking_slot_ = slot;
+    entries_.pop_back();
+    binding.tracker_ = nullptr;
+
+    const StackBindingStatistics& stats = binding.get_statistics();
+    if (entry.profile != nullptr) {
+        entry.profile->resumes += stats.resume_count;
+        entry.profile->copied_bytes += stats.copied_bytes;
+    }
+
+    Stack* stack = binding.get_stack();
+    const bool shared = binding.is_shared();
+    binding.unbind();
+
+    if (shared) {
+        shared_.deallocate(stack);
+        --stats_.shared_bindings;
+    } else {
+        private_.deallocate(stack);
+        --stats_.private_bindings;
+    }
+}
+
+void HybridStackAllocator::rebalance() noexcept
+{
+    ++stats_.periods;
+
+    for (Entry& entry : entries_) {
+        StackBinding& binding = *entry.binding;
+        const StackBindingStatistics& stats = binding.get_statistics();
+        const size_t resumes = stats.resume_count - entry.last_resumes;
+        const size_t copied = stats.copied_bytes - entry.last_copied;
+        const size_t restores = stats.restore_count - entry.last_restores;
+        entry.last_resumes = stats.resume_count;
+        entry.last_copied = stats.copied_bytes;
+        entry.last_restores = stats.restore_count;
+
+        if (binding.is_shared()) {
+            // 高频或深栈：换入换出的拷贝开销已经超过独立栈的内存代价
+            const bool hot = resumes >= options_.hot_switches;
+            const bool deep = restores != 0 && copied / restores >= options_.deep_copy_bytes;
+            if ((hot || deep) && entry.profile != nullptr
+                && entry.profile->preferred == StackKind::SHARED) {
+                entry.profile->preferred = StackKind::PRIVATE;
+                ++entry.profile->promotions;
+                ++stats_.promotions;
+            }
+            continue;
+        }
+
+        // 独立栈：连续空闲则停放，并让同一画像回到共享栈
+        if (resumes != 0) {
+            entry.idle_periods = 0;
+            continue;
+        }
+        if (++entry.idle_periods < options_.idle_periods || !binding.is_resident()) {
+            continue;
+        }
+        if (!binding.park()) {
+            continue;
+        }
+        // 停放本身的拷贝不计入下个周期的判断
+        entry.last_copied = binding.get_statistics().copied_bytes;
+        ++stats_.demotions;
+        if (entry.profile != nullptr && entry.profile->preferred == StackKind::PRIVATE) {
+            entry.profile->preferred = StackKind::SHARED;
+            ++entry.profile->demotions;
+        }
+    }
+}
+
+HybridStackStatistics HybridStackAllocator::get_statistics() const noexcept
+{
+    HybridStackStatistics stats = stats_;
+    stats.parked = 0;
+    for (const Entry& entry : entries_) {
+        if (!entry.binding->is_shared() && !entry.binding->is_resident()) {
+            ++stats.parked;
+        }
+    }
+    return stats;
+}
+
+} // namespace libco_oop
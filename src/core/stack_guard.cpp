@@ -0,0 +1,361 @@
+/**
+ * @file stack_guard.cpp
+ * @brief 协程栈溢出检测实现
+ * @author libco-oop
+ * @version 1.0
+ *
+ * SIGSEGV 处理函数运行在备用信号栈上，从线程登记的当前协程变量找到
+ * 故障协程，故障地址落在它的栈保护页内即判定为溢出。处理函数中只使用
+ * 异步信号安全的操作：报告用 write(2) 输出，结束协程时复制一个预先
+ * 创建好的异常对象，并直接切换回协程的调用者。
+ */
+
+#include "libco_oop/stack_guard.h"
+#include "libco_oop/coroutine.h"
+#include <sys/mman.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <exception>
+
+namespace libco_oop {
+namespace stack_guard {
+
+namespace {
+
+//============================================================================
+// 全局状态
+//============================================================================
+
+std::atomic<bool> g_installed{false};
+std::atomic<size_t> g_overflow_count{0};
+StackGuardOptions g_options;
+struct sigaction g_previous;                ///< 安装之前的 SIGSEGV 处理函数
+std::exception_ptr g_overflow_exception;    ///< 结束协程时使用的异常 (安装时创建)
+
+// 平凡类型的线程局部变量没有初始化函数，信号处理函数中可以直接读取
+thread_local Coroutine* const* t_current = nullptr;
+
+/**
+ * @brief 本库为线程分配的备用信号栈，线程退出时释放
+ */
+struct AltStack {
+    void* memory = nullptr;
+    size_t size = 0;
+
+    ~AltStack()
+    {
+        if (memory == nullptr) {
+            return;
+        }
+        stack_t current{};
+        if (::sigaltstack(nullptr, &current) == 0 && current.ss_sp == memory) {
+            stack_t disable{};
+            disable.ss_flags = SS_DISABLE;
+            ::sigaltstack(&disable, nullptr);
+        }
+        ::munmap(memory, size);
+    }
+};
+
+thread_local AltStack t_alt_stack;
+
+/**
+ * @brief 确保调用线程有备用信号栈
+ */
+bool ensure_alt_stack(size_t size) noexcept
+{
+    stack_t current{};
+    if (::sigaltstack(nullptr, &current) != 0) {
+        return false;
+    }
+    if ((current.ss_flags & SS_DISABLE) == 0) {
+        // 已有备用信号栈 (本库之前分配的，或 AddressSanitizer 等安装的)
+        return true;
+    }
+
+    const size_t page = Stack::page_size();
+    size = (std::max<size_t>(size, 16 * 1024) + page - 1) & ~(page - 1);
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    stack_t stack{};
+    stack.ss_sp = memory;
+    stack.ss_size = size;
+    if (::sigaltstack(&stack, nullptr) != 0) {
+        ::munmap(memory, size);
+        return false;
+    }
+
+    AltStack& alt = t_alt_stack;
+    if (alt.memory != nullptr) {
+        ::munmap(alt.memory, alt.size);
+    }
+    alt.memory = memory;
+    alt.size = size;
+    return true;
+}
+
+//============================================================================
+// 异步信号安全的报告
+//============================================================================
+
+/**
+ * @brief 固定大小的行缓冲区，不分配内存
+ */
+class ReportLine {
+public:
+    ReportLine& text(const char* s) noexcept
+    {
+        while (s != nullptr && *s != '\0' && size_ < sizeof(data_)) {
+            data_[size_++] = *s++;
+        }
+        return *this;
+    }
+
+    ReportLine& decimal(uint64_t value) noexcept
+    {
+        char digits[20];
+        size_t n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (n > 0 && size_ < sizeof(data_)) {
+            data_[size_++] = digits[--n];
+        }
+        return *this;
+    }
+
+    ReportLine& address(const void* pointer) noexcept
+    {
+        static const char kHex[] = "0123456789abcdef";
+        uintptr_t value = reinterpret_cast<uintptr_t>(pointer);
+        char digits[16];
+        size_t n = 0;
+        do {
+            digits[n++] = kHex[value & 15];
+            value >>= 4;
+        } while (value != 0);
+        text("0x");
+        while (n > 0 && size_ < sizeof(data_)) {
+            data_[size_++] = digits[--n];
+        }
+        return *this;
+    }
+
+    void write(int fd) const noexcept
+    {
+        size_t written = 0;
+        while (written < size_) {
+            const ssize_t n = ::write(fd, data_ + written, size_ - written);
+            if (n <= 0) {
+                break;
+            }
+            written += static_cast<size_t>(n);
+        }
+    }
+
+private:
+    char data_[512];
+    size_t size_ = 0;
+};
+
+void report(const StackOverflowInfo& info, bool terminating) noexcept
+{
+    ReportLine line;
+    line.text("libco_oop: stack overflow in coroutine ").decimal(info.coroutine_id)
+        .text(" (entry ").text(info.entry_type).text(" at ").address(info.entry_address)
+        .text(", stack ").decimal(info.stack_size)
+        .text(" bytes, fault at ").address(info.fault_address).text(")")
+        .text(terminating ? ", terminating the coroutine\n" : "\n");
+    line.write(STDERR_FILENO);
+}
+
+/**
+ * @brief 把不属于协程栈溢出的故障交给之前的处理函数
+ *
+ * 之前没有处理函数时恢复默认动作，返回后故障指令重新执行并终止进程。
+ */
+void chain(int sig, siginfo_t* info, void* context) noexcept
+{
+    if ((g_previous.sa_flags & SA_SIGINFO) != 0 && g_previous.sa_sigaction != nullptr) {
+        g_previous.sa_sigaction(sig, info, context);
+        return;
+    }
+    if ((g_previous.sa_flags & SA_SIGINFO) == 0
+        && g_previous.sa_handler != SIG_DFL && g_previous.sa_handler != SIG_IGN) {
+        g_previous.sa_handler(sig);
+        return;
+    }
+    struct sigaction fallback{};
+    fallback.sa_handler = SIG_DFL;
+    sigemptyset(&fallback.sa_mask);
+    ::sigaction(sig, &fallback, nullptr);
+}
+
+void on_fault(int sig, siginfo_t* info, void* context);
+
+} // namespace
+
+//============================================================================
+// 协程访问
+//============================================================================
+
+namespace detail {
+
+/**
+ * @brief 信号处理函数访问协程控制块的入口
+ */
+struct Access {
+    static bool faulted_in_guard(const Coroutine& coroutine, const void* address) noexcept
+    {
+        const Stack* stack = coroutine.binding_.get_stack();
+        if (stack == nullptr || stack->get_guard_size() == 0) {
+            return false;
+        }
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(stack->get_guard_begin());
+        const uintptr_t fault = reinterpret_cast<uintptr_t>(address);
+        return fault >= begin && fault < begin + stack->get_guard_size();
+    }
+
+    static StackOverflowInfo describe(const Coroutine& coroutine, const void* address) noexcept
+    {
+        StackOverflowInfo info;
+        info.coroutine_id = coroutine.id_;
+        info.entry_type = coroutine.function_.target_type().name();
+        info.entry_address = coroutine.function_.get_invoker();
+        info.stack_size = coroutine.binding_.get_stack()->get_size();
+        info.fault_address = address;
+        return info;
+    }
+
+    static bool can_terminate(const Coroutine& coroutine) noexcept
+    {
+        return coroutine.state_ == CoroutineState::RUNNING && coroutine.caller_ != nullptr;
+    }
+
+    /**
+     * @brief 以 StackOverflowError 结束协程，切换回它的调用者 (不会返回)
+     *
+     * 协程栈上的对象不会析构，与销毁挂起的协程相同。
+     */
+    [[noreturn]] static void terminate(Coroutine& coroutine) noexcept
+    {
+        coroutine.exception_ = g_overflow_exception;
+        coroutine.state_ = CoroutineState::ERROR;
+
+        // 不从处理函数返回，需要手动解除 SIGSEGV 的屏蔽
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGSEGV);
+        ::pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
+
+        coroutine.binding_.abandon_to(*coroutine.caller_, coroutine.save_fpu_);
+    }
+};
+
+void attach_thread(Coroutine* const* current) noexcept
+{
+    t_current = current;
+    if (current != nullptr && g_installed.load(std::memory_order_acquire)) {
+        ensure_alt_stack(g_options.alt_stack_size);
+    }
+}
+
+} // namespace detail
+
+namespace {
+
+void on_fault(int sig, siginfo_t* info, void* context)
+{
+    Coroutine* const* current = t_current;
+    Coroutine* coroutine = current != nullptr ? *current : nullptr;
+    if (coroutine == nullptr || !detail::Access::faulted_in_guard(*coroutine, info->si_addr)) {
+        chain(sig, info, context);
+        return;
+    }
+
+    g_overflow_count.fetch_add(1, std::memory_order_relaxed);
+    const bool terminating = g_options.action == OverflowAction::TERMINATE_COROUTINE
+                          && detail::Access::can_terminate(*coroutine);
+    const StackOverflowInfo overflow = detail::Access::describe(*coroutine, info->si_addr);
+    if (g_options.report) {
+        report(overflow, terminating);
+    }
+    if (g_options.on_overflow != nullptr) {
+        g_options.on_overflow(overflow);
+    }
+    if (terminating) {
+        detail::Access::terminate(*coroutine);
+    }
+    chain(sig, info, context);
+}
+
+} // namespace
+
+//============================================================================
+// 安装与卸载
+//============================================================================
+
+bool install(const StackGuardOptions& opts) noexcept
+{
+    if (!g_installed.load(std::memory_order_acquire)) {
+        try {
+            g_overflow_exception = std::make_exception_ptr(StackOverflowError("coroutine stack overflow"));
+        } catch (...) {
+            errno = ENOMEM;
+            return false;
+        }
+    }
+    g_options = opts;
+    if (!ensure_alt_stack(opts.alt_stack_size)) {
+        return false;
+    }
+    if (g_installed.load(std::memory_order_acquire)) {
+        return true;
+    }
+
+    struct sigaction action{};
+    action.sa_sigaction = &on_fault;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    if (::sigaction(SIGSEGV, &action, &g_previous) != 0) {
+        return false;
+    }
+    g_installed.store(true, std::memory_order_release);
+    return true;
+}
+
+void uninstall() noexcept
+{
+    if (g_installed.exchange(false, std::memory_order_acq_rel)) {
+        ::sigaction(SIGSEGV, &g_previous, nullptr);
+    }
+}
+
+bool is_installed() noexcept
+{
+    return g_installed.load(std::memory_order_acquire);
+}
+
+bool prepare_thread() noexcept
+{
+    if (!is_installed()) {
+        return false;
+    }
+    return ensure_alt_stack(g_options.alt_stack_size);
+}
+
+size_t get_overflow_count() noexcept
+{
+    return g_overflow_count.load(std::memory_order_relaxed);
+}
+
+} // namespace stack_guard
+} // namespace libco_oop
@@ -0,0 +1,305 @@
+/**
+ * @file trace.cpp
+ * @brief 调度事件跟踪的缓冲区登记与导出
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 登记表只在线程第一次记录、collect() 和 clear() 时加锁，记录事件不经过这里。
+ */
+
+#include "libco_oop/trace.h"
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <sstream>
+
+namespace libco_oop {
+namespace trace {
+
+namespace {
+
+uint64_t steady_ns() noexcept
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+size_t round_to_power_of_two(size_t value) noexcept
+{
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * @brief 进程级缓冲区登记表
+ *
+ * 不析构：线程可能在静态对象析构之后才退出。
+ */
+class Registry {
+public:
+    static Registry& instance() noexcept
+    {
+        static Registry* registry = new Registry;
+        return *registry;
+    }
+
+    std::mutex mutex;
+    IntrusiveList<ThreadRing> rings;                ///< 所有缓冲区 (含已退出线程的)
+    std::atomic<size_t> capacity{kDefaultCapacity}; ///< 新建缓冲区的容量
+    uint64_t start_cycles = 0;                      ///< 第一次 start() 时的周期计数
+    uint64_t start_ns = 0;                          ///< 同一时刻的 steady_clock
+};
+
+/**
+ * @brief 线程退出时把缓冲区标记为已退出，事件保留到 clear()
+ */
+struct LocalRing {
+    ThreadRing* ring = nullptr;
+
+    ~LocalRing()
+    {
+        if (ring != nullptr) {
+            ring->retire();
+        }
+    }
+};
+
+thread_local LocalRing t_local;
+
+const char* event_name(EventType type) noexcept
+{
+    switch (type) {
+    case EventType::SWITCH_IN:  return "switch in";
+    case EventType::SWITCH_OUT: return "switch out";
+    case EventType::IO_PARK:    return "io park";
+    case EventType::TIMER_WAKE: return "timer wake";
+    case EventType::STEAL:      return "steal";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+//============================================================================
+// ThreadRing 类实现
+//============================================================================
+
+ThreadRing::ThreadRing(size_t capacity)
+    : slots_(new Slot[round_to_power_of_two(capacity == 0 ? 1 : capacity)])
+    , mask_(round_to_power_of_two(capacity == 0 ? 1 : capacity) - 1)
+    , tid_(static_cast<uint32_t>(::syscall(SYS_gettid)))
+{
+}
+
+ThreadTrace ThreadRing::read() const
+{
+    ThreadTrace trace;
+    trace.tid = tid_;
+
+    const uint64_t capacity = mask_ + 1;
+    const uint64_t end = committed_.load(std::memory_order_acquire);
+    const uint64_t begin = end > capacity ? end - capacity : 0;
+    trace.events.resize(static_cast<size_t>(end - begin));
+    for (uint64_t i = begin; i < end; ++i) {
+        const Slot& slot = slots_[i & mask_];
+        Event& event = trace.events[static_cast<size_t>(i - begin)];
+        event.cycles = slot.cycles.load(std::memory_order_relaxed);
+        event.coroutine_id = slot.coroutine_id.load(std::memory_order_relaxed);
+        const uint64_t word = slot.word.load(std::memory_order_relaxed);
+        event.arg = static_cast<uint32_t>(word >> 8);
+        event.type = static_cast<EventType>(word & 0xFF);
+    }
+
+    // 拷贝期间写入者可能已经覆盖了最旧的槽位
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    const uint64_t valid = head > capacity ? head - capacity : 0;
+    if (valid > begin) {
+        const size_t overwritten = static_cast<size_t>(std::min(valid, end) - begin);
+        trace.events.erase(trace.events.begin(), trace.events.begin() + static_cast<std::ptrdiff_t>(overwritten));
+    }
+    trace.dropped = end - trace.events.size();
+    return trace;
+}
+
+void ThreadRing::clear() noexcept
+{
+    head_.store(0, std::memory_order_relaxed);
+    committed_.store(0, std::memory_order_release);
+}
+
+//============================================================================
+// 记录控制
+//============================================================================
+
+namespace detail {
+
+std::atomic<bool> g_running{false};
+
+ThreadRing* local_ring() noexcept
+{
+    if (t_local.ring != nullptr) {
+        return t_local.ring;
+    }
+    Registry& registry = Registry::instance();
+    ThreadRing* ring = new (std::nothrow) ThreadRing(registry.capacity.load(std::memory_order_relaxed));
+    if (ring == nullptr) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.rings.push_back(ring);
+    t_local.ring = ring;
+    return ring;
+}
+
+} // namespace detail
+
+bool start(size_t capacity) noexcept
+{
+    if (!kEnabled) {
+        return false;
+    }
+    Registry& registry = Registry::instance();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (registry.start_ns == 0) {
+            registry.start_cycles = metrics::read_cycles();
+            registry.start_ns = steady_ns();
+        }
+    }
+    registry.capacity.store(capacity, std::memory_order_relaxed);
+    detail::g_running.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void stop() noexcept
+{
+    detail::g_running.store(false, std::memory_order_relaxed);
+}
+
+TraceSnapshot collect()
+{
+    TraceSnapshot snapshot;
+    Registry& registry = Registry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (registry.start_ns == 0) {
+        return snapshot;
+    }
+
+    // 以第一次 start() 到现在的间隔标定周期计数器
+    const uint64_t elapsed_ns = steady_ns() - registry.start_ns;
+    const uint64_t elapsed_cycles = metrics::read_cycles() - registry.start_cycles;
+    snapshot.start_cycles = registry.start_cycles;
+    snapshot.cycles_per_us = elapsed_ns == 0 ? 1000.0
+        : static_cast<double>(elapsed_cycles) * 1000.0 / static_cast<double>(elapsed_ns);
+
+    snapshot.threads.reserve(registry.rings.size());
+    registry.rings.for_each([&snapshot](ThreadRing* ring) {
+        snapshot.threads.push_back(ring->read());
+    });
+    return snapshot;
+}
+
+void clear() noexcept
+{
+    Registry& registry = Registry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    IntrusiveList<ThreadRing> live;
+    while (ThreadRing* ring = registry.rings.pop_front()) {
+        if (ring->is_retired()) {
+            delete ring;
+        } else {
+            ring->clear();
+            live.push_back(ring);
+        }
+    }
+    while (ThreadRing* ring = live.pop_front()) {
+        registry.rings.push_back(ring);
+    }
+}
+
+//============================================================================
+// Chrome trace 导出
+//============================================================================
+
+std::string format_chrome_trace(const TraceSnapshot& snapshot)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    const double cycles_per_us = snapshot.cycles_per_us > 0 ? snapshot.cycles_per_us : 1000.0;
+    bool first = true;
+    auto begin_event = [&](const char* name, const char* phase, uint32_t tid) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "{\"name\":\"" << name << "\",\"ph\":\"" << phase << "\",\"pid\":1,\"tid\":" << tid;
+    };
+
+    for (const ThreadTrace& thread : snapshot.threads) {
+        begin_event("thread_name", "M", thread.tid);
+        out << ",\"args\":{\"name\":\"libco_oop " << thread.tid << "\"}}";
+
+        // 缓冲区覆盖后，开头的切出可能没有对应的切入
+        size_t open = 0;
+        for (const Event& event : thread.events) {
+            const double ts = event.cycles >= snapshot.start_cycles
+                ? static_cast<double>(event.cycles - snapshot.start_cycles) / cycles_per_us : 0.0;
+            std::string slice = "co " + std::to_string(event.coroutine_id);
+            switch (event.type) {
+            case EventType::SWITCH_IN:
+                ++open;
+                begin_event(slice.c_str(), "B", thread.tid);
+                break;
+            case EventType::SWITCH_OUT:
+                if (open == 0) {
+                    continue;
+                }
+                --open;
+                begin_event(slice.c_str(), "E", thread.tid);
+                break;
+            default:
+                begin_event(event_name(event.type), "i", thread.tid);
+                out << ",\"s\":\"t\"";
+                break;
+            }
+            out << ",\"ts\":" << ts << ",\"args\":{\"id\":" << event.coroutine_id;
+            if (event.type == EventType::IO_PARK || event.type == EventType::STEAL) {
+                out << ",\"arg\":" << event.arg;
+            }
+            out << "}}";
+        }
+    }
+    out << "\n]}\n";
+    return out.str();
+}
+
+bool dump_chrome_trace(const char* path)
+{
+    const std::string json = format_chrome_trace(collect());
+    std::FILE* file = std::fopen(path, "w");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    const int saved = errno;
+    if (std::fclose(file) != 0 || !written) {
+        if (!written) {
+            errno = saved;
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace trace
+} // namespace libco_oop
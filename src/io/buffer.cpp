@@ -0,0 +1,444 @@
+/**
+ * @file buffer.cpp
+ * @brief 引用计数的缓冲区链实现
+ * @author libco-oop
+ * @version 1.0
+ *
+ * BufferPool 的 slab 用 mmap 映射，块描述符与 slab 头一起分配在普通堆上，
+ * 块内存只包含数据。BufferChain 的片段数组用 malloc/realloc 管理。
+ */
+
+#include "libco_oop/buffer.h"
+#include <sys/mman.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace libco_oop {
+
+namespace {
+
+constexpr size_t kBlockAlignment = 64;      ///< 块大小的对齐 (缓存行)
+constexpr size_t kMinSegments = 8;          ///< 片段数组的初始容量
+constexpr size_t kAppendIovecs = 8;         ///< append() 每次准备的区间数
+
+} // namespace
+
+//============================================================================
+// BufferPool 类实现
+//============================================================================
+
+/**
+ * @brief 一次映射的块，描述符数组紧跟在结构体之后
+ */
+struct BufferPool::Slab {
+    Slab* next;
+    void* memory;
+    size_t bytes;
+
+    BufferBlock* blocks() noexcept { return reinterpret_cast<BufferBlock*>(this + 1); }
+};
+
+BufferPool::BufferPool(const BufferPoolOptions& opts) noexcept
+    : block_size_(std::min<size_t>(
+          (std::max<size_t>(opts.block_size, 1) + kBlockAlignment - 1) & ~(kBlockAlignment - 1),
+          std::numeric_limits<uint32_t>::max() & ~(kBlockAlignment - 1)))
+    , blocks_per_slab_(std::max<size_t>(opts.blocks_per_slab, 1))
+    , max_blocks_(opts.max_blocks)
+{
+}
+
+BufferPool::~BufferPool() noexcept
+{
+    while (Slab* slab = slabs_) {
+        slabs_ = slab->next;
+        ::munmap(slab->memory, slab->bytes);
+        std::free(slab);
+    }
+}
+
+BufferPool& BufferPool::local() noexcept
+{
+    static thread_local BufferPool pool;
+    return pool;
+}
+
+BufferBlock* BufferPool::allocate() noexcept
+{
+    if (free_ == nullptr && !grow()) {
+        ++stats_.failures;
+        errno = ENOMEM;
+        return nullptr;
+    }
+    BufferBlock* block = free_;
+    free_ = block->next_free_;
+    block->next_free_ = nullptr;
+    block->refs_ = 1;
+    ++stats_.allocations;
+    ++stats_.in_use;
+    return block;
+}
+
+bool BufferPool::grow() noexcept
+{
+    size_t count = blocks_per_slab_;
+    if (max_blocks_ != 0) {
+        count = std::min(count, max_blocks_ - std::min(max_blocks_, stats_.blocks));
+        if (count == 0) {
+            return false;
+        }
+    }
+
+    Slab* slab = static_cast<Slab*>(std::calloc(1, sizeof(Slab) + count * sizeof(BufferBlock)));
+    if (slab == nullptr) {
+        return false;
+    }
+    slab->bytes = count * block_size_;
+    slab->memory = ::mmap(nullptr, slab->bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slab->memory == MAP_FAILED) {
+        std::free(slab);
+        return false;
+    }
+
+    // 逆序链入，使低地址的块最先分配
+    BufferBlock* blocks = slab->blocks();
+    char* memory = static_cast<char*>(slab->memory);
+    for (size_t i = count; i-- > 0;) {
+        BufferBlock& block = blocks[i];
+        block.data_ = memory + i * block_size_;
+        block.pool_ = this;
+        block.capacity_ = static_cast<uint32_t>(block_size_);
+        block.refs_ = 0;
+        block.next_free_ = free_;
+        free_ = &block;
+    }
+    slab->next = slabs_;
+    slabs_ = slab;
+    ++stats_.slabs;
+    stats_.blocks += count;
+    return true;
+}
+
+void BufferPool::recycle(BufferBlock* block) noexcept
+{
+    block->next_free_ = free_;
+    free_ = block;
+    --stats_.in_use;
+}
+
+//============================================================================
+// BufferChain 类实现
+//============================================================================
+
+BufferChain::BufferChain(BufferPool& pool) noexcept
+    : pool_(&pool)
+{
+}
+
+BufferChain::~BufferChain() noexcept
+{
+    clear();
+    std::free(segments_);
+}
+
+BufferChain::BufferChain(BufferChain&& other) noexcept
+    : pool_(other.pool_)
+    , segments_(other.segments_)
+    , head_(other.head_)
+    , count_(other.count_)
+    , capacity_(other.capacity_)
+    , size_(other.size_)
+{
+    other.segments_ = nullptr;
+    other.head_ = other.count_ = other.capacity_ = other.size_ = 0;
+}
+
+BufferChain& BufferChain::operator=(BufferChain&& other) noexcept
+{
+    if (this != &other) {
+        clear();
+        std::free(segments_);
+        pool_ = other.pool_;
+        segments_ = other.segments_;
+        head_ = other.head_;
+        count_ = other.count_;
+        capacity_ = other.capacity_;
+        size_ = other.size_;
+        other.segments_ = nullptr;
+        other.head_ = other.count_ = other.capacity_ = other.size_ = 0;
+    }
+    return *this;
+}
+
+bool BufferChain::reserve(size_t extra) noexcept
+{
+    if (count_ + extra <= capacity_) {
+        return true;
+    }
+    // 先回收已消费的前缀
+    if (head_ > 0) {
+        std::memmove(segments_, segments_ + head_, (count_ - head_) * sizeof(Segment));
+        count_ -= head_;
+        head_ = 0;
+        if (count_ + extra <= capacity_) {
+            return true;
+        }
+    }
+    const size_t capacity = std::max({capacity_ * 2, kMinSegments, count_ + extra});
+    Segment* grown = static_cast<Segment*>(std::realloc(segments_, capacity * sizeof(Segment)));
+    if (grown == nullptr) {
+        errno = ENOMEM;
+        return false;
+    }
+    segments_ = grown;
+    capacity_ = capacity;
+    return true;
+}
+
+void BufferChain::push(BufferBlock* block, uint32_t offset, uint32_t length) noexcept
+{
+    segments_[count_++] = Segment{block, offset, length};
+    size_ += length;
+}
+
+bool BufferChain::writable_tail(const Segment& segment) const noexcept
+{
+    return segment.block->use_count() == 1 && segment.offset + segment.length < segment.block->capacity();
+}
+
+size_t BufferChain::prepare(iovec* iov, size_t max_iov, size_t min_length) noexcept
+{
+    if (max_iov == 0) {
+        return 0;
+    }
+    const size_t block_size = pool_->get_block_size();
+    const size_t wanted = min_length != 0 ? min_length : block_size;
+    if (!reserve(std::min(max_iov, (wanted + block_size - 1) / block_size))) {
+        return 0;
+    }
+
+    size_t filled = 0;
+    size_t space = 0;
+    prepared_ = count_;
+    if (count_ > head_ && writable_tail(segments_[count_ - 1])) {
+        const Segment& tail = segments_[count_ - 1];
+        const size_t end = tail.offset + tail.length;
+        iov[filled++] = iovec{tail.block->data() + end, tail.block->capacity() - end};
+        space += tail.block->capacity() - end;
+        prepared_ = count_ - 1;
+    }
+
+    const size_t appended = count_;
+    while (space < wanted && filled < max_iov && count_ < capacity_) {
+        BufferBlock* block = pool_->allocate();
+        if (block == nullptr) {
+            while (count_ > appended) {
+                segments_[--count_].block->release();
+            }
+            return 0;
+        }
+        push(block, 0, 0);
+        iov[filled++] = iovec{block->data(), block->capacity()};
+        space += block->capacity();
+    }
+    return filled;
+}
+
+void BufferChain::commit(size_t length) noexcept
+{
+    for (size_t i = prepared_; i < count_ && length > 0; ++i) {
+        Segment& segment = segments_[i];
+        const size_t room = segment.block->capacity() - (segment.offset + segment.length);
+        const size_t taken = std::min(room, length);
+        segment.length += static_cast<uint32_t>(taken);
+        size_ += taken;
+        length -= taken;
+    }
+    // 未写入的新块还给池
+    while (count_ > head_ && count_ > prepared_ && segments_[count_ - 1].length == 0) {
+        segments_[--count_].block->release();
+    }
+}
+
+bool BufferChain::append(const void* data, size_t length) noexcept
+{
+    const char* source = static_cast<const char*>(data);
+    while (length > 0) {
+        iovec iov[kAppendIovecs];
+        const size_t filled = prepare(iov, kAppendIovecs, length);
+        if (filled == 0) {
+            return false;
+        }
+        size_t copied = 0;
+        for (size_t i = 0; i < filled && copied < length; ++i) {
+            const size_t taken = std::min(iov[i].iov_len, length - copied);
+            std::memcpy(iov[i].iov_base, source + copied, taken);
+            copied += taken;
+        }
+        commit(copied);
+        source += copied;
+        length -= copied;
+    }
+    return true;
+}
+
+bool BufferChain::append(BufferChain&& other) noexcept
+{
+    if (&other == this) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!reserve(other.segment_count())) {
+        return false;
+    }
+    std::memcpy(segments_ + count_, other.segments_ + other.head_, other.segment_count() * sizeof(Segment));
+    count_ += other.segment_count();
+    size_ += other.size_;
+    other.head_ = other.count_ = other.size_ = 0;
+    return true;
+}
+
+bool BufferChain::append(const BufferChain& other, size_t offset, size_t length) noexcept
+{
+    if (offset > other.size_ || length > other.size_ - offset) {
+        errno = EINVAL;
+        return false;
+    }
+
+    // 先数出需要的片段数：other 可以就是本链，扩容之后才能保存片段的位置
+    size_t needed = 0;
+    size_t skip = offset;
+    size_t remaining = length;
+    for (size_t i = other.head_; i < other.count_ && remaining > 0; ++i) {
+        const size_t segment_length = other.segments_[i].length;
+        if (skip >= segment_length) {
+            skip -= segment_length;
+            continue;
+        }
+        remaining -= std::min(segment_length - skip, remaining);
+        skip = 0;
+        ++needed;
+    }
+    if (!reserve(needed)) {
+        return false;
+    }
+
+    skip = offset;
+    remaining = length;
+    for (size_t i = other.head_; remaining > 0; ++i) {
+        const Segment segment = other.segments_[i];
+        if (skip >= segment.length) {
+            skip -= segment.length;
+            continue;
+        }
+        const size_t taken = std::min(segment.length - skip, remaining);
+        segment.block->retain();
+        push(segment.block, static_cast<uint32_t>(segment.offset + skip), static_cast<uint32_t>(taken));
+        remaining -= taken;
+        skip = 0;
+    }
+    return true;
+}
+
+size_t BufferChain::fill_iovec(iovec* iov, size_t max_iov, size_t offset) const noexcept
+{
+    size_t filled = 0;
+    for (size_t i = head_; i < count_ && filled < max_iov; ++i) {
+        const Segment& segment = segments_[i];
+        if (offset >= segment.length) {
+            offset -= segment.length;
+            continue;
+        }
+        iov[filled++] = iovec{segment.block->data() + segment.offset + offset, segment.length - offset};
+        offset = 0;
+    }
+    return filled;
+}
+
+size_t BufferChain::copy_to(void* out, size_t length, size_t offset) const noexcept
+{
+    char* target = static_cast<char*>(out);
+    size_t copied = 0;
+    for (size_t i = head_; i < count_ && copied < length; ++i) {
+        const Segment& segment = segments_[i];
+        if (offset >= segment.length) {
+            offset -= segment.length;
+            continue;
+        }
+        const size_t taken = std::min<size_t>(segment.length - offset, length - copied);
+        std::memcpy(target + copied, segment.block->data() + segment.offset + offset, taken);
+        copied += taken;
+        offset = 0;
+    }
+    return copied;
+}
+
+void BufferChain::consume(size_t length) noexcept
+{
+    while (length > 0 && head_ < count_) {
+        Segment& segment = segments_[head_];
+        if (length < segment.length) {
+            segment.offset += static_cast<uint32_t>(length);
+            segment.length -= static_cast<uint32_t>(length);
+            size_ -= length;
+            break;
+        }
+        length -= segment.length;
+        size_ -= segment.length;
+        segment.block->release();
+        ++head_;
+    }
+    if (head_ == count_) {
+        head_ = count_ = 0;
+    }
+}
+
+bool BufferChain::split_to(BufferChain& out, size_t length) noexcept
+{
+    if (&out == this || length > size_) {
+        errno = EINVAL;
+        return false;
+    }
+
+    size_t needed = 0;
+    for (size_t i = head_, remaining = length; remaining > 0; ++i) {
+        remaining -= std::min<size_t>(segments_[i].length, remaining);
+        ++needed;
+    }
+    if (!out.reserve(needed)) {
+        return false;
+    }
+
+    size_t remaining = length;
+    while (remaining > 0) {
+        Segment& segment = segments_[head_];
+        if (remaining < segment.length) {
+            // 边界在片段中间：两边各持有一个引用
+            segment.block->retain();
+            out.push(segment.block, segment.offset, static_cast<uint32_t>(remaining));
+            segment.offset += static_cast<uint32_t>(remaining);
+            segment.length -= static_cast<uint32_t>(remaining);
+            break;
+        }
+        out.push(segment.block, segment.offset, segment.length);
+        remaining -= segment.length;
+        ++head_;
+    }
+    size_ -= length;
+    if (head_ == count_) {
+        head_ = count_ = 0;
+    }
+    return true;
+}
+
+void BufferChain::clear() noexcept
+{
+    for (size_t i = head_; i < count_; ++i) {
+        segments_[i].block->release();
+    }
+    head_ = count_ = size_ = 0;
+}
+
+} // namespace libco_oop
@@ -0,0 +1,432 @@
+/**
+ * @file hook.cpp
+ * @brief 阻塞系统调用接管实现
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 本文件单独构成 libco_oop_hook 目标：只有链接了它的程序才会覆盖
+ * libc 符号。内部一律通过 real_* 函数指针调用真实实现，避免递归。
+ */
+
+#include "libco_oop/hook.h"
+#include "libco_oop/io_manager.h"
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdint>
+
+namespace libco_oop {
+
+namespace {
+
+//============================================================================
+// 真实函数解析
+//============================================================================
+
+decltype(::read)* real_read = nullptr;
+decltype(::write)* real_write = nullptr;
+decltype(::recv)* real_recv = nullptr;
+decltype(::send)* real_send = nullptr;
+decltype(::connect)* real_connect = nullptr;
+decltype(::accept)* real_accept = nullptr;
+decltype(::poll)* real_poll = nullptr;
+decltype(::nanosleep)* real_nanosleep = nullptr;
+decltype(::usleep)* real_usleep = nullptr;
+decltype(::close)* real_close = nullptr;
+decltype(::fcntl)* real_fcntl = nullptr;
+
+/**
+ * @brief 首次使用时通过 dlsym(RTLD_NEXT) 解析真实实现
+ */
+template <typename F>
+F* resolve(F*& slot, const char* name) noexcept
+{
+    F* fn = __atomic_load_n(&slot, __ATOMIC_ACQUIRE);
+    if (__builtin_expect(fn == nullptr, 0)) {
+        fn = reinterpret_cast<F*>(::dlsym(RTLD_NEXT, name));
+        __atomic_store_n(&slot, fn, __ATOMIC_RELEASE);
+    }
+    return fn;
+}
+
+#define LIBCO_OOP_REAL(name) resolve(real_##name, #name)
+
+//============================================================================
+// fd 状态表
+//============================================================================
+
+/**
+ * @brief fd 的接管方式
+ */
+enum FdMode : uint8_t {
+    FD_UNKNOWN = 0,     ///< 尚未分类
+    FD_PASSTHROUGH,     ///< 普通文件或用户自己设置了 O_NONBLOCK，直接透传
+    FD_MANAGED          ///< 由接管层设为非阻塞，对用户保持阻塞语义
+};
+
+constexpr size_t kMaxTrackedFds = 1u << 20;     ///< 超出范围的 fd 直接透传
+
+std::atomic<uint8_t> fd_modes[kMaxTrackedFds];  ///< 静态存储，零初始化为 FD_UNKNOWN
+
+thread_local bool t_disabled = false;
+
+FdMode cached_mode(int fd) noexcept
+{
+    if (fd < 0 || static_cast<size_t>(fd) >= kMaxTrackedFds) {
+        return FD_PASSTHROUGH;
+    }
+    return static_cast<FdMode>(fd_modes[fd].load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief 在协程中首次使用 fd 时分类，阻塞的套接字/管道被设为非阻塞
+ */
+FdMode classify(int fd) noexcept
+{
+    FdMode mode = cached_mode(fd);
+    if (mode != FD_UNKNOWN) {
+        return mode;
+    }
+
+    mode = FD_PASSTHROUGH;
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && (S_ISSOCK(info.st_mode) || S_ISFIFO(info.st_mode))) {
+        auto fcntl_fn = LIBCO_OOP_REAL(fcntl);
+        int flags = fcntl_fn(fd, F_GETFL);
+        if (flags >= 0 && (flags & O_NONBLOCK) == 0 && fcntl_fn(fd, F_SETFL, flags | O_NONBLOCK) == 0) {
+            mode = FD_MANAGED;
+        }
+    }
+    fd_modes[fd].store(mode, std::memory_order_relaxed);
+    return mode;
+}
+
+FdMode mode_for(IOManager* io, int fd) noexcept
+{
+    return io != nullptr ? classify(fd) : cached_mode(fd);
+}
+
+bool would_block(int error) noexcept
+{
+    return error == EAGAIN || error == EWOULDBLOCK;
+}
+
+//============================================================================
+// 等待辅助函数
+//============================================================================
+
+/**
+ * @brief 等待 FD_MANAGED 的 fd 就绪
+ *
+ * 协程中挂起等待；协程外 (或同一事件已有协程在等) 用真实 poll 阻塞，
+ * 保持用户看到的阻塞语义。
+ */
+bool wait_ready(IOManager* io, int fd, IOEventType type) noexcept
+{
+    if (io != nullptr) {
+        if (io->wait_for(fd, type) == 0) {
+            return true;
+        }
+        if (errno == ECANCELED) {
+            return false;
+        }
+    }
+    pollfd request{fd, static_cast<short>(type == IOEventType::READ ? POLLIN : POLLOUT), 0};
+    int result;
+    while ((result = LIBCO_OOP_REAL(poll)(&request, 1, -1)) < 0 && errno == EINTR) {
+    }
+    return result >= 0;
+}
+
+/**
+ * @brief 阻塞语义的读写循环
+ * @param call 以已传输字节数为参数执行一次真实调用
+ *
+ * 读在第一次成功后返回；写按阻塞套接字的语义一直写完。
+ */
+template <typename Call>
+ssize_t transfer(int fd, IOEventType type, size_t length, Call&& call) noexcept
+{
+    IOManager* io = syscall_hook::active_manager();
+    if (mode_for(io, fd) != FD_MANAGED) {
+        return call(0);
+    }
+
+    size_t done = 0;
+    for (;;) {
+        ssize_t n = call(done);
+        if (n >= 0) {
+            done += static_cast<size_t>(n);
+            if (type == IOEventType::READ || done >= length || n == 0) {
+                return static_cast<ssize_t>(done);
+            }
+            continue;
+        }
+        if (!would_block(errno) || !wait_ready(io, fd, type)) {
+            return done > 0 ? static_cast<ssize_t>(done) : -1;
+        }
+    }
+}
+
+/**
+ * @brief 协程中睡眠：按毫秒向上取整后交给时间轮
+ */
+int sleep_suspended(IOManager* io, const timespec& duration) noexcept
+{
+    const uint64_t ms = static_cast<uint64_t>(duration.tv_sec) * 1000
+                        + static_cast<uint64_t>(duration.tv_nsec + 999999) / 1000000;
+    return io->sleep_for(ms);
+}
+
+/**
+ * @brief 协程中的 poll：把所有 fd 放入临时 epoll，带超时挂起等待它可读
+ */
+int poll_suspended(IOManager* io, pollfd* fds, nfds_t count, int timeout) noexcept
+{
+    if (count == 0) {
+        return timeout > 0 ? io->sleep_for(static_cast<uint64_t>(timeout)) : LIBCO_OOP_REAL(poll)(fds, count, timeout);
+    }
+    int epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        return LIBCO_OOP_REAL(poll)(fds, count, timeout);
+    }
+
+    bool supported = true;
+    for (nfds_t i = 0; i < count && supported; ++i) {
+        if (fds[i].fd < 0) {
+            continue;
+        }
+        epoll_event event{};
+        event.events = static_cast<uint32_t>(fds[i].events) & (EPOLLIN | EPOLLPRI | EPOLLOUT | EPOLLRDHUP);
+        event.data.fd = fds[i].fd;
+        if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fds[i].fd, &event) != 0 && errno != EEXIST) {
+            supported = false;
+        }
+    }
+
+    int result;
+    if (!supported) {
+        // 无法加入 epoll 的 fd (例如 epoll 不支持的设备)，退回真实 poll
+        result = LIBCO_OOP_REAL(poll)(fds, count, timeout);
+    } else {
+        const uint64_t deadline = TimerManager::now_ms() + static_cast<uint64_t>(timeout > 0 ? timeout : 0);
+        for (;;) {
+            int64_t remaining = -1;
+            if (timeout > 0) {
+                const uint64_t now = TimerManager::now_ms();
+                remaining = deadline > now ? static_cast<int64_t>(deadline - now) : 0;
+            }
+            if (io->wait_for(epoll_fd, IOEventType::READ, remaining) != 0) {
+                result = errno == ETIMEDOUT ? 0 : -1;
+                break;
+            }
+            result = LIBCO_OOP_REAL(poll)(fds, count, 0);
+            if (result != 0) {
+                break;
+            }
+        }
+    }
+
+    int error = errno;
+    io->close(epoll_fd);
+    errno = error;
+    return result;
+}
+
+} // namespace
+
+//============================================================================
+// 接管控制
+//============================================================================
+
+namespace syscall_hook {
+
+void set_enabled(bool enabled) noexcept
+{
+    t_disabled = !enabled;
+}
+
+bool is_enabled() noexcept
+{
+    return !t_disabled;
+}
+
+IOManager* active_manager() noexcept
+{
+    // 透传路径只有一次线程局部变量读取和一次 Coroutine::current()
+    if (t_disabled || Coroutine::current() == nullptr) {
+        return nullptr;
+    }
+    return IOManager::current();
+}
+
+} // namespace syscall_hook
+
+} // namespace libco_oop
+
+//============================================================================
+// 覆盖的 libc 符号
+//============================================================================
+
+using namespace libco_oop;
+
+extern "C" {
+
+ssize_t read(int fd, void* buffer, size_t length)
+{
+    return transfer(fd, IOEventType::READ, length, [&](size_t) {
+        return LIBCO_OOP_REAL(read)(fd, buffer, length);
+    });
+}
+
+ssize_t write(int fd, const void* buffer, size_t length)
+{
+    return transfer(fd, IOEventType::WRITE, length, [&](size_t done) {
+        return LIBCO_OOP_REAL(write)(fd, static_cast<const char*>(buffer) + done, length - done);
+    });
+}
+
+ssize_t recv(int fd, void* buffer, size_t length, int flags)
+{
+    if (flags & MSG_DONTWAIT) {
+        return LIBCO_OOP_REAL(recv)(fd, buffer, length, flags);
+    }
+    return transfer(fd, IOEventType::READ, length, [&](size_t) {
+        return LIBCO_OOP_REAL(recv)(fd, buffer, length, flags);
+    });
+}
+
+ssize_t send(int fd, const void* buffer, size_t length, int flags)
+{
+    if (flags & MSG_DONTWAIT) {
+        return LIBCO_OOP_REAL(send)(fd, buffer, length, flags);
+    }
+    return transfer(fd, IOEventType::WRITE, length, [&](size_t done) {
+        return LIBCO_OOP_REAL(send)(fd, static_cast<const char*>(buffer) + done, length - done, flags);
+    });
+}
+
+int accept(int fd, sockaddr* address, socklen_t* length)
+{
+    return static_cast<int>(transfer(fd, IOEventType::READ, 0, [&](size_t) {
+        return static_cast<ssize_t>(LIBCO_OOP_REAL(accept)(fd, address, length));
+    }));
+}
+
+int connect(int fd, const sockaddr* address, socklen_t length)
+{
+    IOManager* io = syscall_hook::active_manager();
+    if (mode_for(io, fd) != FD_MANAGED) {
+        return LIBCO_OOP_REAL(connect)(fd, address, length);
+    }
+
+    if (LIBCO_OOP_REAL(connect)(fd, address, length) == 0) {
+        return 0;
+    }
+    if (errno != EINPROGRESS || !wait_ready(io, fd, IOEventType::WRITE)) {
+        return -1;
+    }
+    int error = 0;
+    socklen_t size = sizeof(error);
+    if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) != 0) {
+        return -1;
+    }
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
+
+int poll(pollfd* fds, nfds_t count, int timeout)
+{
+    IOManager* io = syscall_hook::active_manager();
+    if (io == nullptr || timeout == 0) {
+        return LIBCO_OOP_REAL(poll)(fds, count, timeout);
+    }
+    int ready = LIBCO_OOP_REAL(poll)(fds, count, 0);
+    if (ready != 0) {
+        return ready;
+    }
+    return poll_suspended(io, fds, count, timeout);
+}
+
+int nanosleep(const timespec* duration, timespec* remaining)
+{
+    IOManager* io = syscall_hook::active_manager();
+    if (io == nullptr || duration == nullptr || duration->tv_sec < 0
+        || duration->tv_nsec < 0 || duration->tv_nsec >= 1000000000L) {
+        return LIBCO_OOP_REAL(nanosleep)(duration, remaining);
+    }
+    int result = sleep_suspended(io, *duration);
+    if (result == 0 && remaining != nullptr) {
+        remaining->tv_sec = 0;
+        remaining->tv_nsec = 0;
+    }
+    return result;
+}
+
+int usleep(useconds_t microseconds)
+{
+    IOManager* io = syscall_hook::active_manager();
+    if (io == nullptr) {
+        return LIBCO_OOP_REAL(usleep)(microseconds);
+    }
+    timespec duration;
+    duration.tv_sec = microseconds / 1000000;
+    duration.tv_nsec = static_cast<long>(microseconds % 1000000) * 1000L;
+    return sleep_suspended(io, duration);
+}
+
+int close(int fd)
+{
+    // fd 号可能被复用，先清除分类；IOManager::remove_fd() 丢弃过期注册
+    if (fd >= 0 && static_cast<size_t>(fd) < kMaxTrackedFds) {
+        fd_modes[fd].store(FD_UNKNOWN, std::memory_order_relaxed);
+    }
+    if (syscall_hook::is_enabled()) {
+        if (IOManager* io = IOManager::current()) {
+            io->remove_fd(fd);
+        }
+    }
+    return LIBCO_OOP_REAL(close)(fd);
+}
+
+int fcntl(int fd, int command, ...)
+{
+    va_list args;
+    va_start(args, command);
+    void* argument = va_arg(args, void*);   // 整数和指针参数在 LP64 上按同一寄存器传递
+    va_end(args);
+
+    auto fcntl_fn = LIBCO_OOP_REAL(fcntl);
+    const FdMode mode = cached_mode(fd);
+    if (mode == FD_MANAGED) {
+        if (command == F_GETFL) {
+            int flags = fcntl_fn(fd, F_GETFL);
+            return flags < 0 ? flags : (flags & ~O_NONBLOCK);
+        }
+        if (command == F_SETFL) {
+            int flags = static_cast<int>(reinterpret_cast<intptr_t>(argument));
+            if (flags & O_NONBLOCK) {
+                // 用户接手非阻塞语义，之后直接透传
+                fd_modes[fd].store(FD_PASSTHROUGH, std::memory_order_relaxed);
+            }
+            return fcntl_fn(fd, F_SETFL, flags | O_NONBLOCK);
+        }
+    } else if (mode == FD_PASSTHROUGH && command == F_SETFL && fd >= 0
+               && static_cast<size_t>(fd) < kMaxTrackedFds) {
+        fd_modes[fd].store(FD_UNKNOWN, std::memory_order_relaxed);
+    }
+    return fcntl_fn(fd, command, argument);
+}
+
+} // extern "C"
@@ -0,0 +1,1227 @@
+/**
+ * @file io_manager.cpp
+ * @brief IO事件驱动调度器实现 (epoll / io_uring 后端)
+ * @author libco-oop
+ * @version 1.0
+ */
+
+#include "libco_oop/io_manager.h"
+#include "io_uring_ring.h"
+#include "libco_oop/trace.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace libco_oop {
+
+namespace {
+
+/**
+ * @brief epoll_event.data 中编码 fd 和表项代数
+ */
+uint64_t encode(int fd, uint32_t generation) noexcept
+{
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+constexpr uint64_t kWakeupEvent = ~uint64_t(0);    ///< 跨线程唤醒 eventfd 的 epoll_event.data
+constexpr size_t kChainIovecs = 64;                 ///< BufferChain 读写每次系统调用的最大区间数
+
+bool would_block(int error) noexcept
+{
+    return error == EAGAIN || error == EWOULDBLOCK;
+}
+
+/**
+ * @brief 取得提交队列项，队列已满时先把本批提交给内核
+ */
+io_uring_sqe* next_sqe(IoUringRing& ring, IOStatistics& stats) noexcept
+{
+    io_uring_sqe* sqe = ring.get_sqe();
+    if (sqe == nullptr) {
+        ++stats.polls;
+        ring.submit();
+        sqe = ring.get_sqe();
+    }
+    return sqe;
+}
+
+std::unique_ptr<IoUringRing> make_ring(const IOManagerOptions& opts)
+{
+    if (opts.backend == IOBackend::EPOLL) {
+        return nullptr;
+    }
+    auto ring = std::make_unique<IoUringRing>();
+    if (!ring->init(opts.uring_entries > 0 ? opts.uring_entries : 1)) {
+        return nullptr;
+    }
+    return ring;
+}
+
+} // namespace
+
+/**
+ * @brief 一次 io_uring 操作的参数
+ */
+struct IOManager::UringOp {
+    uint8_t opcode;
+    int fd;
+    bool fixed_file = false;        ///< fd 是固定文件表下标
+    uint64_t addr = 0;
+    uint32_t len = 0;
+    uint64_t off = 0;               ///< 文件偏移，或 accept 的 addr2
+    uint32_t op_flags = 0;          ///< rw_flags / msg_flags / accept_flags / poll32_events
+    uint16_t buf_index = 0;
+};
+
+/**
+ * @brief 未完成的 io_uring 请求，位于发起协程的栈上
+ *
+ * 地址作为 user_data，完成时由调度循环写入结果并唤醒协程。
+ */
+struct IOManager::UringRequest : IntrusiveListNode {
+    IOManager* owner = nullptr;
+    Coroutine* waiter = nullptr;
+    int fd = -1;                    ///< 普通 fd，固定文件时为 -1
+    int32_t result = 0;             ///< io_uring_cqe.res
+    bool timed_out = false;         ///< 超时定时器已提交取消
+};
+
+namespace {
+
+constexpr uint64_t kUringTimeoutTag = 1;    ///< IORING_OP_TIMEOUT 的 user_data (请求地址不会为 1)
+constexpr uint64_t kUringWakeupTag = 2;     ///< eventfd 上 IORING_OP_POLL_ADD 的 user_data
+
+/**
+ * @brief 至少 delay_ms 毫秒后的到期时刻
+ *
+ * 时钟按毫秒截断，多加 1ms 保证实际等待不短于 delay_ms。
+ */
+uint64_t deadline_after(uint64_t delay_ms) noexcept
+{
+    return TimerManager::now_ms() + delay_ms + 1;
+}
+
+} // namespace
+
+//============================================================================
+// IOManager 类实现
+//============================================================================
+
+IOManager::IOManager(const IOManagerOptions& opts)
+    : Scheduler("io_manager")
+    , ring_(make_ring(opts))
+    , timers_(TimerManager::now_ms())
+{
+    if (ring_ == nullptr && opts.backend != IOBackend::IO_URING) {
+        epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        fds_.resize(opts.initial_fds);
+        events_.resize(opts.max_events > 0 ? opts.max_events : 1);
+    }
+
+    wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd_ < 0) {
+        return;
+    }
+    if (ring_ != nullptr) {
+        uring_arm_wakeup();
+    } else if (epoll_fd_ >= 0) {
+        // 水平触发：处理前 eventfd 一直可读
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = kWakeupEvent;
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event);
+    }
+}
+
+IOManager::~IOManager() noexcept
+{
+    // 先移出所有定时器 (其中一些内嵌在即将销毁的协程中)，睡眠的协程由这里销毁
+    timers_.drain([this](TimerNode* node) {
+        if (node->callback == &IOManager::wake_sleeper) {
+            retire(static_cast<Coroutine*>(node->context));
+        }
+    });
+    sleeping_ = 0;
+
+    // 请求位于协程栈上，必须等内核完成 (或取消) 后才能销毁协程；
+    // 完成的协程回到就绪队列，由基类析构销毁
+    if (ring_ != nullptr) {
+        in_flight_.for_each([this](const UringRequest* request) { uring_cancel(request); });
+        while (!in_flight_.empty()) {
+            uring_poll(true);
+        }
+    }
+
+    // 已投递的协程回到就绪队列；仍在 park() 中的协程由这里销毁
+    if (wakeup_fd_ >= 0) {
+        drain_remote();
+        while (RemoteWakeup* node = parked_.pop_front()) {
+            retire(node->coroutine);
+        }
+        ::close(wakeup_fd_);
+    }
+
+    // 等待IO的协程不在就绪队列中，由这里销毁
+    for (FdSlot& slot : fds_) {
+        if (slot.reader != nullptr) {
+            retire(slot.reader);
+            slot.reader = nullptr;
+        }
+        if (slot.writer != nullptr) {
+            retire(slot.writer);
+            slot.writer = nullptr;
+        }
+    }
+    if (epoll_fd_ >= 0) {
+        ::close(epoll_fd_);
+    }
+}
+
+IOManager* IOManager::current() noexcept
+{
+    return dynamic_cast<IOManager*>(Scheduler::current());
+}
+
+bool IOManager::owns_current() const noexcept
+{
+    return owns(Coroutine::current());
+}
+
+IOManager::FdSlot* IOManager::acquire_slot(int fd) noexcept
+{
+    if (fd < 0 || epoll_fd_ < 0) {
+        errno = EBADF;
+        return nullptr;
+    }
+
+    size_t index = static_cast<size_t>(fd);
+    if (index >= fds_.size()) {
+        size_t size = fds_.size() > 0 ? fds_.size() : 64;
+        while (size <= index) {
+            size *= 2;
+        }
+        try {
+            fds_.resize(size);
+        } catch (...) {
+            errno = ENOMEM;
+            return nullptr;
+        }
+    }
+
+    FdSlot& slot = fds_[index];
+    if (!slot.registered) {
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.u64 = encode(fd, slot.generation);
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            // 同一打开文件仍通过 dup 出的 fd 留在 epoll 中
+            if (errno != EEXIST || ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) != 0) {
+                return nullptr;
+            }
+        }
+        slot.registered = true;
+        ++stats_.registrations;
+    }
+    return &slot;
+}
+
+int IOManager::wait_for(int fd, IOEventType type, int64_t timeout_ms) noexcept
+{
+    Coroutine* self = Coroutine::current();
+    if (!owns(self)) {
+        errno = EPERM;
+        return -1;
+    }
+
+    if (ring_ != nullptr) {
+        UringOp op{IORING_OP_POLL_ADD, fd};
+        op.op_flags = type == IOEventType::READ ? (POLLIN | POLLRDHUP)
+                    : type == IOEventType::WRITE ? POLLOUT : POLLERR;
+        return uring_execute(op, timeout_ms) < 0 ? -1 : 0;
+    }
+
+    FdSlot* slot = acquire_slot(fd);
+    if (slot == nullptr) {
+        return -1;
+    }
+
+    const bool reading = type == IOEventType::READ;
+    bool& ready = reading ? slot->read_ready : slot->write_ready;
+    if (ready) {
+        ready = false;
+        return 0;
+    }
+
+    Coroutine*& waiter = reading ? slot->reader : slot->writer;
+    if (waiter != nullptr) {
+        errno = EBUSY;
+        return -1;
+    }
+    if (timeout_ms == 0) {
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    waiter = self;
+    const uint32_t generation = slot->generation;
+    ++waiting_;
+#if LIBCO_OOP_METRICS
+    get_metrics_counters().io_waits.add();
+#endif
+    trace::record(trace::EventType::IO_PARK, self->get_id(), static_cast<uint32_t>(fd));
+
+    TimerNode& timer = get_timer(self);
+    if (timeout_ms > 0) {
+        timer.callback = &IOManager::wake_waiter;
+        timer.context = self;
+        timers_.add(&timer, deadline_after(static_cast<uint64_t>(timeout_ms)));
+    }
+
+    for (;;) {
+        Scheduler::suspend();
+
+        // fd 表可能在挂起期间扩容，重新索引
+        FdSlot& current = fds_[static_cast<size_t>(fd)];
+        if (current.generation != generation) {
+            timers_.cancel(&timer);
+            errno = ECANCELED;
+            return -1;
+        }
+        Coroutine*& still_waiting = reading ? current.reader : current.writer;
+        if (still_waiting != self) {
+            timers_.cancel(&timer);
+            return 0;
+        }
+        if (timeout_ms > 0 && !timer.is_pending()) {
+            // 超时唤醒：自己离开等待槽
+            still_waiting = nullptr;
+            --waiting_;
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        // 被外部 schedule() 提前唤醒，继续等待
+    }
+}
+
+int IOManager::sleep_for(uint64_t ms) noexcept
+{
+    Coroutine* self = Coroutine::current();
+    if (!owns(self)) {
+        errno = EPERM;
+        return -1;
+    }
+    if (ms == 0) {
+        Scheduler::yield();
+        return 0;
+    }
+
+    TimerNode& timer = get_timer(self);
+    timer.callback = &IOManager::wake_sleeper;
+    timer.context = self;
+    timers_.add(&timer, deadline_after(ms));
+    ++sleeping_;
+    do {
+        Scheduler::suspend();
+    } while (timer.is_pending());
+    return 0;
+}
+
+bool IOManager::add_timer(TimerNode* node, uint64_t delay_ms) noexcept
+{
+    return timers_.add(node, deadline_after(delay_ms));
+}
+
+bool IOManager::cancel_timer(TimerNode* node) noexcept
+{
+    return timers_.cancel(node);
+}
+
+void IOManager::wake_sleeper(TimerNode* node)
+{
+    Coroutine* coroutine = static_cast<Coroutine*>(node->context);
+    IOManager* io = static_cast<IOManager*>(get_owner(coroutine));
+    --io->sleeping_;
+    trace::record(trace::EventType::TIMER_WAKE, coroutine->get_id());
+    io->schedule(coroutine);
+}
+
+void IOManager::wake_waiter(TimerNode* node)
+{
+    Coroutine* coroutine = static_cast<Coroutine*>(node->context);
+    trace::record(trace::EventType::TIMER_WAKE, coroutine->get_id());
+    get_owner(coroutine)->schedule(coroutine);
+}
+
+void IOManager::cancel_request(TimerNode* node)
+{
+    UringRequest* request = static_cast<UringRequest*>(node->context);
+    trace::record(trace::EventType::TIMER_WAKE, request->waiter->get_id());
+    request->timed_out = true;
+    request->owner->uring_cancel(request);
+}
+
+//============================================================================
+// 跨线程唤醒
+//============================================================================
+
+RemoteWakeup::RemoteWakeup() noexcept
+    : coroutine(Coroutine::current())
+{
+    IOManager* io = IOManager::current();
+    if (io != nullptr && io->owns_current()) {
+        manager = io;
+    }
+}
+
+int IOManager::park(RemoteWakeup& node) noexcept
+{
+    if (node.manager != this || node.coroutine != Coroutine::current()) {
+        errno = EPERM;
+        return -1;
+    }
+    if (node.delivered) {
+        return 0;
+    }
+    parked_.push_back(&node);
+    do {
+        Scheduler::suspend();
+    } while (!node.delivered);  // 被外部 schedule() 提前唤醒时继续等待
+    return 0;
+}
+
+void IOManager::unpark(RemoteWakeup* node) noexcept
+{
+    IOManager* io = node->manager;
+    if (Scheduler::current() == io) {
+        io->deliver(node);
+        return;
+    }
+    io->post_remote(node);
+}
+
+void IOManager::deliver(RemoteWakeup* node) noexcept
+{
+    node->delivered = true;
+    if (node->is_linked()) {
+        parked_.remove(node);
+    }
+    schedule(node->coroutine);
+}
+
+void IOManager::post_remote(RemoteWakeup* node) noexcept
+{
+    RemoteWakeup* head = remote_head_.load(std::memory_order_relaxed);
+    do {
+        node->link = head;
+    } while (!remote_head_.compare_exchange_weak(head, node));
+
+    // 压栈之后 node 可能已被投递并销毁。调度循环处理之前只写一次 eventfd：
+    // drain_remote() 先清除标志再取走整个栈，之后压入的唤醒会再次写入
+    if (!remote_signaled_.exchange(true)) {
+        const uint64_t one = 1;
+        ssize_t written = ::write(wakeup_fd_, &one, sizeof(one));
+        (void)written;
+        wakeup_signals_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+size_t IOManager::drain_remote() noexcept
+{
+    uint64_t value;
+    ssize_t result = ::read(wakeup_fd_, &value, sizeof(value));
+    (void)result;
+    remote_signaled_.store(false);
+    RemoteWakeup* head = remote_head_.exchange(nullptr);
+
+    // 栈是后进先出，反转后按投递顺序唤醒
+    RemoteWakeup* ordered = nullptr;
+    while (head != nullptr) {
+        RemoteWakeup* next = head->link;
+        head->link = ordered;
+        ordered = head;
+        head = next;
+    }
+    size_t count = 0;
+    while (ordered != nullptr) {
+        RemoteWakeup* next = ordered->link;
+        deliver(ordered);
+        ordered = next;
+        ++count;
+    }
+    stats_.remote_wakeups += count;
+
+    if (ring_ != nullptr) {
+        uring_arm_wakeup();
+    }
+    return count;
+}
+
+int co_sleep(uint64_t ms) noexcept
+{
+    IOManager* io = IOManager::current();
+    if (io == nullptr) {
+        errno = EPERM;
+        return -1;
+    }
+    return io->sleep_for(ms);
+}
+
+bool IOManager::remove_fd(int fd) noexcept
+{
+    if (ring_ != nullptr) {
+        bool found = false;
+        in_flight_.for_each([&](const UringRequest* request) {
+            if (request->fd == fd) {
+                found = uring_cancel(request) || found;
+            }
+        });
+        return found;
+    }
+
+    if (fd < 0 || static_cast<size_t>(fd) >= fds_.size()) {
+        return false;
+    }
+    FdSlot& slot = fds_[static_cast<size_t>(fd)];
+    if (!slot.registered) {
+        return false;
+    }
+
+    // fd 可能已被关闭，此时内核已自动移除
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    slot.registered = false;
+    slot.read_ready = false;
+    slot.write_ready = false;
+    ++slot.generation;
+    wake(slot.reader);
+    wake(slot.writer);
+    return true;
+}
+
+void IOManager::wake(Coroutine*& waiter) noexcept
+{
+    if (waiter == nullptr) {
+        return;
+    }
+    Coroutine* coroutine = waiter;
+    waiter = nullptr;
+    --waiting_;
+    ++stats_.wakeups;
+    schedule(coroutine);
+}
+
+size_t IOManager::poll(int timeout_ms) noexcept
+{
+    if (epoll_fd_ < 0) {
+        return 0;
+    }
+
+    ++stats_.polls;
+    int count = ::epoll_wait(epoll_fd_, events_.data(), static_cast<int>(events_.size()), timeout_ms);
+    if (count <= 0) {
+        return 0;
+    }
+
+    bool remote = false;
+    for (int i = 0; i < count; ++i) {
+        const epoll_event& event = events_[static_cast<size_t>(i)];
+        if (event.data.u64 == kWakeupEvent) {
+            remote = true;
+            continue;
+        }
+        const size_t fd = static_cast<uint32_t>(event.data.u64);
+        const uint32_t generation = static_cast<uint32_t>(event.data.u64 >> 32);
+        if (fd >= fds_.size() || fds_[fd].generation != generation || !fds_[fd].registered) {
+            continue;   // remove_fd() 之前已进入就绪列表的过期事件
+        }
+
+        FdSlot& slot = fds_[fd];
+        const uint32_t errors = EPOLLERR | EPOLLHUP;
+        if (event.events & (EPOLLIN | EPOLLRDHUP | errors)) {
+            if (slot.reader != nullptr) {
+                wake(slot.reader);
+            } else {
+                slot.read_ready = true;
+            }
+        }
+        if (event.events & (EPOLLOUT | errors)) {
+            if (slot.writer != nullptr) {
+                wake(slot.writer);
+            } else {
+                slot.write_ready = true;
+            }
+        }
+    }
+    stats_.events += static_cast<uint64_t>(count);
+    if (remote) {
+        drain_remote();
+    }
+    return static_cast<size_t>(count);
+}
+
+int64_t IOManager::poll_timeout() noexcept
+{
+    const uint64_t now = TimerManager::now_ms();
+    const size_t fired = timers_.advance(now);
+    stats_.timeouts += fired;
+#if LIBCO_OOP_METRICS
+    get_metrics_counters().timer_fires.add(fired);
+#endif
+    return fired > 0 ? 0 : timers_.next_timeout(now);
+}
+
+void IOManager::expire_timers() noexcept
+{
+    if (!timers_.empty()) {
+        const size_t fired = timers_.advance(TimerManager::now_ms());
+        stats_.timeouts += fired;
+#if LIBCO_OOP_METRICS
+        get_metrics_counters().timer_fires.add(fired);
+#endif
+    }
+}
+
+bool IOManager::idle()
+{
+    if (ring_ != nullptr) {
+        if (in_flight_.empty() && timers_.empty() && parked_.empty()) {
+            uring_poll(false);  // 提交剩余的取消请求
+            return false;
+        }
+        const int64_t timeout = poll_timeout();
+        if (timeout == 0) {
+            return true;
+        }
+        if (timeout > 0) {
+            uring_arm_timeout(TimerManager::now_ms() + static_cast<uint64_t>(timeout));
+        }
+        uring_poll(true);
+        expire_timers();
+        return true;
+    }
+
+    if (waiting_ == 0 && timers_.empty() && parked_.empty()) {
+        return false;
+    }
+    const int64_t timeout = poll_timeout();
+    if (timeout != 0) {
+        poll(timeout > INT32_MAX ? INT32_MAX : static_cast<int>(timeout));
+    }
+    expire_timers();
+    return true;
+}
+
+void IOManager::tick()
+{
+    expire_timers();
+    if (remote_head_.load(std::memory_order_relaxed) != nullptr) {
+        drain_remote();
+    }
+    if (ring_ != nullptr) {
+        uring_poll(false);
+        return;
+    }
+
+    if (waiting_ > 0) {
+        poll(0);
+    }
+}
+
+IOStatistics IOManager::get_statistics() const noexcept
+{
+    IOStatistics stats = stats_;
+    stats.waiting = waiting_;
+    stats.sleeping = sleeping_;
+    stats.parked = parked_.size();
+    stats.wakeup_signals = wakeup_signals_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+//============================================================================
+// 非阻塞IO辅助函数
+//============================================================================
+
+ssize_t IOManager::read(int fd, void* buffer, size_t length) noexcept
+{
+    if (ring_ != nullptr && owns_current()) {
+        UringOp op{IORING_OP_READ, fd};
+        op.addr = reinterpret_cast<uint64_t>(buffer);
+        op.len = static_cast<uint32_t>(length);
+        op.off = static_cast<uint64_t>(-1);
+        return uring_execute(op);
+    }
+
+    ssize_t n;
+    while ((n = ::read(fd, buffer, length)) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (!would_block(errno) || !owns_current() || wait_for(fd, IOEventType::READ) != 0) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+ssize_t IOManager::write(int fd, const void* buffer, size_t length) noexcept
+{
+    if (ring_ != nullptr && owns_current()) {
+        UringOp op{IORING_OP_WRITE, fd};
+        op.addr = reinterpret_cast<uint64_t>(buffer);
+        op.len = static_cast<uint32_t>(length);
+        op.off = static_cast<uint64_t>(-1);
+        return uring_execute(op);
+    }
+
+    ssize_t n;
+    while ((n = ::write(fd, buffer, length)) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (!would_block(errno) || !owns_current() || wait_for(fd, IOEventType::WRITE) != 0) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+ssize_t IOManager::recv(int fd, void* buffer, size_t length, int flags) noexcept
+{
+    if (ring_ != nullptr && !(flags & MSG_DONTWAIT) && owns_current()) {
+        UringOp op{IORING_OP_RECV, fd};
+        op.addr = reinterpret_cast<uint64_t>(buffer);
+        op.len = static_cast<uint32_t>(length);
+        op.op_flags = static_cast<uint32_t>(flags);
+        return uring_execute(op);
+    }
+
+    ssize_t n;
+    while ((n = ::recv(fd, buffer, length, flags)) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (!would_block(errno) || (flags & MSG_DONTWAIT) || !owns_current()
+            || wait_for(fd, IOEventType::READ) != 0) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+ssize_t IOManager::send(int fd, const void* buffer, size_t length, int flags) noexcept
+{
+    if (ring_ != nullptr && !(flags & MSG_DONTWAIT) && owns_current()) {
+        UringOp op{IORING_OP_SEND, fd};
+        op.addr = reinterpret_cast<uint64_t>(buffer);
+        op.len = static_cast<uint32_t>(length);
+        op.op_flags = static_cast<uint32_t>(flags);
+        return uring_execute(op);
+    }
+
+    ssize_t n;
+    while ((n = ::send(fd, buffer, length, flags)) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (!would_block(errno) || (flags & MSG_DONTWAIT) || !owns_current()
+            || wait_for(fd, IOEventType::WRITE) != 0) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+int IOManager::accept(int fd, sockaddr* address, socklen_t* length) noexcept
+{
+    if (ring_ != nullptr && owns_current()) {
+        UringOp op{IORING_OP_ACCEPT, fd};
+        op.addr = reinterpret_cast<uint64_t>(address);
+        op.off = reinterpret_cast<uint64_t>(length);
+        op.op_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        return static_cast<int>(uring_execute(op));
+    }
+
+    int client;
+    while ((client = ::accept4(fd, address, length, SOCK_NONBLOCK | SOCK_CLOEXEC)) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (!would_block(errno) || !owns_current() || wait_for(fd, IOEventType::READ) != 0) {
+            return -1;
+        }
+    }
+    return client;
+}
+
+int IOManager::connect(int fd, const sockaddr* address, socklen_t length) noexcept
+{
+    if (ring_ != nullptr && owns_current()) {
+        UringOp op{IORING_OP_CONNECT, fd};
+        op.addr = reinterpret_cast<uint64_t>(address);
+        op.off = length;
+        return static_cast<int>(uring_execute(op));
+    }
+
+    if (::connect(fd, address, length) == 0) {
+        return 0;
+    }
+    if (errno != EINPROGRESS || !owns_current()) {
+        return -1;
+    }
+    if (wait_for(fd, IOEventType::WRITE) != 0) {
+        return -1;
+    }
+
+    int error = 0;
+    socklen_t size = sizeof(error);
+    if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) != 0) {
+        return -1;
+    }
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
+
+ssize_t IOManager::readv(int fd, const iovec* iov, int count) noexcept
+{
+    if (ring_ != nullptr && owns_current()) {
+        UringOp op{IORING_OP_READV, fd};
+        op.addr = reinterpret_cast<uint64_t>(iov);
+        op.len = static_cast<uint32_t>(count);
+        op.off = static_cast<uint64_t>(-1);
+        return uring_execute(op);
+    }
+
+    ssize_t n;
+    while ((n = ::readv(fd, iov, count)) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (!would_block(errno) || !owns_current() || wait_for(fd, IOEventType::READ) != 0) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+ssize_t IOManager::writev(int fd, const iovec* iov, int count) noexcept
+{
+    if (ring_ != nullptr && owns_current()) {
+        UringOp op{IORING_OP_WRITEV, fd};
+        op.addr = reinterpret_cast<uint64_t>(iov);
+        op.len = static_cast<uint32_t>(count);
+        op.off = static_cast<uint64_t>(-1);
+        return uring_execute(op);
+    }
+
+    ssize_t n;
+    while ((n = ::writev(fd, iov, count)) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (!would_block(errno) || !owns_current() || wait_for(fd, IOEventType::WRITE) != 0) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+ssize_t IOManager::recvmsg(int fd, msghdr* message, int flags) noexcept
+{
+    // 读取错误队列不会阻塞，也不能等待可读
+    if (ring_ != nullptr && !(flags & (MSG_DONTWAIT | MSG_ERRQUEUE)) && owns_current()) {
+        UringOp op{IORING_OP_RECVMSG, fd};
+        op.addr = reinterpret_cast<uint64_t>(message);
+        op.len = 1;
+        op.op_flags = static_cast<uint32_t>(flags);
+        return uring_execute(op);
+    }
+
+    ssize_t n;
+    while ((n = ::recvmsg(fd, message, flags)) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (!would_block(errno) || (flags & (MSG_DONTWAIT | MSG_ERRQUEUE)) || !owns_current()
+            || wait_for(fd, IOEventType::READ) != 0) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+ssize_t IOManager::sendmsg(int fd, const msghdr* message, int flags) noexcept
+{
+    if (ring_ != nullptr && !(flags & MSG_DONTWAIT) && owns_current()) {
+        UringOp op{IORING_OP_SENDMSG, fd};
+        op.addr = reinterpret_cast<uint64_t>(message);
+        op.len = 1;
+        op.op_flags = static_cast<uint32_t>(flags);
+        return uring_execute(op);
+    }
+
+    ssize_t n;
+    while ((n = ::sendmsg(fd, message, flags)) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (!would_block(errno) || (flags & MSG_DONTWAIT) || !owns_current()
+            || wait_for(fd, IOEventType::WRITE) != 0) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+ssize_t IOManager::read(int fd, BufferChain& chain, size_t length) noexcept
+{
+    iovec iov[kChainIovecs];
+    size_t count = chain.prepare(iov, kChainIovecs, length);
+    if (count == 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (length != 0) {
+        // 末尾块的剩余空间和新块加起来可能多于 length
+        size_t space = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (space + iov[i].iov_len >= length) {
+                iov[i].iov_len = length - space;
+                count = i + 1;
+                break;
+            }
+            space += iov[i].iov_len;
+        }
+    }
+
+    const ssize_t n = readv(fd, iov, static_cast<int>(count));
+    chain.commit(n > 0 ? static_cast<size_t>(n) : 0);
+    return n;
+}
+
+ssize_t IOManager::write(int fd, BufferChain& chain) noexcept
+{
+    size_t written = 0;
+    while (!chain.empty()) {
+        iovec iov[kChainIovecs];
+        const size_t count = chain.fill_iovec(iov, kChainIovecs);
+        const ssize_t n = writev(fd, iov, static_cast<int>(count));
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        chain.consume(static_cast<size_t>(n));
+        written += static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(written);
+}
+
+int IOManager::close(int fd) noexcept
+{
+    remove_fd(fd);
+    return ::close(fd);
+}
+
+bool IOManager::set_nonblocking(int fd) noexcept
+{
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags < 0) {
+        return false;
+    }
+    return (flags & O_NONBLOCK) != 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+//============================================================================
+// io_uring 后端
+//============================================================================
+
+ssize_t IOManager::uring_execute(const UringOp& op, int64_t timeout_ms) noexcept
+{
+    Coroutine* self = Coroutine::current();
+    if (!owns(self)) {
+        errno = EPERM;
+        return -1;
+    }
+    io_uring_sqe* sqe = next_sqe(*ring_, stats_);
+    if (sqe == nullptr) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    UringRequest request;
+    request.owner = this;
+    request.waiter = self;
+    request.fd = op.fixed_file ? -1 : op.fd;
+
+    sqe->opcode = op.opcode;
+    sqe->flags = op.fixed_file ? IOSQE_FIXED_FILE : 0;
+    sqe->fd = op.fd;
+    sqe->addr = op.addr;
+    sqe->len = op.len;
+    sqe->off = op.off;
+    sqe->rw_flags = static_cast<__kernel_rwf_t>(op.op_flags);
+    sqe->buf_index = op.buf_index;
+    sqe->user_data = reinterpret_cast<uint64_t>(&request);
+
+    // 不立即提交：同一 tick 内的请求在调度循环中一次性提交
+    in_flight_.push_back(&request);
+    ++waiting_;
+    ++stats_.submissions;
+#if LIBCO_OOP_METRICS
+    get_metrics_counters().io_waits.add();
+#endif
+    trace::record(trace::EventType::IO_PARK, self->get_id(), op.opcode);
+
+    // 超时时取消请求，完成项以 -ECANCELED 返回
+    TimerNode& timer = get_timer(self);
+    if (timeout_ms >= 0) {
+        timer.callback = &IOManager::cancel_request;
+        timer.context = &request;
+        timers_.add(&timer, deadline_after(static_cast<uint64_t>(timeout_ms)));
+    }
+    do {
+        Scheduler::suspend();
+    } while (request.is_linked());  // 被外部 schedule() 提前唤醒时继续等待
+    timers_.cancel(&timer);
+
+    if (request.timed_out && request.result == -ECANCELED) {
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    if (request.result < 0) {
+        errno = -request.result;
+        return -1;
+    }
+    return request.result;
+}
+
+bool IOManager::uring_cancel(const UringRequest* target) noexcept
+{
+    io_uring_sqe* sqe = next_sqe(*ring_, stats_);
+    if (sqe == nullptr) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(target);
+    sqe->user_data = 0;     // 取消请求自身的完成项被忽略
+    return true;
+}
+
+size_t IOManager::uring_reap() noexcept
+{
+    unsigned count = ring_->reap([this](const io_uring_cqe& cqe) {
+        if (cqe.user_data == kUringTimeoutTag) {
+            uring_timeout_armed_ = false;
+            return;
+        }
+        if (cqe.user_data == kUringWakeupTag) {
+            uring_wakeup_armed_ = false;
+            uring_wakeup_fired_ = true;
+            return;
+        }
+        if (cqe.user_data == 0) {
+            return;
+        }
+        UringRequest* request = reinterpret_cast<UringRequest*>(cqe.user_data);
+        request->result = cqe.res;
+        in_flight_.remove(request);
+        --waiting_;
+        ++stats_.wakeups;
+        schedule(request->waiter);
+    });
+    stats_.events += count;
+    if (uring_wakeup_fired_) {
+        uring_wakeup_fired_ = false;
+        drain_remote();
+    }
+    return count;
+}
+
+size_t IOManager::uring_poll(bool wait) noexcept
+{
+    // 先在用户态收集，已有完成项时不必阻塞
+    size_t reaped = uring_reap();
+    const bool block = wait && reaped == 0;
+    if (block || ring_->pending() > 0) {
+        ++stats_.polls;
+        ring_->submit(block ? 1 : 0);
+        reaped += uring_reap();
+    }
+    return reaped;
+}
+
+void IOManager::uring_arm_timeout(uint64_t deadline) noexcept
+{
+    // 已有更早的超时在内核中时不再提交
+    if (uring_timeout_armed_ && uring_timeout_deadline_ <= deadline) {
+        return;
+    }
+    io_uring_sqe* sqe = next_sqe(*ring_, stats_);
+    if (sqe == nullptr) {
+        return;
+    }
+    // 内核在准备阶段复制 timespec，可以复用同一个对象
+    const uint64_t now = TimerManager::now_ms();
+    const uint64_t delay = deadline > now ? deadline - now : 0;
+    uring_timespec_.tv_sec = static_cast<int64_t>(delay / 1000);
+    uring_timespec_.tv_nsec = static_cast<long long>(delay % 1000) * 1000000;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(&uring_timespec_);
+    sqe->len = 1;
+    sqe->user_data = kUringTimeoutTag;
+    uring_timeout_armed_ = true;
+    uring_timeout_deadline_ = deadline;
+}
+
+void IOManager::uring_arm_wakeup() noexcept
+{
+    if (uring_wakeup_armed_) {
+        return;
+    }
+    io_uring_sqe* sqe = next_sqe(*ring_, stats_);
+    if (sqe == nullptr) {
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = wakeup_fd_;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = kUringWakeupTag;
+    uring_wakeup_armed_ = true;
+}
+
+bool IOManager::uring_register(unsigned opcode, const void* arg, unsigned count) noexcept
+{
+    if (ring_ == nullptr) {
+        errno = EOPNOTSUPP;
+        return false;
+    }
+    int result = ring_->register_resource(opcode, arg, count);
+    if (result < 0) {
+        errno = -result;
+        return false;
+    }
+    return true;
+}
+
+ssize_t IOManager::read(FixedFile file, void* buffer, size_t length) noexcept
+{
+    if (ring_ == nullptr) {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    UringOp op{IORING_OP_READ, static_cast<int>(file.index), true};
+    op.addr = reinterpret_cast<uint64_t>(buffer);
+    op.len = static_cast<uint32_t>(length);
+    op.off = static_cast<uint64_t>(-1);
+    return uring_execute(op);
+}
+
+ssize_t IOManager::write(FixedFile file, const void* buffer, size_t length) noexcept
+{
+    if (ring_ == nullptr) {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    UringOp op{IORING_OP_WRITE, static_cast<int>(file.index), true};
+    op.addr = reinterpret_cast<uint64_t>(buffer);
+    op.len = static_cast<uint32_t>(length);
+    op.off = static_cast<uint64_t>(-1);
+    return uring_execute(op);
+}
+
+ssize_t IOManager::read_fixed(int fd, void* buffer, size_t length, unsigned buffer_index,
+                              int64_t offset) noexcept
+{
+    if (ring_ == nullptr) {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    UringOp op{IORING_OP_READ_FIXED, fd};
+    op.addr = reinterpret_cast<uint64_t>(buffer);
+    op.len = static_cast<uint32_t>(length);
+    op.off = static_cast<uint64_t>(offset);
+    op.buf_index = static_cast<uint16_t>(buffer_index);
+    return uring_execute(op);
+}
+
+ssize_t IOManager::write_fixed(int fd, const void* buffer, size_t length, unsigned buffer_index,
+                               int64_t offset) noexcept
+{
+    if (ring_ == nullptr) {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    UringOp op{IORING_OP_WRITE_FIXED, fd};
+    op.addr = reinterpret_cast<uint64_t>(buffer);
+    op.len = static_cast<uint32_t>(length);
+    op.off = static_cast<uint64_t>(offset);
+    op.buf_index = static_cast<uint16_t>(buffer_index);
+    return uring_execute(op);
+}
+
+ssize_t IOManager::read_fixed(FixedFile file, void* buffer, size_t length, unsigned buffer_index,
+                              int64_t offset) noexcept
+{
+    if (ring_ == nullptr) {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    UringOp op{IORING_OP_READ_FIXED, static_cast<int>(file.index), true};
+    op.addr = reinterpret_cast<uint64_t>(buffer);
+    op.len = static_cast<uint32_t>(length);
+    op.off = static_cast<uint64_t>(offset);
+    op.buf_index = static_cast<uint16_t>(buffer_index);
+    return uring_execute(op);
+}
+
+ssize_t IOManager::write_fixed(FixedFile file, const void* buffer, size_t length,
+                               unsigned buffer_index, int64_t offset) noexcept
+{
+    if (ring_ == nullptr) {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    UringOp op{IORING_OP_WRITE_FIXED, static_cast<int>(file.index), true};
+    op.addr = reinterpret_cast<uint64_t>(buffer);
+    op.len = static_cast<uint32_t>(length);
+    op.off = static_cast<uint64_t>(offset);
+    op.buf_index = static_cast<uint16_t>(buffer_index);
+    return uring_execute(op);
+}
+
+bool IOManager::register_buffers(const iovec* buffers, unsigned count) noexcept
+{
+    return uring_register(IORING_REGISTER_BUFFERS, buffers, count);
+}
+
+bool IOManager::unregister_buffers() noexcept
+{
+    return uring_register(IORING_UNREGISTER_BUFFERS, nullptr, 0);
+}
+
+bool IOManager::register_files(const int* fds, unsigned count) noexcept
+{
+    return uring_register(IORING_REGISTER_FILES, fds, count);
+}
+
+bool IOManager::update_files(unsigned offset, const int* fds, unsigned count) noexcept
+{
+    io_uring_files_update update{};
+    update.offset = offset;
+    update.fds = reinterpret_cast<uint64_t>(fds);
+    return uring_register(IORING_REGISTER_FILES_UPDATE, &update, count);
+}
+
+bool IOManager::unregister_files() noexcept
+{
+    return uring_register(IORING_UNREGISTER_FILES, nullptr, 0);
+}
+
+} // namespace libco_oop
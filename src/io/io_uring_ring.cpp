@@ -0,0 +1,147 @@
+/**
+ * @file io_uring_ring.cpp
+ * @brief io_uring 队列封装实现
+ * @author libco-oop
+ * @version 1.0
+ */
+
+#include "io_uring_ring.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+namespace libco_oop {
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) noexcept
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) noexcept
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                                      nullptr, _NSIG / 8));
+}
+
+void* map_ring(int fd, size_t size, uint64_t offset) noexcept
+{
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          fd, static_cast<off_t>(offset));
+    return memory == MAP_FAILED ? nullptr : memory;
+}
+
+template <typename T>
+T* at(void* base, uint32_t offset) noexcept
+{
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+} // namespace
+
+//============================================================================
+// IoUringRing 类实现
+//============================================================================
+
+IoUringRing::~IoUringRing() noexcept
+{
+    if (sqes_ != nullptr) {
+        ::munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+        ::munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) {
+        ::munmap(sq_ring_, sq_ring_size_);
+    }
+    if (ring_fd_ >= 0) {
+        ::close(ring_fd_);
+    }
+}
+
+bool IoUringRing::init(unsigned entries) noexcept
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = sys_io_uring_setup(entries, &params);
+    if (fd < 0) {
+        return false;
+    }
+    ring_fd_ = fd;
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = sq_ring_size_ > cq_ring_size_ ? sq_ring_size_ : cq_ring_size_;
+    }
+
+    sq_ring_ = map_ring(fd, sq_ring_size_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == nullptr) {
+        return false;
+    }
+    cq_ring_ = single_mmap ? sq_ring_ : map_ring(fd, cq_ring_size_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == nullptr) {
+        return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(map_ring(fd, sqes_size_, IORING_OFF_SQES));
+    if (sqes_ == nullptr) {
+        return false;
+    }
+
+    sq_head_ = at<unsigned>(sq_ring_, params.sq_off.head);
+    sq_tail_ = at<unsigned>(sq_ring_, params.sq_off.tail);
+    sq_mask_ = *at<unsigned>(sq_ring_, params.sq_off.ring_mask);
+    sq_entries_ = *at<unsigned>(sq_ring_, params.sq_off.ring_entries);
+    cq_head_ = at<unsigned>(cq_ring_, params.cq_off.head);
+    cq_tail_ = at<unsigned>(cq_ring_, params.cq_off.tail);
+    cq_mask_ = *at<unsigned>(cq_ring_, params.cq_off.ring_mask);
+    cqes_ = at<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+
+    // 提交队列项与索引数组一一对应，之后不再改写索引数组
+    unsigned* array = at<unsigned>(sq_ring_, params.sq_off.array);
+    for (unsigned i = 0; i < sq_entries_; ++i) {
+        array[i] = i;
+    }
+    sqe_tail_ = *sq_tail_;
+    return true;
+}
+
+io_uring_sqe* IoUringRing::get_sqe() noexcept
+{
+    const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sqe_tail_ - head >= sq_entries_) {
+        return nullptr;
+    }
+    io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+    ++sqe_tail_;
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int IoUringRing::submit(unsigned min_complete) noexcept
+{
+    // 内核未消费完的项 (例如上次提交时资源不足) 会随本批一起重新提交
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+    const unsigned to_submit = pending();
+    if (to_submit == 0 && min_complete == 0) {
+        return 0;
+    }
+
+    const unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int result = sys_io_uring_enter(ring_fd_, to_submit, min_complete, flags);
+    return result < 0 ? -errno : result;
+}
+
+int IoUringRing::register_resource(unsigned opcode, const void* arg, unsigned count) noexcept
+{
+    int result = static_cast<int>(::syscall(__NR_io_uring_register, ring_fd_, opcode, arg, count));
+    return result < 0 ? -errno : result;
+}
+
+} // namespace libco_oop
@@ -0,0 +1,186 @@
+/**
+ * @file zero_copy.cpp
+ * @brief MSG_ZEROCOPY 发送实现
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 内核为套接字上每次成功的零拷贝 sendmsg 分配一个递增的 32 位序号，
+ * 完成通知以 [ee_info, ee_data] 区间的形式批量到达，可能合并多次发送。
+ */
+
+#include "libco_oop/zero_copy.h"
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace libco_oop {
+
+namespace {
+
+constexpr size_t kSendIovecs = 64;      ///< 每次 sendmsg 的最大区间数
+
+} // namespace
+
+//============================================================================
+// ZeroCopySender 类实现
+//============================================================================
+
+ZeroCopySender::ZeroCopySender(IOManager& io, int fd, const ZeroCopyOptions& opts)
+    : io_(io)
+    , fd_(fd)
+    , threshold_(opts.threshold)
+    , pending_(std::max<size_t>(opts.max_pending, 1))
+{
+    const int one = 1;
+    enabled_ = ::setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+}
+
+ZeroCopySender::~ZeroCopySender() noexcept = default;
+
+ssize_t ZeroCopySender::send(BufferChain& chain, int flags) noexcept
+{
+    size_t sent = 0;
+    while (!chain.empty()) {
+        iovec iov[kSendIovecs];
+        const size_t count = chain.fill_iovec(iov, kSendIovecs);
+        size_t bytes = 0;
+        for (size_t i = 0; i < count; ++i) {
+            bytes += iov[i].iov_len;
+        }
+
+        bool zerocopy = enabled_ && bytes >= threshold_;
+        if (zerocopy && pending_count_ == pending_.size()) {
+            // 待完成环已满：等最早的发送完成
+            while (reap() == 0 && pending_count_ == pending_.size()) {
+                if (io_.wait_for(fd_, IOEventType::ERROR) != 0) {
+                    return -1;
+                }
+            }
+        }
+
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = count;
+        ssize_t n = io_.sendmsg(fd_, &message, flags | (zerocopy ? MSG_ZEROCOPY : 0));
+        if (n < 0 && zerocopy && errno == ENOBUFS) {
+            // 未完成的零拷贝发送超出了 optmem 限制，这一次拷贝发送
+            ++stats_.fallbacks;
+            zerocopy = false;
+            n = io_.sendmsg(fd_, &message, flags);
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+
+        if (zerocopy) {
+            Pending& entry = pending_[(first_slot_ + pending_count_) % pending_.size()];
+            entry.done = false;
+            ++pending_count_;
+            ++stats_.zerocopy_sends;
+            if (!chain.split_to(entry.data, static_cast<size_t>(n))) {
+                // 无法保留引用：等这次发送完成后再释放
+                const int result = flush();
+                chain.consume(static_cast<size_t>(n));
+                if (result != 0) {
+                    return -1;
+                }
+            }
+        } else {
+            ++stats_.copied_sends;
+            chain.consume(static_cast<size_t>(n));
+        }
+        sent += static_cast<size_t>(n);
+    }
+    reap();
+    return static_cast<ssize_t>(sent);
+}
+
+size_t ZeroCopySender::reap() noexcept
+{
+    if (!enabled_ || pending_count_ == 0) {
+        return 0;
+    }
+
+    for (;;) {
+        char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+        msghdr message{};
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        if (io_.recvmsg(fd_, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;      // EAGAIN: 没有更多通知
+        }
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+            const bool recverr = (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+                || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+            if (!recverr) {
+                continue;
+            }
+            sock_extended_err error;
+            std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+            if (error.ee_origin == SO_EE_ORIGIN_ZEROCOPY && error.ee_errno == 0) {
+                complete(error.ee_info, error.ee_data, (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+            }
+        }
+    }
+
+    // 按发送顺序释放已完成的前缀
+    size_t completed = 0;
+    while (pending_count_ > 0 && pending_[first_slot_].done) {
+        Pending& entry = pending_[first_slot_];
+        entry.data.clear();
+        entry.done = false;
+        first_slot_ = (first_slot_ + 1) % pending_.size();
+        ++first_id_;
+        --pending_count_;
+        ++completed;
+    }
+    stats_.completions += completed;
+    return completed;
+}
+
+void ZeroCopySender::complete(uint32_t first, uint32_t last, bool copied) noexcept
+{
+    // 序号按 32 位回绕，只检查仍在等待的发送
+    const uint32_t span = last - first;
+    for (size_t index = 0; index < pending_count_; ++index) {
+        const uint32_t id = first_id_ + static_cast<uint32_t>(index);
+        Pending& entry = pending_[(first_slot_ + index) % pending_.size()];
+        if (static_cast<uint32_t>(id - first) <= span && !entry.done) {
+            entry.done = true;
+            if (copied) {
+                ++stats_.kernel_copied;
+            }
+        }
+    }
+}
+
+int ZeroCopySender::flush(int64_t timeout_ms) noexcept
+{
+    const uint64_t deadline = timeout_ms >= 0 ? TimerManager::now_ms() + static_cast<uint64_t>(timeout_ms) : 0;
+    reap();
+    while (pending_count_ > 0) {
+        int64_t remaining = -1;
+        if (timeout_ms >= 0) {
+            const uint64_t now = TimerManager::now_ms();
+            if (now >= deadline) {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+            remaining = static_cast<int64_t>(deadline - now);
+        }
+        const int result = io_.wait_for(fd_, IOEventType::ERROR, remaining);
+        reap();
+        if (result != 0 && pending_count_ > 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+} // namespace libco_oop
@@ -0,0 +1,201 @@
+/**
+ * @file coroutine_pool.cpp
+ * @brief 协程池实现
+ * @author libco-oop
+ * @version 1.0
+ */
+
+#include "libco_oop/coroutine_pool.h"
+#include "libco_oop/io_manager.h"
+#include <algorithm>
+#include <cerrno>
+
+namespace libco_oop {
+
+namespace {
+
+/**
+ * @brief 当前线程的标识 (线程局部变量的地址)
+ */
+const void* thread_token() noexcept
+{
+    static thread_local char token;
+    return &token;
+}
+
+/**
+ * @brief 创建并销毁一个协程，返回默认选项
+ *
+ * 让控制块缓存和栈池先于本线程的协程池构造，从而晚于它析构，
+ * 池析构时释放的协程还有地方归还。
+ */
+CoroutinePoolOptions touch_thread_caches() noexcept
+{
+    Coroutine::create([] {});
+    return CoroutinePoolOptions{};
+}
+
+} // namespace
+
+//============================================================================
+// CoroutinePool 类实现
+//============================================================================
+
+CoroutinePool::CoroutinePool(const CoroutinePoolOptions& opts) noexcept
+    : options_(opts)
+    , owner_(thread_token())
+{
+    shrink_timer_.callback = &CoroutinePool::on_shrink_timer;
+    shrink_timer_.context = this;
+}
+
+CoroutinePool::~CoroutinePool() noexcept
+{
+    stop_shrink_timer();
+    clear();
+}
+
+CoroutinePool& CoroutinePool::local() noexcept
+{
+    static thread_local CoroutinePool pool(touch_thread_caches());
+    return pool;
+}
+
+CoroutinePtr CoroutinePool::acquire_function(CoroutineFunction fn) noexcept
+{
+    if (options_.max_active != 0 && active_.load(std::memory_order_relaxed) >= options_.max_active) {
+        ++stats_.rejected;
+        errno = EAGAIN;
+        return nullptr;
+    }
+
+    Coroutine* coroutine = idle_.pop_front();
+    if (coroutine != nullptr) {
+        idle_low_ = std::min(idle_low_, idle_.size());
+        coroutine->reset_function(std::move(fn));
+        ++stats_.hits;
+    } else {
+        CoroutinePtr created = Coroutine::create_function(std::move(fn), options_.coroutine);
+        if (!created) {
+            errno = ENOMEM;
+            return nullptr;
+        }
+        coroutine = created.release();
+        ++stats_.created;
+    }
+
+    coroutine->pool_ = this;
+    active_.fetch_add(1, std::memory_order_relaxed);
+    ++stats_.acquired;
+    return CoroutinePtr(coroutine);
+}
+
+bool CoroutinePool::recycle(Coroutine* coroutine) noexcept
+{
+    active_.fetch_sub(1, std::memory_order_relaxed);
+    coroutine->pool_ = nullptr;
+    if (owner_ != thread_token()) {
+        return false;
+    }
+    // 挂起的协程栈上还有未展开的帧，不能复用
+    if (coroutine->state_ == CoroutineState::SUSPENDED || idle_.size() >= options_.max_idle) {
+        ++stats_.discarded;
+        return false;
+    }
+
+    coroutine->function_.reset();
+    coroutine->exception_ = nullptr;
+    coroutine->scheduler_ = nullptr;
+    coroutine->wake_state_.store(0, std::memory_order_relaxed);
+    // 借出期间可能被调度器修改过调度类
+    coroutine->scheduling_class_ = options_.coroutine.scheduling_class;
+    idle_.push_front(coroutine);
+    ++stats_.recycled;
+    arm_shrink_timer();
+    return true;
+}
+
+size_t CoroutinePool::reserve(size_t count) noexcept
+{
+    count = std::min(count, options_.max_idle);
+    while (idle_.size() < count) {
+        CoroutinePtr created = Coroutine::create_function(CoroutineFunction(), options_.coroutine);
+        if (!created) {
+            break;
+        }
+        idle_.push_back(created.release());
+        ++stats_.created;
+    }
+    arm_shrink_timer();
+    return idle_.size();
+}
+
+size_t CoroutinePool::shrink() noexcept
+{
+    // 整个周期内至少有 idle_low_ 个空闲协程没有被借出过，从最冷的一端释放
+    size_t excess = idle_low_ > options_.min_idle ? idle_low_ - options_.min_idle : 0;
+    excess = std::min(excess, idle_.size());
+    for (size_t i = 0; i < excess; ++i) {
+        destroy(idle_.pop_back());
+    }
+    stats_.trimmed += excess;
+    idle_low_ = idle_.size();
+    return excess;
+}
+
+void CoroutinePool::clear() noexcept
+{
+    while (Coroutine* coroutine = idle_.pop_front()) {
+        destroy(coroutine);
+    }
+    idle_low_ = 0;
+}
+
+void CoroutinePool::destroy(Coroutine* coroutine) noexcept
+{
+    CoroutineDeleter()(coroutine);
+}
+
+bool CoroutinePool::start_shrink_timer(IOManager& io) noexcept
+{
+    if (options_.shrink_interval_ms == 0) {
+        return false;
+    }
+    stop_shrink_timer();
+    io_ = &io;
+    idle_low_ = idle_.size();
+    arm_shrink_timer();
+    return true;
+}
+
+void CoroutinePool::stop_shrink_timer() noexcept
+{
+    if (io_ != nullptr) {
+        io_->cancel_timer(&shrink_timer_);
+        io_ = nullptr;
+    }
+}
+
+void CoroutinePool::arm_shrink_timer() noexcept
+{
+    if (io_ != nullptr && !shrink_timer_.is_pending() && idle_.size() > options_.min_idle) {
+        io_->add_timer(&shrink_timer_, options_.shrink_interval_ms);
+    }
+}
+
+void CoroutinePool::on_shrink_timer(TimerNode* node)
+{
+    CoroutinePool* pool = static_cast<CoroutinePool*>(node->context);
+    pool->shrink();
+    pool->arm_shrink_timer();
+}
+
+CoroutinePoolStatistics CoroutinePool::get_statistics() const noexcept
+{
+    CoroutinePoolStatistics result = stats_;
+    result.idle = idle_.size();
+    result.active = get_active_count();
+    return result;
+}
+
+} // namespace libco_oop
@@ -0,0 +1,387 @@
+/**
+ * @file scheduler.cpp
+ * @brief 单线程协程调度器实现
+ * @author libco-oop
+ * @version 1.0
+ */
+
+#include "libco_oop/scheduler.h"
+
+namespace libco_oop {
+
+namespace {
+
+Scheduler*& current_scheduler() noexcept
+{
+    static thread_local Scheduler* scheduler = nullptr;
+    return scheduler;
+}
+
+} // namespace
+
+//============================================================================
+// Scheduler 类实现
+//============================================================================
+
+Scheduler::Scheduler() noexcept
+    : Scheduler("scheduler")
+{
+}
+
+Scheduler::Scheduler(const char* metrics_kind) noexcept
+    : metrics_kind_(metrics_kind)
+{
+#if LIBCO_OOP_METRICS
+    // collect_metrics 只读取本类的计数器，子类尚未构造完成也可以登记
+    metrics_source_.attach(metrics_kind_, this, &Scheduler::collect_metrics);
+#endif
+}
+
+Scheduler::~Scheduler() noexcept
+{
+    for (ReadyQueue& queue : ready_) {
+        while (Coroutine* coroutine = queue.deadline.pop_front()) {
+            retire(coroutine);
+        }
+        while (Coroutine* coroutine = queue.fifo.pop_front()) {
+            retire(coroutine);
+        }
+    }
+}
+
+__attribute__((noinline))
+Scheduler* Scheduler::current() noexcept
+{
+    return current_scheduler();
+}
+
+Coroutine* Scheduler::submit(CoroutinePtr coroutine) noexcept
+{
+    if (!coroutine || !coroutine->is_resumable() || coroutine->scheduler_ != nullptr) {
+        return nullptr;
+    }
+
+    Coroutine* raw = coroutine.release();
+    raw->scheduler_ = this;
+    ++live_;
+    ++stats_.spawned;
+    enqueue(raw);
+    return raw;
+}
+
+size_t Scheduler::submit_batch(CoroutineBatch& batch) noexcept
+{
+    bool valid = true;
+    const IntrusiveList<Coroutine>* target = nullptr;   // 全部进入同一个先进先出队列时整体拼接
+    bool uniform = true;
+    batch.coroutines_.for_each([&](const Coroutine* coroutine) {
+        valid = valid && coroutine->is_resumable() && coroutine->scheduler_ == nullptr;
+        const IntrusiveList<Coroutine>* queue = &queue_of(coroutine);
+        if (target == nullptr) {
+            target = queue;
+        }
+        uniform = uniform && queue == target
+            && queue == &ready_[static_cast<size_t>(coroutine->scheduling_class_)].fifo;
+    });
+    if (!valid) {
+        return 0;
+    }
+
+    const size_t count = batch.size();
+    batch.coroutines_.for_each([this](Coroutine* coroutine) { coroutine->scheduler_ = this; });
+    live_ += count;
+    stats_.spawned += count;
+    if (uniform && count != 0) {
+        const Coroutine* first = batch.coroutines_.front();
+        queue_of(first).splice_back(batch.coroutines_);
+        ready_mask_ |= 1u << static_cast<size_t>(first->scheduling_class_);
+    } else {
+        while (Coroutine* coroutine = batch.coroutines_.pop_front()) {
+            enqueue(coroutine);
+        }
+    }
+    return count;
+}
+
+bool Scheduler::schedule(Coroutine* coroutine) noexcept
+{
+    if (coroutine == nullptr || coroutine->scheduler_ != this || !coroutine->is_resumable()) {
+        return false;
+    }
+    if (!coroutine->is_linked()) {
+        enqueue(coroutine);
+    }
+    return true;
+}
+
+bool Scheduler::set_policy(const SchedulingPolicy& policy) noexcept
+{
+    if (get_ready_count() != 0) {
+        return false;
+    }
+    policy_ = policy;
+    credit_mask_ = 0;
+    for (ReadyQueue& queue : ready_) {
+        queue.credits = 0;
+        queue.skipped = 0;
+    }
+    return true;
+}
+
+bool Scheduler::set_scheduling_class(Coroutine* coroutine, SchedulingClass scheduling_class) noexcept
+{
+    if (!owns(coroutine)) {
+        return false;
+    }
+    // 调度器拥有的协程只可能链接在就绪队列中
+    const bool queued = coroutine->is_linked();
+    if (queued) {
+        dequeue(coroutine);
+    }
+    coroutine->scheduling_class_ = scheduling_class;
+    if (queued) {
+        enqueue(coroutine);
+    }
+    return true;
+}
+
+bool Scheduler::set_deadline(Coroutine* coroutine, uint64_t deadline) noexcept
+{
+    if (!owns(coroutine)) {
+        return false;
+    }
+    const bool queued = coroutine->is_linked();
+    if (queued) {
+        dequeue(coroutine);
+    }
+    coroutine->deadline_ = deadline;
+    if (queued) {
+        enqueue(coroutine);
+    }
+    return true;
+}
+
+void Scheduler::enqueue(Coroutine* coroutine) noexcept
+{
+    const size_t c = static_cast<size_t>(coroutine->scheduling_class_);
+    ReadyQueue& queue = ready_[c];
+    if (__builtin_expect(policy_.deadline_ordering && coroutine->deadline_ != 0, 0)) {
+        queue.deadline.insert_sorted(coroutine, [](const Coroutine* a, const Coroutine* b) {
+            return a->deadline_ < b->deadline_;
+        });
+    } else {
+        queue.fifo.push_back(coroutine);
+    }
+    ready_mask_ |= 1u << c;
+}
+
+void Scheduler::dequeue(Coroutine* coroutine) noexcept
+{
+    const size_t c = static_cast<size_t>(coroutine->scheduling_class_);
+    queue_of(coroutine).remove(coroutine);
+    if (ready_[c].empty()) {
+        // 越过次数只在非空期间累计，下次变为非空时重新计数
+        ready_mask_ &= ~(1u << c);
+        ready_[c].skipped = 0;
+    }
+}
+
+// 类的数量固定，位图上的选择与就绪协程数无关
+size_t Scheduler::select_class(uint32_t mask) noexcept
+{
+    size_t chosen;
+    if (policy_.selection == ClassSelection::WEIGHTED) {
+        chosen = select_weighted();
+    } else {
+        chosen = static_cast<size_t>(__builtin_ctz(mask));
+    }
+    if (mask >> (chosen + 1) != 0 && policy_.starvation_limit != 0) {
+        chosen = guard_starvation(chosen);
+    }
+    if (policy_.selection == ClassSelection::WEIGHTED) {
+        // 额度记在实际调度的类上，被饥饿保护替换的类保留额度
+        const uint32_t bit = 1u << chosen;
+        if ((credit_mask_ & bit) != 0 && --ready_[chosen].credits == 0) {
+            credit_mask_ &= ~bit;
+        }
+    }
+    return chosen;
+}
+
+size_t Scheduler::select_weighted() noexcept
+{
+    uint32_t candidates = ready_mask_ & credit_mask_;
+    if (candidates == 0) {
+        // 非空的类都用完了额度，开始新的一轮
+        credit_mask_ = 0;
+        for (size_t c = 0; c < kSchedulingClasses; ++c) {
+            ready_[c].credits = policy_.weights[c];
+            if (policy_.weights[c] != 0) {
+                credit_mask_ |= 1u << c;
+            }
+        }
+        candidates = ready_mask_ & credit_mask_;
+    }
+    if (candidates == 0) {
+        // 只剩额度为0的类
+        return static_cast<size_t>(__builtin_ctz(ready_mask_));
+    }
+    return static_cast<size_t>(__builtin_ctz(candidates));
+}
+
+// 低于所选类的非空类各记一次被越过，达到上限的类中被越过最多的优先
+size_t Scheduler::guard_starvation(size_t chosen) noexcept
+{
+    size_t starved = kSchedulingClasses;
+    for (size_t c = chosen + 1; c < kSchedulingClasses; ++c) {
+        ReadyQueue& queue = ready_[c];
+        if ((ready_mask_ & (1u << c)) == 0) {
+            continue;
+        }
+        if (++queue.skipped >= policy_.starvation_limit
+            && (starved == kSchedulingClasses || queue.skipped > ready_[starved].skipped)) {
+            starved = c;
+        }
+    }
+    if (starved == kSchedulingClasses) {
+        return chosen;
+    }
+    ++stats_.starvation_boosts;
+    return starved;
+}
+
+Coroutine* Scheduler::pop_ready() noexcept
+{
+    const uint32_t mask = ready_mask_;
+    if (mask == 0) {
+        return nullptr;
+    }
+    // 只有一个类非空时 (包括默认只使用 NORMAL 类) 不需要选择，也不消耗额度
+    const size_t chosen = (mask & (mask - 1)) == 0 ? static_cast<size_t>(__builtin_ctz(mask))
+                                                   : select_class(mask);
+    ++stats_.class_dispatches[chosen];
+    ReadyQueue& queue = ready_[chosen];
+    queue.skipped = 0;
+    Coroutine* next = queue.deadline.pop_front();
+    if (next == nullptr) {
+        next = queue.fifo.pop_front();
+    }
+    if (queue.empty()) {
+        ready_mask_ &= ~(1u << chosen);
+    }
+    return next;
+}
+
+void Scheduler::run()
+{
+    // 支持在 run() 中途抛出异常后恢复外层调度器
+    struct CurrentGuard {
+        Scheduler* previous;
+        ~CurrentGuard() { current_scheduler() = previous; }
+    } guard{current_scheduler()};
+    current_scheduler() = this;
+    stopping_ = false;
+
+    while (!stopping_) {
+        Coroutine* next = pop_ready();
+        if (next == nullptr) {
+            if (!idle()) {
+                break;
+            }
+            continue;
+        }
+
+#if LIBCO_OOP_METRICS
+        counters_.switches.add();
+        counters_.run_queue.set(get_ready_count());
+#endif
+        if ((++stats_.dispatches & (kTickInterval - 1)) == 0) {
+            tick();
+        }
+        // 经过 yield_to() 交接后，切换回来的可能是另一个协程
+        Coroutine* returned = next->switch_in();
+        if (returned->is_finished()) {
+            std::exception_ptr exception = retire(returned);
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+    }
+}
+
+std::exception_ptr Scheduler::retire(Coroutine* coroutine) noexcept
+{
+    std::exception_ptr exception = std::move(coroutine->exception_);
+    coroutine->exception_ = nullptr;
+    if (coroutine->is_finished()) {
+        ++stats_.finished;
+    }
+    --live_;
+    CoroutineDeleter()(coroutine);
+    return exception;
+}
+
+metrics::SchedulerMetrics Scheduler::get_metrics() const noexcept
+{
+#if LIBCO_OOP_METRICS
+    return metrics_source_.collect();
+#else
+    metrics::SchedulerMetrics result;
+    result.kind = metrics_kind_;
+    return result;
+#endif
+}
+
+#if LIBCO_OOP_METRICS
+void Scheduler::collect_metrics(const void* owner, metrics::SchedulerMetrics& out) noexcept
+{
+    const metrics::SchedulerCounters& counters = static_cast<const Scheduler*>(owner)->counters_;
+    out.switches = counters.switches.load();
+    out.run_queue = static_cast<size_t>(counters.run_queue.load());
+    out.io_waits = counters.io_waits.load();
+    out.timer_fires = counters.timer_fires.load();
+}
+#endif
+
+bool Scheduler::yield() noexcept
+{
+    Coroutine* self = Coroutine::current();
+    if (self == nullptr) {
+        return false;
+    }
+    if (self->scheduler_ != nullptr) {
+        self->scheduler_->enqueue(self);
+    }
+    return Coroutine::yield();
+}
+
+bool Scheduler::suspend() noexcept
+{
+    Coroutine* self = Coroutine::current();
+    if (self == nullptr || self->scheduler_ == nullptr) {
+        return false;
+    }
+    return Coroutine::yield();
+}
+
+bool Scheduler::yield_to(Coroutine* target) noexcept
+{
+    Coroutine* self = Coroutine::current();
+    if (self == nullptr || self->scheduler_ == nullptr || target == nullptr || target == self
+        || target->scheduler_ != self->scheduler_ || !target->is_resumable()) {
+        return false;
+    }
+
+    Scheduler* scheduler = self->scheduler_;
+    if (target->is_linked()) {
+        scheduler->dequeue(target);
+    }
+    scheduler->enqueue(self);
+    ++scheduler->stats_.handoffs;
+#if LIBCO_OOP_METRICS
+    scheduler->counters_.switches.add();
+#endif
+    return Coroutine::yield_to(*target);
+}
+
+} // namespace libco_oop
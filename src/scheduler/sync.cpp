@@ -0,0 +1,143 @@
+/**
+ * @file sync.cpp
+ * @brief 协程同步原语的慢路径实现
+ * @author libco-oop
+ * @version 1.0
+ */
+
+#include "libco_oop/sync.h"
+
+namespace libco_oop {
+
+//============================================================================
+// CoMutex 类实现
+//============================================================================
+
+void CoMutex::lock_slow() noexcept
+{
+    detail::Waiter waiter;
+    {
+        std::lock_guard<std::mutex> guard(queue_mutex_);
+        // 有等待者时状态不会回到 UNLOCKED (解锁直接交接)，
+        // 因此这里看到 UNLOCKED 时可以直接获取而不破坏 FIFO
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        for (;;) {
+            if (state == UNLOCKED) {
+                if (state_.compare_exchange_weak(state, LOCKED, std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+                    return;
+                }
+            } else if (state == CONTENDED
+                       || state_.compare_exchange_weak(state, CONTENDED, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        waiters_.push_back(&waiter);
+    }
+    // 被唤醒时锁已交接给自己
+    waiter.wait();
+}
+
+void CoMutex::unlock_slow() noexcept
+{
+    detail::Waiter* next;
+    {
+        std::lock_guard<std::mutex> guard(queue_mutex_);
+        next = waiters_.pop_front();
+        if (next == nullptr) {
+            state_.store(UNLOCKED, std::memory_order_release);
+            return;
+        }
+        // 锁保持被持有，交给 next；没有其他等待者时下次解锁走快速路径
+        if (waiters_.empty()) {
+            state_.store(LOCKED, std::memory_order_relaxed);
+        }
+    }
+    next->notify();
+}
+
+//============================================================================
+// CoCondVar 类实现
+//============================================================================
+
+void CoCondVar::wait(CoMutex& mutex) noexcept
+{
+    detail::Waiter waiter;
+    {
+        std::lock_guard<std::mutex> guard(queue_mutex_);
+        waiters_.push_back(&waiter);
+        waiting_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 登记之后才释放 mutex：持有 mutex 修改条件后的通知不会丢失
+    mutex.unlock();
+    waiter.wait();
+    mutex.lock();
+}
+
+void CoCondVar::notify_one() noexcept
+{
+    if (waiting_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    detail::Waiter* waiter;
+    {
+        std::lock_guard<std::mutex> guard(queue_mutex_);
+        waiter = waiters_.pop_front();
+        if (waiter == nullptr) {
+            return;
+        }
+        waiting_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    waiter->notify();
+}
+
+void CoCondVar::notify_all() noexcept
+{
+    if (waiting_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    IntrusiveList<detail::Waiter> woken;
+    {
+        std::lock_guard<std::mutex> guard(queue_mutex_);
+        woken.splice_back(waiters_);
+        waiting_.store(0, std::memory_order_relaxed);
+    }
+    while (detail::Waiter* waiter = woken.pop_front()) {
+        waiter->notify();
+    }
+}
+
+//============================================================================
+// CoSemaphore 类实现
+//============================================================================
+
+void CoSemaphore::acquire_slow() noexcept
+{
+    detail::Waiter waiter;
+    {
+        std::lock_guard<std::mutex> guard(queue_mutex_);
+        // 计数已为自己预留了位置；释放者可能先到，许可记在 pending_ 中
+        if (pending_ > 0) {
+            --pending_;
+            return;
+        }
+        waiters_.push_back(&waiter);
+    }
+    waiter.wait();
+}
+
+void CoSemaphore::release_slow() noexcept
+{
+    detail::Waiter* waiter;
+    {
+        std::lock_guard<std::mutex> guard(queue_mutex_);
+        waiter = waiters_.pop_front();
+        if (waiter == nullptr) {
+            ++pending_;
+            return;
+        }
+    }
+    waiter->notify();
+}
+
+} // namespace libco_oop
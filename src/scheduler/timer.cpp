@@ -0,0 +1,230 @@
+/**
+ * @file timer.cpp
+ * @brief 分层时间轮实现
+ * @author libco-oop
+ * @version 1.0
+ */
+
+#include "libco_oop/timer.h"
+#include <chrono>
+
+namespace libco_oop {
+
+namespace {
+
+/**
+ * @brief 第 level 层 (level >= 1) 槽位下标的起始位
+ */
+constexpr unsigned level_shift(unsigned level) noexcept
+{
+    return TimerManager::kLevel0Bits + TimerManager::kLevelBits * (level - 1);
+}
+
+} // namespace
+
+//============================================================================
+// TimerManager 类实现
+//============================================================================
+
+TimerManager::TimerManager(uint64_t now_ms) noexcept
+    : current_(now_ms)
+{
+}
+
+TimerManager::~TimerManager() noexcept
+{
+    drain([](TimerNode*) {});
+}
+
+uint64_t TimerManager::now_ms() noexcept
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool TimerManager::add(TimerNode* node, uint64_t deadline) noexcept
+{
+    if (node == nullptr || node->is_pending() || node->callback == nullptr) {
+        return false;
+    }
+    if (firing_ && deadline < current_ + 1) {
+        deadline = current_ + 1;
+    }
+    node->deadline = deadline;
+    place(node);
+    ++count_;
+    return true;
+}
+
+bool TimerManager::cancel(TimerNode* node) noexcept
+{
+    if (node == nullptr || !node->is_pending()) {
+        return false;
+    }
+    unlink(node);
+    --count_;
+    return true;
+}
+
+void TimerManager::place(TimerNode* node) noexcept
+{
+    uint64_t deadline = node->deadline < current_ ? current_ : node->deadline;
+    uint64_t delay = deadline - current_;
+    if (delay > kMaxDelay) {
+        // 超出最远层：先放到最远处，级联时按真实到期时刻重新放置
+        delay = kMaxDelay;
+        deadline = current_ + kMaxDelay;
+    }
+
+    IntrusiveList<TimerNode>* slot;
+    if (delay < kLevel0Size) {
+        const unsigned index = static_cast<unsigned>(deadline & (kLevel0Size - 1));
+        slot = &level0_[index];
+        level0_bits_[index / 64] |= uint64_t(1) << (index % 64);
+    } else {
+        unsigned level = 1;
+        while (level < kLevels - 1 && delay >= (uint64_t(1) << level_shift(level + 1))) {
+            ++level;
+        }
+        const unsigned index = static_cast<unsigned>((deadline >> level_shift(level)) & (kLevelSize - 1));
+        slot = &levels_[level - 1][index];
+        level_bits_[level - 1] |= uint64_t(1) << index;
+        ++higher_count_;
+    }
+    slot->push_back(node);
+    node->slot = slot;
+}
+
+void TimerManager::unlink(TimerNode* node) noexcept
+{
+    IntrusiveList<TimerNode>* slot = node->slot;
+    slot->remove(node);
+    node->slot = nullptr;
+
+    if (slot >= level0_ && slot < level0_ + kLevel0Size) {
+        if (slot->empty()) {
+            const unsigned index = static_cast<unsigned>(slot - level0_);
+            level0_bits_[index / 64] &= ~(uint64_t(1) << (index % 64));
+        }
+        return;
+    }
+    --higher_count_;
+    if (slot->empty()) {
+        const size_t offset = static_cast<size_t>(slot - &levels_[0][0]);
+        level_bits_[offset / kLevelSize] &= ~(uint64_t(1) << (offset % kLevelSize));
+    }
+}
+
+void TimerManager::cascade() noexcept
+{
+    // 第 0 层转完一圈：把上一层当前槽位的定时器重新放置到更低层；
+    // 上一层也转完一圈时继续级联
+    for (unsigned level = 1; level < kLevels; ++level) {
+        const unsigned index = static_cast<unsigned>((current_ >> level_shift(level)) & (kLevelSize - 1));
+        IntrusiveList<TimerNode>& slot = levels_[level - 1][index];
+        if (!slot.empty()) {
+            IntrusiveList<TimerNode> moving;
+            moving.splice_back(slot);
+            higher_count_ -= moving.size();
+            level_bits_[level - 1] &= ~(uint64_t(1) << index);
+            while (TimerNode* node = moving.pop_front()) {
+                place(node);
+            }
+        }
+        if (index != 0) {
+            break;
+        }
+    }
+}
+
+int TimerManager::find_level0(unsigned from) const noexcept
+{
+    for (unsigned word = from / 64; word < kLevel0Size / 64; ++word) {
+        uint64_t bits = level0_bits_[word];
+        if (word == from / 64) {
+            bits &= ~uint64_t(0) << (from % 64);
+        }
+        if (bits != 0) {
+            return static_cast<int>(word * 64 + static_cast<unsigned>(__builtin_ctzll(bits)));
+        }
+    }
+    return -1;
+}
+
+size_t TimerManager::advance(uint64_t now)
+{
+    if (count_ == 0) {
+        if (current_ <= now) {
+            current_ = now + 1;
+        }
+        return 0;
+    }
+
+    size_t fired = 0;
+    while (current_ <= now) {
+        const unsigned index = static_cast<unsigned>(current_ & (kLevel0Size - 1));
+        if (index == 0 && higher_count_ > 0) {
+            cascade();
+        }
+
+        // 跳过空槽：直接前进到本圈下一个非空槽位，或下一次级联的时刻
+        const int next = find_level0(index);
+        const uint64_t base = current_ - index;
+        const uint64_t target = next < 0 ? base + kLevel0Size : base + static_cast<uint64_t>(next);
+        if (target > now) {
+            current_ = now + 1;
+            break;
+        }
+        current_ = target;
+        if (next < 0) {
+            continue;
+        }
+
+        IntrusiveList<TimerNode>& slot = level0_[next];
+        firing_ = true;
+        while (TimerNode* node = slot.pop_front()) {
+            node->slot = nullptr;
+            --count_;
+            ++fired;
+            node->callback(node);
+        }
+        firing_ = false;
+        level0_bits_[next / 64] &= ~(uint64_t(1) << (next % 64));
+        ++current_;
+    }
+    return fired;
+}
+
+int64_t TimerManager::next_timeout(uint64_t now) const noexcept
+{
+    if (count_ == 0) {
+        return -1;
+    }
+    const unsigned index = static_cast<unsigned>(current_ & (kLevel0Size - 1));
+    const uint64_t base = current_ - index;
+    uint64_t target;
+    int next = find_level0(index);
+    if (next >= 0) {
+        target = base + static_cast<uint64_t>(next);
+    } else if (higher_count_ > 0) {
+        target = base + kLevel0Size;            // 下一次级联
+    } else {
+        next = find_level0(0);                  // 只剩下一圈的第 0 层定时器
+        target = base + kLevel0Size + static_cast<uint64_t>(next);
+    }
+    return target <= now ? 0 : static_cast<int64_t>(target - now);
+}
+
+void TimerManager::clear_bits() noexcept
+{
+    for (uint64_t& bits : level0_bits_) {
+        bits = 0;
+    }
+    for (uint64_t& bits : level_bits_) {
+        bits = 0;
+    }
+    count_ = 0;
+    higher_count_ = 0;
+}
+
+} // namespace libco_oop
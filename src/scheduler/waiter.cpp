@@ -0,0 +1,105 @@
+/**
+ * @file waiter.cpp
+ * @brief 协程同步原语等待者实现
+ * @author libco-oop
+ * @version 1.0
+ */
+
+#include "libco_oop/waiter.h"
+#include "libco_oop/work_stealing.h"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <thread>
+
+namespace libco_oop {
+namespace detail {
+
+namespace {
+
+long futex(std::atomic<uint32_t>* word, int op, uint32_t value) noexcept
+{
+    return ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, nullptr, nullptr, 0);
+}
+
+} // namespace
+
+//============================================================================
+// Waiter 类实现
+//============================================================================
+
+Waiter::Waiter() noexcept
+{
+    if (wakeup_.manager != nullptr) {
+        kind_ = Kind::IO_MANAGER;
+    } else if (wakeup_.coroutine == nullptr) {
+        kind_ = Kind::THREAD;
+    } else if ((scheduler_ = wakeup_.coroutine->get_scheduler()) != nullptr) {
+        kind_ = Kind::SCHEDULER;
+    } else if ((work_stealing_ = WorkStealingScheduler::current()) != nullptr) {
+        kind_ = Kind::WORK_STEALING;
+    }
+}
+
+void Waiter::wait() noexcept
+{
+    switch (kind_) {
+    case Kind::IO_MANAGER:
+        wakeup_.manager->park(wakeup_);
+        return;
+    case Kind::SCHEDULER:
+        // 循环过滤外部 schedule() 造成的提前唤醒
+        while (signaled_.load(std::memory_order_relaxed) == 0) {
+            Scheduler::suspend();
+        }
+        return;
+    case Kind::WORK_STEALING:
+        // 循环过滤之前遗留的唤醒；手动恢复的嵌套协程不能挂起，只能让出线程。
+        // 看到 kNotifying 时唤醒者还在 schedule() 中访问本协程，必须等它返回后
+        // 才能结束 (否则控制块可能在 schedule() 完成前被回收)
+        for (;;) {
+            const uint32_t state = signaled_.load(std::memory_order_acquire);
+            if (state == kNotified) {
+                return;
+            }
+            const bool switched = state == kNotifying ? WorkStealingScheduler::yield()
+                                                      : WorkStealingScheduler::suspend();
+            if (!switched) {
+                std::this_thread::yield();
+            }
+        }
+    case Kind::THREAD:
+        break;
+    }
+    while (signaled_.load(std::memory_order_acquire) == 0) {
+        futex(&signaled_, FUTEX_WAIT_PRIVATE, 0);
+    }
+}
+
+void Waiter::notify() noexcept
+{
+    switch (kind_) {
+    case Kind::IO_MANAGER:
+        IOManager::unpark(&wakeup_);
+        return;
+    case Kind::WORK_STEALING:
+        // 两阶段完成：kNotifying 让等待者不再挂起，schedule() 返回后的 kNotified
+        // 才允许它返回；此后不再访问等待者和协程
+        signaled_.store(kNotifying, std::memory_order_release);
+        work_stealing_->schedule(wakeup_.coroutine);
+        signaled_.store(kNotified, std::memory_order_release);
+        return;
+    case Kind::SCHEDULER:
+        signaled_.store(1, std::memory_order_relaxed);
+        scheduler_->schedule(wakeup_.coroutine);
+        return;
+    case Kind::THREAD:
+        break;
+    }
+    // 存储之后等待者可能已返回；对已失效地址的 FUTEX_WAKE 是无害的
+    signaled_.store(1, std::memory_order_release);
+    futex(&signaled_, FUTEX_WAKE_PRIVATE, 1);
+}
+
+} // namespace detail
+} // namespace libco_oop
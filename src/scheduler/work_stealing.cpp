@@ -0,0 +1,582 @@
+/**
+ * @file work_stealing.cpp
+ * @brief 多线程工作窃取调度器实现
+ * @author libco-oop
+ * @version 1.0
+ */
+
+#include "libco_oop/work_stealing.h"
+#include "libco_oop/chase_lev_deque.h"
+#include "libco_oop/trace.h"
+#include <pthread.h>
+#include <sched.h>
+#include <cstdint>
+#include <thread>
+
+namespace libco_oop {
+
+namespace {
+
+/**
+ * @brief 协程在多线程调度器中的唤醒状态 (Coroutine::wake_state_)
+ *
+ * 状态转换：
+ * - QUEUED -> RUNNING: 工作线程取出协程
+ * - RUNNING -> NOTIFIED: 协程切换出去之前收到唤醒
+ * - RUNNING -> PARKED: 协程挂起且没有待处理的唤醒
+ * - PARKED -> QUEUED: schedule() 唤醒
+ * - NOTIFIED -> QUEUED: 工作线程发现待处理的唤醒后重新入队
+ */
+enum WakeState : uint8_t {
+    QUEUED = 0,
+    RUNNING,
+    PARKED,
+    NOTIFIED
+};
+
+/**
+ * @brief 协程切换回工作线程时请求的动作
+ */
+enum class WorkerAction {
+    PARK,       ///< 挂起，等待 schedule()
+    YIELD       ///< 重新入队
+};
+
+/**
+ * @brief 每处理这么多次本地任务检查一次让出队列和注入队列，防止饥饿
+ */
+constexpr uint64_t kFairnessInterval = 61;
+
+/**
+ * @brief 由所有者线程更新、其他线程读取的计数器
+ */
+void bump(std::atomic<uint64_t>& counter) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+} // namespace
+
+//============================================================================
+// 工作线程
+//============================================================================
+
+struct WorkStealingScheduler::Worker {
+    WorkStealingScheduler* owner;
+    size_t index;
+    ChaseLevDeque<Coroutine*> deque;        ///< 本地就绪队列 (可被窃取)
+    IntrusiveList<Coroutine> yielded;       ///< 本轮让出的协程，本地队列取空后放回
+    Coroutine* running = nullptr;           ///< 正在执行的协程
+    WorkerAction action = WorkerAction::PARK;
+    uint64_t tick = 0;                      ///< 本地调度计数
+    uint64_t random;                        ///< 窃取目标的随机数状态
+    std::thread thread;
+
+    std::atomic<uint64_t> dispatches{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> parks{0};
+
+    Worker(WorkStealingScheduler* scheduler, size_t i, size_t capacity)
+        : owner(scheduler)
+        , index(i)
+        , deque(capacity)
+        , random(0x9E3779B97F4A7C15ull * (i + 1))
+    {
+    }
+
+    size_t next_random() noexcept
+    {
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        return static_cast<size_t>(random);
+    }
+};
+
+//============================================================================
+// 线程局部的当前工作线程
+//============================================================================
+
+namespace {
+
+thread_local void* tls_worker = nullptr;
+
+} // namespace
+
+__attribute__((noinline))
+WorkStealingScheduler::Worker* WorkStealingScheduler::current_worker() noexcept
+{
+    return static_cast<Worker*>(tls_worker);
+}
+
+//============================================================================
+// WorkStealingScheduler 类实现
+//============================================================================
+
+WorkStealingScheduler::WorkStealingScheduler(const WorkStealingOptions& opts)
+    : options_(opts)
+{
+    size_t count = options_.worker_count;
+    if (count == 0) {
+        count = std::thread::hardware_concurrency();
+        if (count == 0) {
+            count = 1;
+        }
+    }
+
+    workers_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>(this, i, options_.deque_capacity));
+    }
+    for (auto& worker : workers_) {
+        Worker* raw = worker.get();
+        raw->thread = std::thread([this, raw] { worker_main(*raw); });
+    }
+#if LIBCO_OOP_METRICS
+    metrics_source_.attach("work_stealing", this, &WorkStealingScheduler::collect_metrics);
+#endif
+}
+
+WorkStealingScheduler::~WorkStealingScheduler() noexcept
+{
+#if LIBCO_OOP_METRICS
+    metrics_source_.detach();
+#endif
+    shutdown();
+}
+
+void WorkStealingScheduler::shutdown() noexcept
+{
+    if (stopping_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_epoch_.fetch_add(1, std::memory_order_release);
+    }
+    park_cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    // 工作线程都已退出，剩余的队列只由当前线程访问
+    for (auto& worker : workers_) {
+        while (Coroutine* coroutine = worker->deque.pop()) {
+            retire(coroutine);
+        }
+        while (Coroutine* coroutine = worker->yielded.pop_front()) {
+            retire(coroutine);
+        }
+    }
+    while (Coroutine* coroutine = injected_.pop_front()) {
+        retire(coroutine);
+    }
+    injected_size_.store(0, std::memory_order_relaxed);
+}
+
+__attribute__((noinline))
+WorkStealingScheduler* WorkStealingScheduler::current() noexcept
+{
+    Worker* worker = current_worker();
+    return worker != nullptr ? worker->owner : nullptr;
+}
+
+__attribute__((noinline))
+size_t WorkStealingScheduler::current_worker_index() noexcept
+{
+    Worker* worker = current_worker();
+    return worker != nullptr ? worker->index : SIZE_MAX;
+}
+
+bool WorkStealingScheduler::submit(CoroutinePtr coroutine) noexcept
+{
+    if (!coroutine || !coroutine->is_resumable() || coroutine->scheduler_ != nullptr
+        || coroutine->hybrid_ != nullptr || coroutine->binding_.is_shared()
+        || stopping_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    Coroutine* raw = coroutine.release();
+    raw->wake_state_.store(QUEUED, std::memory_order_relaxed);
+    live_.fetch_add(1, std::memory_order_relaxed);
+    spawned_.fetch_add(1, std::memory_order_relaxed);
+    enqueue(raw);
+    return true;
+}
+
+size_t WorkStealingScheduler::submit_batch(CoroutineBatch& batch) noexcept
+{
+    bool valid = !batch.empty() && !stopping_.load(std::memory_order_acquire);
+    batch.coroutines_.for_each([&valid](const Coroutine* coroutine) {
+        valid = valid && coroutine->is_resumable() && coroutine->scheduler_ == nullptr
+            && coroutine->hybrid_ == nullptr && !coroutine->binding_.is_shared();
+    });
+    if (!valid) {
+        return 0;
+    }
+
+    const size_t count = batch.size();
+    IntrusiveList<Coroutine>& pending = batch.coroutines_;
+    pending.for_each([](Coroutine* coroutine) {
+        coroutine->wake_state_.store(QUEUED, std::memory_order_relaxed);
+    });
+    live_.fetch_add(count, std::memory_order_relaxed);
+    spawned_.fetch_add(count, std::memory_order_relaxed);
+
+    // 每个工作线程一份；本线程的一份直接一次发布到本地队列
+    const size_t share = (count + workers_.size() - 1) / workers_.size();
+    Worker* worker = current_worker();
+    if (worker != nullptr && worker->owner == this) {
+        worker->deque.push_batch(share, [&pending] { return pending.pop_front(); });
+    }
+    const size_t injected = pending.size();
+    if (injected != 0) {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        injected_.splice_back(pending);
+        injected_size_.fetch_add(injected, std::memory_order_release);
+    }
+    // 注入队列中的每一份唤醒一个休眠者；全部留在本地时唤醒一个来窃取
+    const size_t shares = (injected + share - 1) / share;
+    notify(shares != 0 ? shares : 1);
+    return count;
+}
+
+bool WorkStealingScheduler::schedule(Coroutine* coroutine) noexcept
+{
+    if (coroutine == nullptr) {
+        return false;
+    }
+
+    uint8_t state = coroutine->wake_state_.load(std::memory_order_acquire);
+    for (;;) {
+        switch (state) {
+        case PARKED:
+            if (coroutine->wake_state_.compare_exchange_weak(state, QUEUED,
+                    std::memory_order_acq_rel, std::memory_order_acquire)) {
+                enqueue(coroutine);
+                return true;
+            }
+            break;
+        case RUNNING:
+            // 协程还没有切换出去，由工作线程在切换回来后重新入队
+            if (coroutine->wake_state_.compare_exchange_weak(state, NOTIFIED,
+                    std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return true;
+            }
+            break;
+        default:
+            // 已在队列中或已有待处理的唤醒
+            return true;
+        }
+    }
+}
+
+void WorkStealingScheduler::wait()
+{
+    std::unique_lock<std::mutex> lock(done_mutex_);
+    done_cv_.wait(lock, [this] { return live_.load(std::memory_order_acquire) == 0; });
+    if (exception_) {
+        std::exception_ptr exception = std::move(exception_);
+        exception_ = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+bool WorkStealingScheduler::yield() noexcept
+{
+    Worker* worker = current_worker();
+    Coroutine* self = Coroutine::current();
+    if (worker == nullptr || self == nullptr || worker->running != self) {
+        return false;
+    }
+    worker->action = WorkerAction::YIELD;
+    // 切换回来时可能已在另一个工作线程上，之后不能再访问 worker
+    return Coroutine::yield();
+}
+
+bool WorkStealingScheduler::suspend() noexcept
+{
+    Worker* worker = current_worker();
+    Coroutine* self = Coroutine::current();
+    if (worker == nullptr || self == nullptr || worker->running != self) {
+        return false;
+    }
+    worker->action = WorkerAction::PARK;
+    return Coroutine::yield();
+}
+
+WorkStealingStatistics WorkStealingScheduler::get_statistics() const noexcept
+{
+    WorkStealingStatistics stats;
+    stats.spawned = spawned_.load(std::memory_order_relaxed);
+    stats.finished = finished_.load(std::memory_order_relaxed);
+    stats.wakeups = wakeups_.load(std::memory_order_relaxed);
+    for (const auto& worker : workers_) {
+        stats.dispatches += worker->dispatches.load(std::memory_order_relaxed);
+        stats.steals += worker->steals.load(std::memory_order_relaxed);
+        stats.parks += worker->parks.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+metrics::SchedulerMetrics WorkStealingScheduler::get_metrics() const noexcept
+{
+    metrics::SchedulerMetrics result;
+    collect_metrics(this, result);
+    result.kind = "work_stealing";
+#if LIBCO_OOP_METRICS
+    result.id = metrics_source_.get_id();
+#endif
+    return result;
+}
+
+void WorkStealingScheduler::collect_metrics(const void* owner, metrics::SchedulerMetrics& out) noexcept
+{
+    const WorkStealingScheduler* self = static_cast<const WorkStealingScheduler*>(owner);
+    out.run_queue = self->injected_size_.load(std::memory_order_relaxed);
+    for (const auto& worker : self->workers_) {
+        out.switches += worker->dispatches.load(std::memory_order_relaxed);
+        out.steals += worker->steals.load(std::memory_order_relaxed);
+        out.run_queue += worker->deque.size();
+    }
+}
+
+//============================================================================
+// 工作线程主循环
+//============================================================================
+
+void WorkStealingScheduler::worker_main(Worker& worker) noexcept
+{
+    if (options_.pin_workers) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(static_cast<int>(worker.index % CPU_SETSIZE), &set);
+        ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+    }
+
+    tls_worker = &worker;
+    while (Coroutine* coroutine = find_work(worker)) {
+        dispatch(worker, coroutine);
+    }
+    tls_worker = nullptr;
+}
+
+Coroutine* WorkStealingScheduler::find_work(Worker& worker) noexcept
+{
+    int rounds = 0;
+    while (!stopping_.load(std::memory_order_acquire)) {
+        if (Coroutine* coroutine = next_local(worker)) {
+            return coroutine;
+        }
+        if (Coroutine* coroutine = take_injected(worker)) {
+            return coroutine;
+        }
+        if (Coroutine* coroutine = steal(worker)) {
+            return coroutine;
+        }
+        if (++rounds < options_.spin_rounds) {
+            std::this_thread::yield();
+            continue;
+        }
+        park(worker);
+        rounds = 0;
+    }
+    return nullptr;
+}
+
+Coroutine* WorkStealingScheduler::next_local(Worker& worker) noexcept
+{
+    // 定期优先处理注入队列和让出队列，避免本地队列持续有任务时它们饥饿
+    if (++worker.tick % kFairnessInterval == 0) {
+        if (Coroutine* coroutine = take_injected(worker)) {
+            return coroutine;
+        }
+        if (Coroutine* coroutine = worker.yielded.pop_front()) {
+            return coroutine;
+        }
+    }
+
+    if (Coroutine* coroutine = worker.deque.pop()) {
+        return coroutine;
+    }
+
+    // 本地队列已空：一轮让出的协程放回本地队列，使它们可以被窃取
+    Coroutine* next = worker.yielded.pop_front();
+    if (next != nullptr && !worker.yielded.empty()) {
+        while (Coroutine* coroutine = worker.yielded.pop_front()) {
+            worker.deque.push(coroutine);
+        }
+        notify();
+    }
+    return next;
+}
+
+Coroutine* WorkStealingScheduler::take_injected(Worker& worker) noexcept
+{
+    if (injected_size_.load(std::memory_order_acquire) == 0) {
+        return nullptr;
+    }
+
+    // 一次取走一份 (注入队列长度按工作线程数均分)，余下的留给其他工作线程
+    IntrusiveList<Coroutine> share;
+    {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        const size_t take = (injected_.size() + workers_.size() - 1) / workers_.size();
+        for (size_t i = 0; i < take; ++i) {
+            share.push_back(injected_.pop_front());
+        }
+        injected_size_.fetch_sub(take, std::memory_order_relaxed);
+    }
+
+    Coroutine* coroutine = share.pop_front();
+    if (!share.empty()) {
+        worker.deque.push_batch(share.size(), [&share] { return share.pop_front(); });
+        notify();
+    }
+    return coroutine;
+}
+
+Coroutine* WorkStealingScheduler::steal(Worker& worker) noexcept
+{
+    const size_t count = workers_.size();
+    if (count < 2) {
+        return nullptr;
+    }
+
+    size_t start = worker.next_random() % count;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t index = (start + i) % count;
+        Worker& victim = *workers_[index];
+        if (&victim == &worker) {
+            continue;
+        }
+        if (Coroutine* coroutine = victim.deque.steal()) {
+            bump(worker.steals);
+            trace::record(trace::EventType::STEAL, coroutine->get_id(), static_cast<uint32_t>(index));
+            return coroutine;
+        }
+    }
+    return nullptr;
+}
+
+bool WorkStealingScheduler::has_visible_work() const noexcept
+{
+    if (injected_size_.load(std::memory_order_seq_cst) != 0) {
+        return true;
+    }
+    for (const auto& worker : workers_) {
+        if (!worker->deque.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingScheduler::park(Worker& worker) noexcept
+{
+    uint64_t epoch = park_epoch_.load(std::memory_order_acquire);
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+
+    // 与 notify() 构成 Dekker 式同步：要么这里看到新任务，要么 notify() 看到休眠者
+    if (has_visible_work() || stopping_.load(std::memory_order_seq_cst)) {
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+
+    bump(worker.parks);
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    park_cv_.wait(lock, [this, epoch] {
+        return park_epoch_.load(std::memory_order_acquire) != epoch
+            || stopping_.load(std::memory_order_acquire);
+    });
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void WorkStealingScheduler::notify(size_t count) noexcept
+{
+    // 有任务时其他工作线程都在运行，这里只有一次栅栏和一次读
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const size_t sleepers = static_cast<size_t>(sleepers_.load(std::memory_order_relaxed));
+    if (sleepers == 0 || count == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_epoch_.fetch_add(1, std::memory_order_release);
+    }
+    const size_t wakeups = count < sleepers ? count : sleepers;
+    for (size_t i = 0; i < wakeups; ++i) {
+        park_cv_.notify_one();
+    }
+    wakeups_.fetch_add(wakeups, std::memory_order_relaxed);
+}
+
+void WorkStealingScheduler::enqueue(Coroutine* coroutine) noexcept
+{
+    Worker* worker = current_worker();
+    if (worker != nullptr && worker->owner == this) {
+        worker->deque.push(coroutine);
+    } else {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        injected_.push_back(coroutine);
+        injected_size_.fetch_add(1, std::memory_order_release);
+    }
+    notify();
+}
+
+void WorkStealingScheduler::dispatch(Worker& worker, Coroutine* coroutine) noexcept
+{
+    coroutine->wake_state_.store(RUNNING, std::memory_order_relaxed);
+    worker.running = coroutine;
+    worker.action = WorkerAction::PARK;
+    bump(worker.dispatches);
+
+    Coroutine* returned = coroutine->switch_in();
+    worker.running = nullptr;
+
+    if (returned->is_finished()) {
+        retire(returned);
+        return;
+    }
+
+    if (worker.action == WorkerAction::YIELD) {
+        returned->wake_state_.store(QUEUED, std::memory_order_relaxed);
+        worker.yielded.push_back(returned);
+        return;
+    }
+
+    // 协程已完全切换出去，此后才允许其他线程恢复它
+    uint8_t expected = RUNNING;
+    if (!returned->wake_state_.compare_exchange_strong(expected, PARKED,
+            std::memory_order_acq_rel, std::memory_order_acquire)) {
+        // 切换出去前已收到唤醒
+        returned->wake_state_.store(QUEUED, std::memory_order_relaxed);
+        worker.deque.push(returned);
+        notify();
+    }
+}
+
+void WorkStealingScheduler::retire(Coroutine* coroutine) noexcept
+{
+    if (coroutine->exception_) {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        if (!exception_) {
+            exception_ = std::move(coroutine->exception_);
+        }
+        coroutine->exception_ = nullptr;
+    }
+    if (coroutine->is_finished()) {
+        finished_.fetch_add(1, std::memory_order_relaxed);
+    }
+    CoroutineDeleter()(coroutine);
+
+    if (live_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        done_cv_.notify_all();
+    }
+}
+
+} // namespace libco_oop
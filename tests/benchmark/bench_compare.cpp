@@ -0,0 +1,314 @@
+/**
+ * @file bench_compare.cpp
+ * @brief 与参照协程实现的对比基准
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 同一组负载分别运行在 libco-oop 和参照实现上：
+ * - Create: 创建一个立即返回的协程，运行到结束，销毁
+ * - Live:   range(0) 个永远让出的协程，轮流恢复；range(0)=1 即乒乓切换，
+ *           每次迭代两次切换，活跃协程增多时暴露栈和控制块的缓存效应
+ *
+ * ucontext 随 glibc 提供，始终参与对比；libco、libaco、boost.context
+ * 由 xmake 选项 bench_libco / bench_libaco / bench_boost 开启
+ * (定义 LIBCO_OOP_BENCH_LIBCO / LIBCO_OOP_BENCH_LIBACO / LIBCO_OOP_BENCH_BOOST)。
+ * 所有实现使用相同的栈大小；只有 libco-oop 的结果按 config:: 目标检查。
+ */
+
+#include "bench_helper.h"
+#include "libco_oop/coroutine.h"
+#include <cstdint>
+#include <memory>
+#include <ucontext.h>
+#include <vector>
+
+#ifdef LIBCO_OOP_BENCH_LIBCO
+#include <co_routine.h>
+#endif
+#ifdef LIBCO_OOP_BENCH_LIBACO
+extern "C" {
+#include <aco.h>
+}
+#endif
+#ifdef LIBCO_OOP_BENCH_BOOST
+#include <boost/context/detail/fcontext.hpp>
+#endif
+
+using namespace libco_oop;
+using namespace libco_oop::benchmark;
+
+namespace {
+
+constexpr size_t kStackSize = config::BENCH_STACK_SIZE;
+
+//============================================================================
+// 适配器
+//
+// 每个适配器提供：
+//   Handle spawn(bool yielder)  创建协程；yielder 为 true 时永远让出，否则立即返回
+//   void resume(Handle)         恢复协程直到它让出或结束
+//   void destroy(Handle)        销毁协程 (可以处于挂起状态)
+//============================================================================
+
+/**
+ * @brief libco-oop：Coroutine + 独立的 FixedStackAllocator
+ */
+struct LibcoOop {
+    static constexpr bool kChecked = true;
+    using Handle = Coroutine*;
+
+    static FixedStackAllocator& allocator()
+    {
+        thread_local FixedStackAllocator instance{StackOptions(kStackSize)};
+        return instance;
+    }
+
+    static Handle spawn(bool yielder)
+    {
+        CoroutineOptions opts;
+        opts.stack_allocator = &allocator();
+        if (yielder) {
+            return Coroutine::create([] {
+                for (;;) {
+                    Coroutine::yield();
+                }
+            }, opts).release();
+        }
+        return Coroutine::create([] {}, opts).release();
+    }
+
+    static void resume(Handle coroutine) { coroutine->resume(); }
+    static void destroy(Handle coroutine) { CoroutineDeleter()(coroutine); }
+};
+
+/**
+ * @brief glibc ucontext：每个协程 malloc 一个栈，swapcontext 切换
+ *
+ * swapcontext 每次切换都有一次 rt_sigprocmask 系统调用。
+ */
+struct Ucontext {
+    static constexpr bool kChecked = false;
+
+    struct Co {
+        ucontext_t context;
+        ucontext_t caller;
+        std::unique_ptr<char[]> stack;
+    };
+    using Handle = Co*;
+
+    static void yielder_entry(uint32_t high, uint32_t low)
+    {
+        Co* co = reinterpret_cast<Co*>((static_cast<uintptr_t>(high) << 32) | low);
+        for (;;) {
+            swapcontext(&co->context, &co->caller);
+        }
+    }
+
+    static void noop_entry() {}
+
+    static Handle spawn(bool yielder)
+    {
+        Co* co = new Co;
+        co->stack.reset(new char[kStackSize]);
+        getcontext(&co->context);
+        co->context.uc_stack.ss_sp = co->stack.get();
+        co->context.uc_stack.ss_size = kStackSize;
+        co->context.uc_link = &co->caller;      // 入口返回时回到调用者
+        if (yielder) {
+            const uintptr_t address = reinterpret_cast<uintptr_t>(co);
+            makecontext(&co->context, reinterpret_cast<void (*)()>(&yielder_entry), 2,
+                        static_cast<uint32_t>(address >> 32), static_cast<uint32_t>(address));
+        } else {
+            makecontext(&co->context, &noop_entry, 0);
+        }
+        return co;
+    }
+
+    static void resume(Handle co) { swapcontext(&co->caller, &co->context); }
+    static void destroy(Handle co) { delete co; }
+};
+
+#ifdef LIBCO_OOP_BENCH_LIBCO
+/**
+ * @brief Tencent libco：每个协程独立栈
+ */
+struct Libco {
+    static constexpr bool kChecked = false;
+    using Handle = stCoRoutine_t*;
+
+    static void* yielder_entry(void*)
+    {
+        for (;;) {
+            co_yield_ct();
+        }
+        return nullptr;
+    }
+
+    static void* noop_entry(void*) { return nullptr; }
+
+    static Handle spawn(bool yielder)
+    {
+        stCoRoutineAttr_t attr;
+        attr.stack_size = static_cast<int>(kStackSize);
+        stCoRoutine_t* co = nullptr;
+        co_create(&co, &attr, yielder ? &yielder_entry : &noop_entry, nullptr);
+        return co;
+    }
+
+    static void resume(Handle co) { co_resume(co); }
+    static void destroy(Handle co) { co_release(co); }
+};
+#endif
+
+#ifdef LIBCO_OOP_BENCH_LIBACO
+/**
+ * @brief libaco：每个协程一个独占的共享栈 (libaco 推荐的无拷贝用法)
+ */
+struct Libaco {
+    static constexpr bool kChecked = false;
+
+    struct Co {
+        aco_t* co;
+        aco_share_stack_t* stack;
+    };
+    using Handle = Co*;
+
+    static aco_t* main_co()
+    {
+        thread_local aco_t* instance = [] {
+            aco_thread_init(nullptr);
+            return aco_create(nullptr, nullptr, 0, nullptr, nullptr);
+        }();
+        return instance;
+    }
+
+    static void yielder_entry()
+    {
+        for (;;) {
+            aco_yield();
+        }
+    }
+
+    static void noop_entry() { aco_exit(); }
+
+    static Handle spawn(bool yielder)
+    {
+        Co* handle = new Co;
+        handle->stack = aco_share_stack_new(kStackSize);
+        handle->co = aco_create(main_co(), handle->stack, 0, yielder ? &yielder_entry : &noop_entry, nullptr);
+        return handle;
+    }
+
+    static void resume(Handle handle) { aco_resume(handle->co); }
+
+    static void destroy(Handle handle)
+    {
+        aco_destroy(handle->co);
+        aco_share_stack_destroy(handle->stack);
+        delete handle;
+    }
+};
+#endif
+
+#ifdef LIBCO_OOP_BENCH_BOOST
+/**
+ * @brief boost.context 的 fcontext 层 (make_fcontext/jump_fcontext)
+ *
+ * fcontext 的入口函数不能返回，立即结束的协程以跳回调用者代替返回，
+ * 之后不再被恢复。
+ */
+struct BoostContext {
+    static constexpr bool kChecked = false;
+
+    struct Co {
+        boost::context::detail::fcontext_t context;
+        std::unique_ptr<char[]> stack;
+    };
+    using Handle = Co*;
+
+    static void entry(boost::context::detail::transfer_t transfer)
+    {
+        for (;;) {
+            transfer = boost::context::detail::jump_fcontext(transfer.fctx, nullptr);
+        }
+    }
+
+    static Handle spawn(bool)
+    {
+        Co* co = new Co;
+        co->stack.reset(new char[kStackSize]);
+        co->context = boost::context::detail::make_fcontext(co->stack.get() + kStackSize, kStackSize, &entry);
+        return co;
+    }
+
+    static void resume(Handle co)
+    {
+        co->context = boost::context::detail::jump_fcontext(co->context, nullptr).fctx;
+    }
+
+    static void destroy(Handle co) { delete co; }
+};
+#endif
+
+//============================================================================
+// 负载
+//============================================================================
+
+template <typename Impl>
+void BM_Create(::benchmark::State& state)
+{
+    for (auto _ : state) {
+        typename Impl::Handle handle = Impl::spawn(false);
+        Impl::resume(handle);
+        Impl::destroy(handle);
+    }
+    if (Impl::kChecked) {
+        expect_ns_per_op(state, config::COROUTINE_CREATION_TARGET_NS);
+    }
+}
+
+template <typename Impl>
+void BM_Live(::benchmark::State& state)
+{
+    const size_t live = static_cast<size_t>(state.range(0));
+    std::vector<typename Impl::Handle> handles;
+    handles.reserve(live);
+    for (size_t i = 0; i < live; ++i) {
+        handles.push_back(Impl::spawn(true));
+        Impl::resume(handles.back());       // 换入一次，进入让出循环
+    }
+
+    size_t next = 0;
+    for (auto _ : state) {
+        Impl::resume(handles[next]);
+        if (++next == live) {
+            next = 0;
+        }
+    }
+
+    for (typename Impl::Handle handle : handles) {
+        Impl::destroy(handle);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);     // 每秒切换数
+    if (Impl::kChecked) {
+        expect_ns_per_op(state, config::COROUTINE_SWITCH_TARGET_NS, 2);
+    }
+}
+
+#define LIBCO_OOP_COMPARE(Impl)                                                             \
+    BENCHMARK_TEMPLATE(BM_Create, Impl);                                                    \
+    BENCHMARK_TEMPLATE(BM_Live, Impl)->RangeMultiplier(8)->Range(1, config::LIVE_COROUTINES_MAX)
+
+LIBCO_OOP_COMPARE(LibcoOop);
+LIBCO_OOP_COMPARE(Ucontext);
+#ifdef LIBCO_OOP_BENCH_LIBCO
+LIBCO_OOP_COMPARE(Libco);
+#endif
+#ifdef LIBCO_OOP_BENCH_LIBACO
+LIBCO_OOP_COMPARE(Libaco);
+#endif
+#ifdef LIBCO_OOP_BENCH_BOOST
+LIBCO_OOP_COMPARE(BoostContext);
+#endif
+
+} // namespace
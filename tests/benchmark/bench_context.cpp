@@ -0,0 +1,172 @@
+/**
+ * @file bench_context.cpp
+ * @brief 上下文切换基准
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 主上下文与一个在独立栈上运行的上下文之间乒乓切换，每次迭代两次切换：
+ * - Context::swap 的 COMPLETE/MINIMAL 模式，各自带和不带FPU保存
+ * - 编译期策略组合 FastContext/FpuContext 的 swap_unchecked
+ * - 直接调用汇编入口 libco_oop_context_swap / libco_oop_context_swap_minimal
+ */
+
+#include "bench_helper.h"
+#include "libco_oop/context.h"
+#include <cstring>
+#include <memory>
+
+using namespace libco_oop;
+using namespace libco_oop::benchmark;
+
+namespace {
+
+constexpr size_t kStackSize = config::BENCH_STACK_SIZE;
+
+//============================================================================
+// BasicContext 乒乓
+//============================================================================
+
+/**
+ * @brief 任意 BasicContext 组合的乒乓环境
+ */
+template <typename Ctx, bool Unchecked>
+struct PingPong {
+    static Ctx* main_ctx;
+    static Ctx* co_ctx;
+
+    LIBCO_OOP_CONTEXT_ENTRY
+    static void entry()
+    {
+        for (;;) {
+            if (Unchecked) {
+                co_ctx->swap_unchecked(*main_ctx);
+            } else {
+                co_ctx->swap(*main_ctx);
+            }
+        }
+    }
+
+    static void run(::benchmark::State& state, Ctx& main, Ctx& co)
+    {
+        std::unique_ptr<char[]> stack(new char[kStackSize]);
+        co.set_stack_pointer(stack.get() + kStackSize);
+        co.set_instruction_pointer(reinterpret_cast<void*>(&entry));
+        main.save();
+        main_ctx = &main;
+        co_ctx = &co;
+
+        for (auto _ : state) {
+            if (Unchecked) {
+                main.swap_unchecked(co);
+            } else if (!main.swap(co)) {
+                state.SkipWithError("Context::swap failed");
+                break;
+            }
+        }
+        expect_ns_per_op(state, config::COROUTINE_SWITCH_TARGET_NS, 2);
+    }
+};
+
+template <typename Ctx, bool Unchecked>
+Ctx* PingPong<Ctx, Unchecked>::main_ctx = nullptr;
+template <typename Ctx, bool Unchecked>
+Ctx* PingPong<Ctx, Unchecked>::co_ctx = nullptr;
+
+/**
+ * @brief Context::swap，参数为 (minimal, fpu)
+ */
+void BM_ContextSwap(::benchmark::State& state)
+{
+    const ContextConfig config(state.range(0) ? ContextMode::MINIMAL : ContextMode::COMPLETE,
+                               state.range(1) != 0);
+    Context main_ctx(config), co_ctx(config);
+    PingPong<Context, false>::run(state, main_ctx, co_ctx);
+}
+BENCHMARK(BM_ContextSwap)
+    ->ArgNames({"minimal", "fpu"})
+    ->Args({0, 1})
+    ->Args({0, 0})
+    ->Args({1, 1})
+    ->Args({1, 0});
+
+/**
+ * @brief 编译期保存策略，无校验无计数
+ */
+template <typename Ctx>
+void BM_PolicyContextSwap(::benchmark::State& state)
+{
+    Ctx main_ctx, co_ctx;
+    PingPong<Ctx, true>::run(state, main_ctx, co_ctx);
+}
+BENCHMARK_TEMPLATE(BM_PolicyContextSwap, FastContext);
+BENCHMARK_TEMPLATE(BM_PolicyContextSwap, FpuContext);
+
+//============================================================================
+// 汇编入口
+//============================================================================
+
+RegisterState g_main_regs;
+RegisterState g_co_regs;
+bool g_save_fpu = false;
+
+LIBCO_OOP_CONTEXT_ENTRY
+void raw_entry()
+{
+    for (;;) {
+        libco_oop_context_swap(&g_co_regs, &g_main_regs, g_save_fpu);
+    }
+}
+
+LIBCO_OOP_CONTEXT_ENTRY
+void raw_minimal_entry()
+{
+    for (;;) {
+        libco_oop_context_swap_minimal(&g_co_regs, &g_main_regs);
+    }
+}
+
+/**
+ * @brief 准备一对寄存器状态，协程侧从 entry 开始执行
+ */
+void prepare_registers(char* stack, void (*entry)())
+{
+    for (RegisterState* regs : {&g_main_regs, &g_co_regs}) {
+        std::memset(regs, 0, sizeof(*regs));
+        context_utils::init_fpu_state(*regs);   // 与 BasicContext 的初始值一致，避免恢复出全零控制字
+    }
+    g_co_regs.rsp = context_utils::align_stack_pointer(stack + kStackSize);
+    g_co_regs.rip = reinterpret_cast<void*>(entry);
+}
+
+/**
+ * @brief libco_oop_context_swap，参数为是否保存FPU
+ */
+void BM_RawContextSwap(::benchmark::State& state)
+{
+    std::unique_ptr<char[]> stack(new char[kStackSize]);
+    prepare_registers(stack.get(), &raw_entry);
+    g_save_fpu = state.range(0) != 0;
+
+    for (auto _ : state) {
+        libco_oop_context_swap(&g_main_regs, &g_co_regs, g_save_fpu);
+    }
+    expect_ns_per_op(state, config::COROUTINE_SWITCH_TARGET_NS, 2);
+}
+BENCHMARK(BM_RawContextSwap)->ArgName("fpu")->Arg(1)->Arg(0);
+
+/**
+ * @brief libco_oop_context_swap_minimal
+ */
+void BM_RawContextSwapMinimal(::benchmark::State& state)
+{
+    std::unique_ptr<char[]> stack(new char[kStackSize]);
+    prepare_registers(stack.get(), &raw_minimal_entry);
+
+    for (auto _ : state) {
+        libco_oop_context_swap_minimal(&g_main_regs, &g_co_regs);
+    }
+    expect_ns_per_op(state, config::COROUTINE_SWITCH_TARGET_NS, 2);
+}
+BENCHMARK(BM_RawContextSwapMinimal);
+
+} // namespace
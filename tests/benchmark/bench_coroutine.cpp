@@ -0,0 +1,264 @@
+/**
+ * @file bench_coroutine.cpp
+ * @brief 协程创建、内存占用与调度基准
+ * @author libco-oop
+ * @version 1.0
+ *
+ * - 每种栈分配器下创建、运行到结束、销毁一个协程的耗时，以及协程池复用的耗时
+ * - 共享栈上挂起协程的每协程内存占用
+ * - Scheduler 的调度吞吐 (每秒切换数) 与活跃协程数的关系，暴露缓存效应
+ * - 扇出场景下 spawn_batch() 与逐个 spawn() 的每协程开销 (单线程与工作窃取调度器)
+ */
+
+#include "bench_helper.h"
+#include "libco_oop/coroutine_pool.h"
+#include "libco_oop/scheduler.h"
+#include "libco_oop/work_stealing.h"
+#include <atomic>
+#include <vector>
+
+using namespace libco_oop;
+using namespace libco_oop::benchmark;
+
+namespace {
+
+//============================================================================
+// 创建与销毁
+//============================================================================
+
+/**
+ * @brief 以给定选项循环创建、运行、销毁协程
+ */
+void run_creation(::benchmark::State& state, const CoroutineOptions& opts)
+{
+    for (auto _ : state) {
+        CoroutinePtr coroutine = Coroutine::create([] {}, opts);
+        if (!coroutine) {
+            state.SkipWithError("Coroutine::create failed");
+            break;
+        }
+        coroutine->resume();
+    }
+    expect_ns_per_op(state, config::COROUTINE_CREATION_TARGET_NS);
+}
+
+// 每线程默认的 FixedStackAllocator，栈池已预热
+void BM_CreateFixedPooled(::benchmark::State& state)
+{
+    FixedStackAllocator::local().reserve(1);
+    run_creation(state, CoroutineOptions{});
+}
+BENCHMARK(BM_CreateFixedPooled);
+
+// 不缓存空闲栈，每次创建都 mmap + mprotect，销毁都 munmap
+void BM_CreateFixedUncached(::benchmark::State& state)
+{
+    FixedStackAllocator allocator(StackOptions(config::BENCH_STACK_SIZE, true, 0));
+    CoroutineOptions opts;
+    opts.stack_allocator = &allocator;
+    run_creation(state, opts);
+}
+BENCHMARK(BM_CreateFixedUncached);
+
+void BM_CreateShared(::benchmark::State& state)
+{
+    SharedStackAllocator allocator(1);
+    CoroutineOptions opts;
+    opts.stack_allocator = &allocator;
+    run_creation(state, opts);
+}
+BENCHMARK(BM_CreateShared);
+
+// 没有画像时混合栈策略绑定共享栈，测的是 bind/unbind 的额外开销
+void BM_CreateHybrid(::benchmark::State& state)
+{
+    HybridStackAllocator allocator;
+    CoroutineOptions opts;
+    opts.hybrid = &allocator;
+    run_creation(state, opts);
+}
+BENCHMARK(BM_CreateHybrid);
+
+// 协程池命中：复用结束的协程 (控制块、上下文和栈)，与 BM_CreateFixedPooled 对比
+void BM_CreateFromCoroutinePool(::benchmark::State& state)
+{
+    CoroutinePool pool;
+    pool.reserve(1);
+    for (auto _ : state) {
+        CoroutinePtr coroutine = pool.acquire([] {});
+        if (!coroutine) {
+            state.SkipWithError("CoroutinePool::acquire failed");
+            break;
+        }
+        coroutine->resume();
+    }
+    expect_ns_per_op(state, config::COROUTINE_CREATION_TARGET_NS);
+}
+BENCHMARK(BM_CreateFromCoroutinePool);
+
+//============================================================================
+// 内存占用
+//============================================================================
+
+/**
+ * @brief range(0) 个协程共用一个共享栈，各自挂起在一个小栈帧上
+ *
+ * 每协程内存 = 控制块 + 保存缓冲区。每次迭代创建并换入全部协程，
+ * 时间目标按每个协程计。
+ */
+void BM_SharedStackFootprint(::benchmark::State& state)
+{
+    const size_t count = static_cast<size_t>(state.range(0));
+    SharedStackAllocator allocator(1);
+    CoroutineOptions opts;
+    opts.stack_allocator = &allocator;
+    std::vector<CoroutinePtr> coroutines;
+    coroutines.reserve(count);
+    double bytes_per_coroutine = 0;
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i) {
+            coroutines.push_back(Coroutine::create([] {
+                volatile char frame[256] = {};
+                Coroutine::yield();
+                ::benchmark::DoNotOptimize(frame[0]);
+            }, opts));
+            coroutines.back()->resume();
+        }
+        const SaveBufferStatistics buffers = allocator.get_buffer_pool().get_statistics();
+        bytes_per_coroutine = static_cast<double>(buffers.bytes_in_use) / static_cast<double>(count)
+                            + static_cast<double>(sizeof(Coroutine));
+        coroutines.clear();
+    }
+    expect_ns_per_op(state, config::COROUTINE_CREATION_TARGET_NS, static_cast<double>(count));
+    expect_at_most(state, "bytes_per_coroutine", bytes_per_coroutine,
+                   static_cast<double>(config::MEMORY_USAGE_TARGET_BYTES));
+}
+BENCHMARK(BM_SharedStackFootprint)->Arg(1024);
+
+//============================================================================
+// 调度吞吐与活跃协程数
+//============================================================================
+
+/**
+ * @brief range(0) 个活跃协程轮流让出
+ *
+ * 计时循环本身运行在其中一个协程里，每次迭代是一整轮调度，
+ * 即一个让出的协程再次被调度所需的时间，按调度延迟目标检查；
+ * items_per_second 是每秒调度次数。
+ */
+void BM_SchedulerRound(::benchmark::State& state)
+{
+    const int64_t live = state.range(0);
+    FixedStackAllocator allocator(StackOptions(config::BENCH_STACK_SIZE));
+    CoroutineOptions opts;
+    opts.stack_allocator = &allocator;
+    Scheduler scheduler;
+    bool done = false;
+
+    for (int64_t i = 1; i < live; ++i) {
+        scheduler.spawn([&done] {
+            while (!done) {
+                Scheduler::yield();
+            }
+        }, opts);
+    }
+    scheduler.spawn([&] {
+        Scheduler::yield();         // 先让所有协程换入一次
+        for (auto _ : state) {
+            Scheduler::yield();
+        }
+        done = true;
+    }, opts);
+    scheduler.run();
+
+    state.SetItemsProcessed(state.iterations() * live);
+    expect_ns_per_op(state, static_cast<double>(config::SCHEDULING_LATENCY_TARGET_US) * 1000);
+}
+BENCHMARK(BM_SchedulerRound)->RangeMultiplier(8)->Range(1, config::LIVE_COROUTINES_MAX);
+
+//============================================================================
+// 扇出：批量派生与逐个派生
+//============================================================================
+
+/**
+ * @brief 每次迭代派生 range(0) 个协程并运行到全部结束
+ * @param batched 使用 spawn_batch() 还是逐个 spawn()
+ */
+void run_fan_out(::benchmark::State& state, bool batched)
+{
+    std::vector<int> shards(static_cast<size_t>(state.range(0)));
+    FixedStackAllocator allocator(StackOptions(config::BENCH_STACK_SIZE, true, shards.size()));
+    allocator.reserve(shards.size());
+    CoroutineOptions opts;
+    opts.stack_allocator = &allocator;
+    Scheduler scheduler;
+    int done = 0;
+    auto query = [&done](int) { ++done; };
+
+    for (auto _ : state) {
+        if (batched) {
+            scheduler.spawn_batch(shards.begin(), shards.end(), query, opts);
+        } else {
+            for (int shard : shards) {
+                scheduler.spawn([&query, shard] { query(shard); }, opts);
+            }
+        }
+        scheduler.run();
+    }
+    ::benchmark::DoNotOptimize(done);
+    expect_ns_per_op(state, config::COROUTINE_CREATION_TARGET_NS, static_cast<double>(shards.size()));
+}
+
+/**
+ * @brief 外部线程向工作窃取调度器扇出 range(0) 个协程并等待全部结束
+ *
+ * 逐个提交时每个协程都要加锁进入注入队列并检查休眠者；批量提交只加锁一次。
+ */
+void run_work_stealing_fan_out(::benchmark::State& state, bool batched)
+{
+    std::vector<int> shards(static_cast<size_t>(state.range(0)));
+    WorkStealingOptions ws_opts;
+    ws_opts.worker_count = 2;
+    WorkStealingScheduler scheduler(ws_opts);
+    std::atomic<int> done{0};
+    auto query = [&done](int) { done.fetch_add(1, std::memory_order_relaxed); };
+
+    for (auto _ : state) {
+        if (batched) {
+            scheduler.spawn_batch(shards.begin(), shards.end(), query);
+        } else {
+            for (int shard : shards) {
+                scheduler.spawn([&query, shard] { query(shard); });
+            }
+        }
+        scheduler.wait();
+    }
+    expect_ns_per_op(state, config::COROUTINE_CREATION_TARGET_NS, static_cast<double>(shards.size()));
+}
+
+void BM_FanOutSpawnEach(::benchmark::State& state)
+{
+    run_fan_out(state, false);
+}
+BENCHMARK(BM_FanOutSpawnEach)->Arg(64)->Arg(512);
+
+void BM_FanOutSpawnBatch(::benchmark::State& state)
+{
+    run_fan_out(state, true);
+}
+BENCHMARK(BM_FanOutSpawnBatch)->Arg(64)->Arg(512);
+
+void BM_WorkStealingFanOutEach(::benchmark::State& state)
+{
+    run_work_stealing_fan_out(state, false);
+}
+BENCHMARK(BM_WorkStealingFanOutEach)->Arg(64)->Arg(512)->UseRealTime();
+
+void BM_WorkStealingFanOutBatch(::benchmark::State& state)
+{
+    run_work_stealing_fan_out(state, true);
+}
+BENCHMARK(BM_WorkStealingFanOutBatch)->Arg(64)->Arg(512)->UseRealTime();
+
+} // namespace
@@ -1,140 +1,74 @@
 #pragma once
 
 #include <benchmark/benchmark.h>
-#include <functional>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 
 namespace libco_oop {
 namespace benchmark {
 
-/**
- * @brief 性能测试辅助工具类
- * 
- * 提供性能测试的通用功能和工具
- */
-class BenchmarkHelper {
-public:
-    /**
-     * @brief 生成随机数据用于性能测试
-     * @param size 数据大小
-     * @return 随机数据向量
-     */
-    static std::vector<int> generate_random_data(size_t size);
-    
-    /**
-     * @brief 预热CPU，确保性能测试的准确性
-     * @param iterations 预热迭代次数
-     */
-    static void warmup_cpu(int iterations = 1000000);
-    
-    /**
-     * @brief 创建计算密集型工作负载
-     * @param complexity 复杂度级别
-     * @return 工作负载函数
-     */
-    static std::function<void()> create_cpu_intensive_workload(int complexity = 1000);
-    
-    /**
-     * @brief 创建内存密集型工作负载
-     * @param memory_size 内存大小（字节）
-     * @return 工作负载函数
-     */
-    static std::function<void()> create_memory_intensive_workload(size_t memory_size = 1024 * 1024);
-};
-
-/**
- * @brief 协程性能测试辅助类
- * 
- * 专门用于协程相关的性能测试
- */
-class CoroutineBenchmarkHelper {
-public:
-    /**
-     * @brief 创建简单的协程函数用于性能测试
-     * @return 协程函数
-     */
-    static std::function<void()> create_simple_coroutine();
-    
-    /**
-     * @brief 创建会yield的协程函数
-     * @param yield_count yield次数
-     * @return 协程函数
-     */
-    static std::function<void()> create_yielding_coroutine(int yield_count = 10);
-    
-    /**
-     * @brief 创建计算密集型协程函数
-     * @param iterations 计算迭代次数
-     * @return 协程函数
-     */
-    static std::function<void()> create_compute_coroutine(int iterations = 1000);
-};
-
-/**
- * @brief 性能测试宏定义
- */
-
-// 基础性能测试宏
-#define BENCHMARK_COROUTINE_CREATION(name) \
-    static void BM_##name(::benchmark::State& state) { \
-        for (auto _ : state) { \
-            /* 协程创建性能测试代码 */ \
-            ::benchmark::DoNotOptimize(state.iterations()); \
-        } \
-    } \
-    BENCHMARK(BM_##name)
-
-// 协程切换性能测试宏
-#define BENCHMARK_COROUTINE_SWITCH(name) \
-    static void BM_##name(::benchmark::State& state) { \
-        for (auto _ : state) { \
-            /* 协程切换性能测试代码 */ \
-            ::benchmark::DoNotOptimize(state.iterations()); \
-        } \
-    } \
-    BENCHMARK(BM_##name)
-
-// 内存使用性能测试宏
-#define BENCHMARK_MEMORY_USAGE(name) \
-    static void BM_##name(::benchmark::State& state) { \
-        for (auto _ : state) { \
-            /* 内存使用性能测试代码 */ \
-            ::benchmark::DoNotOptimize(state.iterations()); \
-        } \
-        state.SetBytesProcessed(state.iterations() * sizeof(int)); \
-    } \
-    BENCHMARK(BM_##name)
-
-// 吞吐量性能测试宏
-#define BENCHMARK_THROUGHPUT(name) \
-    static void BM_##name(::benchmark::State& state) { \
-        for (auto _ : state) { \
-            /* 吞吐量性能测试代码 */ \
-            ::benchmark::DoNotOptimize(state.iterations()); \
-        } \
-        state.SetItemsProcessed(state.iterations()); \
-    } \
-    BENCHMARK(BM_##name)
-
 /**
  * @brief 性能测试配置常量
  */
 namespace config {
     // 默认的性能测试迭代次数
     constexpr int DEFAULT_ITERATIONS = 1000000;
-    
-    // 协程创建性能目标（纳秒）
+
+    // 协程创建性能目标（纳秒，创建 + 运行到结束 + 销毁）
     constexpr int64_t COROUTINE_CREATION_TARGET_NS = 1000;
-    
-    // 协程切换性能目标（纳秒）
+
+    // 协程切换性能目标（纳秒，单次切换）
     constexpr int64_t COROUTINE_SWITCH_TARGET_NS = 20;
-    
+
     // 内存使用目标（字节每协程）
     constexpr size_t MEMORY_USAGE_TARGET_BYTES = 4096;
-    
-    // 调度延迟目标（微秒）
+
+    // 调度延迟目标（微秒，一个让出的协程再次被调度所需的时间）
     constexpr int64_t SCHEDULING_LATENCY_TARGET_US = 100;
+
+    // 所有基准 (包括参照实现) 统一使用的协程栈大小
+    constexpr size_t BENCH_STACK_SIZE = 64 * 1024;
+
+    // 活跃协程数扫描的上限
+    constexpr int64_t LIVE_COROUTINES_MAX = 4096;
+}
+
+/**
+ * @brief 目标检查使用的计数器名
+ *
+ * 名字以 kTargetSuffix 结尾的计数器是目标值，去掉后缀即被检查的计数器；
+ * kNsPerOp 不是计数器，由 bench_main.cpp 中的报告器按
+ * 每次迭代耗时 / kOpsPerIteration 计算。测得值不超过目标即达标。
+ */
+constexpr const char* kTargetSuffix = "_target";
+constexpr const char* kNsPerOp = "ns_per_op";
+constexpr const char* kOpsPerIteration = "ops_per_iter";
+
+/**
+ * @brief 为基准登记时间目标
+ * @param state 基准状态
+ * @param target_ns 每次操作的目标耗时 (纳秒)
+ * @param ops_per_iteration 每次迭代包含的操作数 (例如乒乓切换为2)
+ */
+inline void expect_ns_per_op(::benchmark::State& state, double target_ns, double ops_per_iteration = 1)
+{
+    state.counters[kOpsPerIteration] = ops_per_iteration;
+    state.counters[std::string(kNsPerOp) + kTargetSuffix] = target_ns;
+}
+
+/**
+ * @brief 为基准登记一个计数器及其上限
+ * @param state 基准状态
+ * @param name 计数器名
+ * @param value 测得值
+ * @param target 目标上限
+ */
+inline void expect_at_most(::benchmark::State& state, const std::string& name, double value, double target)
+{
+    state.counters[name] = value;
+    state.counters[name + kTargetSuffix] = target;
 }
 
 } // namespace benchmark
-} // namespace libco_oop 
\ No newline at end of file
+} // namespace libco_oop
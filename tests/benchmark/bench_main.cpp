@@ -1,34 +1,127 @@
-#include <benchmark/benchmark.h>
+#include "bench_helper.h"
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <vector>
+
+using namespace libco_oop::benchmark;
+
+namespace {
+
+/**
+ * @brief 在控制台输出之外按 config:: 目标检查每个基准
+ *
+ * 基准通过 expect_ns_per_op()/expect_at_most() 登记目标，
+ * 结束时输出达标/未达标汇总。
+ */
+class TargetReporter : public ::benchmark::ConsoleReporter {
+public:
+    void ReportRuns(const std::vector<Run>& reports) override
+    {
+        ConsoleReporter::ReportRuns(reports);
+        for (const Run& run : reports) {
+            // 重复运行时只检查均值
+            if (run.error_occurred ||
+                (run.run_type == Run::RT_Aggregate && run.aggregate_name != "mean")) {
+                continue;
+            }
+            check(run);
+        }
+    }
+
+    void Finalize() override
+    {
+        ConsoleReporter::Finalize();
+        std::ostream& out = GetOutputStream();
+        out << "=== Targets: " << (checks_ - misses_.size()) << "/" << checks_ << " met ===" << std::endl;
+        for (const std::string& miss : misses_) {
+            out << "  MISS " << miss << std::endl;
+        }
+    }
+
+    size_t miss_count() const noexcept { return misses_.size(); }
+
+private:
+    size_t checks_ = 0;
+    std::vector<std::string> misses_;
+
+    void check(const Run& run)
+    {
+        const size_t suffix_length = std::strlen(kTargetSuffix);
+        for (const auto& entry : run.counters) {
+            const std::string& key = entry.first;
+            if (key.size() <= suffix_length ||
+                key.compare(key.size() - suffix_length, suffix_length, kTargetSuffix) != 0) {
+                continue;
+            }
+            const std::string name = key.substr(0, key.size() - suffix_length);
+            double measured = 0;
+            if (name == kNsPerOp) {
+                auto ops = run.counters.find(kOpsPerIteration);
+                const double per_iteration = run.iterations > 0
+                    ? run.real_accumulated_time * 1e9 / static_cast<double>(run.iterations) : 0;
+                measured = per_iteration / (ops != run.counters.end() && ops->second.value > 0
+                                                ? ops->second.value : 1);
+            } else {
+                auto counter = run.counters.find(name);
+                if (counter == run.counters.end()) {
+                    continue;
+                }
+                measured = counter->second.value;
+            }
+            ++checks_;
+            if (measured > entry.second.value) {
+                misses_.push_back(run.benchmark_name() + ": " + name + " " + std::to_string(measured) +
+                                  " > " + std::to_string(entry.second.value));
+            }
+        }
+    }
+};
+
+} // namespace
 
 /**
  * @brief LibCo-OOP 性能基准测试主函数
- * 
- * 初始化Google Benchmark框架，运行所有性能测试
+ *
+ * 初始化Google Benchmark框架，运行所有性能测试并按目标检查。
+ * 传入 --enforce_targets 时有未达标的基准则返回非零。
  */
 int main(int argc, char** argv) {
+    // 先取出本程序自己的参数，其余交给 Google Benchmark
+    bool enforce_targets = false;
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--enforce_targets") == 0) {
+            enforce_targets = true;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
     // 初始化 Google Benchmark
     ::benchmark::Initialize(&argc, argv);
-    
+
     // 检查是否有错误
     if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
         return 1;
     }
-    
+
     // 输出基准测试开始信息
     std::cout << "=== LibCo-OOP Performance Benchmarks ===" << std::endl;
     std::cout << "Running benchmarks with Google Benchmark framework" << std::endl;
     std::cout << "=============================================" << std::endl;
-    
+
     // 运行所有基准测试
-    ::benchmark::RunSpecifiedBenchmarks();
-    
+    TargetReporter reporter;
+    ::benchmark::RunSpecifiedBenchmarks(&reporter);
+
     // 输出基准测试结束信息
     std::cout << "=============================================" << std::endl;
     std::cout << "Benchmark tests completed!" << std::endl;
-    
+
     // 关闭基准测试框架
     ::benchmark::Shutdown();
-    
-    return 0;
-} 
\ No newline at end of file
+
+    return enforce_targets && reporter.miss_count() > 0 ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "../benchmark/bench_helper.h"
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace libco_oop {
+namespace stress {
+
+/**
+ * @brief 压力场景的规模参数
+ *
+ * 默认值按一台 4GB 内存、默认 vm.max_map_count 的机器选取，
+ * 容量评估时通过命令行放大 (见 stress_main.cpp)。
+ */
+struct StressOptions {
+    size_t coroutines = 1000000;        ///< 内存场景每种栈策略同时存活的协程数
+    std::vector<size_t> threads;        ///< 环形场景的工作线程数，空表示 1, 2, 4 ... CPU 核数
+    size_t ring_size = 1024;            ///< 每个环的协程数 (2 即乒乓)
+    size_t rings = 1;                   ///< 环数
+    size_t tokens = 64;                 ///< 每个环中同时传递的令牌数
+    size_t hops = 2000000;              ///< 环形场景每轮的令牌传递总数
+    size_t connections = 16;            ///< 回显场景的并发连接数
+    size_t requests = 5000;             ///< 回显场景每个连接的请求数
+    size_t payload = 64;                ///< 回显场景每个请求的字节数
+    bool enforce_targets = false;       ///< 有未达标的指标时返回非零
+
+    /**
+     * @brief 解析一个 --name=value 形式的参数
+     * @return bool 不是本程序的参数时返回 false
+     */
+    bool parse(const char* arg)
+    {
+        if (std::strcmp(arg, "--enforce_targets") == 0) {
+            enforce_targets = true;
+            return true;
+        }
+        const char* value = nullptr;
+        if ((value = match(arg, "--threads="))) {
+            threads.clear();
+            for (const char* p = value; *p != '\0';) {
+                char* end = nullptr;
+                const size_t count = std::strtoul(p, &end, 10);
+                if (end == p) {
+                    break;
+                }
+                threads.push_back(count);
+                p = *end == ',' ? end + 1 : end;
+            }
+            return true;
+        }
+        struct Field {
+            const char* prefix;
+            size_t* target;
+        };
+        const Field fields[] = {
+            {"--coroutines=", &coroutines}, {"--ring_size=", &ring_size}, {"--rings=", &rings},
+            {"--tokens=", &tokens}, {"--hops=", &hops}, {"--connections=", &connections},
+            {"--requests=", &requests}, {"--payload=", &payload},
+        };
+        for (const Field& field : fields) {
+            if ((value = match(arg, field.prefix))) {
+                *field.target = std::strtoul(value, nullptr, 10);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 环形场景要运行的工作线程数列表
+     */
+    std::vector<size_t> thread_counts() const
+    {
+        if (!threads.empty()) {
+            return threads;
+        }
+        const size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        std::vector<size_t> counts;
+        for (size_t n = 1; n < cores; n *= 2) {
+            counts.push_back(n);
+        }
+        counts.push_back(cores);
+        return counts;
+    }
+
+private:
+    static const char* match(const char* arg, const char* prefix)
+    {
+        const size_t length = std::strlen(prefix);
+        return std::strncmp(arg, prefix, length) == 0 ? arg + length : nullptr;
+    }
+};
+
+/**
+ * @brief 全局规模参数，main() 在运行测试之前填写
+ */
+inline StressOptions& options()
+{
+    static StressOptions instance;
+    return instance;
+}
+
+/**
+ * @brief 按 config:: 目标汇总压力场景的测量结果
+ *
+ * 与 bench_main.cpp 中的报告器相同：测得值不超过目标即达标，
+ * 结束时输出达标/未达标汇总。只记录不检查的指标用于容量估算。
+ */
+class StressReport {
+public:
+    /**
+     * @brief 记录一个指标
+     */
+    void record(const std::string& scenario, const std::string& name, double value, const char* unit)
+    {
+        std::printf("  %-28s %-24s %14.1f %s\n", scenario.c_str(), name.c_str(), value, unit);
+    }
+
+    /**
+     * @brief 记录一个指标并按目标上限检查
+     */
+    void expect_at_most(const std::string& scenario, const std::string& name, double value,
+                        double target, const char* unit)
+    {
+        std::printf("  %-28s %-24s %14.1f %s (target <= %.0f)\n", scenario.c_str(), name.c_str(),
+                    value, unit, target);
+        ++checks_;
+        if (value > target) {
+            misses_.push_back(scenario + ": " + name + " " + std::to_string(value) + " > " +
+                              std::to_string(target));
+        }
+    }
+
+    void print_summary(std::ostream& out) const
+    {
+        out << "=== Targets: " << (checks_ - misses_.size()) << "/" << checks_ << " met ===" << std::endl;
+        for (const std::string& miss : misses_) {
+            out << "  MISS " << miss << std::endl;
+        }
+    }
+
+    size_t miss_count() const noexcept { return misses_.size(); }
+
+private:
+    size_t checks_ = 0;
+    std::vector<std::string> misses_;
+};
+
+inline StressReport& report()
+{
+    static StressReport instance;
+    return instance;
+}
+
+/**
+ * @brief 当前进程的驻留内存 (字节)
+ */
+inline size_t rss_bytes()
+{
+    size_t pages = 0;
+    size_t resident = 0;
+    if (FILE* file = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(file, "%zu %zu", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        std::fclose(file);
+    }
+    return resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+/**
+ * @brief vm.max_map_count，读取失败时返回内核默认值
+ */
+inline size_t max_map_count()
+{
+    size_t count = 65530;
+    if (FILE* file = std::fopen("/proc/sys/vm/max_map_count", "r")) {
+        if (std::fscanf(file, "%zu", &count) != 1) {
+            count = 65530;
+        }
+        std::fclose(file);
+    }
+    return count;
+}
+
+inline uint64_t now_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief 样本的 q 分位数 (0 < q < 1)，会重排样本
+ */
+inline uint64_t percentile(std::vector<uint64_t>& samples, double q)
+{
+    if (samples.empty()) {
+        return 0;
+    }
+    const size_t index = std::min(samples.size() - 1, static_cast<size_t>(q * static_cast<double>(samples.size())));
+    std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+    return samples[index];
+}
+
+} // namespace stress
+} // namespace libco_oop
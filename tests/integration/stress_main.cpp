@@ -0,0 +1,43 @@
+#include "stress_helper.h"
+#include <gtest/gtest.h>
+#include <iostream>
+
+using namespace libco_oop::stress;
+
+/**
+ * @brief LibCo-OOP 压力与扩展性测试主函数
+ *
+ * 先取出规模参数 (--coroutines=、--threads=1,2,4、--connections= 等，见 StressOptions)，
+ * 其余交给 Google Test。结束时按 config:: 目标输出汇总；
+ * 传入 --enforce_targets 时有未达标的指标则返回非零。
+ */
+int main(int argc, char** argv) {
+    StressOptions& opts = options();
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!opts.parse(argv[i])) {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    // 初始化Google Test框架
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::FLAGS_gtest_print_time = true;
+
+    std::cout << "=== LibCo-OOP Stress Tests ===" << std::endl;
+    std::cout << "coroutines=" << opts.coroutines << " ring_size=" << opts.ring_size
+              << " rings=" << opts.rings << " tokens=" << opts.tokens << " hops=" << opts.hops
+              << " connections=" << opts.connections << " requests=" << opts.requests
+              << " payload=" << opts.payload << std::endl;
+    std::cout << "=================================" << std::endl;
+
+    int result = RUN_ALL_TESTS();
+
+    std::cout << "=================================" << std::endl;
+    report().print_summary(std::cout);
+    if (result == 0 && opts.enforce_targets && report().miss_count() > 0) {
+        result = 1;
+    }
+    return result;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file test_stress_echo.cpp
+ * @brief 回显服务器的负载与尾延迟
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 服务器线程上的 IOManager 为每个连接运行一个回显协程；负载线程上的
+ * IOManager 以 options().connections 个闭环连接各发送 options().requests 个
+ * options().payload 字节的请求，记录每个请求的往返时间。两种后端分别运行，
+ * 报告吞吐和 p50/p99/p999，p99 按调度延迟目标检查。
+ */
+
+#include "stress_helper.h"
+#include "libco_oop/io_manager.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace libco_oop;
+using namespace libco_oop::stress;
+
+namespace {
+
+namespace targets = libco_oop::benchmark::config;
+
+/**
+ * @brief 读满或写满 length 字节
+ * @return bool 对端关闭或出错时返回 false
+ */
+template <typename Op>
+bool transfer_all(Op op, char* buffer, size_t length)
+{
+    size_t done = 0;
+    while (done < length) {
+        const ssize_t n = op(buffer + done, length - done);
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void set_nodelay(int fd)
+{
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+/**
+ * @brief 一个后端上的完整回显负载
+ */
+void run_echo(IOBackend backend, const char* backend_name)
+{
+    const StressOptions& opts = options();
+    IOManagerOptions io_opts;
+    io_opts.backend = backend;
+
+    int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ASSERT_GE(listener, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_EQ(::listen(listener, SOMAXCONN), 0);
+    socklen_t address_length = sizeof(address);
+    ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &address_length), 0);
+
+    // 服务器：接受全部连接后退出接受循环，每个连接回显到对端关闭
+    std::atomic<size_t> served{0};
+    std::thread server_thread([&] {
+        IOManager io(io_opts);
+        io.spawn([&] {
+            for (size_t i = 0; i < opts.connections; ++i) {
+                const int fd = io.accept(listener, nullptr, nullptr);
+                if (fd < 0) {
+                    ADD_FAILURE() << "accept: " << std::strerror(errno);
+                    return;
+                }
+                set_nodelay(fd);
+                io.spawn([&io, &served, fd, payload = opts.payload] {
+                    std::vector<char> buffer(payload);
+                    for (;;) {
+                        const ssize_t n = io.read(fd, buffer.data(), buffer.size());
+                        if (n <= 0) {
+                            break;
+                        }
+                        if (!transfer_all([&](char* p, size_t len) { return io.write(fd, p, len); },
+                                          buffer.data(), static_cast<size_t>(n))) {
+                            break;
+                        }
+                    }
+                    served.fetch_add(1, std::memory_order_relaxed);
+                    io.close(fd);
+                });
+            }
+        });
+        io.run();
+    });
+
+    // 负载：每个连接同步发送请求并等待完整回显
+    IOManager io(io_opts);
+    std::vector<uint64_t> samples;
+    samples.reserve(opts.connections * opts.requests);
+    size_t completed = 0;
+    for (size_t c = 0; c < opts.connections; ++c) {
+        io.spawn([&] {
+            const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            ASSERT_GE(fd, 0);
+            ASSERT_EQ(io.connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0)
+                << std::strerror(errno);
+            set_nodelay(fd);
+            std::vector<char> request(opts.payload, 'x');
+            std::vector<char> response(opts.payload);
+            for (size_t r = 0; r < opts.requests; ++r) {
+                const uint64_t start = now_ns();
+                if (!transfer_all([&](char* p, size_t len) { return io.write(fd, p, len); },
+                                  request.data(), request.size()) ||
+                    !transfer_all([&](char* p, size_t len) { return io.read(fd, p, len); },
+                                  response.data(), response.size())) {
+                    ADD_FAILURE() << "echo failed: " << std::strerror(errno);
+                    break;
+                }
+                samples.push_back(now_ns() - start);
+                ++completed;
+            }
+            io.close(fd);
+        });
+    }
+    const uint64_t start = now_ns();
+    io.run();
+    const uint64_t elapsed = now_ns() - start;
+    server_thread.join();
+    ::close(listener);
+
+    EXPECT_EQ(completed, opts.connections * opts.requests);
+    EXPECT_EQ(served.load(), opts.connections);
+
+    const std::string scenario = std::string("echo/") + backend_name + "/" + std::to_string(opts.connections) + "c";
+    report().record(scenario, "requests_per_sec",
+                    static_cast<double>(completed) / (static_cast<double>(elapsed) / 1e9) / 1000.0, "K/s");
+    report().record(scenario, "p50_us", static_cast<double>(percentile(samples, 0.50)) / 1000.0, "us");
+    report().expect_at_most(scenario, "p99_us", static_cast<double>(percentile(samples, 0.99)) / 1000.0,
+                            static_cast<double>(targets::SCHEDULING_LATENCY_TARGET_US), "us");
+    report().record(scenario, "p999_us", static_cast<double>(percentile(samples, 0.999)) / 1000.0, "us");
+}
+
+} // namespace
+
+TEST(StressEcho, Epoll) {
+    run_echo(IOBackend::EPOLL, "epoll");
+}
+
+TEST(StressEcho, IoUring) {
+    IOManagerOptions opts;
+    opts.backend = IOBackend::IO_URING;
+    if (!IOManager(opts).is_valid()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    run_echo(IOBackend::IO_URING, "io_uring");
+}
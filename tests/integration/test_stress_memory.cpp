@@ -0,0 +1,133 @@
+/**
+ * @file test_stress_memory.cpp
+ * @brief 大量存活协程的内存占用
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 每种栈策略下同时保持 options().coroutines 个挂起在小栈帧上的协程，
+ * 测量每协程的驻留内存 (RSS 增量) 和创建耗时，按 config:: 的内存与创建目标检查。
+ * 内存目标针对共享栈类策略 (与 BM_SharedStackFootprint 一致)，
+ * 独立栈策略只记录，用于按栈策略估算单机容量。
+ */
+
+#include "stress_helper.h"
+#include "libco_oop/coroutine.h"
+#include "libco_oop/stack.h"
+#include <gtest/gtest.h>
+#include <malloc.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace libco_oop;
+using namespace libco_oop::stress;
+
+namespace {
+
+namespace targets = libco_oop::benchmark::config;
+
+/**
+ * @brief 被测的栈策略
+ */
+struct Strategy {
+    const char* name;
+    bool private_stack;     ///< 每个协程一个映射 (受 vm.max_map_count 限制)
+};
+
+const Strategy kStrategies[] = {
+    {"fixed", true},
+    {"size_class", true},
+    {"shared", false},
+    {"hybrid", false},
+};
+
+/**
+ * @brief 按策略创建 count 个协程，每个换入一次后挂起，然后全部运行到结束
+ */
+void measure(const Strategy& strategy, size_t count)
+{
+    std::unique_ptr<StackAllocator> allocator;
+    std::unique_ptr<HybridStackAllocator> hybrid;
+    CoroutineOptions opts;
+    const std::string name = strategy.name;
+    if (name == "fixed") {
+        allocator.reset(new FixedStackAllocator(StackOptions(targets::BENCH_STACK_SIZE)));
+    } else if (name == "size_class") {
+        allocator.reset(new SizeClassStackAllocator(StackOptions(targets::BENCH_STACK_SIZE)));
+        opts.stack_size = SizeClassStackAllocator::kDefaultMinSize;
+    } else if (name == "shared") {
+        allocator.reset(new SharedStackAllocator(1));
+    } else {
+        hybrid.reset(new HybridStackAllocator());
+        opts.hybrid = hybrid.get();
+    }
+    opts.stack_allocator = allocator.get();
+
+    std::vector<CoroutinePtr> coroutines;
+    coroutines.reserve(count);
+    size_t finished = 0;
+    ::malloc_trim(0);
+    const size_t baseline = rss_bytes();
+    const uint64_t start = now_ns();
+
+    for (size_t i = 0; i < count; ++i) {
+        CoroutinePtr coroutine = Coroutine::create([&finished] {
+            volatile char frame[256] = {};
+            Coroutine::yield();
+            static_cast<void>(frame[0]);
+            ++finished;
+        }, opts);
+        ASSERT_TRUE(coroutine) << strategy.name << ": create failed after " << i << " coroutines";
+        ASSERT_TRUE(coroutine->resume());
+        coroutines.push_back(std::move(coroutine));
+    }
+
+    const uint64_t elapsed = now_ns() - start;
+    const size_t after = rss_bytes();
+    const double resident = static_cast<double>(after > baseline ? after - baseline : 0);
+    const std::string scenario = std::string("memory/") + strategy.name + "/" + std::to_string(count);
+    const double bytes_per_coroutine = resident / static_cast<double>(count);
+    const double create_ns = static_cast<double>(elapsed) / static_cast<double>(count);   // 含第一次换入
+    if (strategy.private_stack) {
+        report().record(scenario, "bytes_per_coroutine", bytes_per_coroutine, "B");
+        report().record(scenario, "create_ns", create_ns, "ns");
+    } else {
+        report().expect_at_most(scenario, "bytes_per_coroutine", bytes_per_coroutine,
+                                static_cast<double>(targets::MEMORY_USAGE_TARGET_BYTES), "B");
+        report().expect_at_most(scenario, "create_ns", create_ns,
+                                static_cast<double>(targets::COROUTINE_CREATION_TARGET_NS), "ns");
+    }
+    report().record(scenario, "rss_total", resident / (1024.0 * 1024.0), "MiB");
+
+    for (const CoroutinePtr& coroutine : coroutines) {
+        coroutine->resume();
+    }
+    EXPECT_EQ(finished, count);
+    coroutines.clear();
+}
+
+} // namespace
+
+// 每个协程一个栈映射 (带保护页占两个 VMA)，数量按 vm.max_map_count 截断
+TEST(StressMemory, PrivateStacks) {
+    const size_t limit = (max_map_count() - std::min<size_t>(max_map_count(), 8192)) / 2;
+    const size_t count = std::min(options().coroutines, limit);
+    if (count < options().coroutines) {
+        std::cout << "  private stacks limited to " << count << " by vm.max_map_count=" << max_map_count()
+                  << std::endl;
+    }
+    for (const Strategy& strategy : kStrategies) {
+        if (strategy.private_stack) {
+            measure(strategy, count);
+        }
+    }
+}
+
+// 共享栈上挂起的协程只占用控制块和保存缓冲区
+TEST(StressMemory, SharedStacks) {
+    for (const Strategy& strategy : kStrategies) {
+        if (!strategy.private_stack) {
+            measure(strategy, options().coroutines);
+        }
+    }
+}
@@ -0,0 +1,176 @@
+/**
+ * @file test_stress_ring.cpp
+ * @brief 工作窃取调度器上的乒乓与环形拓扑
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 协程排成环，每个节点有一个容量为 1 的令牌槽，拿到令牌后交给下一个节点。
+ * 令牌不会在节点处堆积，每次传递都是一次跨协程 (可能跨线程) 的唤醒和调度。
+ * 按工作线程数扫描：
+ * - 每秒调度次数及其相对单线程的扩展效率 (取自调度器统计，而不是传递次数)
+ * - 每千次调度中的窃取次数
+ * - 令牌从放入槽位到被下一个节点取走的延迟分位数，p99 按调度延迟目标检查
+ *
+ * 每协程的纯切换开销由 bench_context.cpp 按切换目标检查，这里只记录。
+ */
+
+#include "stress_helper.h"
+#include "libco_oop/sync.h"
+#include "libco_oop/work_stealing.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace libco_oop;
+using namespace libco_oop::stress;
+
+namespace {
+
+namespace targets = libco_oop::benchmark::config;
+
+/**
+ * @brief 环上的一个节点
+ *
+ * full/empty 组成单元素缓冲区：节点同一时刻最多持有一个待取的令牌，
+ * 前驱在槽位被取走之前挂起等待，令牌不会在一个节点处合并成串。
+ */
+struct Node {
+    CoSemaphore full{0};                ///< 槽位中的令牌
+    CoSemaphore empty{0};               ///< 槽位空闲
+    uint64_t sent_at = 0;               ///< 令牌放入槽位的时刻 (初始令牌为0，不计延迟)
+    std::vector<uint64_t> latencies;    ///< 放入到取走的延迟 (只由本节点写)
+};
+
+/**
+ * @brief 一次环形运行的结果
+ */
+struct RingResult {
+    uint64_t elapsed_ns = 0;
+    uint64_t hops = 0;
+    WorkStealingStatistics stats;
+    std::vector<uint64_t> latencies;
+};
+
+/**
+ * @brief rings 个长度为 ring_size 的环，每个环中 tokens 个令牌，每个协程传递 hops_per_node 次
+ *
+ * 每个协程恰好从前驱收到 hops_per_node 个令牌，因此所有协程都能结束，
+ * 初始令牌最后留在槽位中。
+ */
+RingResult run_rings(size_t workers, size_t ring_size, size_t rings, size_t tokens, size_t hops_per_node)
+{
+    const size_t nodes = ring_size * rings;
+    std::unique_ptr<Node[]> ring(new Node[nodes]);
+    for (size_t index = 0; index < nodes; ++index) {
+        ring[index].latencies.reserve(hops_per_node);
+    }
+    for (size_t base = 0; base < nodes; base += ring_size) {
+        for (size_t token = 0; token < tokens; ++token) {
+            ring[base + token * ring_size / tokens].full.release();
+        }
+        for (size_t index = base; index < base + ring_size; ++index) {
+            if (ring[index].full.get_count() == 0) {
+                ring[index].empty.release();
+            }
+        }
+    }
+
+    WorkStealingOptions ws_opts;
+    ws_opts.worker_count = workers;
+    WorkStealingScheduler scheduler(ws_opts);
+    std::vector<size_t> indices(nodes);
+    std::iota(indices.begin(), indices.end(), size_t{0});
+    std::atomic<uint64_t> passed{0};
+
+    RingResult result;
+    const uint64_t start = now_ns();
+    const size_t spawned = scheduler.spawn_batch(indices.begin(), indices.end(), [&](size_t& index) {
+        const size_t base = index - index % ring_size;
+        Node& own = ring[index];
+        Node& next = ring[base + (index - base + 1) % ring_size];
+        for (size_t i = 0; i < hops_per_node; ++i) {
+            if (own.full.get_count() > 0) {
+                // 上一次传递期间令牌已经到达：先让出，每次传递至少经过一次调度
+                WorkStealingScheduler::yield();
+            }
+            own.full.acquire();
+            if (own.sent_at != 0) {
+                own.latencies.push_back(now_ns() - own.sent_at);
+            }
+            own.empty.release();
+            next.empty.acquire();
+            next.sent_at = now_ns();
+            next.full.release();
+        }
+        passed.fetch_add(hops_per_node, std::memory_order_relaxed);
+    });
+    EXPECT_EQ(spawned, nodes);
+    scheduler.wait();
+    result.elapsed_ns = now_ns() - start;
+    result.hops = passed.load(std::memory_order_relaxed);
+    result.stats = scheduler.get_statistics();
+    EXPECT_EQ(result.hops, static_cast<uint64_t>(nodes) * hops_per_node);
+    EXPECT_EQ(result.stats.finished, nodes);
+    for (size_t index = 0; index < nodes; ++index) {
+        result.latencies.insert(result.latencies.end(), ring[index].latencies.begin(), ring[index].latencies.end());
+    }
+    return result;
+}
+
+/**
+ * @brief 按工作线程数扫描一种拓扑并报告
+ */
+void sweep(const std::string& topology, size_t ring_size, size_t rings, size_t tokens)
+{
+    tokens = std::max<size_t>(1, std::min(tokens, ring_size));
+    const size_t nodes = ring_size * rings;
+    const size_t hops_per_node = std::max<size_t>(1, options().hops / nodes);
+    double single_rate = 0;
+
+    for (size_t workers : options().thread_counts()) {
+        RingResult result = run_rings(workers, ring_size, rings, tokens, hops_per_node);
+        const double seconds = static_cast<double>(result.elapsed_ns) / 1e9;
+        const double dispatches = static_cast<double>(std::max<uint64_t>(result.stats.dispatches, 1));
+        const double rate = dispatches / seconds;
+        const std::string scenario = topology + "/" + std::to_string(workers) + "t";
+        if (workers == 1) {
+            single_rate = rate;
+        }
+
+        report().record(scenario, "dispatches_per_sec", rate / 1e6, "M/s");
+        if (single_rate > 0 && workers > 1) {
+            report().record(scenario, "scaling_efficiency", 100.0 * rate / (single_rate * static_cast<double>(workers)), "%");
+        }
+        report().record(scenario, "hops_per_dispatch", static_cast<double>(result.hops) / dispatches, "");
+        report().record(scenario, "steals_per_1k_dispatch",
+                        1000.0 * static_cast<double>(result.stats.steals) / dispatches, "");
+        report().record(scenario, "parks", static_cast<double>(result.stats.parks), "");
+        // 一次调度包含换入和换出两次切换
+        report().record(scenario, "ns_per_switch",
+                        static_cast<double>(result.elapsed_ns) * static_cast<double>(workers) / (2 * dispatches), "ns");
+        // 令牌放入槽位 (release) 到下一个节点取走 (acquire 返回) 的时间
+        report().record(scenario, "wake_p50_us", static_cast<double>(percentile(result.latencies, 0.50)) / 1000.0, "us");
+        report().expect_at_most(scenario, "wake_p99_us", static_cast<double>(percentile(result.latencies, 0.99)) / 1000.0,
+                                static_cast<double>(targets::SCHEDULING_LATENCY_TARGET_US), "us");
+        report().record(scenario, "wake_p999_us", static_cast<double>(percentile(result.latencies, 0.999)) / 1000.0, "us");
+    }
+}
+
+} // namespace
+
+// 成对的协程来回传递一个令牌，协程总数与环形场景相同
+TEST(StressRing, PingPong) {
+    const size_t pairs = std::max<size_t>(1, options().ring_size * options().rings / 2);
+    sweep("pingpong/" + std::to_string(pairs) + "x2", 2, pairs, 1);
+}
+
+// 长环上同时传递多个令牌，后继经常在其他工作线程的队列里
+TEST(StressRing, Ring) {
+    const StressOptions& opts = options();
+    sweep("ring/" + std::to_string(opts.rings) + "x" + std::to_string(opts.ring_size), opts.ring_size,
+          opts.rings, opts.tokens);
+}
@@ -113,7 +113,7 @@ TEST_F(BasicTest, PerformanceTimerTest) {
     // 简单的延时操作
     volatile int sum = 0;
     for (int i = 0; i < 1000; ++i) {
-        sum += i;
+        sum = sum + i;
     }
     
     // 验证计时器能正常工作
@@ -0,0 +1,314 @@
+/**
+ * @file test_buffer.cpp
+ * @brief 缓冲区链测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证块池的复用与上限、在块中直接写入、切分与共享时的引用计数，
+ * 以及 IOManager 在两种后端上的分散/聚集IO和不拷贝的转发。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/buffer.h"
+#include "libco_oop/io_manager.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace libco_oop;
+
+//============================================================================
+// 测试辅助工具
+//============================================================================
+
+namespace {
+
+BufferPoolOptions small_blocks(size_t block_size = 64, size_t max_blocks = 0) {
+    BufferPoolOptions opts;
+    opts.block_size = block_size;
+    opts.blocks_per_slab = 4;
+    opts.max_blocks = max_blocks;
+    return opts;
+}
+
+std::string contents(const BufferChain& chain) {
+    std::string out(chain.size(), '\0');
+    EXPECT_EQ(chain.copy_to(&out[0], out.size()), out.size());
+    return out;
+}
+
+std::string pattern(size_t length) {
+    std::string data(length, '\0');
+    for (size_t i = 0; i < length; ++i) {
+        data[i] = static_cast<char>('a' + i % 26);
+    }
+    return data;
+}
+
+bool make_pair(int fds[2]) {
+    return ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) == 0;
+}
+
+} // namespace
+
+//============================================================================
+// 块池
+//============================================================================
+
+// 最近释放的块最先复用，达到上限后分配失败
+TEST(BufferTest, PoolReusesBlocks) {
+    BufferPool pool(small_blocks(1000, 6));
+    EXPECT_EQ(pool.get_block_size(), 1024u);
+
+    BufferBlock* first = pool.allocate();
+    BufferBlock* second = pool.allocate();
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(first->use_count(), 1u);
+    EXPECT_EQ(second->data() - first->data(), 1024);
+    EXPECT_EQ(pool.get_statistics().slabs, 1u);
+
+    first->retain();
+    first->release();
+    EXPECT_EQ(pool.get_statistics().in_use, 2u);
+    first->release();
+    EXPECT_EQ(pool.get_statistics().in_use, 1u);
+    EXPECT_EQ(pool.allocate(), first);
+
+    // 第二个 slab 只映射到上限为止
+    std::vector<BufferBlock*> blocks;
+    while (BufferBlock* block = pool.allocate()) {
+        blocks.push_back(block);
+    }
+    EXPECT_EQ(errno, ENOMEM);
+    EXPECT_EQ(blocks.size(), 4u);
+    EXPECT_EQ(pool.get_statistics().blocks, 6u);
+    EXPECT_EQ(pool.get_statistics().failures, 1u);
+
+    first->release();
+    second->release();
+    for (BufferBlock* block : blocks) {
+        block->release();
+    }
+    EXPECT_EQ(pool.get_statistics().in_use, 0u);
+}
+
+//============================================================================
+// 缓冲区链
+//============================================================================
+
+// prepare()/commit() 直接在块中写入，末尾块的剩余空间继续使用
+TEST(BufferTest, PrepareAndCommit) {
+    BufferPool pool(small_blocks());
+    BufferChain chain(pool);
+
+    iovec iov[4];
+    ASSERT_EQ(chain.prepare(iov, 4, 100), 2u);
+    EXPECT_EQ(iov[0].iov_len, 64u);
+    EXPECT_EQ(iov[1].iov_len, 64u);
+    const std::string data = pattern(70);
+    std::memcpy(iov[0].iov_base, data.data(), 64);
+    std::memcpy(iov[1].iov_base, data.data() + 64, 6);
+    chain.commit(70);
+    EXPECT_EQ(chain.size(), 70u);
+    EXPECT_EQ(chain.segment_count(), 2u);
+    EXPECT_EQ(contents(chain), data);
+
+    // 只用到末尾块的剩余空间时新块立即还给池
+    ASSERT_EQ(chain.prepare(iov, 4, 100), 2u);
+    EXPECT_EQ(iov[0].iov_len, 58u);
+    chain.commit(0);
+    EXPECT_EQ(chain.segment_count(), 2u);
+    EXPECT_EQ(pool.get_statistics().in_use, 2u);
+
+    ASSERT_TRUE(chain.append("xyz", 3));
+    EXPECT_EQ(chain.segment_count(), 2u);
+    EXPECT_EQ(contents(chain), data + "xyz");
+
+    chain.consume(65);
+    EXPECT_EQ(chain.segment_count(), 1u);
+    EXPECT_EQ(pool.get_statistics().in_use, 1u);
+    EXPECT_EQ(contents(chain), data.substr(65) + "xyz");
+    chain.clear();
+    EXPECT_TRUE(chain.empty());
+    EXPECT_EQ(pool.get_statistics().in_use, 0u);
+}
+
+// 切分和引用共享块，不拷贝数据；共享的块不再写入
+TEST(BufferTest, SplitAndShare) {
+    BufferPool pool(small_blocks());
+    BufferChain chain(pool);
+    const std::string data = pattern(150);
+    ASSERT_TRUE(chain.append(data.data(), data.size()));
+    EXPECT_EQ(chain.segment_count(), 3u);
+
+    BufferChain head(pool);
+    ASSERT_TRUE(chain.split_to(head, 100));
+    EXPECT_EQ(contents(head), data.substr(0, 100));
+    EXPECT_EQ(contents(chain), data.substr(100));
+    EXPECT_EQ(pool.get_statistics().in_use, 3u);
+
+    // 边界所在的块被两个链共享：追加写入使用新块
+    iovec iov[2];
+    head.fill_iovec(iov, 2);
+    char* shared = static_cast<char*>(iov[1].iov_base);
+    ASSERT_TRUE(head.append("!", 1));
+    EXPECT_EQ(pool.get_statistics().in_use, 4u);
+    EXPECT_EQ(contents(chain), data.substr(100));
+    chain.fill_iovec(iov, 1);
+    EXPECT_EQ(static_cast<char*>(iov[0].iov_base), shared + 36);
+
+    BufferChain copy(pool);
+    ASSERT_TRUE(copy.append(head, 60, 41));
+    EXPECT_EQ(contents(copy), data.substr(60, 40) + "!");
+    ASSERT_TRUE(copy.append(copy, 0, 10));     // 引用自身
+    EXPECT_EQ(contents(copy), data.substr(60, 40) + "!" + data.substr(60, 10));
+    EXPECT_EQ(pool.get_statistics().in_use, 4u);
+
+    BufferChain moved(std::move(copy));
+    EXPECT_TRUE(copy.empty());
+    ASSERT_TRUE(chain.append(std::move(moved)));
+    EXPECT_TRUE(moved.empty());
+    EXPECT_EQ(chain.size(), 50u + 51u);
+
+    errno = 0;
+    EXPECT_FALSE(chain.split_to(head, chain.size() + 1));
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_FALSE(chain.append(head, 90, 20));
+    EXPECT_FALSE(chain.append(std::move(chain)));
+
+    chain.clear();
+    head.clear();
+    EXPECT_EQ(pool.get_statistics().in_use, 0u);
+}
+
+// 池用尽时 prepare() 失败，已有数据保持不变
+TEST(BufferTest, PoolExhausted) {
+    BufferPool pool(small_blocks(64, 2));
+    BufferChain chain(pool);
+    ASSERT_TRUE(chain.append(pattern(100).data(), 100));
+    iovec iov[4];
+    errno = 0;
+    EXPECT_EQ(chain.prepare(iov, 4, 100), 0u);
+    EXPECT_EQ(errno, ENOMEM);
+    EXPECT_EQ(chain.size(), 100u);
+    EXPECT_FALSE(chain.append(pattern(100).data(), 100));
+    EXPECT_EQ(chain.size(), 100u);
+}
+
+//============================================================================
+// 分散/聚集IO
+//============================================================================
+
+class BufferIOTest : public ::testing::TestWithParam<IOBackend> {
+protected:
+    void SetUp() override {
+        IOManagerOptions opts;
+        opts.backend = GetParam();
+        io_.reset(new IOManager(opts));
+        if (!io_->is_valid()) {
+            GTEST_SKIP() << "backend is not available";
+        }
+        ASSERT_TRUE(make_pair(in_));
+        ASSERT_TRUE(make_pair(out_));
+    }
+
+    void TearDown() override {
+        for (int fd : {in_[0], in_[1], out_[0], out_[1]}) {
+            if (fd >= 0) {
+                io_->close(fd);
+            }
+        }
+        io_.reset();
+    }
+
+    std::unique_ptr<IOManager> io_;
+    int in_[2] = {-1, -1};
+    int out_[2] = {-1, -1};
+};
+
+// 从一个套接字读入的块原样写往另一个套接字
+TEST_P(BufferIOTest, ForwardWithoutCopy) {
+    IOManager& io = *io_;
+    BufferPool pool(small_blocks(4096));
+    const std::string data = pattern(256 * 1024);
+    std::string received;
+
+    io.spawn([&] {
+        BufferChain source(pool);
+        ASSERT_TRUE(source.append(data.data(), data.size()));
+        EXPECT_EQ(io.write(in_[1], source), static_cast<ssize_t>(data.size()));
+        EXPECT_TRUE(source.empty());
+        ::shutdown(in_[1], SHUT_WR);
+    });
+    io.spawn([&] {
+        // 代理：读入、切出完整的 1000 字节 "消息" 转发，剩余部分留到下一轮
+        BufferChain pending(pool);
+        for (;;) {
+            const ssize_t n = io.read(in_[0], pending, 16 * 1024);
+            ASSERT_GE(n, 0);
+            if (n == 0) {
+                break;
+            }
+            BufferChain message(pool);
+            ASSERT_TRUE(pending.split_to(message, pending.size() - pending.size() % 1000));
+            const size_t length = message.size();
+            EXPECT_EQ(io.write(out_[1], message), static_cast<ssize_t>(length));
+        }
+        EXPECT_EQ(io.write(out_[1], pending), static_cast<ssize_t>(data.size() % 1000));
+        ::shutdown(out_[1], SHUT_WR);
+    });
+    io.spawn([&] {
+        char buffer[8192];
+        iovec iov[2] = {{buffer, 100}, {buffer + 100, sizeof(buffer) - 100}};
+        ssize_t n;
+        while ((n = io.readv(out_[0], iov, 2)) > 0) {
+            received.append(buffer, static_cast<size_t>(n));
+        }
+        EXPECT_EQ(n, 0);
+    });
+
+    io.run();
+    EXPECT_EQ(received.size(), data.size());
+    EXPECT_TRUE(received == data);
+    EXPECT_EQ(pool.get_statistics().in_use, 0u);
+}
+
+// writev/sendmsg/recvmsg 的协程化版本
+TEST_P(BufferIOTest, VectorSyscalls) {
+    IOManager& io = *io_;
+    std::string received;
+
+    io.spawn([&] {
+        char buffer[11];
+        iovec iov{buffer, sizeof(buffer)};
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        ssize_t n = io.recvmsg(in_[0], &message, 0);    // 挂起直到对端写入
+        ASSERT_GT(n, 0);
+        received.assign(buffer, static_cast<size_t>(n));
+        n = io.read(in_[0], buffer, sizeof(buffer));
+        ASSERT_EQ(n, 6);
+        received.append(buffer, 6);
+    });
+    io.spawn([&] {
+        char hello[] = "hello ";
+        char world[] = "world";
+        iovec iov[2] = {{hello, 6}, {world, 5}};
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = 2;
+        EXPECT_EQ(io.sendmsg(in_[1], &message, 0), 11);
+        EXPECT_EQ(io.writev(in_[1], iov, 1), 6);
+    });
+
+    io.run();
+    EXPECT_EQ(received, "hello worldhello ");
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, BufferIOTest, ::testing::Values(IOBackend::EPOLL, IOBackend::IO_URING));
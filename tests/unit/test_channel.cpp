@@ -0,0 +1,315 @@
+/**
+ * @file test_channel.cpp
+ * @brief 通道与跨线程唤醒测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证单调度器通道的直接交接、同步通道、关闭语义，MPSC 通道在线程与
+ * 协程之间的传递和缓冲区满时的等待，以及跨线程唤醒的 eventfd 合并。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/channel.h"
+#include "libco_oop/io_manager.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace libco_oop;
+
+namespace {
+
+/**
+ * @brief 编码生产者编号和序号，检查每个生产者的顺序
+ */
+uint64_t encode_item(uint64_t producer, uint64_t sequence) {
+    return (producer << 32) | sequence;
+}
+
+} // namespace
+
+//============================================================================
+// Channel 测试
+//============================================================================
+
+// 缓冲通道按顺序传递；缓冲区满时发送方挂起
+TEST(ChannelTest, BufferedInOrder) {
+    Scheduler scheduler;
+    Channel<int> channel(4);
+    std::vector<int> received;
+    size_t max_size = 0;
+
+    scheduler.spawn([&] {
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_TRUE(channel.send(i));
+            max_size = std::max(max_size, channel.size());
+        }
+        channel.close();
+    });
+    scheduler.spawn([&] {
+        int value;
+        while (channel.recv(value)) {
+            received.push_back(value);
+        }
+        EXPECT_EQ(errno, EPIPE);
+    });
+
+    scheduler.run();
+    ASSERT_EQ(received.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(received[static_cast<size_t>(i)], i);
+    }
+    EXPECT_EQ(max_size, 4u);
+    EXPECT_EQ(scheduler.get_live_count(), 0u);
+}
+
+// 同步通道：发送方等到接收方取走为止
+TEST(ChannelTest, RendezvousHandoff) {
+    Scheduler scheduler;
+    Channel<std::string> channel;
+    std::vector<std::string> trace;
+
+    scheduler.spawn([&] {
+        trace.push_back("send");
+        EXPECT_TRUE(channel.send("ping"));
+        trace.push_back("sent");
+    });
+    scheduler.spawn([&] {
+        trace.push_back("recv");
+        std::string value;
+        EXPECT_TRUE(channel.recv(value));
+        trace.push_back(value);
+    });
+
+    scheduler.run();
+    std::vector<std::string> expected = {"send", "recv", "ping", "sent"};
+    EXPECT_EQ(trace, expected);
+    EXPECT_EQ(channel.size(), 0u);
+}
+
+// 关闭唤醒等待者；剩余元素仍可接收；协程外需要等待时返回 EPERM
+TEST(ChannelTest, CloseAndErrors) {
+    Scheduler scheduler;
+    Channel<std::unique_ptr<int>> channel(1);
+    int waiter_errno = 0;
+
+    EXPECT_TRUE(channel.try_send(std::make_unique<int>(7)));
+    auto extra = std::make_unique<int>(8);
+    EXPECT_FALSE(channel.try_send(std::move(extra)));
+    EXPECT_EQ(errno, EAGAIN);
+    EXPECT_NE(extra, nullptr);      // 失败时不移动
+    EXPECT_FALSE(channel.send(std::make_unique<int>(9)));
+    EXPECT_EQ(errno, EPERM);
+
+    scheduler.spawn([&] {
+        EXPECT_FALSE(channel.send(std::make_unique<int>(10)));
+        waiter_errno = errno;
+    });
+    scheduler.spawn([&] {
+        channel.close();
+    });
+    scheduler.run();
+    EXPECT_EQ(waiter_errno, EPIPE);
+
+    std::unique_ptr<int> value;
+    EXPECT_TRUE(channel.try_recv(value));
+    EXPECT_EQ(*value, 7);
+    EXPECT_FALSE(channel.try_recv(value));
+    EXPECT_EQ(errno, EPIPE);
+    EXPECT_FALSE(channel.try_send(std::move(extra)));
+    EXPECT_EQ(errno, EPIPE);
+}
+
+//============================================================================
+// 跨线程唤醒测试
+//============================================================================
+
+// 调度循环处理之前的一批跨线程唤醒只写一次 eventfd
+TEST(RemoteWakeupTest, BurstCoalescesToOneSignal) {
+    constexpr int kParkers = 100;
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    std::vector<RemoteWakeup*> nodes(kParkers, nullptr);
+    std::atomic<int> published{0};
+    std::atomic<bool> spinning{false};
+    std::atomic<bool> burst_done{false};
+    int woke = 0;
+
+    for (int i = 0; i < kParkers; ++i) {
+        io.spawn([&, i] {
+            RemoteWakeup node;
+            ASSERT_EQ(node.manager, &io);
+            nodes[static_cast<size_t>(i)] = &node;
+            published.fetch_add(1, std::memory_order_release);
+            EXPECT_EQ(io.park(node), 0);
+            ++woke;
+        });
+    }
+    // 所有协程都已 park() 后占住调度线程，期间的唤醒都只能排队
+    io.spawn([&] {
+        EXPECT_EQ(io.get_statistics().parked, static_cast<size_t>(kParkers));
+        spinning.store(true, std::memory_order_release);
+        while (!burst_done.load(std::memory_order_acquire)) {
+        }
+    });
+
+    std::thread loop([&] { io.run(); });
+    while (!spinning.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    ASSERT_EQ(published.load(std::memory_order_acquire), kParkers);
+    for (RemoteWakeup* node : nodes) {
+        IOManager::unpark(node);
+    }
+    burst_done.store(true, std::memory_order_release);
+    loop.join();
+
+    IOStatistics stats = io.get_statistics();
+    EXPECT_EQ(woke, kParkers);
+    EXPECT_EQ(stats.remote_wakeups, static_cast<uint64_t>(kParkers));
+    EXPECT_EQ(stats.wakeup_signals, 1u);
+    EXPECT_EQ(stats.parked, 0u);
+}
+
+// 不在 IOManager 的协程中不能 park()；销毁时释放仍在 park() 中的协程
+TEST(RemoteWakeupTest, ParkErrorsAndDestroy) {
+    RemoteWakeup outside;
+    EXPECT_EQ(outside.manager, nullptr);
+
+    bool returned = false;
+    {
+        IOManager io(IOManagerOptions{});
+        IOManager other;
+        EXPECT_EQ(io.park(outside), -1);
+        EXPECT_EQ(errno, EPERM);
+        io.spawn([&] {
+            RemoteWakeup node;
+            EXPECT_EQ(other.park(node), -1);
+            EXPECT_EQ(errno, EPERM);
+            io.park(node);
+            returned = true;
+        });
+        io.spawn([&] { io.stop(); });
+        io.run();
+        EXPECT_EQ(io.get_statistics().parked, 1u);
+    }
+    EXPECT_FALSE(returned);
+}
+
+//============================================================================
+// MpscChannel 测试
+//============================================================================
+
+// 线程和另一个 IOManager 上的协程向协程消费者发送，缓冲区小，
+// 双方都会走到等待路径
+TEST(MpscChannelTest, ThreadsAndCoroutinesToCoroutine) {
+    constexpr uint64_t kThreads = 2;
+    constexpr uint64_t kRemoteCoroutines = 2;
+    constexpr uint64_t kItems = 20000;
+    constexpr uint64_t kProducers = kThreads + kRemoteCoroutines;
+
+    for (IOBackend backend : {IOBackend::EPOLL, IOBackend::IO_URING}) {
+        IOManagerOptions opts;
+        opts.backend = backend;
+        IOManager consumer_io(opts);
+        if (!consumer_io.is_valid()) {
+            continue;   // 内核不支持 io_uring
+        }
+        MpscChannel<uint64_t> channel(16);
+        EXPECT_EQ(channel.get_capacity(), 16u);
+
+        std::vector<uint64_t> next(kProducers, 0);
+        uint64_t received = 0;
+        bool ordered = true;
+        consumer_io.spawn([&] {
+            uint64_t item;
+            while (channel.recv(item)) {
+                const uint64_t producer = item >> 32;
+                ordered = ordered && producer < kProducers && (item & 0xffffffff) == next[producer];
+                ++next[producer];
+                ++received;
+            }
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> producers;
+        for (uint64_t p = 0; p < kThreads; ++p) {
+            producers.emplace_back([&, p] {
+                for (uint64_t i = 0; i < kItems; ++i) {
+                    EXPECT_TRUE(channel.send(encode_item(p, i)));
+                }
+            });
+        }
+        producers.emplace_back([&] {
+            IOManager producer_io;
+            for (uint64_t p = kThreads; p < kProducers; ++p) {
+                producer_io.spawn([&, p] {
+                    for (uint64_t i = 0; i < kItems; ++i) {
+                        EXPECT_TRUE(channel.send(encode_item(p, i)));
+                    }
+                });
+            }
+            producer_io.run();
+        });
+        std::thread closer([&] {
+            for (std::thread& producer : producers) {
+                producer.join();
+            }
+            channel.close();
+        });
+
+        consumer_io.run();
+        closer.join();
+        double elapsed_ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+
+        EXPECT_TRUE(ordered);
+        EXPECT_EQ(received, kProducers * kItems);
+        IOStatistics stats = consumer_io.get_statistics();
+        EXPECT_LE(stats.wakeup_signals, stats.remote_wakeups);
+        std::cout << "mpsc channel: " << elapsed_ns / static_cast<double>(received)
+                  << " ns per item, " << stats.remote_wakeups << " remote wakeups, "
+                  << stats.wakeup_signals << " eventfd signals" << std::endl;
+    }
+}
+
+// 消费者是普通线程 (futex)；关闭后先取完剩余元素
+TEST(MpscChannelTest, ThreadConsumerAndClose) {
+    MpscChannel<std::string> channel(4);
+    std::vector<std::string> received;
+
+    std::thread consumer([&] {
+        std::string value;
+        while (channel.recv(value)) {
+            received.push_back(value);
+        }
+        EXPECT_EQ(errno, EPIPE);
+    });
+
+    IOManager io;
+    io.spawn([&] {
+        for (int i = 0; i < 50; ++i) {
+            EXPECT_TRUE(channel.send(std::to_string(i)));
+            if (i % 10 == 0) {
+                co_sleep(1);
+            }
+        }
+        channel.close();
+        EXPECT_FALSE(channel.send("late"));
+        EXPECT_EQ(errno, EPIPE);
+    });
+    io.run();
+    consumer.join();
+
+    ASSERT_EQ(received.size(), 50u);
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(received[static_cast<size_t>(i)], std::to_string(i));
+    }
+    std::string value;
+    EXPECT_FALSE(channel.try_recv(value));
+    EXPECT_EQ(errno, EPIPE);
+}
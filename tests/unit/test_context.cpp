@@ -10,6 +10,7 @@
 
 #include <gtest/gtest.h>
 #include "libco_oop/context.h"
+#include "test_helper.h"
 #include <chrono>
 #include <thread>
 #include <array>
@@ -689,4 +690,212 @@ TEST_F(ContextTest, StressTest) {
     
     std::cout << "Stress test completed in " << timer.get_elapsed_milliseconds() << " ms" << std::endl;
     std::cout << "Average operation time: " << timer.get_elapsed_nanoseconds() / stress_iterations << " ns" << std::endl;
-} 
\ No newline at end of file
+} 
+
+//============================================================================
+// 真实栈切换测试
+//============================================================================
+
+/**
+ * @brief 乒乓切换测试环境
+ * 
+ * 在独立栈上运行一个入口函数，与主上下文来回切换。
+ * 入口函数通过 LIBCO_OOP_CONTEXT_ENTRY 自行对齐栈，
+ * 因为 set_stack_pointer 只保证16字节对齐的栈顶。
+ */
+struct PingPongEnv {
+    static Context* main_ctx;
+    static Context* co_ctx;
+    static int counter;
+    static uint32_t co_fp_control;
+    static bool unchecked;
+    
+    LIBCO_OOP_CONTEXT_ENTRY
+    static void entry() {
+        for (;;) {
+            ++counter;
+            // 在协程内修改舍入模式，用于观察浮点控制寄存器是否随切换恢复
+            test::write_fp_control(co_fp_control);
+            if (unchecked) {
+                co_ctx->swap_unchecked(*main_ctx);
+            } else {
+                co_ctx->swap(*main_ctx);
+            }
+        }
+    }
+};
+
+Context* PingPongEnv::main_ctx = nullptr;
+Context* PingPongEnv::co_ctx = nullptr;
+int PingPongEnv::counter = 0;
+uint32_t PingPongEnv::co_fp_control = test::kDefaultFpControl;
+bool PingPongEnv::unchecked = false;
+
+/**
+ * @brief 在两个给定配置的上下文之间做乒乓切换
+ * @return uint32_t 切换回主上下文后观察到的浮点控制寄存器值
+ */
+static uint32_t run_ping_pong(const ContextConfig& config, int rounds, bool unchecked = false) {
+    Context main_ctx(config), co_ctx(config);
+    const size_t stack_size = 64 * 1024;
+    std::unique_ptr<char[]> stack(new char[stack_size]);
+    
+    EXPECT_TRUE(co_ctx.set_stack_pointer(stack.get() + stack_size));
+    EXPECT_TRUE(co_ctx.set_instruction_pointer(reinterpret_cast<void*>(&PingPongEnv::entry)));
+    EXPECT_TRUE(main_ctx.save());
+    
+    PingPongEnv::main_ctx = &main_ctx;
+    PingPongEnv::co_ctx = &co_ctx;
+    PingPongEnv::counter = 0;
+    PingPongEnv::co_fp_control = test::fp_control_with_rounding(3);   // 向零舍入
+    PingPongEnv::unchecked = unchecked;
+    
+    const uint32_t original_fp_control = test::read_fp_control();
+    uint32_t observed = original_fp_control;
+    for (int i = 0; i < rounds; ++i) {
+        if (unchecked) {
+            main_ctx.swap_unchecked(co_ctx);
+        } else {
+            EXPECT_TRUE(main_ctx.swap(co_ctx));
+        }
+        EXPECT_EQ(PingPongEnv::counter, i + 1);
+        observed = test::read_fp_control();
+        test::write_fp_control(original_fp_control);
+    }
+    
+    // 快速路径只在开启校验的构建中计数
+    if (!unchecked || LIBCO_OOP_CONTEXT_CHECKS) {
+        EXPECT_EQ(main_ctx.get_switch_count(), static_cast<size_t>(rounds));
+    } else {
+        EXPECT_EQ(main_ctx.get_switch_count(), 0u);
+    }
+    return observed;
+}
+
+// 精简模式走独立汇编入口，切换正确且不恢复浮点控制寄存器
+TEST_F(ContextTest, MinimalModePingPong) {
+    const uint32_t original_fp_control = test::read_fp_control();
+    uint32_t observed = run_ping_pong(ContextConfig{ContextMode::MINIMAL, true}, 1000);
+    
+    // MINIMAL 模式下浮点控制状态不参与切换，协程内的修改会保留下来
+    EXPECT_NE(observed, original_fp_control);
+}
+
+// 完整模式保存并恢复浮点控制寄存器
+TEST_F(ContextTest, CompleteModePingPong) {
+    const uint32_t original_fp_control = test::read_fp_control();
+    uint32_t observed = run_ping_pong(ContextConfig{ContextMode::COMPLETE, true}, 1000);
+    EXPECT_EQ(observed, original_fp_control);
+}
+
+// 内联快速路径与校验路径行为一致
+TEST_F(ContextTest, UncheckedSwapPingPong) {
+    const uint32_t original_fp_control = test::read_fp_control();
+    
+    uint32_t observed = run_ping_pong(ContextConfig{ContextMode::COMPLETE, true}, 1000, true);
+    EXPECT_EQ(observed, original_fp_control);
+    
+    observed = run_ping_pong(ContextConfig{ContextMode::MINIMAL, false}, 1000, true);
+    EXPECT_NE(observed, original_fp_control);
+}
+
+//============================================================================
+// 编译期策略组合测试
+//============================================================================
+
+/**
+ * @brief 任意 BasicContext 组合的乒乓切换环境
+ */
+template <typename Ctx>
+struct TypedPingPong {
+    static Ctx* main_ctx;
+    static Ctx* co_ctx;
+    static int counter;
+    
+    LIBCO_OOP_CONTEXT_ENTRY
+    static void entry() {
+        for (;;) {
+            ++counter;
+            test::write_fp_control(test::fp_control_with_rounding(3));
+            co_ctx->swap(*main_ctx);
+        }
+    }
+    
+    static uint32_t run(int rounds) {
+        Ctx main, co;
+        const size_t stack_size = 64 * 1024;
+        std::unique_ptr<char[]> stack(new char[stack_size]);
+        
+        EXPECT_TRUE(co.set_stack_pointer(stack.get() + stack_size));
+        EXPECT_TRUE(co.set_instruction_pointer(reinterpret_cast<void*>(&entry)));
+        EXPECT_TRUE(main.save());
+        main_ctx = &main;
+        co_ctx = &co;
+        counter = 0;
+        
+        const uint32_t original_fp_control = test::read_fp_control();
+        uint32_t observed = original_fp_control;
+        for (int i = 0; i < rounds; ++i) {
+            EXPECT_TRUE(main.swap(co));
+            EXPECT_EQ(counter, i + 1);
+            observed = test::read_fp_control();
+            test::write_fp_control(original_fp_control);
+        }
+        // 这里测试的组合都使用 NoStats，不存在切换计数
+        EXPECT_EQ(main.get_switch_count(), 0u);
+        return observed;
+    }
+};
+
+template <typename Ctx> Ctx* TypedPingPong<Ctx>::main_ctx = nullptr;
+template <typename Ctx> Ctx* TypedPingPong<Ctx>::co_ctx = nullptr;
+template <typename Ctx> int TypedPingPong<Ctx>::counter = 0;
+
+// 精简组合只包含寄存器状态
+TEST_F(ContextTest, PolicyContextLayout) {
+    EXPECT_EQ(sizeof(FastContext), sizeof(RegisterState));
+    EXPECT_EQ(sizeof(FpuContext), sizeof(RegisterState));
+    EXPECT_GT(sizeof(Context), sizeof(RegisterState));
+    
+    // 寄存器状态位于对象开头，配置、计数和校验标记排在后面
+    Context context;
+    EXPECT_EQ(static_cast<void*>(&context.registers()), static_cast<void*>(&context));
+    
+    FastContext fast;
+    EXPECT_FALSE(fast.is_valid());
+    EXPECT_EQ(fast.get_config().mode, ContextMode::MINIMAL);
+    EXPECT_FALSE(fast.get_config().save_fpu);
+    
+    FpuContext fpu;
+    EXPECT_EQ(fpu.get_config().mode, ContextMode::COMPLETE);
+    EXPECT_TRUE(fpu.get_config().save_fpu);
+    
+    // 无校验策略下有效性由寄存器内容推导
+    ASSERT_TRUE(fast.save());
+    EXPECT_TRUE(fast.is_valid());
+    fast.reset();
+    EXPECT_FALSE(fast.is_valid());
+}
+
+// FastContext 使用精简入口，不恢复浮点控制寄存器，也没有切换计数
+TEST_F(ContextTest, FastContextPingPong) {
+    const uint32_t original_fp_control = test::read_fp_control();
+    EXPECT_NE(TypedPingPong<FastContext>::run(1000), original_fp_control);
+}
+
+// FpuContext 使用无分支的完整入口，恢复浮点控制寄存器
+TEST_F(ContextTest, FpuContextPingPong) {
+    const uint32_t original_fp_control = test::read_fp_control();
+    EXPECT_EQ(TypedPingPong<FpuContext>::run(1000), original_fp_control);
+}
+
+// 同一组合的移动语义
+TEST_F(ContextTest, PolicyContextMove) {
+    FastContext source;
+    ASSERT_TRUE(source.save());
+    void* sp = source.get_stack_pointer();
+    
+    FastContext moved = std::move(source);
+    EXPECT_TRUE(moved.is_valid());
+    EXPECT_EQ(moved.get_stack_pointer(), sp);
+}
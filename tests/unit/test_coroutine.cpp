@@ -0,0 +1,465 @@
+/**
+ * @file test_coroutine.cpp
+ * @brief 基础协程类测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证协程的生命周期、状态转换、嵌套恢复、异常传播、入口函数的
+ * 小对象优化以及控制块和栈的池化复用。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/coroutine.h"
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace libco_oop;
+
+//============================================================================
+// 测试辅助工具
+//============================================================================
+
+// 统计当前线程在开启计数期间的全局 operator new 调用次数。
+// 替换的 operator new/delete 直接使用 malloc/free，内联后 GCC 会误报不匹配。
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+static thread_local bool g_count_allocations = false;
+static thread_local size_t g_allocation_count = 0;
+
+void* operator new(size_t size)
+{
+    if (g_count_allocations) {
+        ++g_allocation_count;
+    }
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    if (g_count_allocations) {
+        ++g_allocation_count;
+    }
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+/**
+ * @brief 在作用域内统计堆分配次数
+ */
+class AllocationCounter {
+public:
+    AllocationCounter() noexcept
+    {
+        g_allocation_count = 0;
+        g_count_allocations = true;
+    }
+    ~AllocationCounter() noexcept { g_count_allocations = false; }
+    size_t count() const noexcept { return g_allocation_count; }
+};
+
+class CoroutineTest : public ::testing::Test {
+protected:
+    std::vector<std::string> trace_;
+};
+
+//============================================================================
+// 核心测试用例
+//============================================================================
+
+// 协程的创建和销毁
+TEST_F(CoroutineTest, BasicCoroutineCreation) {
+    CoroutinePtr co = Coroutine::create([] {});
+    ASSERT_NE(co, nullptr);
+    EXPECT_EQ(co->get_state(), CoroutineState::READY);
+    EXPECT_FALSE(co->is_finished());
+    ASSERT_NE(co->get_stack(), nullptr);
+    EXPECT_TRUE(co->get_stack()->is_valid());
+
+    CoroutinePtr other = Coroutine::create([] {});
+    ASSERT_NE(other, nullptr);
+    EXPECT_NE(co->get_id(), other->get_id());
+    EXPECT_NE(co->get_stack(), other->get_stack());
+}
+
+// 基本的执行流程
+TEST_F(CoroutineTest, SimpleCoroutineExecution) {
+    int value = 0;
+    Coroutine* inside = nullptr;
+    CoroutinePtr co = Coroutine::create([&] {
+        inside = Coroutine::current();
+        value = 42;
+    });
+
+    EXPECT_EQ(Coroutine::current(), nullptr);
+    EXPECT_TRUE(co->resume());
+    EXPECT_EQ(value, 42);
+    EXPECT_EQ(inside, co.get());
+    EXPECT_EQ(Coroutine::current(), nullptr);
+    EXPECT_EQ(co->get_state(), CoroutineState::FINISHED);
+
+    // 已完成的协程不能再恢复
+    EXPECT_FALSE(co->resume());
+}
+
+// 暂停和恢复
+TEST_F(CoroutineTest, CoroutineYieldResume) {
+    int steps = 0;
+    CoroutinePtr co = Coroutine::create([&] {
+        for (int i = 0; i < 3; ++i) {
+            ++steps;
+            EXPECT_TRUE(Coroutine::yield());
+        }
+    });
+
+    for (int i = 1; i <= 3; ++i) {
+        EXPECT_TRUE(co->resume());
+        EXPECT_EQ(steps, i);
+        EXPECT_EQ(co->get_state(), CoroutineState::SUSPENDED);
+    }
+    EXPECT_TRUE(co->resume());
+    EXPECT_TRUE(co->is_finished());
+    EXPECT_EQ(co->get_resume_count(), 4u);
+
+    // 不在协程中 yield 直接返回
+    EXPECT_FALSE(Coroutine::yield());
+}
+
+// 状态转换
+TEST_F(CoroutineTest, CoroutineStateTransition) {
+    CoroutineState observed = CoroutineState::READY;
+    Coroutine* self = nullptr;
+    CoroutinePtr co = Coroutine::create([&] {
+        self = Coroutine::current();
+        observed = self->get_state();
+        Coroutine::yield();
+    });
+
+    EXPECT_EQ(co->get_state(), CoroutineState::READY);
+    co->resume();
+    EXPECT_EQ(observed, CoroutineState::RUNNING);
+    EXPECT_EQ(co->get_state(), CoroutineState::SUSPENDED);
+    co->resume();
+    EXPECT_EQ(co->get_state(), CoroutineState::FINISHED);
+}
+
+// 协程异常在 resume() 中重新抛出
+TEST_F(CoroutineTest, CoroutineException) {
+    bool after_throw = false;
+    CoroutinePtr co = Coroutine::create([&] {
+        Coroutine::yield();
+        throw std::runtime_error("boom");
+        after_throw = true;
+    });
+
+    EXPECT_TRUE(co->resume());
+    EXPECT_THROW(co->resume(), std::runtime_error);
+    EXPECT_EQ(co->get_state(), CoroutineState::ERROR);
+    EXPECT_TRUE(co->is_finished());
+    EXPECT_FALSE(after_throw);
+    EXPECT_FALSE(co->resume());
+}
+
+//============================================================================
+// 高级测试用例
+//============================================================================
+
+// 多个协程交替执行
+TEST_F(CoroutineTest, MultipleCoroutines) {
+    std::vector<CoroutinePtr> coroutines;
+    for (int i = 0; i < 3; ++i) {
+        coroutines.push_back(Coroutine::create([this, i] {
+            trace_.push_back("a" + std::to_string(i));
+            Coroutine::yield();
+            trace_.push_back("b" + std::to_string(i));
+        }));
+    }
+
+    for (int round = 0; round < 2; ++round) {
+        for (auto& co : coroutines) {
+            co->resume();
+        }
+    }
+    std::vector<std::string> expected{"a0", "a1", "a2", "b0", "b1", "b2"};
+    EXPECT_EQ(trace_, expected);
+}
+
+// 协程中恢复另一个协程，yield 回到最近的恢复者
+TEST_F(CoroutineTest, NestedCoroutineCalls) {
+    CoroutinePtr inner = Coroutine::create([this] {
+        trace_.push_back("inner-1");
+        Coroutine::yield();
+        trace_.push_back("inner-2");
+    });
+
+    CoroutinePtr outer = Coroutine::create([&] {
+        trace_.push_back("outer-1");
+        inner->resume();
+        EXPECT_NE(Coroutine::current(), inner.get());
+        trace_.push_back("outer-2");
+        Coroutine::yield();
+        inner->resume();
+        trace_.push_back("outer-3");
+    });
+
+    outer->resume();
+    trace_.push_back("main");
+    outer->resume();
+
+    std::vector<std::string> expected{"outer-1", "inner-1", "outer-2", "main", "inner-2", "outer-3"};
+    EXPECT_EQ(trace_, expected);
+    EXPECT_TRUE(inner->is_finished());
+    EXPECT_TRUE(outer->is_finished());
+}
+
+// 入口函数的小对象优化
+TEST_F(CoroutineTest, InlineEntryFunction) {
+    int hits = 0;
+    CoroutineFunction small([&hits] { ++hits; });
+    EXPECT_TRUE(small.is_inline());
+
+    struct Big {
+        char payload[128];
+    } big{};
+    CoroutineFunction large([big, &hits] { hits += big.payload[0] + 1; });
+    EXPECT_FALSE(large.is_inline());
+
+    // 只能移动的捕获
+    auto owned = std::make_unique<int>(5);
+    CoroutineFunction move_only([p = std::move(owned), &hits] { hits += *p; });
+    EXPECT_TRUE(move_only.is_inline());
+
+    CoroutineFunction moved(std::move(small));
+    EXPECT_FALSE(small);
+    moved();
+    large();
+    move_only();
+    EXPECT_EQ(hits, 7);
+
+    // 小捕获的协程创建不产生堆分配
+    CoroutinePtr warm = Coroutine::create([] {});
+    warm.reset();
+    size_t allocations = 0;
+    {
+        AllocationCounter counter;
+        CoroutinePtr co = Coroutine::create([&hits, a = 1, b = 2, c = 3] { hits += a + b + c; });
+        co->resume();
+        allocations = counter.count();
+    }
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(hits, 13);
+}
+
+// 控制块和栈在稳态下复用，不分配内存
+TEST_F(CoroutineTest, CoroutineResourceManagement) {
+    FixedStackAllocator& stacks = FixedStackAllocator::local();
+
+    // 预热：控制块池和栈池各有至少一个空闲项
+    CoroutinePtr first = Coroutine::create([] { Coroutine::yield(); });
+    Coroutine* first_block = first.get();
+    Stack* first_stack = first->get_stack();
+    first->resume();
+    first.reset();
+
+    const size_t mmap_before = stacks.get_statistics().mmap_calls;
+    size_t allocations = 0;
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 100; ++i) {
+            CoroutinePtr co = Coroutine::create([] { Coroutine::yield(); });
+            co->resume();
+            co->resume();
+        }
+        allocations = counter.count();
+    }
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(stacks.get_statistics().mmap_calls, mmap_before);
+
+    // 后进先出：刚归还的控制块和栈被下一个协程直接使用
+    CoroutinePtr again = Coroutine::create([] {});
+    EXPECT_EQ(again.get(), first_block);
+    EXPECT_EQ(again->get_stack(), first_stack);
+}
+
+// 控制块按缓存行对齐，切换访问的寄存器独占控制块的第二个缓存行
+TEST_F(CoroutineTest, ControlBlockLayout) {
+    constexpr uintptr_t kLine = 64;
+    EXPECT_EQ(alignof(Coroutine), kLine);
+    EXPECT_EQ(sizeof(Coroutine) % kLine, 0u);
+
+    std::vector<CoroutinePtr> coroutines;
+    for (int i = 0; i < 100; ++i) {
+        coroutines.push_back(Coroutine::create([] {}));
+        ASSERT_NE(coroutines.back(), nullptr);
+    }
+    for (const CoroutinePtr& co : coroutines) {
+        const uintptr_t block = reinterpret_cast<uintptr_t>(co.get());
+        const uintptr_t regs = reinterpret_cast<uintptr_t>(co->get_stack_binding().get_registers());
+        EXPECT_EQ(block % kLine, 0u);
+        EXPECT_EQ(regs - block, kLine);
+    }
+}
+
+// 复用已结束的协程
+TEST_F(CoroutineTest, CoroutineReset) {
+    int runs = 0;
+    CoroutinePtr co = Coroutine::create([&] { ++runs; });
+    Stack* stack = co->get_stack();
+    const uint64_t first_id = co->get_id();
+
+    co->resume();
+    ASSERT_TRUE(co->is_finished());
+
+    EXPECT_TRUE(co->reset([&] {
+        runs += 10;
+        Coroutine::yield();
+    }));
+    EXPECT_EQ(co->get_state(), CoroutineState::READY);
+    EXPECT_EQ(co->get_stack(), stack);
+    EXPECT_NE(co->get_id(), first_id);
+
+    co->resume();
+    EXPECT_EQ(runs, 11);
+    // 挂起中的协程不能重置
+    EXPECT_FALSE(co->reset([] {}));
+    co->resume();
+    EXPECT_TRUE(co->is_finished());
+}
+
+// 采样的栈在释放时记录高水位，样本足够后同类协程使用推荐大小的栈
+TEST_F(CoroutineTest, StackUsageAutoSizing) {
+    StackOptions stack_opts{128 * 1024};
+    stack_opts.canary_sample = 1;
+    SizeClassStackAllocator classes(stack_opts);
+    StackUsage usage;
+    CoroutineOptions opts;
+    opts.stack_allocator = &classes;
+    opts.stack_usage = &usage;
+
+    auto entry = [] {
+        volatile char frame[6 * 1024];
+        frame[0] = 1;
+        Coroutine::yield();
+        frame[sizeof(frame) - 1] = frame[0];
+    };
+    for (size_t i = 0; i < StackUsage::kMinSamples; ++i) {
+        CoroutinePtr co = Coroutine::create(entry, opts);
+        ASSERT_NE(co, nullptr);
+        EXPECT_EQ(co->get_stack()->get_size(), 128u * 1024);
+        while (!co->is_finished()) {
+            co->resume();
+        }
+    }
+    EXPECT_EQ(usage.get_samples(), StackUsage::kMinSamples);
+    EXPECT_GE(usage.get_max_used(), 6u * 1024);
+
+    CoroutinePtr sized = Coroutine::create(entry, opts);
+    ASSERT_NE(sized, nullptr);
+    EXPECT_LT(sized->get_stack()->get_size(), 128u * 1024);
+    EXPECT_GE(sized->get_stack()->get_size(), usage.get_max_used());
+    while (!sized->is_finished()) {
+        sized->resume();
+    }
+
+    // 复用时记录上一次运行并重新涂抹
+    ASSERT_TRUE(sized->reset(entry));
+    EXPECT_EQ(usage.get_samples(), StackUsage::kMinSamples + 1);
+    EXPECT_TRUE(sized->get_stack()->is_painted());
+    EXPECT_EQ(sized->get_stack()->high_water_mark(), 0u);
+}
+
+// 协程运行在共享栈上
+TEST_F(CoroutineTest, SharedStackCoroutines) {
+    SharedStackAllocator shared(1, StackOptions{64 * 1024});
+    CoroutineOptions opts;
+    opts.stack_allocator = &shared;
+
+    std::vector<CoroutinePtr> coroutines;
+    int sum = 0;
+    for (int i = 0; i < 4; ++i) {
+        coroutines.push_back(Coroutine::create([&sum, i] {
+            volatile int local = i * 100;
+            Coroutine::yield();
+            sum += local;
+        }, opts));
+        ASSERT_NE(coroutines.back(), nullptr);
+        EXPECT_TRUE(coroutines.back()->get_stack_binding().is_shared());
+    }
+
+    for (int round = 0; round < 2; ++round) {
+        for (auto& co : coroutines) {
+            co->resume();
+        }
+    }
+    EXPECT_EQ(sum, 600);
+    EXPECT_GT(coroutines[0]->get_stack_binding().get_statistics().restore_count, 0u);
+
+    coroutines.clear();
+    EXPECT_EQ(shared.get_statistics().in_use, 0u);
+}
+
+// 对称切换：目标接替当前协程，让出时回到原来的调用者
+TEST_F(CoroutineTest, SymmetricTransfer) {
+    CoroutinePtr second = Coroutine::create([this] {
+        trace_.push_back("second");
+        Coroutine::yield();
+        trace_.push_back("second-end");
+    });
+    Coroutine* target = second.get();
+    CoroutinePtr first = Coroutine::create([this, target] {
+        trace_.push_back("first");
+        EXPECT_TRUE(Coroutine::yield_to(*target));
+        trace_.push_back("first-end");
+    });
+
+    EXPECT_FALSE(Coroutine::yield_to(*target));
+
+    EXPECT_TRUE(first->resume());
+    EXPECT_EQ(first->get_state(), CoroutineState::SUSPENDED);
+    EXPECT_EQ(second->get_state(), CoroutineState::SUSPENDED);
+    EXPECT_EQ(Coroutine::current(), nullptr);
+
+    EXPECT_TRUE(first->resume());
+    EXPECT_TRUE(first->is_finished());
+    EXPECT_TRUE(second->resume());
+    EXPECT_TRUE(second->is_finished());
+
+    std::vector<std::string> expected = {"first", "second", "first-end", "second-end"};
+    EXPECT_EQ(trace_, expected);
+}
+
+// 协程创建+运行+销毁的耗时 (只输出；创建目标由 BM_Create<LibcoOop> 经 bench_gate 检查)
+TEST_F(CoroutineTest, CoroutinePerformance) {
+    const int iterations = 10000;
+    CoroutinePtr warm = Coroutine::create([] {});
+    warm.reset();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        CoroutinePtr co = Coroutine::create([] {});
+        co->resume();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    double avg = static_cast<double>(elapsed) / iterations;
+    std::cout << "Average coroutine create+run+destroy: " << avg << " ns" << std::endl;
+}
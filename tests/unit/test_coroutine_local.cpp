@@ -0,0 +1,283 @@
+/**
+ * @file test_coroutine_local.cpp
+ * @brief 协程局部存储测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证值按协程隔离 (交替让出、对称切换、调度器)、溢出槽位、
+ * 结束/复用/销毁/线程退出时的析构，以及切换钩子让线程级状态跟随协程。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/coroutine_local.h"
+#include "libco_oop/coroutine_pool.h"
+#include "libco_oop/scheduler.h"
+#include <cerrno>
+#include <thread>
+#include <vector>
+
+using namespace libco_oop;
+
+namespace {
+
+// 统计构造和析构次数的值类型
+struct Tracked {
+    static int live;
+    int value = 0;
+    Tracked() { ++live; }
+    ~Tracked() { --live; }
+};
+int Tracked::live = 0;
+
+int g_destroyed = 0;
+
+void count_destroy(void*) noexcept {
+    ++g_destroyed;
+}
+
+// 模拟每线程缓存：钩子把协程的值装入线程局部变量
+thread_local void* t_active = nullptr;
+int g_hook_calls = 0;
+
+void install_active(void* from, void* to) {
+    ++g_hook_calls;
+    t_active = to;
+}
+
+} // namespace
+
+//============================================================================
+// 值的隔离
+//============================================================================
+
+// 交替运行的协程和线程本身各自看到自己的值
+TEST(CoroutineLocalTest, ValuesArePerCoroutine) {
+    const int key = coroutine_local::create_key();
+    ASSERT_GE(key, 0);
+    int thread_value = 0;
+    int a_value = 1;
+    int b_value = 2;
+    ASSERT_TRUE(coroutine_local::set(key, &thread_value));
+
+    std::vector<void*> seen;
+    auto body = [&](int* mine) {
+        return [&seen, key, mine] {
+            EXPECT_EQ(coroutine_local::get(key), nullptr);
+            ASSERT_TRUE(coroutine_local::set(key, mine));
+            Coroutine::yield();
+            seen.push_back(coroutine_local::get(key));
+        };
+    };
+    CoroutinePtr a = Coroutine::create(body(&a_value));
+    CoroutinePtr b = Coroutine::create(body(&b_value));
+    a->resume();
+    b->resume();
+    EXPECT_EQ(coroutine_local::get(key), &thread_value);
+    b->resume();
+    a->resume();
+    ASSERT_EQ(seen.size(), 2u);
+    EXPECT_EQ(seen[0], &b_value);
+    EXPECT_EQ(seen[1], &a_value);
+    EXPECT_EQ(coroutine_local::get(key), &thread_value);
+    ASSERT_TRUE(coroutine_local::set(key, nullptr));
+}
+
+// 嵌套恢复和对称切换之后访问的都是当前协程的值
+TEST(CoroutineLocalTest, NestedAndSymmetric) {
+    const int key = coroutine_local::create_key();
+    int inner_value = 1;
+    int outer_value = 2;
+    int target_value = 3;
+    void* inner_seen = nullptr;
+    void* outer_seen = nullptr;
+    void* target_seen = nullptr;
+
+    CoroutinePtr target = Coroutine::create([&] {
+        coroutine_local::set(key, &target_value);
+        target_seen = coroutine_local::get(key);
+    });
+    CoroutinePtr inner = Coroutine::create([&] {
+        coroutine_local::set(key, &inner_value);
+        Coroutine::yield_to(*target);
+        inner_seen = coroutine_local::get(key);
+    });
+    CoroutinePtr outer = Coroutine::create([&] {
+        coroutine_local::set(key, &outer_value);
+        inner->resume();
+        outer_seen = coroutine_local::get(key);
+    });
+    outer->resume();
+    EXPECT_EQ(target_seen, &target_value);
+    EXPECT_EQ(outer_seen, &outer_value);
+    inner->resume();
+    EXPECT_EQ(inner_seen, &inner_value);
+}
+
+// 调度器交替运行的协程互不干扰
+TEST(CoroutineLocalTest, SchedulerInterleaving) {
+    static CoroutineLocal<Tracked> local;
+    ASSERT_TRUE(local.valid());
+    Scheduler scheduler;
+    constexpr int kCoroutines = 16;
+    int mismatches = 0;
+    for (int i = 0; i < kCoroutines; ++i) {
+        scheduler.spawn([i, &mismatches] {
+            local->value = i;
+            for (int round = 0; round < 4; ++round) {
+                Scheduler::yield();
+                if (local->value != i) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    scheduler.run();
+    EXPECT_EQ(mismatches, 0);
+    EXPECT_EQ(Tracked::live, 0);
+}
+
+// 超出内联槽位的键使用溢出数组
+TEST(CoroutineLocalTest, OverflowSlots) {
+    std::vector<int> keys;
+    for (size_t i = 0; i < coroutine_local::kInlineSlots + 20; ++i) {
+        keys.push_back(coroutine_local::create_key());
+        ASSERT_GE(keys.back(), 0);
+    }
+    std::vector<int> values(keys.size());
+
+    bool checked = false;
+    CoroutinePtr co = Coroutine::create([&] {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            ASSERT_TRUE(coroutine_local::set(keys[i], &values[i]));
+        }
+        Coroutine::yield();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(coroutine_local::get(keys[i]), &values[i]);
+        }
+        checked = true;
+    });
+    co->resume();
+    EXPECT_EQ(coroutine_local::get(keys.back()), nullptr);
+    co->resume();
+    EXPECT_TRUE(checked);
+}
+
+// 无效的键
+TEST(CoroutineLocalTest, InvalidKey) {
+    int value = 0;
+    errno = 0;
+    EXPECT_FALSE(coroutine_local::set(-1, &value));
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_FALSE(coroutine_local::set(static_cast<int>(coroutine_local::kMaxKeys), &value));
+    EXPECT_EQ(coroutine_local::get(-1), nullptr);
+    EXPECT_EQ(coroutine_local::get(static_cast<int>(coroutine_local::kMaxKeys)), nullptr);
+}
+
+//============================================================================
+// 析构
+//============================================================================
+
+// 值在协程结束、复用和销毁挂起的协程时析构
+TEST(CoroutineLocalTest, DestructorsRun) {
+    const int key = coroutine_local::create_key(&count_destroy);
+    int value = 0;
+    g_destroyed = 0;
+
+    CoroutinePtr finished = Coroutine::create([&] { coroutine_local::set(key, &value); });
+    finished->resume();
+    EXPECT_EQ(g_destroyed, 1);
+
+    CoroutinePtr suspended = Coroutine::create([&] {
+        coroutine_local::set(key, &value);
+        Coroutine::yield();
+    });
+    suspended->resume();
+    EXPECT_EQ(g_destroyed, 1);
+    suspended.reset();
+    EXPECT_EQ(g_destroyed, 2);
+
+    // 池中复用的协程从空的局部存储开始
+    CoroutinePool pool;
+    void* seen = &value;
+    CoroutinePtr first = pool.acquire([&] { coroutine_local::set(key, &value); });
+    first->resume();
+    first.reset();
+    CoroutinePtr second = pool.acquire([&] { seen = coroutine_local::get(key); });
+    second->resume();
+    EXPECT_EQ(seen, nullptr);
+    EXPECT_EQ(g_destroyed, 3);
+}
+
+// 类型化的局部变量首次访问时构造，线程退出时析构线程本身的值
+TEST(CoroutineLocalTest, TypedLocalLifetime) {
+    static CoroutineLocal<Tracked> local;
+    Tracked::live = 0;
+
+    CoroutinePtr co = Coroutine::create([] {
+        EXPECT_EQ(local.peek(), nullptr);
+        local->value = 7;
+        EXPECT_EQ(Tracked::live, 1);
+        EXPECT_EQ(local.get()->value, 7);
+    });
+    co->resume();
+    EXPECT_EQ(Tracked::live, 0);
+
+    std::thread worker([] {
+        local->value = 1;
+    });
+    worker.join();
+    EXPECT_EQ(Tracked::live, 0);
+}
+
+//============================================================================
+// 切换钩子
+//============================================================================
+
+// 钩子让线程局部变量在每次切换时跟随当前上下文
+TEST(CoroutineLocalTest, SwitchHookFollowsCoroutine) {
+    const int key = coroutine_local::create_key(nullptr, &install_active);
+    int thread_cache = 0;
+    int a_cache = 1;
+    int b_cache = 2;
+    t_active = &thread_cache;
+    ASSERT_TRUE(coroutine_local::set(key, &thread_cache));
+
+    std::vector<void*> seen;
+    auto body = [&](int* cache) {
+        return [&seen, key, cache] {
+            seen.push_back(t_active);           // 尚未设置：钩子装入空值
+            coroutine_local::set(key, cache);
+            t_active = cache;
+            Coroutine::yield();
+            seen.push_back(t_active);
+        };
+    };
+    CoroutinePtr a = Coroutine::create(body(&a_cache));
+    CoroutinePtr b = Coroutine::create(body(&b_cache));
+    a->resume();
+    EXPECT_EQ(t_active, &thread_cache);
+    b->resume();
+    EXPECT_EQ(t_active, &thread_cache);
+    a->resume();
+    EXPECT_EQ(t_active, &thread_cache);
+    b->resume();
+    EXPECT_EQ(t_active, &thread_cache);
+
+    ASSERT_EQ(seen.size(), 4u);
+    EXPECT_EQ(seen[0], nullptr);
+    EXPECT_EQ(seen[1], nullptr);
+    EXPECT_EQ(seen[2], &a_cache);
+    EXPECT_EQ(seen[3], &b_cache);
+    ASSERT_TRUE(coroutine_local::set(key, nullptr));
+    t_active = nullptr;
+}
+
+// 双方都没有带钩子的值时不调用钩子
+TEST(CoroutineLocalTest, SwitchHookSkippedWithoutValues) {
+    coroutine_local::create_key(nullptr, &install_active);
+    g_hook_calls = 0;
+    CoroutinePtr co = Coroutine::create([] { Coroutine::yield(); });
+    co->resume();
+    co->resume();
+    EXPECT_EQ(g_hook_calls, 0);
+}
@@ -0,0 +1,260 @@
+/**
+ * @file test_coroutine_pool.cpp
+ * @brief 协程池测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证结束的协程连同栈一起复用 (栈页保持驻留)、调度器销毁的协程回到池中、
+ * 并发上限、空闲上限、低水位收缩和收缩定时器，以及热路径上的命中率。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/coroutine_pool.h"
+#include "libco_oop/io_manager.h"
+#include <sys/mman.h>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace libco_oop;
+
+namespace {
+
+/**
+ * @brief 统计一段内存中已驻留的物理页数量
+ */
+size_t resident_pages(void* begin, size_t length) {
+    const size_t page = Stack::page_size();
+    std::vector<unsigned char> vec((length + page - 1) / page);
+    if (::mincore(begin, length, vec.data()) != 0) {
+        return static_cast<size_t>(-1);
+    }
+    size_t count = 0;
+    for (unsigned char v : vec) {
+        count += (v & 1);
+    }
+    return count;
+}
+
+__attribute__((noinline)) void touch_stack(size_t bytes) {
+    volatile char frame[4096];
+    for (size_t i = 0; i < sizeof(frame); i += 64) {
+        frame[i] = 1;
+    }
+    if (bytes > sizeof(frame)) {
+        touch_stack(bytes - sizeof(frame));
+    }
+    frame[0] = 0;               // 阻止尾调用，确保每一层都占用栈
+}
+
+/**
+ * @brief 运行协程直到结束
+ */
+void run_to_end(Coroutine& coroutine) {
+    while (!coroutine.is_finished()) {
+        coroutine.resume();
+    }
+}
+
+} // namespace
+
+//============================================================================
+// 复用测试
+//============================================================================
+
+// 结束的协程回到池中，下一个任务复用同一控制块和同一个栈，栈页不再缺页
+TEST(CoroutinePoolTest, WarmReuse) {
+    CoroutinePool pool;
+    CoroutinePtr first = pool.acquire([] { touch_stack(32 * 1024); });
+    ASSERT_NE(first, nullptr);
+    run_to_end(*first);
+    Coroutine* const block = first.get();
+    Stack* const stack = first->get_stack();
+    const uint64_t first_id = first->get_id();
+    const size_t resident = resident_pages(stack->get_base(), stack->get_size());
+    EXPECT_GE(resident, 8u);
+    first.reset();
+    EXPECT_EQ(pool.get_idle_count(), 1u);
+    EXPECT_EQ(pool.get_active_count(), 0u);
+
+    int runs = 0;
+    CoroutinePtr second = pool.acquire([&runs] { ++runs; Coroutine::yield(); ++runs; });
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(second.get(), block);
+    EXPECT_EQ(second->get_stack(), stack);
+    EXPECT_NE(second->get_id(), first_id);
+    EXPECT_EQ(second->get_state(), CoroutineState::READY);
+    EXPECT_EQ(resident_pages(stack->get_base(), stack->get_size()), resident);
+    run_to_end(*second);
+    EXPECT_EQ(runs, 2);
+    second.reset();
+
+    CoroutinePoolStatistics stats = pool.get_statistics();
+    EXPECT_EQ(stats.acquired, 2u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.created, 1u);
+    EXPECT_EQ(stats.recycled, 2u);
+    EXPECT_EQ(stats.idle, 1u);
+}
+
+// 调度器销毁结束的协程时协程回到池中，可以再次交给调度器
+TEST(CoroutinePoolTest, SchedulerReturnsToPool) {
+    CoroutinePool pool;
+    Scheduler scheduler;
+    int counter = 0;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_NE(pool.spawn(scheduler, [&counter] { Scheduler::yield(); ++counter; }), nullptr);
+        }
+        EXPECT_EQ(pool.get_active_count(), 4u);
+        scheduler.run();
+        EXPECT_EQ(pool.get_active_count(), 0u);
+        EXPECT_EQ(pool.get_idle_count(), 4u);
+    }
+    EXPECT_EQ(counter, 12);
+    EXPECT_EQ(scheduler.get_statistics().finished, 12u);
+    CoroutinePoolStatistics stats = pool.get_statistics();
+    EXPECT_EQ(stats.created, 4u);
+    EXPECT_EQ(stats.hits, 8u);
+}
+
+// 挂起的协程和超出空闲上限的协程直接销毁
+TEST(CoroutinePoolTest, DiscardsUnreusable) {
+    CoroutinePoolOptions opts;
+    opts.max_idle = 1;
+    CoroutinePool pool(opts);
+
+    CoroutinePtr suspended = pool.acquire([] { Coroutine::yield(); });
+    suspended->resume();
+    suspended.reset();
+    EXPECT_EQ(pool.get_idle_count(), 0u);
+
+    CoroutinePtr a = pool.acquire([] {});
+    CoroutinePtr b = pool.acquire([] {});
+    a->resume();
+    b->resume();
+    a.reset();
+    b.reset();
+    EXPECT_EQ(pool.get_idle_count(), 1u);
+
+    // 没运行过的协程可以直接复用
+    CoroutinePtr unused = pool.acquire([] {});
+    unused.reset();
+    EXPECT_EQ(pool.get_idle_count(), 1u);
+    EXPECT_EQ(pool.get_statistics().discarded, 2u);
+    EXPECT_EQ(pool.get_active_count(), 0u);
+
+    // 在其他线程销毁的协程只释放并发名额
+    CoroutinePtr migrated = pool.acquire([] {});
+    std::thread([&migrated] { migrated.reset(); }).join();
+    EXPECT_EQ(pool.get_active_count(), 0u);
+    EXPECT_EQ(pool.get_idle_count(), 0u);
+}
+
+//============================================================================
+// 容量控制测试
+//============================================================================
+
+// 达到 max_active 后拒绝借出，协程结束后名额释放
+TEST(CoroutinePoolTest, BoundedConcurrency) {
+    CoroutinePoolOptions opts;
+    opts.max_active = 2;
+    CoroutinePool pool(opts);
+    Scheduler scheduler;
+
+    ASSERT_NE(pool.spawn(scheduler, [] {}), nullptr);
+    ASSERT_NE(pool.spawn(scheduler, [] {}), nullptr);
+    errno = 0;
+    EXPECT_EQ(pool.spawn(scheduler, [] {}), nullptr);
+    EXPECT_EQ(errno, EAGAIN);
+    EXPECT_EQ(pool.get_statistics().rejected, 1u);
+
+    scheduler.run();
+    EXPECT_NE(pool.spawn(scheduler, [] {}), nullptr);
+    scheduler.run();
+    EXPECT_EQ(pool.get_active_count(), 0u);
+}
+
+// 一个周期内始终空闲的协程被释放，借出过的部分保留
+TEST(CoroutinePoolTest, ShrinkByLowWaterMark) {
+    CoroutinePoolOptions opts;
+    opts.min_idle = 2;
+    CoroutinePool pool(opts);
+    EXPECT_EQ(pool.reserve(10), 10u);
+    pool.shrink();                  // 从这里开始计算低水位
+
+    // 同时借出 3 个：低水位为 7
+    std::vector<CoroutinePtr> busy;
+    for (int i = 0; i < 3; ++i) {
+        busy.push_back(pool.acquire([] {}));
+    }
+    busy.clear();
+    EXPECT_EQ(pool.get_idle_count(), 10u);
+    EXPECT_EQ(pool.shrink(), 5u);
+    EXPECT_EQ(pool.get_idle_count(), 5u);
+
+    // 没有借出：收缩到 min_idle
+    EXPECT_EQ(pool.shrink(), 3u);
+    EXPECT_EQ(pool.get_idle_count(), 2u);
+    EXPECT_EQ(pool.shrink(), 0u);
+    EXPECT_EQ(pool.get_statistics().trimmed, 8u);
+
+    pool.clear();
+    EXPECT_EQ(pool.get_idle_count(), 0u);
+}
+
+// 收缩定时器在 IOManager 上运行，收缩到位后 run() 返回
+TEST(CoroutinePoolTest, ShrinkTimer) {
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    CoroutinePoolOptions opts;
+    opts.min_idle = 1;
+    opts.shrink_interval_ms = 5;
+    CoroutinePool pool(opts);
+    ASSERT_TRUE(pool.start_shrink_timer(io));
+
+    for (int i = 0; i < 8; ++i) {
+        pool.spawn(io, [] { co_sleep(1); });
+    }
+    auto start = std::chrono::steady_clock::now();
+    io.run();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(pool.get_idle_count(), 1u);
+    EXPECT_EQ(pool.get_statistics().trimmed, 7u);
+    EXPECT_LT(elapsed, std::chrono::seconds(1));
+
+    // 再次有协程回到池中时定时器重新启动
+    pool.spawn(io, [] {});
+    pool.spawn(io, [] {});
+    io.run();
+    EXPECT_EQ(pool.get_idle_count(), 1u);
+    pool.stop_shrink_timer();
+
+    CoroutinePoolOptions disabled;
+    disabled.shrink_interval_ms = 0;
+    EXPECT_FALSE(CoroutinePool(disabled).start_shrink_timer(io));
+}
+
+//============================================================================
+// 性能测试
+//============================================================================
+
+// 命中时借出、运行、归还一个协程的耗时 (只输出；耗时上限由 BM_CreateFromCoroutinePool 经 bench_gate 检查)
+TEST(CoroutinePoolTest, AcquirePerformance) {
+    CoroutinePool& pool = CoroutinePool::local();
+    pool.reserve(1);
+    const int iterations = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        CoroutinePtr coroutine = pool.acquire([] {});
+        coroutine->resume();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    double avg = static_cast<double>(elapsed) / iterations;
+    std::cout << "pooled acquire + resume + release: " << avg << " ns" << std::endl;
+    CoroutinePoolStatistics stats = pool.get_statistics();
+    EXPECT_GE(static_cast<double>(stats.hits) / static_cast<double>(stats.acquired), 0.95);
+}
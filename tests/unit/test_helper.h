@@ -7,6 +7,10 @@
 #include <vector>
 #include <string>
 #include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__)
+#include <xmmintrin.h>
+#endif
 
 namespace libco_oop {
 namespace test {
@@ -137,6 +141,57 @@ public:
     static void exception_throwing_function();
 };
 
+//============================================================================
+// 浮点控制寄存器
+//============================================================================
+
+/**
+ * @brief 平台默认的浮点控制寄存器值 (x86_64 为 MXCSR，AArch64 为 FPCR)
+ */
+#if defined(__x86_64__)
+constexpr uint32_t kDefaultFpControl = 0x1F80;
+#else
+constexpr uint32_t kDefaultFpControl = 0;
+#endif
+
+/**
+ * @brief 读取当前线程的浮点控制寄存器
+ *
+ * 用于观察 FPU 状态是否随上下文切换保存和恢复。
+ */
+inline uint32_t read_fp_control() {
+#if defined(__x86_64__)
+    return _mm_getcsr();
+#else
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    return static_cast<uint32_t>(fpcr);
+#endif
+}
+
+/**
+ * @brief 写入当前线程的浮点控制寄存器
+ */
+inline void write_fp_control(uint32_t value) {
+#if defined(__x86_64__)
+    _mm_setcsr(value);
+#else
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(static_cast<uint64_t>(value)));
+#endif
+}
+
+/**
+ * @brief 默认值基础上设置舍入模式后的控制寄存器值
+ * @param mode 舍入模式 (0-3，两个平台的编码相同，3 为向零舍入)
+ */
+constexpr uint32_t fp_control_with_rounding(unsigned int mode) {
+#if defined(__x86_64__)
+    return kDefaultFpControl | ((mode & 3u) << 13);
+#else
+    return kDefaultFpControl | ((mode & 3u) << 22);
+#endif
+}
+
 /**
  * @brief 测试断言宏扩展
  */
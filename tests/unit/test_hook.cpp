@@ -0,0 +1,239 @@
+/**
+ * @file test_hook.cpp
+ * @brief 系统调用接管测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证阻塞套接字在协程中变为挂起、睡眠与 poll 超时不阻塞线程、
+ * 协程外保持透传和阻塞语义，以及透传判断的开销。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/hook.h"
+#include "libco_oop/io_manager.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace libco_oop;
+
+namespace {
+
+constexpr double kPassthroughTargetNs = 5.0;    ///< 透传判断的目标开销
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+class HookTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // 用户视角的阻塞套接字
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair_), 0);
+    }
+
+    void TearDown() override {
+        ::close(pair_[0]);
+        ::close(pair_[1]);
+    }
+
+    int pair_[2] = {-1, -1};
+};
+
+//============================================================================
+// 核心测试用例
+//============================================================================
+
+// 阻塞套接字上的 read 挂起协程而不是阻塞线程
+TEST_F(HookTest, BlockingReadYields) {
+    IOManager io;
+    std::vector<std::string> trace;
+    std::string received;
+
+    io.spawn([&] {
+        EXPECT_EQ(syscall_hook::active_manager(), &io);
+        char buffer[64];
+        trace.push_back("read");
+        ssize_t n = ::read(pair_[0], buffer, sizeof(buffer));
+        ASSERT_GT(n, 0);
+        received.assign(buffer, static_cast<size_t>(n));
+        trace.push_back("got");
+    });
+    io.spawn([&] {
+        trace.push_back("write");
+        EXPECT_EQ(::write(pair_[1], "hello", 5), 5);
+    });
+
+    io.run();
+    EXPECT_EQ(received, "hello");
+    std::vector<std::string> expected = {"read", "write", "got"};
+    EXPECT_EQ(trace, expected);
+
+    // 内部设置的 O_NONBLOCK 对用户不可见
+    EXPECT_EQ(::fcntl(pair_[0], F_GETFL) & O_NONBLOCK, 0);
+}
+
+// 被接管的 fd 在协程外仍保持阻塞语义
+TEST_F(HookTest, BlockingSemanticsOutsideCoroutine) {
+    IOManager io;
+    io.spawn([&] {
+        EXPECT_EQ(::write(pair_[1], "x", 1), 1);
+        char byte;
+        EXPECT_EQ(::read(pair_[0], &byte, 1), 1);
+    });
+    io.run();
+
+    EXPECT_EQ(syscall_hook::active_manager(), nullptr);
+    std::thread writer([this] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_EQ(::write(pair_[1], "late", 4), 4);
+    });
+    char buffer[8];
+    EXPECT_EQ(::read(pair_[0], buffer, sizeof(buffer)), 4);
+    writer.join();
+}
+
+// usleep/nanosleep 挂起当前协程，其他协程继续运行
+TEST_F(HookTest, SleepDoesNotBlockThread) {
+    IOManager io;
+    std::vector<std::string> trace;
+    auto start = std::chrono::steady_clock::now();
+
+    io.spawn([&] {
+        ::usleep(30 * 1000);
+        trace.push_back("usleep");
+    });
+    io.spawn([&] {
+        timespec duration{0, 10 * 1000 * 1000};
+        timespec remaining{1, 1};
+        EXPECT_EQ(::nanosleep(&duration, &remaining), 0);
+        EXPECT_EQ(remaining.tv_sec, 0);
+        trace.push_back("nanosleep");
+    });
+    io.spawn([&] {
+        trace.push_back("running");
+    });
+
+    io.run();
+    double elapsed = elapsed_ms(start);
+    std::vector<std::string> expected = {"running", "nanosleep", "usleep"};
+    EXPECT_EQ(trace, expected);
+    EXPECT_GE(elapsed, 30.0);
+    EXPECT_LT(elapsed, 60.0);   // 两次睡眠并发，而不是串行
+}
+
+// poll 的超时与就绪
+TEST_F(HookTest, PollSuspends) {
+    IOManager io;
+    int timed_out = -1;
+    int ready = -1;
+    short revents = 0;
+    double waited = 0;
+
+    io.spawn([&] {
+        pollfd request{pair_[0], POLLIN, 0};
+        auto start = std::chrono::steady_clock::now();
+        timed_out = ::poll(&request, 1, 20);
+        waited = elapsed_ms(start);
+
+        ready = ::poll(&request, 1, -1);
+        revents = request.revents;
+    });
+    io.spawn([&] {
+        ::usleep(40 * 1000);
+        EXPECT_EQ(::write(pair_[1], "x", 1), 1);
+    });
+
+    io.run();
+    EXPECT_EQ(timed_out, 0);
+    EXPECT_GE(waited, 20.0);
+    EXPECT_EQ(ready, 1);
+    EXPECT_TRUE(revents & POLLIN);
+}
+
+// 阻塞 TCP 套接字上的 accept/connect/send/recv
+TEST_F(HookTest, BlockingTcpSockets) {
+    int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_GE(listener, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_EQ(::listen(listener, 16), 0);
+    socklen_t length = sizeof(address);
+    ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length), 0);
+
+    IOManager io;
+    std::string echoed;
+    io.spawn([&] {
+        int client = ::accept(listener, nullptr, nullptr);
+        ASSERT_GE(client, 0);
+        char buffer[64];
+        ssize_t n = ::recv(client, buffer, sizeof(buffer), 0);
+        ASSERT_GT(n, 0);
+        EXPECT_EQ(::send(client, buffer, static_cast<size_t>(n), 0), n);
+        ::close(client);
+    });
+    io.spawn([&] {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+        EXPECT_EQ(::send(fd, "ping", 4, 0), 4);
+        char buffer[64];
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        ASSERT_GT(n, 0);
+        echoed.assign(buffer, static_cast<size_t>(n));
+        ::close(fd);
+    });
+
+    io.run();
+    ::close(listener);
+    EXPECT_EQ(echoed, "ping");
+    EXPECT_EQ(io.get_live_count(), 0u);
+}
+
+// 禁用后协程中也直接透传；透传判断只需几纳秒
+TEST_F(HookTest, PassthroughCheckOverhead) {
+    IOManager io;
+    io.spawn([&] {
+        syscall_hook::set_enabled(false);
+        EXPECT_EQ(syscall_hook::active_manager(), nullptr);
+        char byte;
+        EXPECT_EQ(::recv(pair_[0], &byte, 1, MSG_DONTWAIT), -1);
+        EXPECT_EQ(::read(pair_[0], &byte, 0), 0);
+        syscall_hook::set_enabled(true);
+        EXPECT_EQ(syscall_hook::active_manager(), &io);
+    });
+    io.run();
+    EXPECT_TRUE(syscall_hook::is_enabled());
+
+    // 取三轮中最好的一轮，减少单核环境下调度噪声的影响
+    const int iterations = 5 * 1000 * 1000;
+    int hits = 0;
+    double average_ns = 1e9;
+    for (int round = 0; round < 3; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            hits += syscall_hook::active_manager() != nullptr;
+            asm volatile("" ::: "memory");
+        }
+        average_ns = std::min(average_ns, elapsed_ms(start) * 1e6 / iterations);
+    }
+    EXPECT_EQ(hits, 0);
+    std::cout << "passthrough check: " << average_ns << " ns" << std::endl;
+#ifdef NDEBUG
+    EXPECT_LT(average_ns, kPassthroughTargetNs);
+#else
+    EXPECT_LT(average_ns, kPassthroughTargetNs * 10);
+#endif
+}
@@ -0,0 +1,250 @@
+/**
+ * @file test_io_manager.cpp
+ * @brief IO事件驱动调度器测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证边缘触发下的等待与唤醒、就绪标志、取消、TCP accept/connect
+ * 以及大量连接下的单线程吞吐。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/io_manager.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace libco_oop;
+
+//============================================================================
+// 测试辅助工具
+//============================================================================
+
+/**
+ * @brief 创建一对非阻塞的 UNIX 域流套接字
+ */
+static bool make_pair(int fds[2]) {
+    return ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) == 0;
+}
+
+class IOManagerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(make_pair(pair_));
+    }
+
+    void TearDown() override {
+        ::close(pair_[0]);
+        ::close(pair_[1]);
+    }
+
+    int pair_[2] = {-1, -1};
+};
+
+//============================================================================
+// 核心测试用例
+//============================================================================
+
+// 读协程在没有数据时挂起，写入后被唤醒
+TEST_F(IOManagerTest, ReadWaitsForData) {
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    std::string received;
+    std::vector<std::string> trace;
+
+    io.spawn([&] {
+        char buffer[64];
+        trace.push_back("read");
+        ssize_t n = io.read(pair_[0], buffer, sizeof(buffer));
+        ASSERT_GT(n, 0);
+        received.assign(buffer, static_cast<size_t>(n));
+        trace.push_back("got");
+    });
+    io.spawn([&] {
+        EXPECT_EQ(io.get_statistics().waiting, 1u);
+        trace.push_back("write");
+        EXPECT_EQ(io.write(pair_[1], "hello", 5), 5);
+    });
+
+    io.run();
+
+    EXPECT_EQ(received, "hello");
+    std::vector<std::string> expected = {"read", "write", "got"};
+    EXPECT_EQ(trace, expected);
+    IOStatistics stats = io.get_statistics();
+    EXPECT_EQ(stats.waiting, 0u);
+    EXPECT_EQ(stats.wakeups, 1u);
+    EXPECT_EQ(stats.registrations, 1u);
+    EXPECT_EQ(io.get_live_count(), 0u);
+}
+
+// 每个 fd 只注册一次；边缘触发下没有等待者时到达的事件不会丢失
+TEST_F(IOManagerTest, EdgeTriggeredReadiness) {
+    IOManager io;
+    const int messages = 100;
+    int received = 0;
+
+    io.spawn([&] {
+        char byte;
+        while (received < messages) {
+            ssize_t n = io.read(pair_[0], &byte, 1);
+            ASSERT_EQ(n, 1);
+            EXPECT_EQ(byte, static_cast<char>(received));
+            ++received;
+            // 对端可能在我们处理期间写入，事件到达时没有等待者
+            Scheduler::yield();
+        }
+    });
+    io.spawn([&] {
+        for (int i = 0; i < messages; ++i) {
+            char byte = static_cast<char>(i);
+            ASSERT_EQ(io.write(pair_[1], &byte, 1), 1);
+            if (i % 3 == 0) {
+                Scheduler::yield();
+            }
+        }
+    });
+
+    io.run();
+    EXPECT_EQ(received, messages);
+    // 只有读端需要等待，且反复等待也只注册一次
+    EXPECT_EQ(io.get_statistics().registrations, 1u);
+}
+
+// remove_fd() 取消等待者，不在协程中时辅助函数直接返回 EAGAIN
+TEST_F(IOManagerTest, RemoveCancelsWaiter) {
+    IOManager io;
+    int result = 0;
+    int error = 0;
+
+    io.spawn([&] {
+        char buffer[8];
+        result = static_cast<int>(io.read(pair_[0], buffer, sizeof(buffer)));
+        error = errno;
+    });
+    io.spawn([&] {
+        EXPECT_TRUE(io.remove_fd(pair_[0]));
+        EXPECT_FALSE(io.remove_fd(pair_[0]));
+    });
+
+    io.run();
+    EXPECT_EQ(result, -1);
+    EXPECT_EQ(error, ECANCELED);
+
+    char buffer[8];
+    EXPECT_EQ(io.read(pair_[0], buffer, sizeof(buffer)), -1);
+    EXPECT_EQ(errno, EAGAIN);
+    EXPECT_EQ(io.wait_for(pair_[0], IOEventType::READ), -1);
+    EXPECT_EQ(errno, EPERM);
+}
+
+// 非阻塞 TCP accept/connect 与收发
+TEST_F(IOManagerTest, TcpAcceptConnect) {
+    int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ASSERT_GE(listener, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_EQ(::listen(listener, 16), 0);
+    socklen_t length = sizeof(address);
+    ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length), 0);
+
+    IOManager io;
+    std::string echoed;
+
+    io.spawn([&] {
+        int client = io.accept(listener, nullptr, nullptr);
+        ASSERT_GE(client, 0);
+        char buffer[64];
+        ssize_t n = io.recv(client, buffer, sizeof(buffer), 0);
+        ASSERT_GT(n, 0);
+        EXPECT_EQ(io.send(client, buffer, static_cast<size_t>(n), 0), n);
+        io.close(client);
+    });
+    io.spawn([&] {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(io.connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+        EXPECT_EQ(io.send(fd, "ping", 4, 0), 4);
+        char buffer[64];
+        ssize_t n = io.recv(fd, buffer, sizeof(buffer), 0);
+        ASSERT_GT(n, 0);
+        echoed.assign(buffer, static_cast<size_t>(n));
+        // 对端关闭后读到 EOF
+        EXPECT_EQ(io.recv(fd, buffer, sizeof(buffer), 0), 0);
+        io.close(fd);
+    });
+
+    io.run();
+    io.close(listener);
+    EXPECT_EQ(echoed, "ping");
+}
+
+// 大量连接的回显往返，fd 表按需扩容
+TEST_F(IOManagerTest, ManyConnections) {
+    const int connections = 2000;
+    const int rounds = 10;
+    // 保护页每个栈占两个映射区，大量协程使用共享栈
+    SharedStackAllocator shared(4, StackOptions{64 * 1024});
+    CoroutineOptions opts;
+    opts.stack_allocator = &shared;
+
+    IOManagerOptions io_opts;
+    io_opts.initial_fds = 16;
+    IOManager io(io_opts);
+    std::vector<int> fds;
+    int completed = 0;
+    std::vector<double> latencies;
+    latencies.reserve(static_cast<size_t>(connections) * rounds);
+
+    for (int i = 0; i < connections; ++i) {
+        int pair[2];
+        ASSERT_TRUE(make_pair(pair));
+        fds.push_back(pair[0]);
+        fds.push_back(pair[1]);
+        io.spawn([&io, fd = pair[1]] {
+            char buffer[16];
+            ssize_t n;
+            while ((n = io.read(fd, buffer, sizeof(buffer))) > 0) {
+                io.write(fd, buffer, static_cast<size_t>(n));
+            }
+        }, opts);
+        io.spawn([&, fd = pair[0]] {
+            char buffer[16];
+            for (int round = 0; round < rounds; ++round) {
+                auto start = std::chrono::steady_clock::now();
+                ASSERT_EQ(io.write(fd, "abcd", 4), 4);
+                ASSERT_EQ(io.read(fd, buffer, sizeof(buffer)), 4);
+                latencies.push_back(std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+            }
+            ::shutdown(fd, SHUT_WR);
+            ++completed;
+        }, opts);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    io.run();
+    double elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(completed, connections);
+    EXPECT_EQ(io.get_live_count(), 0u);
+    std::sort(latencies.begin(), latencies.end());
+    double p99 = latencies[latencies.size() * 99 / 100];
+    std::cout << connections << " connections x " << rounds << " round trips: " << elapsed
+              << " ms, p99 " << p99 << " us, " << io.get_statistics().polls << " polls" << std::endl;
+
+    for (int fd : fds) {
+        io.close(fd);
+    }
+}
@@ -0,0 +1,239 @@
+/**
+ * @file test_io_uring.cpp
+ * @brief IOManager io_uring 后端测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证批量提交、完成唤醒、取消、TCP accept/connect、注册缓冲区和
+ * 固定文件，以及销毁时未完成请求的清理。内核不支持 io_uring 时跳过。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/io_manager.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace libco_oop;
+
+//============================================================================
+// 测试辅助工具
+//============================================================================
+
+static bool make_pair(int fds[2]) {
+    return ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) == 0;
+}
+
+static IOManagerOptions uring_options() {
+    IOManagerOptions opts;
+    opts.backend = IOBackend::IO_URING;
+    return opts;
+}
+
+class IoUringTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        IOManager probe(uring_options());
+        if (!probe.is_valid()) {
+            GTEST_SKIP() << "io_uring is not available";
+        }
+        ASSERT_TRUE(make_pair(pair_));
+    }
+
+    void TearDown() override {
+        if (pair_[0] >= 0) {
+            ::close(pair_[0]);
+            ::close(pair_[1]);
+        }
+    }
+
+    int pair_[2] = {-1, -1};
+};
+
+//============================================================================
+// 核心测试用例
+//============================================================================
+
+// 后端选择：AUTO 优先 io_uring，EPOLL 后端不支持注册资源
+TEST_F(IoUringTest, BackendSelection) {
+    IOManagerOptions opts;
+    opts.backend = IOBackend::AUTO;
+    IOManager automatic(opts);
+    EXPECT_TRUE(automatic.is_valid());
+    EXPECT_EQ(automatic.get_backend(), IOBackend::IO_URING);
+
+    IOManager epoll;
+    EXPECT_EQ(epoll.get_backend(), IOBackend::EPOLL);
+    EXPECT_FALSE(epoll.register_files(pair_, 2));
+    EXPECT_EQ(errno, EOPNOTSUPP);
+    char byte;
+    EXPECT_EQ(epoll.read(FixedFile{0}, &byte, 1), -1);
+    EXPECT_EQ(errno, EOPNOTSUPP);
+
+    // 不在协程中时直接执行非阻塞系统调用
+    EXPECT_EQ(automatic.read(pair_[0], &byte, 1), -1);
+    EXPECT_EQ(errno, EAGAIN);
+}
+
+// 同一轮调度中的请求一次提交，完成后唤醒
+TEST_F(IoUringTest, BatchedSubmission) {
+    const int count = 32;
+    std::vector<int> fds;
+    for (int i = 0; i < count; ++i) {
+        int pair[2];
+        ASSERT_TRUE(make_pair(pair));
+        fds.push_back(pair[0]);
+        fds.push_back(pair[1]);
+    }
+
+    IOManager io(uring_options());
+    int echoed = 0;
+    for (int i = 0; i < count; ++i) {
+        io.spawn([&, fd = fds[2 * i]] {
+            char buffer[16];
+            ASSERT_EQ(io.read(fd, buffer, sizeof(buffer)), 4);
+            ++echoed;
+        });
+    }
+    for (int i = 0; i < count; ++i) {
+        io.spawn([&, fd = fds[2 * i + 1]] {
+            EXPECT_EQ(io.write(fd, "ping", 4), 4);
+        });
+    }
+
+    io.run();
+    EXPECT_EQ(echoed, count);
+
+    IOStatistics stats = io.get_statistics();
+    EXPECT_EQ(stats.submissions, static_cast<uint64_t>(2 * count));
+    EXPECT_EQ(stats.wakeups, static_cast<uint64_t>(2 * count));
+    EXPECT_EQ(stats.waiting, 0u);
+    // 64 个请求只需少量 io_uring_enter
+    EXPECT_LT(stats.polls, static_cast<uint64_t>(count));
+    for (int fd : fds) {
+        ::close(fd);
+    }
+}
+
+// remove_fd() 取消未完成的读请求
+TEST_F(IoUringTest, RemoveCancelsRequest) {
+    IOManager io(uring_options());
+    int result = 0;
+    int error = 0;
+
+    io.spawn([&] {
+        char buffer[8];
+        result = static_cast<int>(io.read(pair_[0], buffer, sizeof(buffer)));
+        error = errno;
+    });
+    io.spawn([&] {
+        EXPECT_EQ(io.get_statistics().waiting, 1u);
+        EXPECT_TRUE(io.remove_fd(pair_[0]));
+        EXPECT_FALSE(io.remove_fd(pair_[1]));
+    });
+
+    io.run();
+    EXPECT_EQ(result, -1);
+    EXPECT_EQ(error, ECANCELED);
+}
+
+// wait_for() 使用 POLL_ADD，TCP accept/connect 与收发
+TEST_F(IoUringTest, TcpAcceptConnect) {
+    int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ASSERT_GE(listener, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_EQ(::listen(listener, 16), 0);
+    socklen_t length = sizeof(address);
+    ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length), 0);
+
+    IOManager io(uring_options());
+    std::string echoed;
+
+    io.spawn([&] {
+        EXPECT_EQ(io.wait_for(listener, IOEventType::READ), 0);
+        int client = io.accept(listener, nullptr, nullptr);
+        ASSERT_GE(client, 0);
+        char buffer[64];
+        ssize_t n = io.recv(client, buffer, sizeof(buffer), 0);
+        ASSERT_GT(n, 0);
+        EXPECT_EQ(io.send(client, buffer, static_cast<size_t>(n), 0), n);
+        io.close(client);
+    });
+    io.spawn([&] {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(io.connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+        EXPECT_EQ(io.send(fd, "ping", 4, 0), 4);
+        char buffer[64];
+        ssize_t n = io.recv(fd, buffer, sizeof(buffer), 0);
+        ASSERT_GT(n, 0);
+        echoed.assign(buffer, static_cast<size_t>(n));
+        EXPECT_EQ(io.recv(fd, buffer, sizeof(buffer), 0), 0);
+        io.close(fd);
+    });
+
+    io.run();
+    io.close(listener);
+    EXPECT_EQ(echoed, "ping");
+}
+
+// 注册缓冲区与固定文件上的读写
+TEST_F(IoUringTest, FixedBuffersAndFiles) {
+    IOManager io(uring_options());
+    static char buffers[2][64];
+    iovec vectors[2] = {{buffers[0], sizeof(buffers[0])}, {buffers[1], sizeof(buffers[1])}};
+    ASSERT_TRUE(io.register_buffers(vectors, 2));
+    int files[2] = {pair_[0], -1};
+    ASSERT_TRUE(io.register_files(files, 2));
+    ASSERT_TRUE(io.update_files(1, &pair_[1], 1));
+
+    std::string first;
+    std::string second;
+    io.spawn([&] {
+        ssize_t n = io.read_fixed(FixedFile{0}, buffers[0], sizeof(buffers[0]), 0);
+        ASSERT_GT(n, 0);
+        first.assign(buffers[0], static_cast<size_t>(n));
+        n = io.read(FixedFile{0}, buffers[0], sizeof(buffers[0]));
+        ASSERT_GT(n, 0);
+        second.assign(buffers[0], static_cast<size_t>(n));
+    });
+    io.spawn([&] {
+        std::memcpy(buffers[1], "fixed", 5);
+        EXPECT_EQ(io.write_fixed(FixedFile{1}, buffers[1], 5, 1), 5);
+        Scheduler::yield();
+        EXPECT_EQ(io.write_fixed(pair_[1], buffers[1], 3, 1), 3);
+    });
+
+    io.run();
+    EXPECT_EQ(first, "fixed");
+    EXPECT_EQ(second, "fix");
+    EXPECT_TRUE(io.unregister_files());
+    EXPECT_TRUE(io.unregister_buffers());
+}
+
+// 销毁调度器时取消未完成的请求并销毁等待的协程
+TEST_F(IoUringTest, DestroyWithPendingRequests) {
+    bool finished = false;
+    {
+        IOManager io(uring_options());
+        io.spawn([&] {
+            char buffer[8];
+            io.read(pair_[0], buffer, sizeof(buffer));
+            finished = true;
+        });
+        io.spawn([&] {
+            io.stop();
+        });
+        io.run();
+        EXPECT_EQ(io.get_live_count(), 1u);
+    }
+    EXPECT_FALSE(finished);
+}
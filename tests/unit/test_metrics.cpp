@@ -0,0 +1,223 @@
+/**
+ * @file test_metrics.cpp
+ * @brief 运行指标测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证每协程的切换次数、运行周期和栈深度，各类调度器的计数器与登记，
+ * 线程退出后计数并入进程总数，以及 Prometheus 文本输出。
+ * 运行指标关闭的构建只验证接口仍然可用且不产生数据。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/io_manager.h"
+#include "libco_oop/metrics.h"
+#include "libco_oop/scheduler.h"
+#include "libco_oop/work_stealing.h"
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+
+using namespace libco_oop;
+
+namespace {
+
+/**
+ * @brief 在快照中查找调度器
+ */
+const metrics::SchedulerMetrics* find_scheduler(const metrics::MetricsSnapshot& snapshot, uint64_t id) {
+    for (const metrics::SchedulerMetrics& scheduler : snapshot.schedulers) {
+        if (scheduler.id == id) {
+            return &scheduler;
+        }
+    }
+    return nullptr;
+}
+
+__attribute__((noinline)) void deep_yield(int levels) {
+    volatile char frame[1024];
+    std::memset(const_cast<char*>(frame), levels, sizeof(frame));
+    if (levels > 0) {
+        deep_yield(levels - 1);
+    } else {
+        Coroutine::yield();
+    }
+}
+
+} // namespace
+
+//============================================================================
+// 协程指标测试
+//============================================================================
+
+// 切换次数一直统计；运行周期和最大栈深度只在开启时统计
+TEST(MetricsTest, CoroutineCounters) {
+    CoroutinePtr coroutine = Coroutine::create([] {
+        Coroutine::yield();
+        deep_yield(8);          // 至少 8KB 栈深度
+        Coroutine::yield();
+    });
+    ASSERT_NE(coroutine, nullptr);
+    while (!coroutine->is_finished()) {
+        coroutine->resume();
+    }
+
+    metrics::CoroutineMetrics stats = coroutine->get_metrics();
+    EXPECT_EQ(stats.switches, 4u);
+    if (metrics::kEnabled) {
+        EXPECT_GT(stats.run_cycles, 0u);
+        EXPECT_GE(stats.max_stack_depth, 8u * 1024);
+        EXPECT_LT(stats.max_stack_depth, coroutine->get_stack()->get_size());
+    } else {
+        EXPECT_EQ(stats.run_cycles, 0u);
+        EXPECT_EQ(stats.max_stack_depth, 0u);
+    }
+
+    // 复用后指标清零
+    ASSERT_TRUE(coroutine->reset([] {}));
+    EXPECT_EQ(coroutine->get_metrics().switches, 0u);
+    EXPECT_EQ(coroutine->get_metrics().max_stack_depth, 0u);
+}
+
+//============================================================================
+// 调度器指标测试
+//============================================================================
+
+// 调度器构造时登记、析构时注销，切换次数与统计一致
+TEST(MetricsTest, SchedulerRegistration) {
+    uint64_t id = 0;
+    {
+        Scheduler scheduler;
+        for (int i = 0; i < 3; ++i) {
+            scheduler.spawn([] {
+                for (int n = 0; n < 5; ++n) {
+                    Scheduler::yield();
+                }
+            });
+        }
+        scheduler.run();
+
+        metrics::SchedulerMetrics stats = scheduler.get_metrics();
+        EXPECT_STREQ(stats.kind, "scheduler");
+        if (!metrics::kEnabled) {
+            EXPECT_EQ(stats.switches, 0u);
+            EXPECT_TRUE(metrics::snapshot().schedulers.empty());
+            return;
+        }
+        EXPECT_EQ(stats.switches, scheduler.get_statistics().dispatches);
+        EXPECT_EQ(stats.switches, 18u);
+        id = stats.id;
+        const metrics::MetricsSnapshot snapshot = metrics::snapshot();
+        const metrics::SchedulerMetrics* listed = find_scheduler(snapshot, id);
+        ASSERT_NE(listed, nullptr);
+        EXPECT_EQ(listed->switches, 18u);
+    }
+    EXPECT_EQ(find_scheduler(metrics::snapshot(), id), nullptr);
+}
+
+// IOManager 统计IO等待和定时器到期
+TEST(MetricsTest, IOManagerWaitsAndTimers) {
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    io.spawn([&] {
+        EXPECT_EQ(io.wait_for(fds[0], IOEventType::READ, 1000), 0);
+        char byte;
+        EXPECT_EQ(read(fds[0], &byte, 1), 1);
+    });
+    io.spawn([&] {
+        co_sleep(1);
+        EXPECT_EQ(write(fds[1], "x", 1), 1);
+    });
+    io.run();
+    close(fds[0]);
+    close(fds[1]);
+
+    metrics::SchedulerMetrics stats = io.get_metrics();
+    EXPECT_STREQ(stats.kind, "io_manager");
+    if (metrics::kEnabled) {
+        EXPECT_EQ(stats.io_waits, 1u);
+        EXPECT_GE(stats.timer_fires, 1u);
+        EXPECT_EQ(stats.switches, static_cast<const Scheduler&>(io).get_statistics().dispatches);
+    } else {
+        EXPECT_EQ(stats.io_waits, 0u);
+    }
+}
+
+// 工作窃取调度器的计数器在两种构建中都可读
+TEST(MetricsTest, WorkStealingAggregatesWorkers) {
+    WorkStealingOptions opts;
+    opts.worker_count = 2;
+    WorkStealingScheduler scheduler(opts);
+    for (int i = 0; i < 16; ++i) {
+        scheduler.spawn([] {
+            for (int n = 0; n < 4; ++n) {
+                WorkStealingScheduler::yield();
+            }
+        });
+    }
+    scheduler.wait();
+
+    metrics::SchedulerMetrics stats = scheduler.get_metrics();
+    WorkStealingStatistics expected = scheduler.get_statistics();
+    EXPECT_STREQ(stats.kind, "work_stealing");
+    EXPECT_EQ(stats.switches, expected.dispatches);
+    EXPECT_EQ(stats.steals, expected.steals);
+    EXPECT_EQ(stats.run_queue, 0u);
+    EXPECT_EQ(find_scheduler(metrics::snapshot(), stats.id) != nullptr, metrics::kEnabled);
+}
+
+//============================================================================
+// 快照与导出测试
+//============================================================================
+
+// 退出线程的计数并入进程总数
+TEST(MetricsTest, ThreadTotalsSurviveExit) {
+    metrics::MetricsSnapshot before = metrics::snapshot();
+
+    std::thread worker([] {
+        CoroutinePtr coroutine = Coroutine::create([] {
+            for (int i = 0; i < 9; ++i) {
+                Coroutine::yield();
+            }
+        });
+        while (!coroutine->is_finished()) {
+            coroutine->resume();
+        }
+    });
+    worker.join();
+
+    metrics::MetricsSnapshot after = metrics::snapshot();
+    EXPECT_EQ(after.enabled, metrics::kEnabled);
+    if (metrics::kEnabled) {
+        EXPECT_EQ(after.threads, before.threads);
+        // 其他测试的线程可能同时在运行协程，只检查下限
+        EXPECT_GE(after.switches - before.switches, 10u);
+        EXPECT_GE(after.coroutines_created - before.coroutines_created, 1u);
+        EXPECT_GE(after.coroutines_finished - before.coroutines_finished, 1u);
+        EXPECT_GT(after.run_cycles, before.run_cycles);
+    } else {
+        EXPECT_EQ(after.switches, 0u);
+        EXPECT_EQ(after.threads, 0u);
+    }
+}
+
+// Prometheus 文本格式：每个指标一组 HELP/TYPE，调度器带标签
+TEST(MetricsTest, PrometheusFormat) {
+    IOManager io;
+    io.spawn([] { co_sleep(1); });
+    io.run();
+
+    const std::string text = metrics::format_prometheus(metrics::snapshot(), "svc");
+    if (!metrics::kEnabled) {
+        EXPECT_TRUE(text.empty());
+        return;
+    }
+    EXPECT_NE(text.find("# TYPE svc_coroutine_switches_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE svc_scheduler_run_queue gauge\n"), std::string::npos);
+    const std::string label = "svc_scheduler_timer_fires_total{kind=\"io_manager\",id=\""
+                            + std::to_string(io.get_metrics().id) + "\"} 1\n";
+    EXPECT_NE(text.find(label), std::string::npos) << text;
+}
@@ -0,0 +1,482 @@
+/**
+ * @file test_scheduler.cpp
+ * @brief 单线程调度器测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证轮转调度、批量派生、挂起与唤醒、yield_to() 直接交接、异常传播、
+ * idle() 扩展点、调度类 (严格优先级、加权、饥饿保护、截止时刻) 以及
+ * 大量就绪协程下的调度延迟。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/scheduler.h"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace libco_oop;
+
+// 与 tests/benchmark/bench_helper.h 中的 SCHEDULING_LATENCY_TARGET_US 一致
+static constexpr double kSchedulingLatencyTargetUs = 100.0;
+
+class SchedulerTest : public ::testing::Test {
+protected:
+    std::vector<std::string> trace_;
+};
+
+//============================================================================
+// 核心测试用例
+//============================================================================
+
+// 就绪协程按轮转顺序执行，结束后由调度器销毁
+TEST_F(SchedulerTest, RoundRobinOrder) {
+    Scheduler scheduler;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_NE(scheduler.spawn([this, i, &scheduler] {
+            EXPECT_EQ(Scheduler::current(), &scheduler);
+            for (int round = 0; round < 2; ++round) {
+                trace_.push_back(std::to_string(i) + ":" + std::to_string(round));
+                EXPECT_TRUE(Scheduler::yield());
+            }
+        }), nullptr);
+    }
+    EXPECT_EQ(scheduler.get_ready_count(), 3u);
+    EXPECT_EQ(Scheduler::current(), nullptr);
+
+    scheduler.run();
+
+    std::vector<std::string> expected = {"0:0", "1:0", "2:0", "0:1", "1:1", "2:1"};
+    EXPECT_EQ(trace_, expected);
+    EXPECT_EQ(scheduler.get_ready_count(), 0u);
+    EXPECT_EQ(scheduler.get_live_count(), 0u);
+    EXPECT_EQ(scheduler.get_statistics().spawned, 3u);
+    EXPECT_EQ(scheduler.get_statistics().finished, 3u);
+    EXPECT_EQ(scheduler.get_statistics().dispatches, 9u);
+    EXPECT_EQ(Scheduler::current(), nullptr);
+}
+
+// 挂起的协程不在就绪队列中，直到被唤醒
+TEST_F(SchedulerTest, SuspendAndSchedule) {
+    Scheduler scheduler;
+    Coroutine* sleeper = scheduler.spawn([this] {
+        trace_.push_back("sleep");
+        EXPECT_TRUE(Scheduler::suspend());
+        trace_.push_back("woken");
+    });
+    ASSERT_NE(sleeper, nullptr);
+    scheduler.spawn([this, sleeper, &scheduler] {
+        trace_.push_back("waker");
+        EXPECT_EQ(scheduler.get_ready_count(), 0u);
+        EXPECT_TRUE(scheduler.schedule(sleeper));
+        EXPECT_TRUE(scheduler.schedule(sleeper));   // 重复唤醒不会重复入队
+        EXPECT_EQ(scheduler.get_ready_count(), 1u);
+    });
+
+    scheduler.run();
+
+    std::vector<std::string> expected = {"sleep", "waker", "woken"};
+    EXPECT_EQ(trace_, expected);
+    EXPECT_EQ(scheduler.get_live_count(), 0u);
+
+    // 不属于调度器的协程不能被调度
+    CoroutinePtr foreign = Coroutine::create([] {});
+    EXPECT_FALSE(scheduler.schedule(foreign.get()));
+    EXPECT_FALSE(Scheduler::suspend());
+}
+
+// yield_to() 在生产者和消费者之间直接交接，不经过调度循环
+TEST_F(SchedulerTest, DirectHandoff) {
+    Scheduler scheduler;
+    const int items = 1000;
+    int slot = -1;
+    int consumed = 0;
+
+    Coroutine* consumer = scheduler.spawn([&] {
+        for (;;) {
+            if (slot < 0) {
+                Scheduler::suspend();
+                continue;
+            }
+            EXPECT_EQ(slot, consumed);
+            slot = -1;
+            if (++consumed == items) {
+                return;
+            }
+            Scheduler::suspend();
+        }
+    });
+    scheduler.spawn([&] {
+        for (int i = 0; i < items; ++i) {
+            slot = i;
+            EXPECT_TRUE(Scheduler::yield_to(consumer));
+        }
+    });
+
+    // 不在协程中不能交接
+    EXPECT_FALSE(Scheduler::yield_to(consumer));
+
+    scheduler.run();
+
+    EXPECT_EQ(consumed, items);
+    EXPECT_EQ(scheduler.get_live_count(), 0u);
+    EXPECT_EQ(scheduler.get_statistics().handoffs, static_cast<uint64_t>(items));
+    // 交接不经过调度循环：每次交接后生产者经调度循环恢复一次
+    EXPECT_LE(scheduler.get_statistics().dispatches, static_cast<uint64_t>(items) + 3);
+}
+
+// 未捕获的异常从 run() 抛出，其他协程之后可以继续调度
+TEST_F(SchedulerTest, ExceptionPropagation) {
+    Scheduler scheduler;
+    int finished = 0;
+    scheduler.spawn([] { throw std::runtime_error("boom"); });
+    scheduler.spawn([&finished] {
+        Scheduler::yield();
+        ++finished;
+    });
+
+    EXPECT_THROW(scheduler.run(), std::runtime_error);
+    EXPECT_EQ(scheduler.get_live_count(), 1u);
+    EXPECT_EQ(Scheduler::current(), nullptr);
+
+    scheduler.run();
+    EXPECT_EQ(finished, 1);
+    EXPECT_EQ(scheduler.get_live_count(), 0u);
+    EXPECT_EQ(scheduler.get_statistics().finished, 2u);
+}
+
+// 批量派生的协程按元素顺序整体接到就绪队列末尾
+TEST_F(SchedulerTest, SpawnBatch) {
+    Scheduler scheduler;
+    scheduler.spawn([this] { trace_.push_back("single"); });
+    const std::vector<std::string> shards = {"a", "b", "c", "d"};
+    EXPECT_EQ(scheduler.spawn_batch(shards.begin(), shards.end(), [this](const std::string& shard) {
+        trace_.push_back(shard);
+        Scheduler::yield();
+        trace_.push_back(shard + "'");
+    }), 4u);
+    EXPECT_EQ(scheduler.get_ready_count(), 5u);
+    EXPECT_EQ(scheduler.get_live_count(), 5u);
+    EXPECT_EQ(scheduler.get_statistics().spawned, 5u);
+    EXPECT_EQ(scheduler.spawn_batch(shards.end(), shards.end(), [](const std::string&) {}), 0u);
+
+    scheduler.run();
+    std::vector<std::string> expected = {"single", "a", "b", "c", "d", "a'", "b'", "c'", "d'"};
+    EXPECT_EQ(trace_, expected);
+    EXPECT_EQ(scheduler.get_statistics().finished, 5u);
+
+    // 批次中有不可恢复的协程时整批拒绝，批次保持不变
+    CoroutineBatch batch;
+    ASSERT_TRUE(batch.add([] {}));
+    CoroutinePtr finished = Coroutine::create([] {});
+    finished->resume();
+    ASSERT_TRUE(batch.push(std::move(finished)));
+    EXPECT_EQ(scheduler.submit_batch(batch), 0u);
+    EXPECT_EQ(batch.size(), 2u);
+    EXPECT_EQ(scheduler.get_ready_count(), 0u);
+}
+
+// stop() 让调度循环在当前协程让出后退出，析构时销毁就绪协程
+TEST_F(SchedulerTest, StopAndDestroy) {
+    int steps = 0;
+    {
+        Scheduler scheduler;
+        for (int i = 0; i < 4; ++i) {
+            scheduler.spawn([&] {
+                for (;;) {
+                    if (++steps % 6 == 0) {
+                        Scheduler::current()->stop();
+                    }
+                    Scheduler::yield();
+                }
+            });
+        }
+        scheduler.run();
+        EXPECT_EQ(steps, 6);
+        EXPECT_EQ(scheduler.get_ready_count(), 4u);
+
+        scheduler.run();
+        EXPECT_EQ(steps, 12);
+        EXPECT_EQ(scheduler.get_live_count(), 4u);
+    }
+}
+
+/**
+ * @brief 就绪队列为空时唤醒一个挂起协程的调度器
+ */
+class WakingScheduler : public Scheduler {
+public:
+    Coroutine* parked = nullptr;
+    int idle_calls = 0;
+
+protected:
+    bool idle() override
+    {
+        ++idle_calls;
+        if (parked == nullptr) {
+            return false;
+        }
+        schedule(parked);
+        parked = nullptr;
+        return true;
+    }
+};
+
+// idle() 扩展点在就绪队列为空时被调用
+TEST_F(SchedulerTest, IdleHook) {
+    WakingScheduler scheduler;
+    bool resumed = false;
+    scheduler.parked = scheduler.spawn([&resumed] {
+        Scheduler::suspend();
+        resumed = true;
+    });
+
+    scheduler.run();
+    EXPECT_TRUE(resumed);
+    EXPECT_EQ(scheduler.idle_calls, 2);
+    EXPECT_EQ(scheduler.get_live_count(), 0u);
+}
+
+//============================================================================
+// 调度类
+//============================================================================
+
+namespace {
+
+CoroutineOptions class_options(SchedulingClass scheduling_class, uint64_t deadline = 0) {
+    CoroutineOptions opts;
+    opts.scheduling_class = scheduling_class;
+    opts.deadline = deadline;
+    return opts;
+}
+
+} // namespace
+
+// 严格优先级：高的类清空之后才调度低的类
+TEST_F(SchedulerTest, StrictPriorityClasses) {
+    Scheduler scheduler;
+    SchedulingPolicy policy;
+    policy.starvation_limit = 0;
+    ASSERT_TRUE(scheduler.set_policy(policy));
+
+    auto body = [this](const std::string& name) {
+        return [this, name] {
+            for (int round = 0; round < 2; ++round) {
+                trace_.push_back(name + std::to_string(round));
+                Scheduler::yield();
+            }
+        };
+    };
+    scheduler.spawn(body("B"), class_options(SchedulingClass::BATCH));
+    scheduler.spawn(body("N"), class_options(SchedulingClass::NORMAL));
+    scheduler.spawn(body("L"), class_options(SchedulingClass::LATENCY));
+    EXPECT_EQ(scheduler.get_ready_count(), 3u);
+    EXPECT_EQ(scheduler.get_ready_count(SchedulingClass::LATENCY), 1u);
+
+    scheduler.run();
+    std::vector<std::string> expected = {"L0", "L1", "N0", "N1", "B0", "B1"};
+    EXPECT_EQ(trace_, expected);
+    const SchedulerStatistics& stats = scheduler.get_statistics();
+    for (size_t c = 0; c < kSchedulingClasses; ++c) {
+        EXPECT_EQ(stats.class_dispatches[c], 3u);
+    }
+    EXPECT_EQ(stats.starvation_boosts, 0u);
+}
+
+// 加权选择：每轮按额度调度各类，额度为0的类只在其他类为空时调度
+TEST_F(SchedulerTest, WeightedClasses) {
+    Scheduler scheduler;
+    SchedulingPolicy policy;
+    policy.selection = ClassSelection::WEIGHTED;
+    policy.weights[0] = 3;
+    policy.weights[1] = 1;
+    policy.weights[2] = 0;
+    policy.starvation_limit = 0;
+    ASSERT_TRUE(scheduler.set_policy(policy));
+
+    std::string order;
+    auto body = [&order](char name, int rounds) {
+        return [&order, name, rounds] {
+            for (int round = 0; round < rounds; ++round) {
+                order += name;
+                Scheduler::yield();
+            }
+        };
+    };
+    scheduler.spawn(body('B', 1), class_options(SchedulingClass::BATCH));
+    scheduler.spawn(body('N', 4), class_options(SchedulingClass::NORMAL));
+    scheduler.spawn(body('L', 9), class_options(SchedulingClass::LATENCY));
+
+    scheduler.run();
+    EXPECT_EQ(order, "LLLNLLLNLLLNNB");
+}
+
+// 饥饿保护：低的类连续被越过 starvation_limit 次后得到一次调度
+TEST_F(SchedulerTest, StarvationGuard) {
+    Scheduler scheduler;
+    SchedulingPolicy policy;
+    policy.starvation_limit = 4;
+    ASSERT_TRUE(scheduler.set_policy(policy));
+
+    int latency_runs = 0;
+    int runs_before_batch = -1;
+    scheduler.spawn([&] {
+        for (int round = 0; round < 20; ++round) {
+            ++latency_runs;
+            Scheduler::yield();
+        }
+    }, class_options(SchedulingClass::LATENCY));
+    scheduler.spawn([&] { runs_before_batch = latency_runs; }, class_options(SchedulingClass::BATCH));
+
+    scheduler.run();
+    EXPECT_EQ(runs_before_batch, 3);
+    EXPECT_EQ(scheduler.get_statistics().starvation_boosts, 1u);
+}
+
+// 饥饿保护替换加权选择的结果时，额度记在实际调度的类上
+TEST_F(SchedulerTest, StarvationBoostKeepsWeightedCredit) {
+    Scheduler scheduler;
+    SchedulingPolicy policy;
+    policy.selection = ClassSelection::WEIGHTED;
+    policy.weights[0] = 2;
+    policy.weights[1] = 1;
+    policy.weights[2] = 0;
+    policy.starvation_limit = 3;
+    ASSERT_TRUE(scheduler.set_policy(policy));
+
+    std::string order;
+    auto body = [&order](char name, int rounds) {
+        return [&order, name, rounds] {
+            for (int round = 0; round < rounds; ++round) {
+                order += name;
+                Scheduler::yield();
+            }
+        };
+    };
+    scheduler.spawn(body('L', 6), class_options(SchedulingClass::LATENCY));
+    scheduler.spawn(body('N', 3), class_options(SchedulingClass::NORMAL));
+    scheduler.spawn([&order] { order += 'B'; }, class_options(SchedulingClass::BATCH));
+
+    scheduler.run();
+    // 第三次调度被 B 顶替，N 的额度留到下一次
+    EXPECT_EQ(order, "LLBNLLNLLN");
+    EXPECT_EQ(scheduler.get_statistics().starvation_boosts, 1u);
+}
+
+// 类变为空时越过次数清零，之后进入的协程重新计数
+TEST_F(SchedulerTest, StarvationCountResetsWhenClassEmpties) {
+    Scheduler scheduler;
+    SchedulingPolicy policy;
+    policy.starvation_limit = 4;
+    ASSERT_TRUE(scheduler.set_policy(policy));
+
+    int latency_runs = 0;
+    int runs_before_batch = -1;
+    Coroutine* moved = scheduler.spawn([] {}, class_options(SchedulingClass::BATCH));
+    scheduler.spawn([&] {
+        for (int round = 0; round < 20; ++round) {
+            ++latency_runs;
+            if (round == 2) {
+                // BATCH 已经被越过 3 次，移走后清空
+                EXPECT_TRUE(scheduler.set_scheduling_class(moved, SchedulingClass::LATENCY));
+                scheduler.spawn([&] { runs_before_batch = latency_runs; },
+                                class_options(SchedulingClass::BATCH));
+            }
+            Scheduler::yield();
+        }
+    }, class_options(SchedulingClass::LATENCY));
+
+    scheduler.run();
+    EXPECT_EQ(runs_before_batch, 5);
+    EXPECT_EQ(scheduler.get_statistics().starvation_boosts, 1u);
+}
+
+// EDF：类内按截止时刻从早到晚调度，没有截止时刻的协程排在最后
+TEST_F(SchedulerTest, DeadlineOrdering) {
+    Scheduler scheduler;
+    SchedulingPolicy policy;
+    policy.deadline_ordering = true;
+    ASSERT_TRUE(scheduler.set_policy(policy));
+
+    auto body = [this](const std::string& name) {
+        return [this, name] { trace_.push_back(name); };
+    };
+    scheduler.spawn(body("30"), class_options(SchedulingClass::NORMAL, 30));
+    scheduler.spawn(body("10"), class_options(SchedulingClass::NORMAL, 10));
+    Coroutine* later = scheduler.spawn(body("none"), class_options(SchedulingClass::NORMAL));
+    scheduler.spawn(body("20"), class_options(SchedulingClass::NORMAL, 20));
+    scheduler.spawn(body("10'"), class_options(SchedulingClass::NORMAL, 10));
+    EXPECT_FALSE(scheduler.set_policy(SchedulingPolicy{}));
+
+    // 排队中的协程修改截止时刻后移到新的位置
+    Coroutine* moved = scheduler.spawn(body("5"), class_options(SchedulingClass::NORMAL));
+    ASSERT_TRUE(scheduler.set_deadline(moved, 5));
+    EXPECT_EQ(moved->get_deadline(), 5u);
+    EXPECT_EQ(later->get_deadline(), 0u);
+
+    scheduler.run();
+    std::vector<std::string> expected = {"5", "10", "10'", "20", "30", "none"};
+    EXPECT_EQ(trace_, expected);
+}
+
+// 修改调度类会把排队中的协程移到新类的队尾；批次中的协程进入各自的类
+TEST_F(SchedulerTest, ChangeClassAndMixedBatch) {
+    Scheduler scheduler;
+    auto body = [this](const std::string& name) {
+        return [this, name] { trace_.push_back(name); };
+    };
+    scheduler.spawn(body("a"));
+    Coroutine* urgent = scheduler.spawn(body("b"));
+    ASSERT_TRUE(scheduler.set_scheduling_class(urgent, SchedulingClass::LATENCY));
+    EXPECT_EQ(urgent->get_scheduling_class(), SchedulingClass::LATENCY);
+    EXPECT_EQ(scheduler.get_ready_count(SchedulingClass::LATENCY), 1u);
+    EXPECT_EQ(scheduler.get_ready_count(SchedulingClass::NORMAL), 1u);
+
+    CoroutinePtr foreign = Coroutine::create([] {});
+    EXPECT_FALSE(scheduler.set_scheduling_class(foreign.get(), SchedulingClass::BATCH));
+    EXPECT_FALSE(scheduler.set_deadline(foreign.get(), 1));
+
+    CoroutineBatch batch;
+    ASSERT_TRUE(batch.add(body("c"), class_options(SchedulingClass::BATCH)));
+    ASSERT_TRUE(batch.add(body("d"), class_options(SchedulingClass::LATENCY)));
+    ASSERT_TRUE(batch.add(body("e")));
+    EXPECT_EQ(scheduler.submit_batch(batch), 3u);
+    EXPECT_EQ(scheduler.get_ready_count(), 5u);
+
+    scheduler.run();
+    std::vector<std::string> expected = {"b", "d", "a", "e", "c"};
+    EXPECT_EQ(trace_, expected);
+}
+
+// 10万个就绪协程下的调度延迟 (目标远低于 100μs)
+TEST_F(SchedulerTest, SchedulingLatency) {
+    const int count = 100000;
+    const int rounds = 4;
+    // 保护页每个栈占两个映射区，大量协程使用共享栈
+    SharedStackAllocator shared(4, StackOptions{64 * 1024});
+    CoroutineOptions opts;
+    opts.stack_allocator = &shared;
+
+    Scheduler scheduler;
+    for (int i = 0; i < count; ++i) {
+        ASSERT_NE(scheduler.spawn([] {
+            for (int round = 0; round < rounds; ++round) {
+                Scheduler::yield();
+            }
+        }, opts), nullptr);
+    }
+    EXPECT_EQ(scheduler.get_ready_count(), static_cast<size_t>(count));
+
+    auto start = std::chrono::steady_clock::now();
+    scheduler.run();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    const uint64_t dispatches = scheduler.get_statistics().dispatches;
+    EXPECT_EQ(dispatches, static_cast<uint64_t>(count) * (rounds + 1));
+    double avg_ns = static_cast<double>(elapsed) / static_cast<double>(dispatches);
+    std::cout << "Average dispatch with " << count << " runnable: " << avg_ns << " ns" << std::endl;
+    EXPECT_LT(avg_ns / 1000.0, kSchedulingLatencyTargetUs / 10.0);
+    EXPECT_EQ(scheduler.get_live_count(), 0u);
+}
@@ -0,0 +1,774 @@
+/**
+ * @file test_stack.cpp
+ * @brief 协程栈管理系统测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证栈的分配、对齐、保护页、按需提交、栈池复用以及共享栈的换入换出。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/stack.h"
+#include "libco_oop/context.h"
+#include "test_helper.h"
+#include <sys/mman.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace libco_oop;
+
+//============================================================================
+// 测试辅助工具
+//============================================================================
+
+/**
+ * @brief 统计一段内存中已驻留的物理页数量
+ */
+static size_t resident_pages(void* begin, size_t length) {
+    const size_t page = Stack::page_size();
+    std::vector<unsigned char> vec((length + page - 1) / page);
+    if (::mincore(begin, length, vec.data()) != 0) {
+        return static_cast<size_t>(-1);
+    }
+    size_t count = 0;
+    for (unsigned char v : vec) {
+        count += (v & 1);
+    }
+    return count;
+}
+
+class StackTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        allocator_ = std::make_unique<FixedStackAllocator>(StackOptions{64 * 1024});
+    }
+
+    std::unique_ptr<FixedStackAllocator> allocator_;
+};
+
+//============================================================================
+// 核心测试用例
+//============================================================================
+
+// 测试基本的栈分配和释放
+TEST_F(StackTest, BasicStackAllocation) {
+    Stack empty;
+    EXPECT_FALSE(empty.is_valid());
+
+    Stack stack(64 * 1024);
+    ASSERT_TRUE(stack.is_valid());
+    EXPECT_EQ(stack.get_size(), 64u * 1024);
+    EXPECT_EQ(stack.get_guard_size(), Stack::page_size());
+    EXPECT_EQ(stack.get_mapped_size(), 64u * 1024 + Stack::page_size());
+    EXPECT_EQ(static_cast<char*>(stack.get_top()) - static_cast<char*>(stack.get_base()), 64 * 1024);
+
+    // 大小向上取整到页
+    Stack odd(1000, false);
+    ASSERT_TRUE(odd.is_valid());
+    EXPECT_EQ(odd.get_size(), Stack::page_size());
+    EXPECT_EQ(odd.get_guard_size(), 0u);
+
+    // 移动语义
+    void* base = stack.get_base();
+    Stack moved(std::move(stack));
+    EXPECT_FALSE(stack.is_valid());
+    EXPECT_EQ(moved.get_base(), base);
+}
+
+// 验证栈内存的对齐要求
+TEST_F(StackTest, StackAlignment) {
+    Stack stack(16 * 1024);
+    ASSERT_TRUE(stack.is_valid());
+    EXPECT_TRUE(context_utils::is_stack_aligned(stack.get_top()));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(stack.get_base()) % Stack::page_size(), 0u);
+}
+
+// 栈边界检查
+TEST_F(StackTest, StackBoundaryCheck) {
+    Stack stack(16 * 1024);
+    ASSERT_TRUE(stack.is_valid());
+
+    char* top = static_cast<char*>(stack.get_top());
+    char* base = static_cast<char*>(stack.get_base());
+    EXPECT_TRUE(stack.contains(top - 16));
+    EXPECT_TRUE(stack.contains(base));
+    EXPECT_FALSE(stack.contains(base - 1));
+    EXPECT_FALSE(stack.check_overflow(base));
+    EXPECT_TRUE(stack.check_overflow(base - 8));
+    EXPECT_EQ(stack.used_bytes(top - 256), 256u);
+}
+
+// 访问保护页触发 SIGSEGV
+TEST_F(StackTest, GuardPageAccess) {
+    Stack stack(16 * 1024);
+    ASSERT_TRUE(stack.is_valid());
+    volatile char* guard = static_cast<char*>(stack.get_base()) - 1;
+    EXPECT_DEATH({ *guard = 1; }, "");
+}
+
+// 栈内存按需提交：分配后不驻留，只有访问过的页驻留
+TEST_F(StackTest, LazyCommit) {
+    Stack stack(256 * 1024);
+    ASSERT_TRUE(stack.is_valid());
+    EXPECT_EQ(resident_pages(stack.get_base(), stack.get_size()), 0u);
+
+    // 模拟协程只用到栈顶附近的一页
+    char* top = static_cast<char*>(stack.get_top());
+    top[-1] = 1;
+    EXPECT_EQ(resident_pages(stack.get_base(), stack.get_size()), 1u);
+}
+
+//============================================================================
+// 分配器测试用例
+//============================================================================
+
+// 栈池复用：归还后再次分配不再 mmap
+TEST_F(StackTest, PoolRecycling) {
+    Stack* first = allocator_->allocate();
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(allocator_->get_statistics().mmap_calls, 1u);
+
+    allocator_->deallocate(first);
+    EXPECT_EQ(allocator_->get_statistics().cached, 1u);
+
+    Stack* second = allocator_->allocate();
+    EXPECT_EQ(second, first);
+
+    StackStatistics stats = allocator_->get_statistics();
+    EXPECT_EQ(stats.mmap_calls, 1u);
+    EXPECT_EQ(stats.munmap_calls, 0u);
+    EXPECT_EQ(stats.pool_hits, 1u);
+    EXPECT_EQ(stats.in_use, 1u);
+    EXPECT_EQ(stats.total_allocations, 2u);
+
+    allocator_->deallocate(second);
+}
+
+// 超过固定大小的请求失败
+TEST_F(StackTest, OversizedRequest) {
+    EXPECT_EQ(allocator_->allocate(1024 * 1024), nullptr);
+    Stack* stack = allocator_->allocate(4096);
+    ASSERT_NE(stack, nullptr);
+    EXPECT_EQ(stack->get_size(), 64u * 1024);
+    allocator_->deallocate(stack);
+}
+
+// 预热、缓存上限和裁剪
+TEST_F(StackTest, StackStatistics) {
+    allocator_->set_options(StackOptions{64 * 1024, true, 4});
+    EXPECT_EQ(allocator_->reserve(8), 4u);
+
+    StackStatistics stats = allocator_->get_statistics();
+    EXPECT_EQ(stats.cached, 4u);
+    EXPECT_EQ(stats.mmap_calls, 4u);
+    EXPECT_EQ(stats.reserved_bytes, 4 * (64u * 1024 + Stack::page_size()));
+
+    std::vector<Stack*> stacks;
+    for (int i = 0; i < 6; ++i) {
+        stacks.push_back(allocator_->allocate());
+        ASSERT_NE(stacks.back(), nullptr);
+    }
+    EXPECT_EQ(allocator_->get_statistics().pool_hits, 4u);
+
+    for (Stack* s : stacks) {
+        allocator_->deallocate(s);
+    }
+    stats = allocator_->get_statistics();
+    EXPECT_EQ(stats.cached, 4u);
+    EXPECT_EQ(stats.munmap_calls, 2u);
+    EXPECT_EQ(stats.in_use, 0u);
+
+    allocator_->trim(1);
+    EXPECT_EQ(allocator_->get_statistics().cached, 1u);
+
+    // 修改栈大小会丢弃旧栈
+    allocator_->set_options(StackOptions{32 * 1024, true, 4});
+    EXPECT_EQ(allocator_->get_statistics().cached, 0u);
+    Stack* small = allocator_->allocate();
+    ASSERT_NE(small, nullptr);
+    EXPECT_EQ(small->get_size(), 32u * 1024);
+    allocator_->deallocate(small);
+}
+
+// 金丝雀涂抹：高水位为最深一次写入的深度，取消涂抹后归还未用的页
+TEST_F(StackTest, CanaryHighWaterMark) {
+    Stack stack(64 * 1024);
+    ASSERT_TRUE(stack.is_valid());
+    EXPECT_EQ(stack.high_water_mark(), 0u);
+
+    stack.paint();
+    EXPECT_TRUE(stack.is_painted());
+    EXPECT_EQ(stack.high_water_mark(), 0u);
+    EXPECT_EQ(resident_pages(stack.get_base(), stack.get_size()), 16u);
+
+    char* top = static_cast<char*>(stack.get_top());
+    top[-5000] = 1;
+    EXPECT_GE(stack.high_water_mark(), 5000u);
+    EXPECT_LT(stack.high_water_mark(), 5000u + 8);
+
+    stack.unpaint();
+    EXPECT_FALSE(stack.is_painted());
+    EXPECT_EQ(stack.high_water_mark(), 0u);
+    EXPECT_EQ(resident_pages(stack.get_base(), stack.get_size()), 2u);
+}
+
+// 每 N 次分配涂抹一个栈
+TEST_F(StackTest, CanarySampling) {
+    StackOptions opts{64 * 1024};
+    opts.canary_sample = 4;
+    allocator_->set_options(opts);
+
+    std::vector<Stack*> stacks;
+    size_t painted = 0;
+    for (int i = 0; i < 8; ++i) {
+        stacks.push_back(allocator_->allocate());
+        ASSERT_NE(stacks.back(), nullptr);
+        painted += stacks.back()->is_painted();
+    }
+    EXPECT_EQ(painted, 2u);
+    EXPECT_EQ(allocator_->get_statistics().sampled, 2u);
+
+    // 归还时清除涂抹标记
+    for (Stack* s : stacks) {
+        allocator_->deallocate(s);
+        EXPECT_FALSE(s->is_painted());
+    }
+}
+
+// 分级栈池：取能容纳请求的最小一级，按栈大小归还
+TEST_F(StackTest, SizeClassAllocator) {
+    SizeClassStackAllocator classes(StackOptions{128 * 1024}, 16 * 1024);
+    ASSERT_EQ(classes.get_class_count(), 4u);
+    EXPECT_EQ(classes.get_class(0).get_options().stack_size, 16u * 1024);
+    EXPECT_EQ(classes.get_class(3).get_options().stack_size, 128u * 1024);
+
+    Stack* small = classes.allocate(20 * 1024);
+    Stack* large = classes.allocate();
+    ASSERT_NE(small, nullptr);
+    ASSERT_NE(large, nullptr);
+    EXPECT_EQ(small->get_size(), 32u * 1024);
+    EXPECT_EQ(large->get_size(), 128u * 1024);
+    EXPECT_EQ(classes.allocate(256 * 1024), nullptr);
+
+    classes.deallocate(small);
+    classes.deallocate(large);
+    EXPECT_EQ(classes.get_class(1).get_statistics().cached, 1u);
+    EXPECT_EQ(classes.get_class(3).get_statistics().cached, 1u);
+    StackStatistics stats = classes.get_statistics();
+    EXPECT_EQ(stats.cached, 2u);
+    EXPECT_EQ(stats.in_use, 0u);
+
+    // 重建后归还的旧栈直接释放
+    Stack* old = classes.allocate();
+    ASSERT_NE(old, nullptr);
+    classes.set_options(StackOptions{96 * 1024});
+    EXPECT_EQ(classes.get_class_count(), 4u);
+    EXPECT_EQ(classes.get_class(3).get_options().stack_size, 96u * 1024);
+    classes.deallocate(old);
+    EXPECT_EQ(classes.get_statistics().cached, 0u);
+}
+
+// 栈用量画像：样本足够后推荐最大高水位的两倍
+TEST_F(StackTest, StackUsageRecommendation) {
+    StackUsage usage;
+    EXPECT_EQ(usage.recommended_size(), 0u);
+    for (size_t i = 0; i < StackUsage::kMinSamples; ++i) {
+        usage.record(3000 + i * 1000);
+    }
+    EXPECT_EQ(usage.get_samples(), StackUsage::kMinSamples);
+    EXPECT_EQ(usage.get_max_used(), 10000u);
+    EXPECT_EQ(usage.get_average_used(), 6500u);
+    EXPECT_EQ(usage.recommended_size(), 5 * Stack::page_size());
+
+    usage.reset();
+    usage.record(16);
+    EXPECT_EQ(usage.recommended_size(1), 2 * Stack::page_size());
+
+    // 每个入口函数类型一个画像
+    EXPECT_NE(&stack_usage_for<int>(), &stack_usage_for<long>());
+    EXPECT_EQ(&stack_usage_for<int>(), &stack_usage_for<int>());
+}
+
+// 每线程独立的默认实例
+TEST_F(StackTest, ThreadLocalAllocator) {
+    FixedStackAllocator* main_allocator = &FixedStackAllocator::local();
+    FixedStackAllocator* other_allocator = nullptr;
+    std::thread t([&] { other_allocator = &FixedStackAllocator::local(); });
+    t.join();
+    EXPECT_NE(main_allocator, other_allocator);
+    EXPECT_EQ(main_allocator, &FixedStackAllocator::local());
+}
+
+// 栈池命中时分配开销远低于协程创建目标 (1000ns)
+TEST_F(StackTest, AllocationPerformance) {
+    allocator_->reserve(1);
+    const int iterations = 10000;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        Stack* stack = allocator_->allocate();
+        allocator_->deallocate(stack);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    double avg = static_cast<double>(elapsed) / iterations;
+    std::cout << "Average pooled stack allocate+deallocate: " << avg << " ns" << std::endl;
+    EXPECT_LT(avg, 1000.0);
+    EXPECT_EQ(allocator_->get_statistics().mmap_calls, 1u);
+}
+
+//============================================================================
+// 与 Context 的集成
+//============================================================================
+
+static FastContext* g_stack_main = nullptr;
+static FastContext* g_stack_co = nullptr;
+static void* g_observed_sp = nullptr;
+
+LIBCO_OOP_CONTEXT_ENTRY
+static void stack_entry() {
+    for (;;) {
+        char marker = 0;
+        g_observed_sp = &marker;
+        g_stack_co->swap(*g_stack_main);
+    }
+}
+
+// 协程在分配的栈上运行
+TEST_F(StackTest, ContextRunsOnAllocatedStack) {
+    Stack* stack = allocator_->allocate();
+    ASSERT_NE(stack, nullptr);
+
+    FastContext main_ctx, co_ctx;
+    ASSERT_TRUE(co_ctx.set_stack_pointer(stack->get_top()));
+    ASSERT_TRUE(co_ctx.set_instruction_pointer(reinterpret_cast<void*>(&stack_entry)));
+    g_stack_main = &main_ctx;
+    g_stack_co = &co_ctx;
+
+    main_ctx.swap(co_ctx);
+    EXPECT_TRUE(stack->contains(g_observed_sp));
+    EXPECT_LT(stack->used_bytes(g_observed_sp), 4096u);
+    EXPECT_TRUE(stack->contains(co_ctx.get_stack_pointer()));
+
+    allocator_->deallocate(stack);
+}
+
+//============================================================================
+// 共享栈测试用例
+//============================================================================
+
+// 保存缓冲区按 2 的幂分级复用
+TEST_F(StackTest, SaveBufferSizeClasses) {
+    EXPECT_EQ(SaveBufferPool::block_size_for(1), 64u);
+    EXPECT_EQ(SaveBufferPool::block_size_for(64), 64u);
+    EXPECT_EQ(SaveBufferPool::block_size_for(65), 128u);
+    EXPECT_EQ(SaveBufferPool::block_size_for(3000), 4096u);
+    EXPECT_EQ(SaveBufferPool::block_size_for(SaveBufferPool::kMaxBlockSize + 1),
+              SaveBufferPool::kMaxBlockSize + Stack::page_size());
+
+    SaveBufferPool pool;
+    size_t capacity = 0;
+    void* a = pool.allocate(300, capacity);
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(capacity, 512u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0u);
+    EXPECT_EQ(pool.get_statistics().slab_count, 1u);
+
+    size_t capacity_b = 0;
+    void* b = pool.allocate(400, capacity_b);
+    EXPECT_NE(b, a);
+    pool.deallocate(a, capacity);
+
+    // 同规格的块优先复用，不会申请新 slab
+    size_t capacity_c = 0;
+    void* c = pool.allocate(512, capacity_c);
+    EXPECT_EQ(c, a);
+    EXPECT_EQ(pool.get_statistics().slab_count, 1u);
+    EXPECT_EQ(pool.get_statistics().blocks_in_use, 2u);
+    EXPECT_EQ(pool.get_statistics().bytes_in_use, 1024u);
+
+    pool.deallocate(b, capacity_b);
+    pool.deallocate(c, capacity_c);
+    EXPECT_EQ(pool.get_statistics().bytes_in_use, 0u);
+}
+
+// 共享栈轮转分配
+TEST_F(StackTest, SharedStackRoundRobin) {
+    SharedStackAllocator shared(2, StackOptions{64 * 1024});
+    EXPECT_EQ(shared.get_stack_count(), 2u);
+
+    SharedStack* a = shared.acquire();
+    SharedStack* b = shared.acquire();
+    SharedStack* c = shared.acquire();
+    ASSERT_NE(a, nullptr);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a, c);
+    EXPECT_EQ(a->get_user_count(), 2u);
+    EXPECT_EQ(a->get_owner(), &shared);
+    EXPECT_EQ(shared.allocate(1024 * 1024), nullptr);
+    EXPECT_EQ(shared.get_statistics().in_use, 3u);
+
+    shared.deallocate(a);
+    shared.deallocate(b);
+    shared.deallocate(c);
+    EXPECT_EQ(shared.get_statistics().in_use, 0u);
+    EXPECT_EQ(a->get_user_count(), 0u);
+}
+
+/**
+ * @brief 共享栈测试环境
+ *
+ * 多个协程运行在同一个共享栈上，每个协程在自己的栈帧里写入特征数据，
+ * 被换出再换入后检查数据是否完整。
+ */
+struct SharedStackEnv {
+    static constexpr int kPatternSize = 512;
+
+    static FastContext main_ctx;
+    static StackBinding main_binding;
+    static std::unique_ptr<FastContext[]> contexts;
+    static std::unique_ptr<StackBinding[]> bindings;
+    static int count;
+    static int starting;                ///< 首次进入的协程编号
+    static int verified;                ///< 换入后数据校验通过的次数
+    static bool chain;                  ///< 是否直接切换到同一栈上的下一个协程
+    static bool save_fpu;
+
+    static void setup(SharedStackAllocator& shared, int n)
+    {
+        count = n;
+        verified = 0;
+        chain = false;
+        save_fpu = false;
+        contexts.reset(new FastContext[n]);
+        bindings.reset(new StackBinding[n]);
+        main_binding.bind(main_ctx.registers());
+        for (int i = 0; i < n; ++i) {
+            SharedStack* stack = shared.acquire();
+            contexts[i].set_stack_pointer(stack->get_top());
+            contexts[i].set_instruction_pointer(reinterpret_cast<void*>(&entry));
+            bindings[i].bind(contexts[i].registers(), stack);
+        }
+    }
+
+    static void teardown(SharedStackAllocator& shared)
+    {
+        for (int i = 0; i < count; ++i) {
+            Stack* stack = bindings[i].get_stack();
+            bindings[i].unbind();
+            shared.deallocate(stack);
+        }
+        bindings.reset();
+        contexts.reset();
+        main_binding.unbind();
+    }
+
+    static void resume(int id)
+    {
+        starting = id;
+        main_binding.switch_to(bindings[id], save_fpu);
+    }
+
+    LIBCO_OOP_CONTEXT_ENTRY
+    static void entry()
+    {
+        const int id = starting;
+        const uint32_t csr = test::fp_control_with_rounding(static_cast<unsigned int>(id));
+        volatile unsigned char pattern[kPatternSize];
+        for (int i = 0; i < kPatternSize; ++i) {
+            pattern[i] = static_cast<unsigned char>(id * 7 + i);
+        }
+        if (save_fpu) {
+            test::write_fp_control(csr);
+        }
+
+        for (;;) {
+            StackBinding& next = (chain && id + 1 < count) ? bindings[id + 1] : main_binding;
+            if (chain && id + 1 < count) {
+                starting = id + 1;
+            }
+            bindings[id].switch_to(next, save_fpu);
+
+            bool intact = true;
+            for (int i = 0; i < kPatternSize; ++i) {
+                intact = intact && pattern[i] == static_cast<unsigned char>(id * 7 + i);
+            }
+            if (save_fpu && test::read_fp_control() != csr) {
+                intact = false;
+            }
+            if (intact) {
+                ++verified;
+            }
+        }
+    }
+};
+
+FastContext SharedStackEnv::main_ctx;
+StackBinding SharedStackEnv::main_binding;
+std::unique_ptr<FastContext[]> SharedStackEnv::contexts;
+std::unique_ptr<StackBinding[]> SharedStackEnv::bindings;
+int SharedStackEnv::count = 0;
+int SharedStackEnv::starting = 0;
+int SharedStackEnv::verified = 0;
+bool SharedStackEnv::chain = false;
+bool SharedStackEnv::save_fpu = false;
+
+// 多个协程在同一共享栈上与主线程交替运行，栈帧数据换出换入后保持完整
+TEST_F(StackTest, SharedStackPingPong) {
+    SharedStackAllocator shared(1, StackOptions{64 * 1024});
+    const int n = 8;
+    const int rounds = 5;
+    SharedStackEnv::setup(shared, n);
+
+    for (int round = 0; round < rounds; ++round) {
+        for (int id = 0; id < n; ++id) {
+            SharedStackEnv::resume(id);
+        }
+    }
+
+    // 第一轮是首次进入，之后每次换入都要校验
+    EXPECT_EQ(SharedStackEnv::verified, n * (rounds - 1));
+    for (int id = 0; id < n; ++id) {
+        const StackBinding& binding = SharedStackEnv::bindings[id];
+        EXPECT_GE(binding.get_saved_size(), static_cast<size_t>(SharedStackEnv::kPatternSize));
+        EXPECT_LT(binding.get_saved_size(), 4096u);
+        EXPECT_EQ(binding.get_statistics().restore_count, static_cast<size_t>(rounds - 1));
+    }
+    EXPECT_TRUE(SharedStackEnv::bindings[n - 1].is_resident());
+    EXPECT_FALSE(SharedStackEnv::bindings[0].is_resident());
+
+    SharedStackEnv::teardown(shared);
+    EXPECT_EQ(shared.get_buffer_pool().get_statistics().blocks_in_use, 0u);
+}
+
+// 同一共享栈上的协程之间直接切换 (经中转上下文拷贝)，并保持各自的浮点控制寄存器
+TEST_F(StackTest, SharedStackDirectSwitch) {
+    SharedStackAllocator shared(1, StackOptions{64 * 1024});
+    const int n = 4;
+    const int rounds = 3;
+    SharedStackEnv::setup(shared, n);
+    SharedStackEnv::chain = true;
+    SharedStackEnv::save_fpu = true;
+
+    const uint32_t main_csr = test::read_fp_control();
+    for (int round = 0; round < rounds; ++round) {
+        // 主线程只换入第一个协程，其余协程由前一个直接切换过去
+        SharedStackEnv::resume(0);
+        EXPECT_EQ(test::read_fp_control(), main_csr);
+    }
+
+    EXPECT_EQ(SharedStackEnv::verified, n * (rounds - 1));
+    SharedStackEnv::teardown(shared);
+}
+
+// 空闲协程的内存占用只有实际栈帧的大小
+TEST_F(StackTest, SharedStackMemoryDensity) {
+    SharedStackAllocator shared(1, StackOptions{128 * 1024});
+    const int n = 1000;
+    SharedStackEnv::setup(shared, n);
+
+    for (int id = 0; id < n; ++id) {
+        SharedStackEnv::resume(id);
+    }
+    // 再换入一次第一个协程，迫使最后一个协程也被换出
+    SharedStackEnv::resume(0);
+
+    SaveBufferStatistics stats = shared.get_buffer_pool().get_statistics();
+    const size_t per_coroutine = stats.slab_bytes / n;
+    std::cout << "Shared stack save buffer per coroutine: " << per_coroutine << " bytes" << std::endl;
+    EXPECT_EQ(stats.blocks_in_use, static_cast<size_t>(n));
+    EXPECT_LT(per_coroutine, 4096u);
+
+    SharedStackEnv::teardown(shared);
+}
+
+//============================================================================
+// 混合栈策略测试用例
+//============================================================================
+
+/**
+ * @brief 混合栈测试环境
+ *
+ * 两个协程槽位，入口函数在栈上写入 N 字节特征数据，每次换入后校验。
+ */
+struct HybridEnv {
+    static FastContext main_ctx;
+    static StackBinding main_binding;
+    static FastContext contexts[2];
+    static StackBinding bindings[2];
+    static int starting;
+    static int verified;
+
+    template <int N>
+    LIBCO_OOP_CONTEXT_ENTRY
+    static void entry()
+    {
+        const int id = starting;
+        volatile unsigned char pattern[N];
+        for (int i = 0; i < N; ++i) {
+            pattern[i] = static_cast<unsigned char>(id + i);
+        }
+        for (;;) {
+            bindings[id].switch_to(main_binding);
+            bool intact = true;
+            for (int i = 0; i < N; ++i) {
+                intact = intact && pattern[i] == static_cast<unsigned char>(id + i);
+            }
+            if (intact) {
+                ++verified;
+            }
+        }
+    }
+
+    static bool start(HybridStackAllocator& hybrid, int id, StackProfile* profile, void (*fn)())
+    {
+        main_binding.bind(main_ctx.registers());
+        contexts[id].reset();
+        if (!hybrid.bind(bindings[id], contexts[id].registers(), profile)) {
+            return false;
+        }
+        contexts[id].set_stack_pointer(bindings[id].get_stack()->get_top());
+        contexts[id].set_instruction_pointer(reinterpret_cast<void*>(fn));
+        return true;
+    }
+
+    static void resume(int id)
+    {
+        starting = id;
+        main_binding.switch_to(bindings[id]);
+    }
+};
+
+FastContext HybridEnv::main_ctx;
+StackBinding HybridEnv::main_binding;
+FastContext HybridEnv::contexts[2];
+StackBinding HybridEnv::bindings[2];
+int HybridEnv::starting = 0;
+int HybridEnv::verified = 0;
+
+static HybridStackOptions small_hybrid_options()
+{
+    HybridStackOptions opts;
+    opts.private_stack = StackOptions{64 * 1024};
+    opts.shared_stack = StackOptions{64 * 1024};
+    opts.shared_stack_count = 1;
+    opts.hot_switches = 32;
+    opts.deep_copy_bytes = 16 * 1024;
+    opts.idle_periods = 2;
+    return opts;
+}
+
+// 高频切换的共享栈协程被升级，同一画像下次绑定到独立栈
+TEST_F(StackTest, HybridPromotesHotCoroutine) {
+    HybridStackAllocator hybrid(small_hybrid_options());
+    StackProfile profile;
+    HybridEnv::verified = 0;
+
+    ASSERT_TRUE(HybridEnv::start(hybrid, 0, &profile, &HybridEnv::entry<256>));
+    EXPECT_TRUE(HybridEnv::bindings[0].is_shared());
+    EXPECT_EQ(hybrid.get_statistics().shared_bindings, 1u);
+
+    // 切换次数不足时不升级
+    for (int i = 0; i < 8; ++i) {
+        HybridEnv::resume(0);
+    }
+    hybrid.rebalance();
+    EXPECT_EQ(profile.preferred, StackKind::SHARED);
+
+    for (int i = 0; i < 40; ++i) {
+        HybridEnv::resume(0);
+    }
+    hybrid.rebalance();
+    EXPECT_EQ(profile.preferred, StackKind::PRIVATE);
+    EXPECT_EQ(profile.promotions, 1u);
+    EXPECT_EQ(hybrid.get_statistics().promotions, 1u);
+
+    hybrid.unbind(HybridEnv::bindings[0]);
+    EXPECT_EQ(profile.resumes, 48u);
+    EXPECT_EQ(hybrid.get_statistics().shared_bindings, 0u);
+
+    // 下一个同类协程直接使用独立栈
+    ASSERT_TRUE(HybridEnv::start(hybrid, 0, &profile, &HybridEnv::entry<256>));
+    EXPECT_FALSE(HybridEnv::bindings[0].is_shared());
+    EXPECT_EQ(hybrid.get_statistics().private_bindings, 1u);
+    HybridEnv::resume(0);
+    HybridEnv::resume(0);
+    EXPECT_EQ(HybridEnv::bindings[0].get_statistics().copied_bytes, 0u);
+    EXPECT_EQ(HybridEnv::verified, 47 + 1);
+
+    hybrid.unbind(HybridEnv::bindings[0]);
+}
+
+// 每次换入都要拷贝大量栈内容的深栈协程被升级
+TEST_F(StackTest, HybridPromotesDeepCoroutine) {
+    HybridStackAllocator hybrid(small_hybrid_options());
+    StackProfile deep;
+    StackProfile shallow;
+    HybridEnv::verified = 0;
+
+    ASSERT_TRUE(HybridEnv::start(hybrid, 0, &deep, &HybridEnv::entry<20 * 1024>));
+    ASSERT_TRUE(HybridEnv::start(hybrid, 1, &shallow, &HybridEnv::entry<256>));
+
+    // 两个协程轮流占用同一个共享栈，互相换出
+    for (int i = 0; i < 4; ++i) {
+        HybridEnv::resume(0);
+        HybridEnv::resume(1);
+    }
+    hybrid.rebalance();
+
+    EXPECT_EQ(deep.preferred, StackKind::PRIVATE);
+    EXPECT_EQ(shallow.preferred, StackKind::SHARED);
+    EXPECT_EQ(HybridEnv::verified, 6);
+
+    hybrid.unbind(HybridEnv::bindings[0]);
+    hybrid.unbind(HybridEnv::bindings[1]);
+}
+
+// 空闲的独立栈协程被停放：栈帧存入缓冲区，物理页归还，恢复后数据完整
+TEST_F(StackTest, HybridDemotesIdleCoroutine) {
+    HybridStackAllocator hybrid(small_hybrid_options());
+    StackProfile profile;
+    profile.preferred = StackKind::PRIVATE;
+    HybridEnv::verified = 0;
+
+    ASSERT_TRUE(HybridEnv::start(hybrid, 0, &profile, &HybridEnv::entry<8 * 1024>));
+    StackBinding& binding = HybridEnv::bindings[0];
+    Stack* stack = binding.get_stack();
+    ASSERT_FALSE(binding.is_shared());
+
+    HybridEnv::resume(0);
+    EXPECT_GE(resident_pages(stack->get_base(), stack->get_size()), 2u);
+
+    // 活跃的周期会清零空闲计数
+    hybrid.rebalance();
+    HybridEnv::resume(0);
+    hybrid.rebalance();
+    EXPECT_TRUE(binding.is_resident());
+
+    hybrid.rebalance();
+    hybrid.rebalance();
+    EXPECT_FALSE(binding.is_resident());
+    EXPECT_EQ(resident_pages(stack->get_base(), stack->get_size()), 0u);
+    EXPECT_GE(binding.get_saved_size(), 8u * 1024);
+    EXPECT_EQ(profile.preferred, StackKind::SHARED);
+    EXPECT_EQ(profile.demotions, 1u);
+
+    HybridStackStatistics stats = hybrid.get_statistics();
+    EXPECT_EQ(stats.demotions, 1u);
+    EXPECT_EQ(stats.parked, 1u);
+    EXPECT_EQ(stats.periods, 4u);
+
+    // 换入时自动拷回原地址
+    HybridEnv::resume(0);
+    EXPECT_TRUE(binding.is_resident());
+    EXPECT_EQ(HybridEnv::verified, 2);
+    EXPECT_EQ(hybrid.get_statistics().parked, 0u);
+
+    // StackBinding::unbind() 同样把栈归还给混合栈分配器
+    binding.unbind();
+    EXPECT_EQ(hybrid.get_statistics().private_bindings, 0u);
+    EXPECT_EQ(hybrid.get_private_allocator().get_statistics().cached, 1u);
+}
@@ -0,0 +1,179 @@
+/**
+ * @file test_stack_guard.cpp
+ * @brief 协程栈溢出检测测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证溢出报告的内容、只结束溢出的协程 (独立栈、共享栈和调度器中)、
+ * 默认动作终止进程，以及不属于保护页的故障交给之前的处理函数。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/stack_guard.h"
+#include "libco_oop/scheduler.h"
+#include <typeinfo>
+
+using namespace libco_oop;
+
+namespace {
+
+constexpr size_t kSmallStack = 16 * 1024;
+
+/**
+ * @brief 无限递归直到越过栈底 (每层约 1KB 栈帧，小于一页)
+ */
+__attribute__((noinline)) int recurse(volatile char* parent, int depth) {
+    volatile char frame[1024];
+    frame[0] = static_cast<char>(depth);
+    frame[1] = parent != nullptr ? parent[0] : 0;
+    if (depth < (1 << 30)) {
+        return recurse(frame, depth + 1) + frame[1];    // 阻止尾调用
+    }
+    return frame[0];
+}
+
+// 回调在信号处理函数中运行，只写入普通全局变量
+StackOverflowInfo g_last_overflow;
+int g_callbacks = 0;
+
+void record_overflow(const StackOverflowInfo& info) {
+    g_last_overflow = info;
+    ++g_callbacks;
+}
+
+StackGuardOptions terminate_options() {
+    StackGuardOptions opts;
+    opts.action = OverflowAction::TERMINATE_COROUTINE;
+    opts.report = false;
+    opts.on_overflow = &record_overflow;
+    return opts;
+}
+
+} // namespace
+
+class StackGuardTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        g_last_overflow = StackOverflowInfo{};
+        g_callbacks = 0;
+        opts_.stack_allocator = &allocator_;
+    }
+
+    void TearDown() override {
+        stack_guard::uninstall();
+    }
+
+    FixedStackAllocator allocator_{StackOptions(kSmallStack)};
+    CoroutineOptions opts_;
+};
+
+//============================================================================
+// 结束溢出的协程
+//============================================================================
+
+// 溢出的协程以 StackOverflowError 结束，报告包含协程ID、入口函数和栈大小
+TEST_F(StackGuardTest, TerminatesOverflowingCoroutine) {
+    ASSERT_TRUE(stack_guard::install(terminate_options()));
+    EXPECT_TRUE(stack_guard::is_installed());
+    const size_t overflows = stack_guard::get_overflow_count();
+
+    auto entry = [] { recurse(nullptr, 0); };
+    CoroutinePtr co = Coroutine::create(entry, opts_);
+    ASSERT_NE(co, nullptr);
+    EXPECT_THROW(co->resume(), StackOverflowError);
+    EXPECT_EQ(co->get_state(), CoroutineState::ERROR);
+    EXPECT_FALSE(co->resume());
+
+    EXPECT_EQ(g_callbacks, 1);
+    EXPECT_EQ(g_last_overflow.coroutine_id, co->get_id());
+    EXPECT_EQ(g_last_overflow.stack_size, co->get_stack()->get_size());
+    EXPECT_STREQ(g_last_overflow.entry_type, typeid(entry).name());
+    EXPECT_NE(g_last_overflow.entry_address, nullptr);
+    EXPECT_EQ(stack_guard::get_overflow_count(), overflows + 1);
+
+    // 线程不受影响，栈可以继续复用；再次溢出同样可以识别
+    co.reset();
+    int runs = 0;
+    CoroutinePtr next = Coroutine::create([&runs] { ++runs; }, opts_);
+    ASSERT_TRUE(next->resume());
+    EXPECT_EQ(runs, 1);
+    CoroutinePtr again = Coroutine::create(entry, opts_);
+    EXPECT_THROW(again->resume(), StackOverflowError);
+    EXPECT_EQ(g_callbacks, 2);
+}
+
+// 调用者的栈帧在共享栈的保存缓冲区中时，结束溢出的协程后换回调用者
+TEST_F(StackGuardTest, SharedStackCallerRestored) {
+    ASSERT_TRUE(stack_guard::install(terminate_options()));
+    SharedStackAllocator shared(1, StackOptions(kSmallStack));
+    CoroutineOptions opts;
+    opts.stack_allocator = &shared;
+
+    bool caught = false;
+    int marker = 0;
+    CoroutinePtr inner = Coroutine::create([] { recurse(nullptr, 0); }, opts);
+    CoroutinePtr outer = Coroutine::create([&] {
+        volatile int local = 42;
+        try {
+            inner->resume();
+        } catch (const StackOverflowError&) {
+            caught = true;
+        }
+        marker = local;
+    }, opts);
+    ASSERT_TRUE(outer->resume());
+    EXPECT_TRUE(caught);
+    EXPECT_EQ(marker, 42);
+    EXPECT_TRUE(outer->is_finished());
+    EXPECT_EQ(inner->get_state(), CoroutineState::ERROR);
+}
+
+// 调度器中溢出的协程结束后异常由 run() 抛出，其余协程继续运行
+TEST_F(StackGuardTest, SchedulerKeepsRunning) {
+    ASSERT_TRUE(stack_guard::install(terminate_options()));
+    Scheduler scheduler;
+    int finished = 0;
+    scheduler.spawn([&finished] { Scheduler::yield(); ++finished; }, opts_);
+    scheduler.spawn([] { recurse(nullptr, 0); }, opts_);
+    scheduler.spawn([&finished] { Scheduler::yield(); ++finished; }, opts_);
+
+    EXPECT_THROW(scheduler.run(), StackOverflowError);
+    scheduler.run();
+    EXPECT_EQ(finished, 2);
+    EXPECT_EQ(scheduler.get_statistics().finished, 3u);
+}
+
+//============================================================================
+// 默认动作与故障转交
+//============================================================================
+
+// 默认动作：报告之后进程照常因 SIGSEGV 终止
+TEST_F(StackGuardTest, AbortReportsAndDies) {
+    EXPECT_DEATH({
+        stack_guard::install();
+        CoroutinePtr co = Coroutine::create([] { recurse(nullptr, 0); }, opts_);
+        co->resume();
+    }, "stack overflow in coroutine [0-9]+ \\(entry .* stack 16384 bytes");
+}
+
+// 不在保护页内的故障不当作栈溢出
+TEST_F(StackGuardTest, OtherFaultsChained) {
+    ASSERT_TRUE(stack_guard::install(terminate_options()));
+    EXPECT_DEATH({
+        CoroutinePtr co = Coroutine::create([] {
+            volatile int* bad = nullptr;
+            *bad = 1;
+        }, opts_);
+        co->resume();
+    }, "");
+    EXPECT_EQ(g_callbacks, 0);
+}
+
+// 未安装时不为线程准备备用信号栈
+TEST_F(StackGuardTest, PrepareRequiresInstall) {
+    stack_guard::uninstall();
+    EXPECT_FALSE(stack_guard::is_installed());
+    EXPECT_FALSE(stack_guard::prepare_thread());
+    ASSERT_TRUE(stack_guard::install(terminate_options()));
+    EXPECT_TRUE(stack_guard::prepare_thread());
+}
@@ -0,0 +1,296 @@
+/**
+ * @file test_sync.cpp
+ * @brief 协程同步原语测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证 CoMutex 跨让出点的互斥与 FIFO 交接、无竞争路径不切换、
+ * 多线程调度器与普通线程混用，以及 CoCondVar 和 CoSemaphore 的语义。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/io_manager.h"
+#include "libco_oop/scheduler.h"
+#include "libco_oop/sync.h"
+#include "libco_oop/work_stealing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace libco_oop;
+
+//============================================================================
+// CoMutex 测试
+//============================================================================
+
+// 持有锁跨过让出点不会死锁，等待者按 FIFO 顺序获得锁
+TEST(CoMutexTest, ExclusionAcrossYields) {
+    Scheduler scheduler;
+    CoMutex mutex;
+    int inside = 0;
+    int max_inside = 0;
+    std::vector<int> order;
+
+    for (int id = 0; id < 4; ++id) {
+        scheduler.spawn([&, id] {
+            for (int round = 0; round < 3; ++round) {
+                std::lock_guard<CoMutex> guard(mutex);
+                order.push_back(id);
+                max_inside = std::max(max_inside, ++inside);
+                Scheduler::yield();
+                Scheduler::yield();
+                --inside;
+            }
+        });
+    }
+
+    scheduler.run();
+    EXPECT_EQ(max_inside, 1);
+    ASSERT_EQ(order.size(), 12u);
+    // 解锁直接交接给等待最久的协程，轮流获得锁
+    for (size_t i = 0; i < order.size(); ++i) {
+        EXPECT_EQ(order[i], static_cast<int>(i % 4));
+    }
+    EXPECT_FALSE(mutex.is_locked());
+}
+
+// 无竞争的加锁/解锁不切换协程
+TEST(CoMutexTest, UncontendedFastPath) {
+    Scheduler scheduler;
+    CoMutex mutex;
+    const int iterations = 1000000;
+    double per_pair_ns = 0;
+
+    Coroutine* coroutine = scheduler.spawn([&] {
+        EXPECT_TRUE(mutex.try_lock());
+        EXPECT_FALSE(mutex.try_lock());
+        mutex.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            mutex.lock();
+            mutex.unlock();
+        }
+        per_pair_ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count() / iterations;
+    });
+    ASSERT_NE(coroutine, nullptr);
+
+    scheduler.run();
+    EXPECT_EQ(scheduler.get_statistics().dispatches, 1u);
+    std::cout << "uncontended CoMutex lock/unlock: " << per_pair_ns << " ns" << std::endl;
+}
+
+// 工作窃取调度器的协程与普通线程争用同一把锁
+TEST(CoMutexTest, WorkStealingAndThreads) {
+    CoMutex mutex;
+    uint64_t counter = 0;          // 只在锁内访问
+    constexpr int kCoroutines = 8;
+    constexpr int kThreads = 2;
+    constexpr int kIncrements = 5000;
+
+    {
+        WorkStealingOptions opts;
+        opts.worker_count = 4;
+        WorkStealingScheduler scheduler(opts);
+        for (int i = 0; i < kCoroutines; ++i) {
+            scheduler.spawn([&] {
+                for (int n = 0; n < kIncrements; ++n) {
+                    std::lock_guard<CoMutex> guard(mutex);
+                    uint64_t value = counter;
+                    if (n % 64 == 0) {
+                        WorkStealingScheduler::yield();     // 持有锁让出
+                    }
+                    counter = value + 1;
+                }
+            });
+        }
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&] {
+                for (int n = 0; n < kIncrements; ++n) {
+                    std::lock_guard<CoMutex> guard(mutex);
+                    ++counter;
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        scheduler.wait();
+    }
+    EXPECT_EQ(counter, static_cast<uint64_t>((kCoroutines + kThreads) * kIncrements));
+    EXPECT_FALSE(mutex.is_locked());
+}
+
+// 临界区不让出：解锁者交接时等待者经常还没挂起，交接后立即结束并被回收
+TEST(CoMutexTest, WorkStealingShortCriticalSections) {
+    CoMutex mutex;
+    uint64_t counter = 0;          // 只在锁内访问
+    constexpr int kCoroutines = 64;
+    constexpr int kIncrements = 2000;
+
+    {
+        WorkStealingOptions opts;
+        opts.worker_count = 4;
+        WorkStealingScheduler scheduler(opts);
+        for (int round = 0; round < 4; ++round) {
+            for (int i = 0; i < kCoroutines; ++i) {
+                scheduler.spawn([&] {
+                    for (int n = 0; n < kIncrements; ++n) {
+                        std::lock_guard<CoMutex> guard(mutex);
+                        ++counter;
+                    }
+                });
+            }
+            scheduler.wait();
+        }
+    }
+    EXPECT_EQ(counter, static_cast<uint64_t>(4 * kCoroutines * kIncrements));
+    EXPECT_FALSE(mutex.is_locked());
+}
+
+//============================================================================
+// CoCondVar 测试
+//============================================================================
+
+// 有界队列：两个条件变量协调生产者和消费者
+TEST(CoCondVarTest, BoundedQueue) {
+    Scheduler scheduler;
+    CoMutex mutex;
+    CoCondVar not_empty;
+    CoCondVar not_full;
+    std::deque<int> queue;
+    std::vector<int> received;
+    constexpr size_t kCapacity = 2;
+
+    for (int producer = 0; producer < 2; ++producer) {
+        scheduler.spawn([&, producer] {
+            for (int i = 0; i < 50; ++i) {
+                std::unique_lock<CoMutex> lock(mutex);
+                not_full.wait(mutex, [&] { return queue.size() < kCapacity; });
+                queue.push_back(producer * 1000 + i);
+                not_empty.notify_one();
+            }
+        });
+    }
+    scheduler.spawn([&] {
+        for (int i = 0; i < 100; ++i) {
+            std::unique_lock<CoMutex> lock(mutex);
+            not_empty.wait(mutex, [&] { return !queue.empty(); });
+            received.push_back(queue.front());
+            queue.pop_front();
+            not_full.notify_one();
+        }
+    });
+
+    scheduler.run();
+    ASSERT_EQ(received.size(), 100u);
+    std::vector<int> next = {0, 1000};
+    for (int value : received) {
+        int& expected = next[static_cast<size_t>(value / 1000)];
+        EXPECT_EQ(value, expected);
+        ++expected;
+    }
+    EXPECT_FALSE(not_empty.has_waiters());
+    EXPECT_FALSE(not_full.has_waiters());
+}
+
+// notify_all() 按等待顺序唤醒所有等待者；没有等待者时通知无效果
+TEST(CoCondVarTest, NotifyAll) {
+    Scheduler scheduler;
+    CoMutex mutex;
+    CoCondVar condition;
+    bool ready = false;
+    std::vector<int> woken;
+
+    condition.notify_one();
+    condition.notify_all();
+    for (int id = 0; id < 5; ++id) {
+        scheduler.spawn([&, id] {
+            std::lock_guard<CoMutex> guard(mutex);
+            condition.wait(mutex, [&] { return ready; });
+            woken.push_back(id);
+        });
+    }
+    scheduler.spawn([&] {
+        EXPECT_TRUE(condition.has_waiters());
+        std::lock_guard<CoMutex> guard(mutex);
+        ready = true;
+        condition.notify_all();
+    });
+
+    scheduler.run();
+    std::vector<int> expected = {0, 1, 2, 3, 4};
+    EXPECT_EQ(woken, expected);
+}
+
+//============================================================================
+// CoSemaphore 测试
+//============================================================================
+
+// 信号量限制并发数，睡眠中持有许可的协程不阻塞线程
+TEST(CoSemaphoreTest, LimitsConcurrency) {
+    IOManager io;
+    CoSemaphore semaphore(3);
+    int active = 0;
+    int max_active = 0;
+    std::vector<int> entered;
+
+    for (int id = 0; id < 10; ++id) {
+        io.spawn([&, id] {
+            semaphore.acquire();
+            entered.push_back(id);
+            max_active = std::max(max_active, ++active);
+            co_sleep(2);
+            --active;
+            semaphore.release();
+        });
+    }
+
+    io.run();
+    EXPECT_EQ(max_active, 3);
+    std::vector<int> expected = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    EXPECT_EQ(entered, expected);
+    EXPECT_EQ(semaphore.get_count(), 3);
+    EXPECT_TRUE(semaphore.try_acquire());
+    EXPECT_EQ(semaphore.get_count(), 2);
+}
+
+// 其他线程的 release() 唤醒 IOManager 上挂起的协程
+TEST(CoSemaphoreTest, ReleaseFromThread) {
+    IOManager io;
+    CoSemaphore semaphore(0);
+    std::atomic<int> acquired{0};
+    bool other_ran = false;
+
+    for (int i = 0; i < 3; ++i) {
+        io.spawn([&] {
+            semaphore.acquire();
+            acquired.fetch_add(1);
+        });
+    }
+    io.spawn([&] {
+        other_ran = true;       // 等待者挂起时线程继续调度其他协程
+    });
+
+    std::thread releaser([&] {
+        while (semaphore.get_count() != -3) {
+            std::this_thread::yield();
+        }
+        for (int i = 0; i < 3; ++i) {
+            semaphore.release();
+        }
+    });
+    io.run();
+    releaser.join();
+
+    EXPECT_TRUE(other_ran);
+    EXPECT_EQ(acquired.load(), 3);
+    EXPECT_EQ(semaphore.get_count(), 0);
+    EXPECT_FALSE(semaphore.try_acquire());
+}
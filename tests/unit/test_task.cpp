@@ -0,0 +1,238 @@
+/**
+ * @file test_task.cpp
+ * @brief C++20 无栈协程互操作测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证 Task 之间的对称转移、有栈协程等待 Task、Task 等待通道、IO
+ * 和有栈代码，睡眠中的 Task 不占用有栈协程，以及异常的传递。
+ * C++17 构建中只有一个跳过的占位测试。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/task.h"
+
+#if LIBCO_OOP_HAS_TASK
+
+#include "libco_oop/channel.h"
+#include "libco_oop/io_manager.h"
+#include <unistd.h>
+#include <cerrno>
+#include <stdexcept>
+#include <thread>
+
+using namespace libco_oop;
+
+namespace {
+
+Task<int> add(int a, int b) {
+    co_return a + b;
+}
+
+Task<int> sum_to(int n) {
+    int total = 0;
+    for (int i = 1; i <= n; ++i) {
+        total = co_await add(total, i);
+    }
+    co_return total;
+}
+
+Task<int> sleep_then(int value, uint64_t ms) {
+    EXPECT_EQ(co_await async_sleep(ms), 0);
+    co_return value;
+}
+
+Task<void> fail_after_sleep() {
+    co_await async_sleep(1);
+    throw std::runtime_error("task failed");
+}
+
+} // namespace
+
+//============================================================================
+// Task 组合测试
+//============================================================================
+
+// Task 之间对称转移，深度循环也不会增加栈深度；普通线程可以直接等待
+TEST(TaskTest, SymmetricTransfer) {
+    EXPECT_EQ(await_task(add(2, 3)), 5);
+    EXPECT_EQ(await_task(sum_to(10000)), 50005000);
+
+    Task<int> unused = add(1, 1);
+    EXPECT_TRUE(unused.is_valid());
+    EXPECT_FALSE(unused.is_done());                     // 惰性启动
+}
+
+// 普通线程中没有 IOManager，async_sleep 同 co_sleep 返回 EPERM
+TEST(TaskTest, SleepOutsideIOManager) {
+    auto task = []() -> Task<int> { co_return co_await async_sleep(1); };
+    errno = 0;
+    EXPECT_EQ(await_task(task()), -1);
+    EXPECT_EQ(errno, EPERM);
+}
+
+//============================================================================
+// 有栈协程等待 Task
+//============================================================================
+
+// 等待期间只挂起当前有栈协程，同一线程上的其他协程继续运行
+TEST(TaskTest, StackfulAwaitsTask) {
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    int result = 0;
+    int ticks = 0;
+    bool finished = false;
+    io.spawn([&] {
+        result = await_task(sleep_then(42, 20));
+        finished = true;
+    });
+    io.spawn([&] {
+        while (!finished) {
+            ++ticks;
+            co_sleep(1);
+        }
+    });
+    io.run();
+    EXPECT_EQ(result, 42);
+    EXPECT_GT(ticks, 1);
+}
+
+// Task 抛出的异常在 await_task() 中重新抛出
+TEST(TaskTest, StackfulSeesException) {
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    bool caught = false;
+    io.spawn([&] {
+        try {
+            await_task(fail_after_sleep());
+        } catch (const std::runtime_error&) {
+            caught = true;
+        }
+    });
+    io.run();
+    EXPECT_TRUE(caught);
+}
+
+//============================================================================
+// Task 等待有栈操作
+//============================================================================
+
+// 分离的 Task 从通道接收，与有栈生产者在同一事件循环中运行
+TEST(TaskTest, TaskAwaitsChannel) {
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    Channel<int> channel(4);
+    Channel<int> done(1);
+    int total = 0;
+
+    auto consumer = [&]() -> Task<void> {
+        while (std::optional<int> value = co_await async_recv(channel)) {
+            total += *value;
+        }
+        EXPECT_TRUE(co_await async_send(done, total));
+    };
+    ASSERT_TRUE(spawn_task(io, consumer()));
+    io.spawn([&] {
+        for (int i = 1; i <= 100; ++i) {
+            EXPECT_TRUE(channel.send(i));
+        }
+        channel.close();
+        int reported = 0;
+        EXPECT_TRUE(done.recv(reported));
+        EXPECT_EQ(reported, 5050);
+    });
+    io.run();
+    EXPECT_EQ(total, 5050);
+}
+
+// Task 在 IOManager 中等待 fd 就绪；在无栈上下文中恢复时借出宿主协程
+TEST(TaskTest, TaskAwaitsIo) {
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    int waited = -1;
+    char byte = 0;
+
+    auto reader = [&]() -> Task<void> {
+        co_await async_sleep(1);                // 之后在宿主协程中恢复
+        waited = co_await async_wait_for(io, fds[0], IOEventType::READ, 1000);
+        byte = co_await stackful([&] {
+            char c = 0;
+            EXPECT_EQ(::read(fds[0], &c, 1), 1);
+            return c;
+        });
+    };
+    ASSERT_TRUE(spawn_task(io, reader()));
+    io.spawn([&] {
+        co_sleep(5);
+        EXPECT_EQ(::write(fds[1], "x", 1), 1);
+    });
+    io.run();
+    EXPECT_EQ(waited, 0);
+    EXPECT_EQ(byte, 'x');
+    io.remove_fd(fds[0]);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// 在普通线程上恢复的 Task 直接在线程上运行有栈代码
+TEST(TaskTest, StackfulInlineOnThread) {
+    std::thread::id ran_on;
+    auto task = [&]() -> Task<int> {
+        co_return co_await stackful([&] {
+            ran_on = std::this_thread::get_id();
+            return 7;
+        });
+    };
+    EXPECT_EQ(await_task(task()), 7);
+    EXPECT_EQ(ran_on, std::this_thread::get_id());
+}
+
+//============================================================================
+// 分离 Task 测试
+//============================================================================
+
+// 睡眠中的分离 Task 不占用有栈协程，宿主全部回到池中
+TEST(TaskTest, SleepingTasksHoldNoStack) {
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    CoroutinePool& pool = CoroutinePool::local();
+    const size_t active_before = pool.get_active_count();
+    const int count = 100;
+    int woken = 0;
+    size_t active_while_sleeping = 0;
+
+    auto sleeper = [&woken]() -> Task<void> {
+        co_await async_sleep(5);
+        ++woken;
+    };
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(spawn_task(io, sleeper()));
+    }
+    io.spawn([&] {
+        active_while_sleeping = pool.get_active_count() - active_before;
+    });
+    io.run();
+    EXPECT_EQ(active_while_sleeping, 0u);
+    EXPECT_EQ(woken, count);
+    EXPECT_EQ(pool.get_active_count(), active_before);
+}
+
+// 分离 Task 的异常由恢复它的宿主协程抛出，传给 run() 的调用者
+TEST(TaskTest, DetachedExceptionReachesRun) {
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    ASSERT_TRUE(spawn_task(io, fail_after_sleep()));
+    EXPECT_THROW(io.run(), std::runtime_error);
+    EXPECT_FALSE(spawn_task(io, Task<void>()));
+    EXPECT_EQ(errno, EINVAL);
+}
+
+#else
+
+TEST(TaskTest, RequiresCxx20) {
+    GTEST_SKIP() << "Task 需要 C++20 构建 (xmake f --cxx20=y)";
+}
+
+#endif // LIBCO_OOP_HAS_TASK
@@ -0,0 +1,295 @@
+/**
+ * @file test_timer.cpp
+ * @brief 分层时间轮与协程睡眠测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证跨层级的到期精度、O(1) 插入/取消、下一次超时的计算、
+ * 回调中重新插入，以及 IOManager 中的 co_sleep 与等待超时。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/io_manager.h"
+#include "libco_oop/timer.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace libco_oop;
+
+//============================================================================
+// 测试辅助工具
+//============================================================================
+
+namespace {
+
+/**
+ * @brief 记录到期时刻的定时器
+ */
+struct RecordingTimer : TimerNode {
+    uint64_t fired_at = 0;
+    int fires = 0;
+};
+
+uint64_t g_now = 0;     ///< 推进时钟时的当前时刻，供回调读取
+
+void record(TimerNode* node) {
+    RecordingTimer* timer = static_cast<RecordingTimer*>(node);
+    timer->fired_at = g_now;
+    ++timer->fires;
+}
+
+size_t advance_to(TimerManager& timers, uint64_t now) {
+    g_now = now;
+    return timers.advance(now);
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+//============================================================================
+// TimerManager 测试
+//============================================================================
+
+// 各层级的定时器都在到期的那一毫秒触发
+TEST(TimerManagerTest, FiresExactlyAcrossLevels) {
+    const uint64_t start = 1000003;     // 非对齐的起点
+    TimerManager timers(start);
+    const uint64_t delays[] = {0, 1, 255, 256, 257, 16383, 16384, 1u << 20, (1u << 26) + 5};
+    std::vector<RecordingTimer> nodes(sizeof(delays) / sizeof(delays[0]));
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i].callback = &record;
+        ASSERT_TRUE(timers.add(&nodes[i], start + delays[i]));
+    }
+    EXPECT_FALSE(timers.add(&nodes[0], start));    // 已在时间轮中
+    EXPECT_EQ(timers.size(), nodes.size());
+
+    // 逐个到期时刻推进：到期前一毫秒不触发，到期时刻正好触发
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const uint64_t deadline = start + delays[i];
+        if (deadline > start) {
+            advance_to(timers, deadline - 1);
+            EXPECT_EQ(nodes[i].fires, 0) << "delay " << delays[i];
+        }
+        advance_to(timers, deadline);
+        EXPECT_EQ(nodes[i].fires, 1) << "delay " << delays[i];
+        EXPECT_EQ(nodes[i].fired_at, deadline);
+    }
+    EXPECT_TRUE(timers.empty());
+}
+
+// 随机插入、取消和推进，与逐个检查的结果一致
+TEST(TimerManagerTest, RandomizedAgainstReference) {
+    std::mt19937_64 random(42);
+    const uint64_t start = 123456789;
+    TimerManager timers(start);
+    std::vector<RecordingTimer> nodes(20000);
+    std::vector<bool> cancelled(nodes.size(), false);
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i].callback = &record;
+        // 混合短、中、长延迟
+        const uint64_t range = (i % 3 == 0) ? 300 : (i % 3 == 1) ? 20000 : 3000000;
+        ASSERT_TRUE(timers.add(&nodes[i], start + random() % range));
+    }
+    for (size_t i = 0; i < nodes.size(); i += 7) {
+        EXPECT_TRUE(timers.cancel(&nodes[i]));
+        EXPECT_FALSE(timers.cancel(&nodes[i]));
+        cancelled[i] = true;
+    }
+
+    uint64_t now = start;
+    while (!timers.empty()) {
+        now += 1 + random() % 5000;
+        advance_to(timers, now);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (!cancelled[i] && nodes[i].deadline <= now) {
+                ASSERT_EQ(nodes[i].fires, 1) << "timer " << i;
+            }
+        }
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_EQ(nodes[i].fires, cancelled[i] ? 0 : 1);
+        if (!cancelled[i]) {
+            EXPECT_GE(nodes[i].fired_at, nodes[i].deadline);
+        }
+    }
+}
+
+// 下一次超时取自下一个非空槽位；只有高层定时器时指向下一次级联
+TEST(TimerManagerTest, NextTimeout) {
+    TimerManager timers(0);
+    EXPECT_EQ(timers.next_timeout(0), -1);
+
+    RecordingTimer near;
+    near.callback = &record;
+    timers.add(&near, 10);
+    EXPECT_EQ(timers.next_timeout(0), 10);
+    EXPECT_EQ(timers.next_timeout(4), 6);
+    EXPECT_EQ(timers.next_timeout(10), 0);
+    timers.cancel(&near);
+
+    RecordingTimer far;
+    far.callback = &record;
+    timers.add(&far, 1000);
+    int64_t timeout = timers.next_timeout(0);
+    EXPECT_GT(timeout, 0);
+    EXPECT_LE(timeout, 1000);
+
+    // 按 next_timeout() 等待，最终正好在到期时刻触发
+    uint64_t now = 0;
+    int wakeups = 0;
+    while (far.fires == 0) {
+        now += static_cast<uint64_t>(timers.next_timeout(now));
+        advance_to(timers, now);
+        ++wakeups;
+    }
+    EXPECT_EQ(far.fired_at, 1000u);
+    EXPECT_LE(wakeups, 5);
+}
+
+// 回调中重新插入零延迟的周期定时器不会在一次推进中无限循环
+TEST(TimerManagerTest, RearmFromCallback) {
+    struct Periodic : TimerNode {
+        TimerManager* timers = nullptr;
+        int fires = 0;
+    } periodic;
+    TimerManager timers(0);
+    periodic.timers = &timers;
+    periodic.callback = [](TimerNode* node) {
+        Periodic* self = static_cast<Periodic*>(node);
+        ++self->fires;
+        self->timers->add(self, 0);
+    };
+    timers.add(&periodic, 5);
+
+    EXPECT_EQ(timers.advance(5), 1u);
+    EXPECT_EQ(timers.advance(5), 0u);
+    EXPECT_EQ(timers.advance(9), 4u);
+    EXPECT_EQ(periodic.fires, 5);
+    timers.cancel(&periodic);
+}
+
+// 插入和取消是 O(1)：百万个几乎总被取消的超时
+TEST(TimerManagerTest, InsertCancelThroughput) {
+    const size_t count = 1000000;
+    std::vector<RecordingTimer> nodes(count);
+    std::mt19937 random(7);
+    TimerManager timers(0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        nodes[i].callback = &record;
+        timers.add(&nodes[i], 1 + random() % 600000);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        timers.cancel(&nodes[i]);
+    }
+    double per_op_ns = elapsed_ms(start) * 1e6 / (2.0 * count);
+    std::cout << "timer insert/cancel: " << per_op_ns << " ns per operation" << std::endl;
+    EXPECT_TRUE(timers.empty());
+    EXPECT_EQ(timers.next_timeout(0), -1);
+}
+
+//============================================================================
+// IOManager 集成测试
+//============================================================================
+
+// co_sleep 按到期顺序唤醒，睡眠期间其他协程继续运行
+TEST(IOTimerTest, CoSleepOrdering) {
+    IOManager io;
+    std::vector<int> order;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int ms : {30, 10, 20}) {
+        io.spawn([&order, ms] {
+            EXPECT_EQ(co_sleep(static_cast<uint64_t>(ms)), 0);
+            order.push_back(ms);
+        });
+    }
+    io.spawn([&] {
+        EXPECT_EQ(io.get_statistics().sleeping, 3u);
+    });
+
+    io.run();
+    double elapsed = elapsed_ms(start);
+    std::vector<int> expected = {10, 20, 30};
+    EXPECT_EQ(order, expected);
+    EXPECT_GE(elapsed, 30.0);
+    EXPECT_LT(elapsed, 100.0);
+    EXPECT_EQ(io.get_statistics().sleeping, 0u);
+    EXPECT_EQ(io.get_statistics().timeouts, 3u);
+    EXPECT_EQ(co_sleep(1), -1);
+    EXPECT_EQ(errno, EPERM);
+}
+
+// 两种后端的 wait_for() 超时
+TEST(IOTimerTest, WaitForTimeout) {
+    for (IOBackend backend : {IOBackend::EPOLL, IOBackend::IO_URING}) {
+        IOManagerOptions opts;
+        opts.backend = backend;
+        IOManager io(opts);
+        if (!io.is_valid()) {
+            continue;   // 内核不支持 io_uring
+        }
+        int pair[2];
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, pair), 0);
+        int timed_out = 0;
+        int ready = -1;
+        double waited = 0;
+
+        io.spawn([&] {
+            auto start = std::chrono::steady_clock::now();
+            timed_out = io.wait_for(pair[0], IOEventType::READ, 20) != 0 ? errno : 0;
+            waited = elapsed_ms(start);
+            ready = io.wait_for(pair[0], IOEventType::READ, 1000);
+        });
+        io.spawn([&] {
+            EXPECT_EQ(co_sleep(40), 0);
+            EXPECT_EQ(::write(pair[1], "x", 1), 1);
+        });
+
+        io.run();
+        EXPECT_EQ(timed_out, ETIMEDOUT);
+        EXPECT_GE(waited, 20.0);
+        EXPECT_EQ(ready, 0);
+        EXPECT_EQ(io.get_statistics().waiting, 0u);
+        EXPECT_TRUE(io.get_timer_manager().empty());
+        ::close(pair[0]);
+        ::close(pair[1]);
+    }
+}
+
+// 用户定时器在调度循环中触发；销毁调度器时释放睡眠中的协程
+TEST(IOTimerTest, UserTimersAndDestroy) {
+    int fired = 0;
+    bool woke = false;
+    {
+        IOManager io;
+        struct Counter : TimerNode {
+            int* fired;
+        } counter;
+        counter.fired = &fired;
+        counter.callback = [](TimerNode* node) { ++*static_cast<Counter*>(node)->fired; };
+        ASSERT_TRUE(io.add_timer(&counter, 5));
+
+        io.spawn([&] {
+            co_sleep(60 * 1000);
+            woke = true;
+        });
+        io.spawn([&] {
+            co_sleep(20);
+            io.stop();
+        });
+        io.run();
+        EXPECT_EQ(fired, 1);
+        EXPECT_EQ(io.get_statistics().sleeping, 1u);
+    }
+    EXPECT_FALSE(woke);
+}
@@ -0,0 +1,243 @@
+/**
+ * @file test_trace.cpp
+ * @brief 调度事件跟踪测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证切换、IO等待和定时器唤醒事件的记录顺序，环形缓冲区的覆盖，
+ * 记录开销以及 Chrome trace JSON 导出。
+ * 跟踪关闭的构建只验证接口仍然可用且不产生数据。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/io_manager.h"
+#include "libco_oop/scheduler.h"
+#include "libco_oop/trace.h"
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace libco_oop;
+
+namespace {
+
+constexpr double kRecordTargetNs = 100.0;
+
+/**
+ * @brief 取出当前线程的事件
+ */
+std::vector<trace::Event> local_events(const trace::TraceSnapshot& snapshot) {
+    const uint32_t tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+    for (const trace::ThreadTrace& thread : snapshot.threads) {
+        if (thread.tid == tid) {
+            return thread.events;
+        }
+    }
+    return {};
+}
+
+class TraceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        trace::stop();
+        trace::clear();
+    }
+
+    void TearDown() override {
+        trace::stop();
+        trace::clear();
+    }
+};
+
+} // namespace
+
+//============================================================================
+// 事件记录测试
+//============================================================================
+
+// 调度器轮流运行两个协程，切入切出成对且按时间排序
+TEST_F(TraceTest, SwitchEventsInOrder) {
+    if (!trace::kEnabled) {
+        EXPECT_FALSE(trace::start());
+        EXPECT_FALSE(trace::is_running());
+        EXPECT_TRUE(trace::collect().threads.empty());
+        return;
+    }
+
+    Scheduler scheduler;
+    uint64_t ids[2] = {0, 0};
+    for (int i = 0; i < 2; ++i) {
+        scheduler.spawn([&ids, i] {
+            ids[i] = Coroutine::current()->get_id();
+            Scheduler::yield();
+        });
+    }
+    ASSERT_TRUE(trace::start());
+    scheduler.run();
+    trace::stop();
+
+    const std::vector<trace::Event> events = local_events(trace::collect());
+    ASSERT_EQ(events.size(), 8u);
+    const uint64_t order[4] = {ids[0], ids[1], ids[0], ids[1]};
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(events[2 * i].type, trace::EventType::SWITCH_IN);
+        EXPECT_EQ(events[2 * i + 1].type, trace::EventType::SWITCH_OUT);
+        EXPECT_EQ(events[2 * i].coroutine_id, order[i]);
+        EXPECT_EQ(events[2 * i + 1].coroutine_id, order[i]);
+    }
+    for (size_t i = 1; i < events.size(); ++i) {
+        EXPECT_GE(events[i].cycles, events[i - 1].cycles);
+    }
+}
+
+// IO 等待记录 fd，超时由定时器唤醒
+TEST_F(TraceTest, IoParkAndTimerWake) {
+    IOManager io;
+    ASSERT_TRUE(io.is_valid());
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    uint64_t id = 0;
+    io.spawn([&] {
+        id = Coroutine::current()->get_id();
+        EXPECT_EQ(io.wait_for(fds[0], IOEventType::READ, 1), -1);
+        EXPECT_EQ(errno, ETIMEDOUT);
+    });
+    trace::start();
+    io.run();
+    trace::stop();
+    close(fds[0]);
+    close(fds[1]);
+
+    const std::vector<trace::Event> events = local_events(trace::collect());
+    if (!trace::kEnabled) {
+        EXPECT_TRUE(events.empty());
+        return;
+    }
+    size_t parks = 0;
+    size_t wakes = 0;
+    for (const trace::Event& event : events) {
+        if (event.type == trace::EventType::IO_PARK) {
+            ++parks;
+            EXPECT_EQ(event.coroutine_id, id);
+            EXPECT_EQ(event.arg, static_cast<uint32_t>(fds[0]));
+        } else if (event.type == trace::EventType::TIMER_WAKE) {
+            ++wakes;
+            EXPECT_EQ(event.coroutine_id, id);
+            EXPECT_EQ(parks, 1u);       // 先等待、后唤醒
+        }
+    }
+    EXPECT_EQ(parks, 1u);
+    EXPECT_EQ(wakes, 1u);
+}
+
+// 缓冲区满后覆盖最旧的事件，退出线程的事件保留到 clear()
+TEST_F(TraceTest, RingOverwritesOldest) {
+    if (!trace::kEnabled) {
+        return;
+    }
+    ASSERT_TRUE(trace::start(16));
+    uint32_t tid = 0;
+    std::thread worker([&tid] {
+        tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+        for (uint32_t i = 0; i < 100; ++i) {
+            trace::record(trace::EventType::STEAL, i, i);
+        }
+    });
+    worker.join();
+    trace::stop();
+
+    trace::TraceSnapshot snapshot = trace::collect();
+    const trace::ThreadTrace* found = nullptr;
+    for (const trace::ThreadTrace& thread : snapshot.threads) {
+        if (thread.tid == tid) {
+            found = &thread;
+        }
+    }
+    ASSERT_NE(found, nullptr);
+    ASSERT_EQ(found->events.size(), 16u);
+    EXPECT_EQ(found->dropped, 84u);
+    EXPECT_EQ(found->events.front().coroutine_id, 84u);
+    EXPECT_EQ(found->events.back().arg, 99u);
+
+    trace::clear();
+    for (const trace::ThreadTrace& thread : trace::collect().threads) {
+        EXPECT_NE(thread.tid, tid);
+    }
+}
+
+// 记录一个事件的开销
+TEST_F(TraceTest, RecordCost) {
+    if (!trace::kEnabled) {
+        return;
+    }
+    ASSERT_TRUE(trace::start());
+    const int iterations = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        trace::record(trace::EventType::SWITCH_IN, static_cast<uint64_t>(i));
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    trace::stop();
+
+    double avg = static_cast<double>(elapsed) / iterations;
+    std::cout << "trace record: " << avg << " ns per event" << std::endl;
+    // 主要是一次 rdtsc：物理机上约 10ns，虚拟机上 rdtsc 本身可能要 20ns 以上
+#ifdef NDEBUG
+    EXPECT_LT(avg, kRecordTargetNs);
+#else
+    EXPECT_LT(avg, kRecordTargetNs * 10);
+#endif
+}
+
+//============================================================================
+// 导出测试
+//============================================================================
+
+// 切入切出成对输出为时间片，开头缺少切入的切出被丢弃
+TEST_F(TraceTest, ChromeTraceFormat) {
+    trace::TraceSnapshot snapshot;
+    snapshot.start_cycles = 1000;
+    snapshot.cycles_per_us = 1000.0;
+    trace::ThreadTrace thread;
+    thread.tid = 42;
+    thread.events = {
+        {1500, 6, 0, trace::EventType::SWITCH_OUT},
+        {2000, 7, 0, trace::EventType::SWITCH_IN},
+        {2500, 7, 9, trace::EventType::IO_PARK},
+        {3000, 7, 0, trace::EventType::SWITCH_OUT},
+    };
+    snapshot.threads.push_back(thread);
+
+    const std::string json = trace::format_chrome_trace(snapshot);
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0u);
+    EXPECT_NE(json.find("\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":42"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"co 7\",\"ph\":\"B\",\"pid\":1,\"tid\":42,\"ts\":1.000,"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"io park\",\"ph\":\"i\",\"pid\":1,\"tid\":42,\"s\":\"t\",\"ts\":1.500,"
+                        "\"args\":{\"id\":7,\"arg\":9}}"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"co 7\",\"ph\":\"E\",\"pid\":1,\"tid\":42,\"ts\":2.000,"), std::string::npos);
+    EXPECT_EQ(json.find("co 6"), std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+}
+
+// 写入文件
+TEST_F(TraceTest, DumpToFile) {
+    char path[] = "/tmp/libco_oop_trace_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    EXPECT_TRUE(trace::dump_chrome_trace(path));
+    FILE* file = fopen(path, "r");
+    ASSERT_NE(file, nullptr);
+    char head[32] = {};
+    EXPECT_GT(fread(head, 1, sizeof(head) - 1, file), 0u);
+    fclose(file);
+    unlink(path);
+    EXPECT_EQ(std::string(head).find("{\"displayTimeUnit\""), 0u);
+
+    EXPECT_FALSE(trace::dump_chrome_trace("/nonexistent/dir/trace.json"));
+    EXPECT_EQ(errno, ENOENT);
+}
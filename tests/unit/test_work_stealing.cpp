@@ -0,0 +1,388 @@
+/**
+ * @file test_work_stealing.cpp
+ * @brief 多线程工作窃取调度器测试套件
+ * @author libco-oop
+ * @version 1.0
+ *
+ * 验证 Chase-Lev 双端队列的单线程语义、批量压入和并发窃取，以及调度器的
+ * 跨线程执行、批量派生、协程迁移、窃取、跨线程唤醒、迁移协程的栈归还和异常传播。
+ */
+
+#include <gtest/gtest.h>
+#include "libco_oop/chase_lev_deque.h"
+#include "libco_oop/stack.h"
+#include "libco_oop/work_stealing.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace libco_oop;
+
+//============================================================================
+// ChaseLevDeque 测试
+//============================================================================
+
+// 所有者 LIFO、窃取者 FIFO，容量不足时扩容
+TEST(ChaseLevDequeTest, OwnerAndThiefOrder) {
+    ChaseLevDeque<int*> deque(2);
+    std::vector<int> values(10);
+    for (auto& value : values) {
+        deque.push(&value);
+    }
+    EXPECT_EQ(deque.size(), 10u);
+    EXPECT_GE(deque.capacity(), 10u);
+
+    EXPECT_EQ(deque.steal(), &values[0]);
+    EXPECT_EQ(deque.pop(), &values[9]);
+    EXPECT_EQ(deque.steal(), &values[1]);
+    EXPECT_EQ(deque.pop(), &values[8]);
+    EXPECT_EQ(deque.size(), 6u);
+
+    while (deque.pop() != nullptr) {
+    }
+    EXPECT_TRUE(deque.empty());
+    EXPECT_EQ(deque.steal(), nullptr);
+}
+
+// 所有者和多个窃取者并发时，每个元素恰好被取出一次
+TEST(ChaseLevDequeTest, ConcurrentSteal) {
+    const int items = 200000;
+    const int thieves = 3;
+    ChaseLevDeque<int*> deque(64);
+    std::vector<int> values(items);
+    std::vector<std::atomic<int>> seen(items);
+    std::atomic<bool> done{false};
+    std::atomic<int> taken{0};
+
+    auto take = [&](int* value) {
+        seen[value - values.data()].fetch_add(1, std::memory_order_relaxed);
+        taken.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thieves; ++t) {
+        threads.emplace_back([&] {
+            while (!done.load(std::memory_order_acquire)) {
+                if (int* value = deque.steal()) {
+                    take(value);
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < items; ++i) {
+        deque.push(&values[i]);
+        if (i % 3 == 0) {
+            if (int* value = deque.pop()) {
+                take(value);
+            }
+        }
+    }
+    while (int* value = deque.pop()) {
+        take(value);
+    }
+    while (taken.load(std::memory_order_acquire) < items) {
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(taken.load(), items);
+    for (int i = 0; i < items; ++i) {
+        ASSERT_EQ(seen[i].load(), 1) << "item " << i;
+    }
+}
+
+// 批量压入只发布一次，顺序与逐个压入相同
+TEST(ChaseLevDequeTest, PushBatch) {
+    ChaseLevDeque<int*> deque(2);
+    std::vector<int> values(10);
+    deque.push(&values[0]);
+    size_t next = 1;
+    deque.push_batch(9, [&] { return &values[next++]; });
+    EXPECT_EQ(deque.size(), 10u);
+    EXPECT_GE(deque.capacity(), 10u);
+    deque.push_batch(0, [] { return static_cast<int*>(nullptr); });
+
+    EXPECT_EQ(deque.steal(), &values[0]);
+    EXPECT_EQ(deque.steal(), &values[1]);
+    EXPECT_EQ(deque.pop(), &values[9]);
+    EXPECT_EQ(deque.size(), 7u);
+}
+
+//============================================================================
+// WorkStealingScheduler 测试
+//============================================================================
+
+// 大量让出的协程全部在工作线程上执行完毕
+TEST(WorkStealingTest, RunsAllCoroutines) {
+    WorkStealingOptions opts;
+    opts.worker_count = 4;
+    WorkStealingScheduler scheduler(opts);
+    EXPECT_EQ(scheduler.get_worker_count(), 4u);
+
+    const int count = 2000;
+    const int rounds = 5;
+    std::atomic<int> steps{0};
+    std::atomic<int> outside{0};
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(scheduler.spawn([&] {
+            for (int round = 0; round < rounds; ++round) {
+                if (WorkStealingScheduler::current() == nullptr) {
+                    outside.fetch_add(1);
+                }
+                steps.fetch_add(1, std::memory_order_relaxed);
+                EXPECT_TRUE(WorkStealingScheduler::yield());
+            }
+        }));
+    }
+
+    scheduler.wait();
+    EXPECT_EQ(steps.load(), count * rounds);
+    EXPECT_EQ(outside.load(), 0);
+    EXPECT_EQ(scheduler.get_live_count(), 0u);
+
+    WorkStealingStatistics stats = scheduler.get_statistics();
+    EXPECT_EQ(stats.spawned, static_cast<uint64_t>(count));
+    EXPECT_EQ(stats.finished, static_cast<uint64_t>(count));
+    EXPECT_EQ(stats.dispatches, static_cast<uint64_t>(count) * (rounds + 1));
+
+    // 不在工作线程中调用
+    EXPECT_FALSE(WorkStealingScheduler::yield());
+    EXPECT_EQ(WorkStealingScheduler::current_worker_index(), SIZE_MAX);
+}
+
+// 外部线程和工作线程批量派生的协程都执行完毕
+TEST(WorkStealingTest, SpawnBatch) {
+    WorkStealingOptions opts;
+    opts.worker_count = 4;
+    WorkStealingScheduler scheduler(opts);
+
+    std::vector<int> shards(500);
+    for (size_t i = 0; i < shards.size(); ++i) {
+        shards[i] = static_cast<int>(i);
+    }
+    std::atomic<long> sum{0};
+    std::atomic<int> outside{0};
+    auto query = [&](int shard) {
+        if (WorkStealingScheduler::current() == nullptr) {
+            outside.fetch_add(1);
+        }
+        WorkStealingScheduler::yield();
+        sum.fetch_add(shard, std::memory_order_relaxed);
+    };
+    EXPECT_EQ(scheduler.spawn_batch(shards.begin(), shards.end(), query), shards.size());
+    scheduler.wait();
+    const long expected = 499L * 500 / 2;
+    EXPECT_EQ(sum.load(), expected);
+
+    // 工作线程中的扇出：本线程的一份进入本地队列，其余交给其他工作线程
+    sum.store(0);
+    std::atomic<size_t> spawned{0};
+    ASSERT_TRUE(scheduler.spawn([&] {
+        spawned = WorkStealingScheduler::current()->spawn_batch(shards.begin(), shards.end(), query);
+    }));
+    scheduler.wait();
+    EXPECT_EQ(spawned.load(), shards.size());
+    EXPECT_EQ(sum.load(), expected);
+    EXPECT_EQ(outside.load(), 0);
+
+    WorkStealingStatistics stats = scheduler.get_statistics();
+    EXPECT_EQ(stats.spawned, 1001u);
+    EXPECT_EQ(stats.finished, 1001u);
+
+    // 共享栈的协程不能提交，整批拒绝
+    SharedStackAllocator shared(1);
+    CoroutineOptions shared_opts;
+    shared_opts.stack_allocator = &shared;
+    CoroutineBatch batch;
+    ASSERT_TRUE(batch.add([] {}));
+    ASSERT_TRUE(batch.add([] {}, shared_opts));
+    EXPECT_EQ(scheduler.submit_batch(batch), 0u);
+    EXPECT_EQ(batch.size(), 2u);
+    batch.clear();
+}
+
+// 被阻塞的工作线程产生的协程由其他工作线程窃取执行
+TEST(WorkStealingTest, IdleWorkersSteal) {
+    WorkStealingOptions opts;
+    opts.worker_count = 3;
+    WorkStealingScheduler scheduler(opts);
+
+    const int children = 64;
+    std::atomic<int> finished{0};
+    std::atomic<size_t> parent_worker{SIZE_MAX};
+    std::atomic<int> on_parent_worker{0};
+
+    ASSERT_TRUE(scheduler.spawn([&] {
+        WorkStealingScheduler* self = WorkStealingScheduler::current();
+        size_t index = WorkStealingScheduler::current_worker_index();
+        parent_worker.store(index);
+        for (int i = 0; i < children; ++i) {
+            self->spawn([&, index] {
+                if (WorkStealingScheduler::current_worker_index() == index) {
+                    on_parent_worker.fetch_add(1);
+                }
+                finished.fetch_add(1);
+            });
+        }
+        // 阻塞本工作线程：子协程只能被其他工作线程窃取
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (finished.load() < children && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }));
+
+    scheduler.wait();
+    EXPECT_EQ(finished.load(), children);
+    EXPECT_EQ(on_parent_worker.load(), 0);
+    EXPECT_GE(scheduler.get_statistics().steals, 1u);
+}
+
+// 挂起的协程可以在其他线程上唤醒，在切换出去之前到达的唤醒不会丢失
+TEST(WorkStealingTest, CrossThreadWakeup) {
+    WorkStealingOptions opts;
+    opts.worker_count = 2;
+    WorkStealingScheduler scheduler(opts);
+
+    const int count = 200;
+    const int rounds = 20;
+    std::vector<std::atomic<Coroutine*>> handles(count);
+    std::atomic<int> wakes_needed{count * rounds};
+    std::atomic<int> completed{0};
+
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(scheduler.spawn([&, i] {
+            for (int round = 0; round < rounds; ++round) {
+                handles[i].store(Coroutine::current(), std::memory_order_release);
+                EXPECT_TRUE(WorkStealingScheduler::suspend());
+            }
+            completed.fetch_add(1);
+        }));
+    }
+
+    // 外部线程不断唤醒已登记的协程；先于挂起到达的唤醒会让 suspend() 立即返回
+    std::thread waker([&] {
+        while (wakes_needed.load() > 0) {
+            for (auto& handle : handles) {
+                if (Coroutine* coroutine = handle.exchange(nullptr, std::memory_order_acq_rel)) {
+                    scheduler.schedule(coroutine);
+                    wakes_needed.fetch_sub(1);
+                }
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    scheduler.wait();
+    waker.join();
+    EXPECT_EQ(completed.load(), count);
+}
+
+// 外部线程创建的协程迁移到工作线程上结束，栈归还给创建线程的默认分配器
+TEST(WorkStealingTest, MigratedStacksReturnToOwner) {
+    WorkStealingOptions opts;
+    opts.worker_count = 2;
+    WorkStealingScheduler scheduler(opts);
+    const size_t count = 64;
+    std::atomic<size_t> worker_in_use{SIZE_MAX};
+    std::atomic<bool> go{false};
+    // 全部派生后才结束，每轮的栈同时在使用中
+    auto body = [&go] {
+        while (!go.load(std::memory_order_acquire)) {
+            WorkStealingScheduler::yield();
+        }
+    };
+
+    // 新线程的默认分配器从零开始计数
+    std::thread owner([&] {
+        FixedStackAllocator& local = FixedStackAllocator::local();
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_TRUE(scheduler.spawn(body));
+        }
+        go.store(true, std::memory_order_release);
+        scheduler.wait();
+
+        // 计数没有记到工作线程的分配器上，也没有下溢
+        const StackStatistics returned = local.get_statistics();
+        EXPECT_EQ(returned.in_use, 0u);
+        EXPECT_EQ(returned.mmap_calls, count);
+        EXPECT_GE(returned.reserved_bytes, count * local.get_options().stack_size);
+        ASSERT_TRUE(scheduler.spawn([&] {
+            worker_in_use = FixedStackAllocator::local().get_statistics().in_use;
+        }));
+        scheduler.wait();
+        EXPECT_EQ(worker_in_use.load(), 0u);
+
+        // 下一轮分配收回远程归还的栈，不再新建映射
+        go.store(false, std::memory_order_release);
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_TRUE(scheduler.spawn(body));
+        }
+        go.store(true, std::memory_order_release);
+        scheduler.wait();
+        const StackStatistics reused = local.get_statistics();
+        EXPECT_EQ(reused.in_use, 0u);
+        EXPECT_EQ(reused.mmap_calls, returned.mmap_calls);
+        EXPECT_EQ(reused.pool_hits, count + 1);
+        EXPECT_EQ(reused.reserved_bytes, returned.reserved_bytes);
+    });
+    owner.join();
+}
+
+// 未捕获的异常从 wait() 重新抛出
+TEST(WorkStealingTest, ExceptionPropagation) {
+    WorkStealingOptions opts;
+    opts.worker_count = 2;
+    WorkStealingScheduler scheduler(opts);
+
+    std::atomic<int> finished{0};
+    ASSERT_TRUE(scheduler.spawn([] { throw std::runtime_error("boom"); }));
+    for (int i = 0; i < 10; ++i) {
+        scheduler.spawn([&finished] {
+            WorkStealingScheduler::yield();
+            finished.fetch_add(1);
+        });
+    }
+
+    EXPECT_THROW(scheduler.wait(), std::runtime_error);
+    EXPECT_EQ(finished.load(), 10);
+    EXPECT_EQ(scheduler.get_statistics().finished, 11u);
+}
+
+// 共享栈不能跨线程使用；析构时销毁仍在队列中的协程
+TEST(WorkStealingTest, RejectsSharedStacksAndShutsDown) {
+    SharedStackAllocator shared(1, StackOptions{64 * 1024});
+    CoroutineOptions shared_opts;
+    shared_opts.stack_allocator = &shared;
+
+    std::atomic<int> parked{0};
+    {
+        WorkStealingOptions opts;
+        opts.worker_count = 2;
+        WorkStealingScheduler scheduler(opts);
+        EXPECT_FALSE(scheduler.spawn([] {}, shared_opts));
+        EXPECT_FALSE(scheduler.submit(nullptr));
+
+        // 持续让出的协程在 shutdown() 时仍在队列中
+        for (int i = 0; i < 8; ++i) {
+            scheduler.spawn([&parked] {
+                parked.fetch_add(1);
+                for (;;) {
+                    WorkStealingScheduler::yield();
+                }
+            });
+        }
+        while (parked.load() < 8) {
+            std::this_thread::yield();
+        }
+        scheduler.shutdown();
+        EXPECT_EQ(scheduler.get_live_count(), 0u);
+        EXPECT_FALSE(scheduler.spawn([] {}));
+    }
+    EXPECT_EQ(shared.get_statistics().in_use, 0u);
+}
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+LibCo-OOP 基准回归门禁
+
+把 benchmark_tests 绑定到一个隔离的 CPU 上运行，输出 Google Benchmark JSON，
+与检入的基线 (tests/benchmark/baseline.json) 比较。任一指标比基线慢出阈值
+以上、或基线中的基准没有结果时返回非零。
+
+指标与 bench_main.cpp 的目标检查一致：
+- ns_per_op: 重复运行的中位数耗时 / ops_per_iter 计数器 (例如每次切换、每次创建)
+- 登记了 "<name>_target" 的计数器 (例如 bytes_per_coroutine)
+没有 ops_per_iter 计数器的基准 (参照实现) 不参与门禁。
+
+用法:
+    tools/bench_gate.py --binary build/bin/benchmark_tests
+    tools/bench_gate.py --binary build/bin/benchmark_tests --update     # 重新生成基线
+    tools/bench_gate.py --current build/bench/current.json              # 只比较已有结果
+
+基线与机器相关，应在门禁所用的机器上以发布构建生成。
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+DEFAULT_BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                "..", "tests", "benchmark", "baseline.json")
+DEFAULT_THRESHOLD = 0.15
+TARGET_SUFFIX = "_target"
+NS_PER_OP = "ns_per_op"
+OPS_PER_ITERATION = "ops_per_iter"
+TIME_UNIT_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def pick_cpu():
+    """优先使用内核隔离的 CPU (isolcpus)，否则使用亲和性掩码中编号最大的 CPU"""
+    try:
+        with open("/sys/devices/system/cpu/isolated") as f:
+            isolated = f.read().strip()
+    except OSError:
+        isolated = ""
+    if isolated:
+        # 隔离的 CPU 不在默认掩码中，仍然可以显式绑定
+        return int(isolated.split(",")[0].split("-")[0])
+    return max(os.sched_getaffinity(0))
+
+
+def run_benchmarks(binary, cpu, out_path, repetitions, bench_filter):
+    """绑定到 cpu 运行基准，结果写入 out_path"""
+    os.makedirs(os.path.dirname(os.path.abspath(out_path)), exist_ok=True)
+    command = [binary,
+               "--benchmark_out=" + out_path,
+               "--benchmark_out_format=json",
+               "--benchmark_repetitions=%d" % repetitions,
+               "--benchmark_report_aggregates_only=true"]
+    if bench_filter:
+        command.append("--benchmark_filter=" + bench_filter)
+    print("running on cpu %d: %s" % (cpu, " ".join(command)))
+    result = subprocess.run(command, preexec_fn=lambda: os.sched_setaffinity(0, {cpu}))
+    if result.returncode != 0:
+        sys.exit("benchmark_tests exited with %d" % result.returncode)
+
+
+def extract_metrics(report):
+    """从 Google Benchmark JSON 提取 {基准名: {指标: 值}}，重复运行时取中位数"""
+    rows = report.get("benchmarks", [])
+    has_aggregates = any(row.get("run_type") == "aggregate" for row in rows)
+    metrics = {}
+    for row in rows:
+        if row.get("error_occurred"):
+            continue
+        if has_aggregates:
+            if row.get("run_type") != "aggregate" or row.get("aggregate_name") != "median":
+                continue
+            name = row.get("run_name", row["name"])
+        else:
+            name = row["name"]
+        ops = row.get(OPS_PER_ITERATION)
+        if not ops:
+            continue
+        values = {NS_PER_OP: row["real_time"] * TIME_UNIT_NS[row.get("time_unit", "ns")] / ops}
+        for key in row:
+            if key.endswith(TARGET_SUFFIX):
+                counter = key[:-len(TARGET_SUFFIX)]
+                if counter != NS_PER_OP and counter in row:
+                    values[counter] = row[counter]
+        metrics[name] = values
+    return metrics
+
+
+def compare(baseline, metrics, threshold):
+    """逐项比较，返回失败项数"""
+    overrides = baseline.get("thresholds", {})
+    failures = 0
+    print("%-48s %-20s %12s %12s %8s" % ("benchmark", "metric", "baseline", "current", "delta"))
+    for name, expected in sorted(baseline["benchmarks"].items()):
+        limit = overrides.get(name, threshold)
+        current = metrics.get(name)
+        for metric, base_value in sorted(expected.items()):
+            if current is None or metric not in current:
+                print("%-48s %-20s %12.2f %12s %8s  MISSING" % (name, metric, base_value, "-", "-"))
+                failures += 1
+                continue
+            value = current[metric]
+            delta = (value - base_value) / base_value if base_value > 0 else 0.0
+            status = ""
+            if delta > limit:
+                status = "  REGRESSION (> %+.0f%%)" % (limit * 100)
+                failures += 1
+            print("%-48s %-20s %12.2f %12.2f %+7.1f%%%s" % (name, metric, base_value, value, delta * 100, status))
+    for name in sorted(set(metrics) - set(baseline["benchmarks"])):
+        print("%-48s not in baseline (run with --update to add)" % name)
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark regression gate for libco-oop")
+    parser.add_argument("--binary", default="build/bin/benchmark_tests", help="benchmark_tests executable")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE, help="checked-in baseline file")
+    parser.add_argument("--current", help="compare an existing Google Benchmark JSON instead of running")
+    parser.add_argument("--out", default="build/bench/current.json", help="where to write the JSON result")
+    parser.add_argument("--threshold", type=float, help="allowed slowdown as a fraction (default from baseline)")
+    parser.add_argument("--cpu", type=int, help="CPU to pin to (default: isolated or last allowed CPU)")
+    parser.add_argument("--repetitions", type=int, default=5, help="repetitions per benchmark, median is used")
+    parser.add_argument("--filter", help="--benchmark_filter passed to benchmark_tests")
+    parser.add_argument("--update", action="store_true", help="write the result as the new baseline")
+    args = parser.parse_args()
+
+    if args.current:
+        result_path = args.current
+    else:
+        result_path = args.out
+        cpu = args.cpu if args.cpu is not None else pick_cpu()
+        run_benchmarks(args.binary, cpu, result_path, args.repetitions, args.filter)
+    with open(result_path) as f:
+        report = json.load(f)
+    metrics = extract_metrics(report)
+
+    if args.update:
+        previous = {}
+        if os.path.exists(args.baseline):
+            with open(args.baseline) as f:
+                previous = json.load(f)
+        context = report.get("context", {})
+        baseline = {
+            "host": {key: context.get(key) for key in ("host_name", "num_cpus", "mhz_per_cpu")},
+            "threshold": previous.get("threshold", DEFAULT_THRESHOLD),
+            "thresholds": previous.get("thresholds", {}),
+            "benchmarks": {name: {metric: round(value, 3) for metric, value in values.items()}
+                           for name, values in sorted(metrics.items())},
+        }
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("baseline written to %s (%d benchmarks)" % (args.baseline, len(metrics)))
+        return 0
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    threshold = args.threshold if args.threshold is not None else baseline.get("threshold", DEFAULT_THRESHOLD)
+    failures = compare(baseline, metrics, threshold)
+    if failures:
+        print("%d metric(s) regressed beyond the threshold or are missing" % failures)
+        return 1
+    print("no regressions (threshold %+.0f%%)" % (threshold * 100))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
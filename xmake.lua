@@ -2,7 +2,6 @@
 -- 设置项目基本信息
 set_project("libco-oop")
 set_version("1.0.0")
-set_languages("c++17")
 
 -- 设置构建模式
 add_rules("mode.debug", "mode.release", "mode.coverage")
@@ -28,6 +27,78 @@ elseif is_mode("coverage") then
     add_ldflags("--coverage")
 end
 
+-- 插桩构建：在发布模式下也开启上下文校验和切换计数
+-- 用法: xmake f --instrument=y
+option("instrument")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Enable context validation and switch counters in all build modes")
+option_end()
+
+if has_config("instrument") then
+    add_defines("LIBCO_OOP_INSTRUMENT")
+end
+
+-- 运行指标：每线程/每调度器/每协程计数器 (调试和插桩构建默认开启)
+-- 用法: xmake f --metrics=y
+option("metrics")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Compile per-coroutine and per-scheduler metrics counters")
+option_end()
+
+if has_config("metrics") then
+    add_defines("LIBCO_OOP_METRICS=1")
+end
+
+-- 调度事件跟踪 (调试和插桩构建默认编译，运行时由 trace::start() 开启)
+-- 用法: xmake f --trace=y
+option("trace")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Compile the scheduler event tracer (Chrome/Perfetto trace export)")
+option_end()
+
+if has_config("trace") then
+    add_defines("LIBCO_OOP_TRACING=1")
+end
+
+-- C++20 构建：启用 task.h 中的无栈协程 (co_await) 互操作
+-- 用法: xmake f --cxx20=y
+option("cxx20")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Build with C++20 to enable stackless Task<T> interop (task.h)")
+option_end()
+
+if has_config("cxx20") then
+    set_languages("c++20")
+else
+    set_languages("c++17")
+end
+
+-- 基准对比的参照实现 (默认关闭)
+-- 用法: xmake f --bench_boost=y --bench_libco=y --bench_libaco=y
+-- libco (libcolib) 和 libaco 不在包仓库中，头文件与库路径通过
+-- --includedirs/--linkdirs 指定
+option("bench_boost")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Compare against boost.context in benchmark_tests")
+option_end()
+
+option("bench_libco")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Compare against Tencent libco in benchmark_tests")
+option_end()
+
+option("bench_libaco")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Compare against libaco in benchmark_tests")
+option_end()
+
 -- 设置警告选项
 add_cxflags("-Wall", "-Wextra", "-Werror")
 add_cxflags("-Wno-unused-parameter") -- 允许未使用的参数
@@ -38,25 +109,57 @@ add_includedirs("include", "include/internal")
 
 -- 配置依赖包
 add_requires("gtest", "benchmark")
+if has_config("bench_boost") then
+    add_requires("boost", {configs = {context = true}})
+end
 
 -- 主静态库目标
 target("libco_oop")
     set_kind("static")
     -- 添加核心源文件
     add_files("src/core/context.cpp")
-    add_files("src/core/context_switch.S")
+    add_files("src/core/stack.cpp")
+    add_files("src/core/coroutine.cpp")
+    add_files("src/core/coroutine_local.cpp")
+    add_files("src/core/metrics.cpp")
+    add_files("src/core/trace.cpp")
+    add_files("src/core/stack_guard.cpp")
+    -- 上下文切换汇编按目标架构选择
+    if is_arch("arm64", "arm64-v8a", "aarch64") then
+        add_files("src/core/context_switch_aarch64.S")
+    else
+        add_files("src/core/context_switch.S")
+    end
+    add_files("src/scheduler/scheduler.cpp")
+    add_files("src/scheduler/work_stealing.cpp")
+    add_files("src/scheduler/timer.cpp")
+    add_files("src/scheduler/waiter.cpp")
+    add_files("src/scheduler/sync.cpp")
+    add_files("src/scheduler/coroutine_pool.cpp")
+    add_files("src/io/io_manager.cpp")
+    add_files("src/io/io_uring_ring.cpp")
+    add_files("src/io/buffer.cpp")
+    add_files("src/io/zero_copy.cpp")
     -- 保留空文件确保编译
     add_files("src/core/empty.cpp")
-    -- 后续会逐步添加：src/scheduler/*.cpp, src/io/*.cpp, src/utils/*.cpp
+    -- 后续会逐步添加：src/utils/*.cpp
     
     -- 设置输出目录
     set_targetdir("build/lib")
     set_objectdir("build/obj")
 
+-- 系统调用接管目标
+-- 以目标文件形式链接，确保覆盖的 libc 符号总是进入可执行文件
+target("libco_oop_hook")
+    set_kind("object")
+    add_deps("libco_oop")
+    add_files("src/io/hook.cpp")
+    add_syslinks("dl")
+
 -- 单元测试目标
 target("unit_tests")
     set_kind("binary")
-    add_deps("libco_oop")
+    add_deps("libco_oop", "libco_oop_hook")
     add_files("tests/unit/*.cpp")
     add_packages("gtest")
     add_links("pthread") -- gtest需要pthread
@@ -75,10 +178,33 @@ target("benchmark_tests")
     add_deps("libco_oop")
     add_files("tests/benchmark/*.cpp")
     add_packages("benchmark")
+    if has_config("bench_boost") then
+        add_defines("LIBCO_OOP_BENCH_BOOST")
+        add_packages("boost")
+    end
+    if has_config("bench_libco") then
+        add_defines("LIBCO_OOP_BENCH_LIBCO")
+        add_links("colib")
+    end
+    if has_config("bench_libaco") then
+        add_defines("LIBCO_OOP_BENCH_LIBACO")
+        add_links("aco")
+    end
     add_links("pthread")
     
     set_targetdir("build/bin")
 
+-- 压力与扩展性测试目标 (规模参数见 tests/integration/stress_helper.h)
+-- 按 bench_helper.h 中的 config:: 目标汇总，与基准共用目标定义
+target("integration_tests")
+    set_kind("binary")
+    add_deps("libco_oop")
+    add_files("tests/integration/*.cpp")
+    add_packages("gtest", "benchmark")
+    add_links("pthread")
+
+    set_targetdir("build/bin")
+
 -- 自定义任务：运行单元测试
 task("test")
     on_run(function ()
@@ -99,6 +225,39 @@ task("bench")
         description = "Run performance benchmarks"
     }
 
+-- 自定义任务：基准回归门禁
+-- 绑定到隔离的 CPU 运行基准，与 tests/benchmark/baseline.json 比较，
+-- 任一指标慢出阈值以上时失败；--update 以本次结果重写基线
+task("bench-gate")
+    on_run(function ()
+        import("core.base.option")
+        os.exec("xmake build benchmark_tests")
+        local argv = {"tools/bench_gate.py", "--binary", "build/bin/benchmark_tests"}
+        for _, name in ipairs({"baseline", "threshold", "cpu", "repetitions", "filter"}) do
+            local value = option.get(name)
+            if value then
+                table.insert(argv, "--" .. name)
+                table.insert(argv, value)
+            end
+        end
+        if option.get("update") then
+            table.insert(argv, "--update")
+        end
+        os.execv("python3", argv)
+    end)
+    set_menu {
+        usage = "xmake bench-gate [options]",
+        description = "Run benchmarks pinned to one CPU and fail on regressions against the baseline",
+        options = {
+            {nil, "baseline",    "kv", nil, "Baseline file (default: tests/benchmark/baseline.json)"},
+            {nil, "threshold",   "kv", nil, "Allowed slowdown as a fraction, e.g. 0.1"},
+            {nil, "cpu",         "kv", nil, "CPU to pin to (default: isolated or last allowed CPU)"},
+            {nil, "repetitions", "kv", nil, "Repetitions per benchmark, the median is compared"},
+            {nil, "filter",      "kv", nil, "Only run benchmarks matching this regex"},
+            {nil, "update",      "k",  nil, "Write the result as the new baseline"}
+        }
+    }
+
 -- 自定义任务：代码覆盖率
 task("coverage")
     on_run(function ()
@@ -140,6 +299,7 @@ task("info")
         print("  xmake build          - 编译项目")
         print("  xmake test           - 运行单元测试")
         print("  xmake bench          - 运行性能基准测试")
+        print("  xmake bench-gate     - 基准回归门禁 (与基线比较)")
         print("  xmake coverage       - 生成代码覆盖率报告")
         print("  xmake clean-all      - 清理所有构建产物")
     end)